@@ -0,0 +1,131 @@
+/**
+  @file callback.cc
+
+  @brief Implements sorting and sampling utitlities. Employs pre-allocated copy-out parameters to avoid dependence on front end's memory allocation. The core does not implement the callback.h and callback.cc so I have to implement them here...
+
+  @author GitHub user @fyears
+ */
+#include <algorithm> // sort
+#include <random> // default_random_engine
+#include <utility> // make_pair
+//#include <iostream>
+//#include <vector> // vector
+
+
+#include "callback.h"
+
+
+/**
+  @brief The generator from which the core seeds each fit's own.
+
+  @return reference to the generator.
+ */
+static std::mt19937 &Generator() {
+  static std::mt19937 gen{std::random_device{}()};
+  return gen;
+}
+
+/**
+  @brief Call-back to integer quicksort with indices.
+
+  @param ySorted[] is a copy-out vector containing the sorted integers.
+
+  @param rank2Row[] is the vector of permuted indices.
+
+  @param one is a hard-coded integer indicating unit stride.
+
+  @param nRow is the number of rows to sort.
+
+  @return Formally void, with copy-out parameter vectors.
+*/
+void CallBack::QSortI(int ySorted[], int rank2Row[], int one, int nRow) {
+  std::vector<std::pair<int, int>> pairs;
+  for (int i = one; i <= nRow; ++i)
+  {
+    pairs.push_back(std::make_pair(ySorted[i-1], rank2Row[i-1]));
+  }
+
+  std::sort(pairs.begin(), pairs.end(),
+    [](const std::pair<int, int> &a, const std::pair<int, int> &b){
+      return a.first < b.first;
+    }
+  );
+
+  for (int i = one; i <= nRow; ++i) {
+    ySorted[i-1] = pairs[i-1].first;
+    rank2Row[i-1] = pairs[i-1].second;
+  }
+}
+
+
+/**
+  @brief Call-back to double quicksort with indices.
+
+  @param ySorted[] is the copy-out vector of sorted values.
+
+  @param rank2Row[] is the copy-out vector of permuted indices.
+
+  @param one is a hard-coded integer indicating unit stride.
+
+  @param nRow is the number of rows to sort.
+
+  @return Formally void, with copy-out parameter vectors.
+*/
+void CallBack::QSortD(double ySorted[], int rank2Row[], int one, int nRow) {
+  std::vector<std::pair<double, int>> pairs;
+  for (int i = one; i <= nRow; ++i)
+  {
+    pairs.push_back(std::make_pair(ySorted[i-1], rank2Row[i-1]));
+  }
+
+  std::sort(pairs.begin(), pairs.end(),
+    [](const std::pair<double, int> &a, const std::pair<double, int> &b){
+      // avoid Inf
+      return a.first < b.first || (b.first != b.first && a.first == a.first);
+    }
+  );
+
+  for (int i = one; i <= nRow; ++i) {
+    ySorted[i-1] = pairs[i-1].first;
+    rank2Row[i-1] = pairs[i-1].second;
+  }
+}
+
+
+/**
+  @brief Call-back to uniform random-variate generator.
+
+  @param len is number of variates to generate.
+
+  @param out[] is the copy-out vector of generated variates.
+
+  @return Formally void, with copy-out parameter vector.
+    
+ */
+void CallBack::RUnif(int len, double out[]) {
+  std::mt19937 &gen = Generator();
+  std::uniform_real_distribution<double> distribution(0.0, 1.0);
+  for (int i = 0; i < len; i++){
+    out[i] = distribution(gen);
+  }
+}
+
+
+/**
+  @brief Cancellation is not yet wired to the Python front end.
+
+  @return false.
+ */
+bool CallBack::Interrupted() {
+  return false;
+}
+
+
+/**
+  @brief Progress reporting is not yet wired to the Python front end.
+
+  @return void.
+ */
+void CallBack::Progress(unsigned int treeDone, unsigned int nTree) {
+}
+
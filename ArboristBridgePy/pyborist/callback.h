@@ -12,18 +12,7 @@
 #include <vector>
 
 class CallBack {
-  static unsigned int nRow;
-  static bool withRepl;
-  static std::vector<double> weight;
-
   public:
-    static void SampleInit(unsigned int _nRow,
-      double _sampleWeight[],
-      bool _withRepl);
-
-    static void SampleRows(unsigned int nSamp,
-      int out[]);
-
     static void QSortI(int ySorted[],
       int rank2Row[],
       int one,
@@ -36,6 +25,11 @@ class CallBack {
 
     static void RUnif(int len,
       double out[]);
+
+    static bool Interrupted();
+
+    static void Progress(unsigned int treeDone,
+      unsigned int nTree);
 };
 
 #endif
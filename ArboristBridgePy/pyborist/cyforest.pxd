@@ -9,9 +9,23 @@ cdef extern from 'forest.h':
     cdef cppclass ForestNode:
         pass
 
+    cdef cppclass ForestCompact:
+        void Compile(const vector[ForestNode] &forestNode,
+            const vector[unsigned int] &origin,
+            const vector[unsigned int] &facOrigin,
+            const vector[unsigned int] &facVec,
+            unsigned int nPredNum)
+
 
 
 cdef class PyPtrVecForestNode:
     cdef shared_ptr[vector[ForestNode]] thisptr
     cdef set(self, shared_ptr[vector[ForestNode]] ptr)
     cdef shared_ptr[vector[ForestNode]] get(self)
+
+
+
+cdef class PyPtrForestCompact:
+    cdef shared_ptr[ForestCompact] thisptr
+    cdef set(self, shared_ptr[ForestCompact] ptr)
+    cdef shared_ptr[ForestCompact] get(self)
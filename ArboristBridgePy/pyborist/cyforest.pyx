@@ -6,3 +6,14 @@ cdef class PyPtrVecForestNode:
         return self.thisptr
     def __repr__(self):
         return '<Pointer to vector<ForestNode>>'
+
+
+
+cdef class PyPtrForestCompact:
+    cdef set(self, shared_ptr[ForestCompact] ptr):
+        self.thisptr = ptr
+        return self
+    cdef shared_ptr[ForestCompact] get(self):
+        return self.thisptr
+    def __repr__(self):
+        return '<Pointer to ForestCompact>'
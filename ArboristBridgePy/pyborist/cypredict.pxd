@@ -2,7 +2,7 @@
 
 from libcpp.vector cimport vector
 
-from .cyforest cimport ForestNode
+from .cyforest cimport ForestCompact
 from .cyleaf cimport LeafNode
 from .cyleaf cimport BagRow
 
@@ -12,10 +12,7 @@ cdef extern from 'predict.h':
         int *_blockFacT,
         unsigned int _nPredNum,
         unsigned int _nPredFac,
-        vector[ForestNode] &_forestNode,
-        vector[unsigned int] &_origin,
-        vector[unsigned int] &_facOff,
-        vector[unsigned int] &_facSplit,
+        const ForestCompact &_forest,
         vector[unsigned int] &_leafOrigin,
         vector[LeafNode] &_leafNode,
         vector[BagRow] &_bagRow,
@@ -28,10 +25,7 @@ cdef extern from 'predict.h':
         int *_blockFacT,
         unsigned int _nPredNum,
         unsigned int _nPredFac,
-        vector[ForestNode] &_forestNode,
-        vector[unsigned int] &_origin,
-        vector[unsigned int] &_facOff,
-        vector[unsigned int] &_facSplit,
+        const ForestCompact &_forest,
         vector[unsigned int] &_leafOrigin,
         vector[LeafNode] &_leafNode,
         vector[BagRow] &_bagRow,
@@ -47,10 +41,7 @@ cdef extern from 'predict.h':
         int *_blockFacT,
         unsigned int _nPredNum,
         unsigned int _nPredFac,
-        vector[ForestNode] &_forestNode,
-        vector[unsigned int] &_origin,
-        vector[unsigned int] &_facOff,
-        vector[unsigned int] &_facSplit,
+        const ForestCompact &_forest,
         vector[unsigned int] &_leafOrigin,
         vector[LeafNode] &_leafNode,
         vector[BagRow] &_bagRow,
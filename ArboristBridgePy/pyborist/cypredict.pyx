@@ -5,7 +5,7 @@ from cython.operator cimport dereference as deref
 from libcpp cimport bool
 from libcpp.memory cimport shared_ptr, make_shared
 
-from .cyforest cimport ForestNode, PyPtrVecForestNode
+from .cyforest cimport ForestCompact, PyPtrForestCompact
 from .cyleaf cimport LeafNode, PyPtrVecLeafNode
 from .cyleaf cimport BagRow, PyPtrVecBagRow
 
@@ -16,10 +16,7 @@ cdef class PyPredict:
     def Regression(double[::view.contiguous] X not None,
         unsigned int nRow,
         unsigned int nPred,
-        unsigned int[::view.contiguous] origin not None,
-        unsigned int[::view.contiguous] facOrig not None,
-        unsigned int[::view.contiguous] facSplit not None,
-        PyPtrVecForestNode pyPtrForestNode,
+        PyPtrForestCompact pyPtrForest,
         double[::view.contiguous] yRanked,
         unsigned int[::view.contiguous] leafOrigin,
         PyPtrVecLeafNode pyPtrLeafNode,
@@ -32,10 +29,7 @@ cdef class PyPredict:
             NULL, # blockFacT
             nPred,
             0, # nPredFac
-            deref(pyPtrForestNode.get()),
-            np.asarray(origin),
-            np.asarray(facOrig),
-            np.asarray(facSplit),
+            deref(pyPtrForest.get()),
             np.asarray(leafOrigin),
             deref(pyPtrLeafNode.get()),
             deref(pyPtrBagRow.get()),
@@ -52,10 +46,7 @@ cdef class PyPredict:
         unsigned int nRow,
         unsigned int nPred,
         unsigned int ctgWidth,
-        unsigned int[::view.contiguous] origin not None,
-        unsigned int[::view.contiguous] facOrig not None,
-        unsigned int[::view.contiguous] facSplit not None,
-        PyPtrVecForestNode pyPtrForestNode,
+        PyPtrForestCompact pyPtrForest,
         unsigned int[::view.contiguous] yLevels,
         unsigned int[::view.contiguous] leafOrigin,
         PyPtrVecLeafNode pyPtrLeafNode,
@@ -74,10 +65,7 @@ cdef class PyPredict:
             NULL, # blockFacT
             nPred,
             0, # nPredFac
-            deref(pyPtrForestNode.get()),
-            np.asarray(origin),
-            np.asarray(facOrig),
-            np.asarray(facSplit),
+            deref(pyPtrForest.get()),
             np.asarray(leafOrigin),
             deref(pyPtrLeafNode.get()),
             deref(pyPtrBagRow.get()),
@@ -8,6 +8,7 @@ from cython.operator cimport dereference as deref
 from libcpp.memory cimport shared_ptr, make_shared
 
 from .cyforest cimport ForestNode, PyPtrVecForestNode
+from .cyforest cimport ForestCompact, PyPtrForestCompact
 from .cyleaf cimport LeafNode, PyPtrVecLeafNode
 from .cyleaf cimport BagRow, PyPtrVecBagRow
 
@@ -96,12 +97,17 @@ cdef class PyTrain:
             deref(ptrVecBagRow),
             rank)
 
+        # Compiles the prediction form once, alongside the trained forest.
+        cdef shared_ptr[ForestCompact] ptrForest = make_shared[ForestCompact]()
+        deref(ptrForest).Compile(deref(ptrVecForestNode), origin, facOrig, facSplit, nPred)
+
         result = {
             'forest': {
                 'origin': np.asarray(origin, dtype=np.uintc),
                 'facOrig': np.asarray(facOrig, dtype=np.uintc),
                 'facSplit': np.asarray(facSplit, dtype=np.uintc),
-                'forestNode': PyPtrVecForestNode().set(ptrVecForestNode)
+                'forestNode': PyPtrVecForestNode().set(ptrVecForestNode),
+                'compact': PyPtrForestCompact().set(ptrForest)
             },
             'leaf': {
                 'leafOrigin': np.asarray(leafOrigin, dtype=np.uintc),
@@ -186,12 +192,17 @@ cdef class PyTrain:
             deref(ptrVecBagRow),
             weight)
 
+        # Compiles the prediction form once, alongside the trained forest.
+        cdef shared_ptr[ForestCompact] ptrForest = make_shared[ForestCompact]()
+        deref(ptrForest).Compile(deref(ptrVecForestNode), origin, facOrig, facSplit, nPred)
+
         result = {
             'forest': {
                 'origin': np.asarray(origin, dtype=np.uintc),
                 'facOrig': np.asarray(facOrig, dtype=np.uintc),
                 'facSplit': np.asarray(facSplit, dtype=np.uintc),
-                'forestNode': PyPtrVecForestNode().set(ptrVecForestNode)
+                'forestNode': PyPtrVecForestNode().set(ptrVecForestNode),
+                'compact': PyPtrForestCompact().set(ptrForest)
             },
             'leaf': {
                 'leafOrigin': np.asarray(leafOrigin, dtype=np.uintc),
@@ -464,10 +464,7 @@ class PyboristModel(object):
         result = PyPredict.Regression(np.ascontiguousarray(X.reshape(X.size)),
             X.shape[0],
             X.shape[1],
-            self.estimators_['forest']['origin'],
-            self.estimators_['forest']['facOrig'],
-            self.estimators_['forest']['facSplit'],
-            self.estimators_['forest']['forestNode'],
+            self.estimators_['forest']['compact'],
             self.estimators_['leaf']['yRanked'],
             self.estimators_['leaf']['leafOrigin'],
             self.estimators_['leaf']['leafNode'],
@@ -483,10 +480,7 @@ class PyboristModel(object):
             X.shape[0],
             X.shape[1],
             self.n_classes_,
-            self.estimators_['forest']['origin'],
-            self.estimators_['forest']['facOrig'],
-            self.estimators_['forest']['facSplit'],
-            self.estimators_['forest']['forestNode'],
+            self.estimators_['forest']['compact'],
             self.estimators_['leaf']['yLevels'],
             self.estimators_['leaf']['leafOrigin'],
             self.estimators_['leaf']['leafNode'],
@@ -15,7 +15,7 @@ cp ../Shared/Makevars Rborist/src/
 cp ../Shared/?[^cpp]*.cc Rborist/src/
 
 # Hideous hack for tricking linker:
-cat ../Shared/rcppMonolithHeader ../Shared/rcppArmadillo*.cc ../Shared/rcpp[^Armadillo]*.cc > Rborist/src/rcppMonolith.cc
+cat ../Shared/rcppMonolithHeader ../Shared/rcpp*.cc > Rborist/src/rcppMonolith.cc
 
 cp ../Shared/*.h Rborist/src/
 cp ../../ArboristCore/*.cc Rborist/src/
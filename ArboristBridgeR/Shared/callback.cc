@@ -24,37 +24,10 @@
  */
 
 
-#include "rcppSample.h"
-#include "callback.h"
-
-/**
-   @brief Initializes static state parameters for row sampling.
-
-   @param _nRow is the (fixed) number of response rows.
-
-   @param _weight is the user-specified weighting of row samples.
-
-   @param _repl is true iff sampling with replacement.
-
-   @return void.
- */
-void CallBack::SampleInit(unsigned int _nRow, const double _weight[], bool _repl) {
-  RcppSample::Init(_nRow, _weight, _repl);
-}
+#include <Rcpp.h>
+using namespace Rcpp;
 
-
-/**
-   @brief Call-back to Rcpp implementation of row sampling.
-
-   @param nSamp is the number of samples to draw.
-
-   @param out[] outputs the sampled row indices.
-
-   @return Formally void, with copy-out parameter vector.
-*/
-void CallBack::SampleRows(unsigned int nSamp, int out[]) {
-  RcppSample::SampleRows(nSamp, out);
-}
+#include "callback.h"
 
 
 /**
@@ -116,3 +89,39 @@ void CallBack::QSortD(double ySorted[],  unsigned int rank2Row[], int one,  int
 }
 
 
+
+
+/**
+   @brief Wraps R's interrupt check, which does not return if an
+   interrupt is pending.
+ */
+static void CheckInterrupt(void *dummy) {
+  R_CheckUserInterrupt();
+}
+
+
+/**
+   @brief Polls for a user interrupt without unwinding the core's stack.
+
+   @return true iff an interrupt is pending.
+ */
+bool CallBack::Interrupted() {
+  return R_ToplevelExec(CheckInterrupt, NULL) == FALSE;
+}
+
+
+/**
+   @brief Reports training progress if option "Rborist.progress" is set.
+
+   @param treeDone is the number of trees trained so far.
+
+   @param nTree is the number of trees requested.
+
+   @return void.
+ */
+void CallBack::Progress(unsigned int treeDone, unsigned int nTree) {
+  Function getOption("getOption");
+  if (as<bool>(getOption("Rborist.progress", false))) {
+    Rprintf("Trained %u of %u trees\n", treeDone, nTree);
+  }
+}
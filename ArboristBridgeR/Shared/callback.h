@@ -26,13 +26,15 @@
 #ifndef ARBORIST_CALLBACK_H
 #define ARBORIST_CALLBACK_H
 
+#include <vector>
+
 class CallBack {
  public:
-  static void SampleInit(unsigned int _nRow, const double _sampleWeight[], bool _withRepl);
-  static void SampleRows(unsigned int nSamp, int out[]);
   static void RUnif(int len, double out[]);
   static void QSortI(int ySorted[], unsigned int rank2Row[], int one, int nRow);
   static void QSortD(double ySorted[], unsigned int rank2Row[], int one, int nRow);
+  static bool Interrupted();
+  static void Progress(unsigned int treeDone, unsigned int nTree);
 };
 
 #endif
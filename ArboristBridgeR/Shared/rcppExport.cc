@@ -35,6 +35,7 @@ using namespace std;
 #include "forest.h"
 #include "bv.h"
 #include "leaf.h"
+#include "bundle.h"
 
 
 /**
@@ -62,12 +63,87 @@ void PredExport(const int predMap[], std::vector<std::vector<unsigned int> > &pr
 }
 
 
+/**
+   @brief Prepares predictor field for export, resolving splits on bundles
+   into the original columns they encode.  Bundles, having no front-end
+   position, are numbered after the front-end columns.
+
+   @param sSignature is the training signature.
+
+   @param bundleNode outputs the per-tree indices of nodes splitting on a
+   bundle.
+
+   @param zeroLeft outputs, for each such node, whether rows setting none
+   of the bundle's columns go left.
+
+   @param colLeft outputs, for each such node, the front-end columns whose
+   set rows go left.
+
+   @return void, with output vector parameters.
+ */
+void BundleExport(SEXP sSignature, std::vector<std::vector<unsigned int> > &predTree, std::vector<std::vector<unsigned int> > &bumpTree, const std::vector<std::vector<double> > &splitTree, const std::vector<std::vector<unsigned int> > &facSplitTree, std::vector<std::vector<unsigned int> > &bundleNode, std::vector<std::vector<unsigned int> > &zeroLeft, std::vector<std::vector<std::vector<unsigned int> > > &colLeft) {
+  IntegerVector predMap;
+  List predLevel;
+  RcppPredblock::SignatureUnwrap(sSignature, predMap, predLevel);
+  std::vector<unsigned int> bundle, level;
+  unsigned int nBundle = RcppPredblock::BundleUnwrap(sSignature, bundle, level);
+  if (nBundle == 0) {
+    PredExport(predMap.begin(), predTree, bumpTree);
+    return;
+  }
+
+  std::vector<unsigned int> predOrig, levelOff, levelCol;
+  Bundle::Origin(bundle, level, predMap.length() - bundle.size(), nBundle, predOrig, levelOff, levelCol);
+  unsigned int bundleBase = predOrig.size() - nBundle;
+  std::vector<int> predFE(predOrig.size());
+  for (unsigned int predIdx = 0; predIdx < predOrig.size(); predIdx++) {
+    predFE[predIdx] = predIdx < bundleBase ? predMap[predOrig[predIdx]] : predMap.length() + predIdx - bundleBase;
+  }
+
+  for (unsigned int tIdx = 0; tIdx < predTree.size(); tIdx++) {
+    for (unsigned int i = 0; i < predTree[tIdx].size(); i++) {
+      if (bumpTree[tIdx][i] > 0 && predTree[tIdx][i] >= bundleBase) {
+        std::vector<unsigned int> col;
+        zeroLeft[tIdx].push_back(Bundle::SplitColumns(facSplitTree[tIdx], splitTree[tIdx][i], levelOff, levelCol, predTree[tIdx][i] - bundleBase, col));
+        for (unsigned int j = 0; j < col.size(); j++) {
+          col[j] = predMap[col[j]];
+        }
+        bundleNode[tIdx].push_back(i);
+        colLeft[tIdx].push_back(col);
+      }
+    }
+  }
+  PredExport(&predFE[0], predTree, bumpTree);
+}
+
+
+/**
+   @brief Unwraps the map from original to distinct training rows, if
+   duplicates were collapsed.
+
+   @param rowUnique outputs the zero-based distinct row of each original
+   row, or remains empty.
+
+   @param rowTrain outputs the original row count, if collapsed.
+
+   @return void, with output reference parameters.
+ */
+void RowUnique(SEXP sRowUnique, std::vector<unsigned int> &rowUnique, unsigned int &rowTrain) {
+  if (Rf_isNull(sRowUnique))
+    return;
+
+  IntegerVector uniqueZero = IntegerVector(sRowUnique) - 1;
+  rowUnique = as<std::vector<unsigned int> >(uniqueZero);
+  rowTrain = rowUnique.size();
+}
+
+
 /**
    @brief Exports core data structures as vector of per-tree vectors.
 
    @return List with common and regression-specific members.
  */
-RcppExport SEXP ExportReg(SEXP sForest, SEXP sLeaf, IntegerVector predMap) {
+RcppExport SEXP ExportReg(SEXP sForest, SEXP sLeaf, SEXP sSignature, SEXP sRowUnique) {
 
   // Instantiates the forest-wide data structures as long vectors, then
   // distributes per tree.
@@ -80,11 +156,14 @@ RcppExport SEXP ExportReg(SEXP sForest, SEXP sLeaf, IntegerVector predMap) {
   std::vector<std::vector<unsigned int> > predTree(nTree), bumpTree(nTree);
   std::vector<std::vector<double > > splitTree(nTree);
   ForestNode::Export(nodeOrigin, forestNode, predTree, bumpTree, splitTree);
-  PredExport(predMap.begin(), predTree, bumpTree);
   
   std::vector<std::vector<unsigned int> > facSplitTree(nTree);
   BVJagged::Export(facOrigin, splitBV, facSplitTree);
 
+  std::vector<std::vector<unsigned int> > bundleNodeTree(nTree), zeroLeftTree(nTree);
+  std::vector<std::vector<std::vector<unsigned int> > > colLeftTree(nTree);
+  BundleExport(sSignature, predTree, bumpTree, splitTree, facSplitTree, bundleNodeTree, zeroLeftTree, colLeftTree);
+
   std::vector<double> yRanked;
   std::vector<unsigned int> leafOrigin;
   std::vector<LeafNode> leafNode;
@@ -92,12 +171,14 @@ RcppExport SEXP ExportReg(SEXP sForest, SEXP sLeaf, IntegerVector predMap) {
   unsigned int rowTrain;
   std::vector<unsigned int> rank;
   RcppLeaf::UnwrapReg(sLeaf, yRanked, leafOrigin, leafNode, bagRow, rowTrain, rank);
+  std::vector<unsigned int> rowUnique;
+  RowUnique(sRowUnique, rowUnique, rowTrain);
 
   std::vector<std::vector<unsigned int> > rowTree(nTree), sCountTree(nTree);
   std::vector<std::vector<double> > scoreTree(nTree);
   std::vector<std::vector<unsigned int> > extentTree(nTree);
   std::vector<std::vector<unsigned int> > rankTree(nTree);
-  LeafReg::Export(leafOrigin, leafNode, bagRow, rank, rowTree, sCountTree, scoreTree, extentTree, rankTree);
+  LeafReg::Export(leafOrigin, leafNode, bagRow, rank, rowTree, sCountTree, scoreTree, extentTree, rankTree, rowUnique);
 
   List outBundle = List::create(
 				_["rowTrain"] = rowTrain,
@@ -105,6 +186,9 @@ RcppExport SEXP ExportReg(SEXP sForest, SEXP sLeaf, IntegerVector predMap) {
 				_["bump"] = bumpTree,
 				_["split"] = splitTree,
 				_["facSplit"] = facSplitTree,
+				_["bundleNode"] = bundleNodeTree,
+				_["bundleZeroLeft"] = zeroLeftTree,
+				_["bundleColLeft"] = colLeftTree,
 				_["row"] = rowTree,
 				_["sCount"] = sCountTree,
 				_["score"] = scoreTree,
@@ -122,7 +206,7 @@ RcppExport SEXP ExportReg(SEXP sForest, SEXP sLeaf, IntegerVector predMap) {
 
    @return List with common and classification-specific members.
  */
-RcppExport SEXP ExportCtg(SEXP sForest, SEXP sLeaf, IntegerVector predMap) {
+RcppExport SEXP ExportCtg(SEXP sForest, SEXP sLeaf, SEXP sSignature, SEXP sRowUnique) {
   std::vector<unsigned int> nodeOrigin, facOrigin, splitBV;
   std::vector<ForestNode> forestNode;
   RcppForest::Unwrap(sForest, nodeOrigin, facOrigin, splitBV, forestNode);
@@ -131,11 +215,14 @@ RcppExport SEXP ExportCtg(SEXP sForest, SEXP sLeaf, IntegerVector predMap) {
   std::vector<std::vector<unsigned int> > predTree(nTree), bumpTree(nTree);
   std::vector<std::vector<double > > splitTree(nTree);
   ForestNode::Export(nodeOrigin, forestNode, predTree, bumpTree, splitTree);
-  PredExport(predMap.begin(), predTree, bumpTree);
   
   std::vector<std::vector<unsigned int> > facSplitTree(nTree);
   BVJagged::Export(facOrigin, splitBV, facSplitTree);
 
+  std::vector<std::vector<unsigned int> > bundleNodeTree(nTree), zeroLeftTree(nTree);
+  std::vector<std::vector<std::vector<unsigned int> > > colLeftTree(nTree);
+  BundleExport(sSignature, predTree, bumpTree, splitTree, facSplitTree, bundleNodeTree, zeroLeftTree, colLeftTree);
+
   std::vector<unsigned int> leafOrigin;
   std::vector<LeafNode> leafNode;
   std::vector<BagRow> bagRow;
@@ -143,12 +230,14 @@ RcppExport SEXP ExportCtg(SEXP sForest, SEXP sLeaf, IntegerVector predMap) {
   std::vector<double> weight;
   CharacterVector yLevel;
   RcppLeaf::UnwrapCtg(sLeaf, leafOrigin, leafNode, bagRow, rowTrain, weight, yLevel);
+  std::vector<unsigned int> rowUnique;
+  RowUnique(sRowUnique, rowUnique, rowTrain);
 
   std::vector<std::vector<unsigned int> > rowTree(nTree), sCountTree(nTree);
   std::vector<std::vector<double> > scoreTree(nTree);
   std::vector<std::vector<unsigned int> > extentTree(nTree);
   std::vector<std::vector<double> > weightTree(nTree);
-  LeafCtg::Export(leafOrigin, leafNode, bagRow, weight, yLevel.length(), rowTree, sCountTree, scoreTree, extentTree, weightTree);
+  LeafCtg::Export(leafOrigin, leafNode, bagRow, weight, yLevel.length(), rowTree, sCountTree, scoreTree, extentTree, weightTree, rowUnique);
 
   List outBundle = List::create(
 				_["rowTrain"] = rowTrain,
@@ -156,6 +245,9 @@ RcppExport SEXP ExportCtg(SEXP sForest, SEXP sLeaf, IntegerVector predMap) {
 				_["bump"] = bumpTree,
 				_["split"] = splitTree,
 				_["facSplit"] = facSplitTree,
+				_["bundleNode"] = bundleNodeTree,
+				_["bundleZeroLeft"] = zeroLeftTree,
+				_["bundleColLeft"] = colLeftTree,
 				_["row"] = rowTree,
 				_["sCount"] = sCountTree,
 				_["score"] = scoreTree,
@@ -234,6 +326,9 @@ RcppExport SEXP FFloorInternal(SEXP sForestCore, unsigned int tIdx) {
   std::vector<std::vector<unsigned int> > bumpTree = forestCore["bump"];
   std::vector<std::vector<double > > splitTree = forestCore["split"];
   std::vector<std::vector<unsigned int> > facSplitTree = forestCore["facSplit"];
+  std::vector<std::vector<unsigned int> > bundleNodeTree = forestCore["bundleNode"];
+  std::vector<std::vector<unsigned int> > zeroLeftTree = forestCore["bundleZeroLeft"];
+  List colLeftTree = forestCore["bundleColLeft"];
   IntegerVector incrL(bumpTree[tIdx].begin(), bumpTree[tIdx].end());
   IntegerVector predIdx(predTree[tIdx].begin(), predTree[tIdx].end());
   List ffTree = List::create(
@@ -241,7 +336,10 @@ RcppExport SEXP FFloorInternal(SEXP sForestCore, unsigned int tIdx) {
      _["daughterL"] = incrL,
      _["daughterR"] = ifelse(incrL == 0, 0, incrL + 1),
      _["split"] = splitTree[tIdx],
-     _["facSplit"] = facSplitTree[tIdx]
+     _["facSplit"] = facSplitTree[tIdx],
+     _["bundleNode"] = bundleNodeTree[tIdx],
+     _["bundleZeroLeft"] = zeroLeftTree[tIdx],
+     _["bundleColLeft"] = colLeftTree[tIdx]
      );
 
   ffTree.attr("class") = "FFloorTree";
@@ -293,8 +391,11 @@ RcppExport SEXP FFloorTreeCtg(SEXP sCoreCtg, unsigned int tIdx) {
 
 /**
  */
-RcppExport SEXP FFloorReg(SEXP sForest, SEXP sLeaf, IntegerVector predMap, List predLevel) {
-  SEXP sCoreReg = ExportReg(sForest, sLeaf, predMap);
+RcppExport SEXP FFloorReg(SEXP sForest, SEXP sLeaf, SEXP sSignature, SEXP sRowUnique) {
+  IntegerVector predMap;
+  List predLevel;
+  RcppPredblock::SignatureUnwrap(sSignature, predMap, predLevel);
+  SEXP sCoreReg = ExportReg(sForest, sLeaf, sSignature, sRowUnique);
   unsigned int nTree = NTree(sCoreReg);
   List trees(nTree);
   for (unsigned int tIdx = 0; tIdx < nTree; tIdx++) {
@@ -315,8 +416,11 @@ RcppExport SEXP FFloorReg(SEXP sForest, SEXP sLeaf, IntegerVector predMap, List
 
 /**
  */
-RcppExport SEXP FFloorCtg(SEXP sForest, SEXP sLeaf, IntegerVector predMap, List predLevel) {
-  SEXP sCoreCtg = ExportCtg(sForest, sLeaf, predMap);
+RcppExport SEXP FFloorCtg(SEXP sForest, SEXP sLeaf, SEXP sSignature, SEXP sRowUnique) {
+  IntegerVector predMap;
+  List predLevel;
+  RcppPredblock::SignatureUnwrap(sSignature, predMap, predLevel);
+  SEXP sCoreCtg = ExportCtg(sForest, sLeaf, sSignature, sRowUnique);
   unsigned int nTree = NTree(sCoreCtg);
   List trees(nTree);
   for (unsigned int tIdx = 0; tIdx < nTree; tIdx++) {
@@ -351,16 +455,13 @@ RcppExport SEXP RcppForestFloorExport(SEXP sArbOut) {
     return List::create(0);
   }
 
-  IntegerVector predMap;
-  List predLevel;
-  RcppPredblock::SignatureUnwrap(arbOut["signature"], predMap, predLevel);
-
+  SEXP sRowUnique = arbOut.containsElementNamed("rowUnique") ? (SEXP) arbOut["rowUnique"] : R_NilValue;
   List leaf((SEXP) arbOut["leaf"]);
   if (leaf.inherits("LeafReg"))  {
-    return FFloorReg(arbOut["forest"], arbOut["leaf"], predMap, predLevel);
+    return FFloorReg(arbOut["forest"], arbOut["leaf"], arbOut["signature"], sRowUnique);
   }
   else if (leaf.inherits("LeafCtg")) {
-    return FFloorCtg(arbOut["forest"], arbOut["leaf"], predMap, predLevel);
+    return FFloorCtg(arbOut["forest"], arbOut["leaf"], arbOut["signature"], sRowUnique);
   }
   else {
     warning("Unrecognized forest type.");
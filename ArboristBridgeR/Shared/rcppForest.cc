@@ -26,6 +26,7 @@
 
 #include "forest.h"
 #include <Rcpp.h>
+#include <random>
 
 using namespace std;
 using namespace Rcpp;
@@ -34,24 +35,90 @@ using namespace Rcpp;
 
 //#include <iostream>
 
-SEXP RcppForest::Wrap(const std::vector<unsigned int> &origin, const std::vector<unsigned int> &facOrigin, const std::vector<unsigned int> &facSplit, const std::vector<ForestNode> &forestNode) {
-  unsigned int rawSize = forestNode.size() * sizeof(ForestNode);
-  RawVector fnRaw(rawSize);
+/**
+   @brief Copies a vector of core records into a raw vector.
+ */
+template<typename T> static RawVector RawWrap(const std::vector<T> &vec) {
+  unsigned int rawSize = vec.size() * sizeof(T);
+  RawVector raw(rawSize);
+  for (unsigned int i = 0; i < rawSize; i++) {
+    raw[i] = ((const unsigned char*) &vec[0])[i];
+  }
+
+  return raw;
+}
+
+
+/**
+   @brief Copies a raw vector back into a vector of core records.
+ */
+template<typename T> static void RawUnwrap(const RawVector &raw, std::vector<T> &vec) {
+  unsigned int rawSize = raw.length();
+  vec = std::vector<T>(rawSize / sizeof(T));
   for (unsigned int i = 0; i < rawSize; i++) {
-    fnRaw[i] = ((unsigned char*) &forestNode[0])[i];
+    ((unsigned char*) &vec[0])[i] = raw[i];
   }
+}
+
+
+/**
+   @brief Wraps a newly-trained forest, together with its inference
+   form.  The latter is compiled here, once per model, so that
+   prediction need not rebuild it on every call.
+
+   @param nPredNum is the number of numeric predictors in training.
+
+   @return wrapped forest.
+ */
+SEXP RcppForest::Wrap(const std::vector<unsigned int> &origin, const std::vector<unsigned int> &facOrigin, const std::vector<unsigned int> &facSplit, const std::vector<ForestNode> &forestNode, unsigned int nPredNum) {
+  ForestCompact compact;
+  compact.Compile(forestNode, origin, facOrigin, facSplit, nPredNum);
 
   List forest = List::create(
-     _["forestNode"] = fnRaw,
+     _["forestNode"] = RawWrap(forestNode),
      _["origin"] = origin,
      _["facOrig"] = facOrigin,
-     _["facSplit"] = facSplit);
+     _["facSplit"] = facSplit,
+     _["modelId"] = NewId(),
+     _["predictNode"] = RawWrap(compact.predictNode),
+     _["farNode"] = RawWrap(compact.farNode),
+     _["facMask"] = RawWrap(compact.facMask),
+     _["cut"] = compact.cut,
+     _["cutOrigin"] = compact.cutOrigin);
   forest.attr("class") = "Forest";
 
   return forest;
 }
 
 
+/**
+   @brief Draws an identifier for a newly-trained forest, by which the
+   core's prediction cache recognizes its rows.  Draws avoid R's generator,
+   so that training leaves the session's random stream undisturbed.
+
+   @return nonzero identifier, representable exactly as a double.
+ */
+double RcppForest::NewId() {
+  std::random_device rd;
+  unsigned long long id = ((unsigned long long) rd() << 32 | rd()) & ((1ull << 52) - 1);
+
+  return id == 0 ? 1.0 : (double) id;
+}
+
+
+/**
+   @brief Reads the forest's identifier.
+
+   @param sForest is the front-end forest.
+
+   @return identifier, or zero if the forest predates identifiers.
+ */
+unsigned long long RcppForest::ModelId(SEXP sForest) {
+  List forest(sForest);
+  return forest.containsElementNamed("modelId") ? (unsigned long long) as<double>(forest["modelId"]) : 0;
+}
+
+
 /**
    @brief Exposes front-end Forest fields for transmission to core.
 
@@ -62,16 +129,46 @@ void RcppForest::Unwrap(SEXP sForest, std::vector<unsigned int> &_origin, std::v
   if (!forest.inherits("Forest"))
     stop("Expecting Forest");
 
-  RawVector fnRaw = forest["forestNode"];
-  unsigned int rawSize = fnRaw.length();
-  std::vector<ForestNode> forestNode(rawSize / sizeof(ForestNode));
-  for (unsigned int i = 0; i < rawSize; i++) {
-    ((unsigned char*) &forestNode[0])[i] = fnRaw[i];
-  }
-  
+  std::vector<ForestNode> forestNode;
+  RawUnwrap(as<RawVector>(forest["forestNode"]), forestNode);
 
   _origin = as<std::vector<unsigned int> >(forest["origin"]);
   _facOrig = as<std::vector<unsigned int> >(forest["facOrig"]);
   _facSplit = as<std::vector<unsigned int> >(forest["facSplit"]);
   _forestNode = std::move(forestNode);
 }
+
+
+/**
+   @brief Exposes the inference form of a front-end Forest to the core.
+   Training nodes are not read, save for forests wrapped before the
+   inference form was kept, which are compiled here.
+
+   @param nPredNum is the number of numeric predictors.
+
+   @param compact outputs the compiled forest.
+
+   @return void, with output reference parameter.
+ */
+void RcppForest::UnwrapCompact(SEXP sForest, unsigned int nPredNum, ForestCompact &compact) {
+  List forest(sForest);
+  if (!forest.inherits("Forest"))
+    stop("Expecting Forest");
+
+  if (!forest.containsElementNamed("predictNode")) {
+    std::vector<unsigned int> origin, facOrig, facSplit;
+    std::vector<ForestNode> forestNode;
+    Unwrap(sForest, origin, facOrig, facSplit, forestNode);
+    compact.Compile(forestNode, origin, facOrig, facSplit, nPredNum);
+    return;
+  }
+
+  compact.treeOrigin = as<std::vector<unsigned int> >(forest["origin"]);
+  compact.facOrigin = as<std::vector<unsigned int> >(forest["facOrig"]);
+  compact.facVec = as<std::vector<unsigned int> >(forest["facSplit"]);
+  RawUnwrap(as<RawVector>(forest["predictNode"]), compact.predictNode);
+  RawUnwrap(as<RawVector>(forest["farNode"]), compact.farNode);
+  RawUnwrap(as<RawVector>(forest["facMask"]), compact.facMask);
+  compact.cut = as<std::vector<double> >(forest["cut"]);
+  compact.cutOrigin = as<std::vector<unsigned int> >(forest["cutOrigin"]);
+}
@@ -31,10 +31,15 @@
 using namespace Rcpp;
 
 class RcppForest {
+  static double NewId();
  public:
-  static SEXP Wrap(const std::vector<unsigned int> &origin, const std::vector<unsigned int> &facOrigin, const std::vector<unsigned int> &facSplit, const std::vector<class ForestNode> &test);
+  static SEXP Wrap(const std::vector<unsigned int> &origin, const std::vector<unsigned int> &facOrigin, const std::vector<unsigned int> &facSplit, const std::vector<class ForestNode> &test, unsigned int nPredNum);
+
+  static unsigned long long ModelId(SEXP sForest);
 
   static void Unwrap(SEXP sForest, std::vector<unsigned int> &_origin, std::vector<unsigned int> &_facOrig, std::vector<unsigned int> &_facSplit, std::vector<class ForestNode> &_forestNode);
+
+  static void UnwrapCompact(SEXP sForest, unsigned int nPredNum, class ForestCompact &compact);
 };
 
 #endif
@@ -30,8 +30,11 @@
 
 /**
    @brief Wraps core (regression) Leaf vectors for reference by front end.
+
+   @param score holds the multi-output leaf scores, leaf-major, or is
+   empty if single-output.
  */
-SEXP RcppLeaf::WrapReg(const std::vector<unsigned int> &leafOrigin, std::vector<LeafNode> &leafNode, const std::vector<BagRow> &bagRow, unsigned int rowTrain, const std::vector<unsigned int> &rank, const std::vector<double> &yRanked) {
+SEXP RcppLeaf::WrapReg(const std::vector<unsigned int> &leafOrigin, std::vector<LeafNode> &leafNode, const std::vector<BagRow> &bagRow, unsigned int rowTrain, const std::vector<unsigned int> &rank, const std::vector<double> &yRanked, const std::vector<double> &score) {
   // Serializes the two internally-typed objects, 'LeafNode' and 'BagRow'.
   //
   unsigned int rawSize = leafNode.size() * sizeof(LeafNode);
@@ -52,7 +55,8 @@ SEXP RcppLeaf::WrapReg(const std::vector<unsigned int> &leafOrigin, std::vector<
    _["bagRow"] = BRRaw,
    _["rowTrain"] = rowTrain,
    _["rank"] = rank,
-   _["yRanked"] = yRanked
+   _["yRanked"] = yRanked,
+   _["score"] = score
   );
   leaf.attr("class") = "LeafReg";
   
@@ -101,6 +105,26 @@ void RcppLeaf::UnwrapReg(SEXP sLeaf, std::vector<double> &_yRanked, std::vector<
 }
 
 
+/**
+   @brief Exposes the multi-output scores of a (regression) Leaf.
+
+   @param sLeaf is the R object containing the leaf (list) data.
+
+   @param _score outputs the leaf scores, leaf-major, or is empty if the
+   forest is single-output.
+
+   @return void, with output reference parameter.
+ */
+void RcppLeaf::UnwrapScore(SEXP sLeaf, std::vector<double> &_score) {
+  List leaf(sLeaf);
+  if (!leaf.inherits("LeafReg"))
+    stop("Expecting LeafReg");
+
+  // Leaves saved before multi-output support carry no scores.
+  _score = leaf.containsElementNamed("score") ? as<std::vector<double> >(leaf["score"]) : std::vector<double>();
+}
+
+
 /**
    @brief Wraps core (classification) Leaf vectors for reference by front end.
  */
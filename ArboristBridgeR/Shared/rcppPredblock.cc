@@ -28,6 +28,9 @@
 
 #include "rcppPredblock.h"
 #include "rowrank.h"
+#include "predblock.h"
+#include "bundle.h"
+#include "dedup.h"
 
 
 /**
@@ -125,27 +128,21 @@ RcppExport SEXP RcppPredBlockFrame(SEXP sX, SEXP sNumElt, SEXP sFacElt, SEXP sLe
 }
 
 
+/**
+   @brief Hands test and training level names to the core, which recodes
+   the factor block to the training level order.
+
+   @return void.
+ */
 void RcppPredblock::FactorRemap(IntegerMatrix &xFac, List &levelTest, List &levelTrain) {
+  std::vector<std::vector<std::string> > colTest(xFac.ncol());
+  std::vector<std::vector<std::string> > colTrain(xFac.ncol());
   for (int col = 0; col < xFac.ncol(); col++) {
-    CharacterVector colTest(as<CharacterVector>(levelTest[col]));
-    CharacterVector colTrain(as<CharacterVector>(levelTrain[col]));
-    if (is_true(any(colTest != colTrain))) {
-      IntegerVector colMatch = match(colTest, colTrain);
-      IntegerVector sq = seq(0, colTest.length() - 1);
-      IntegerVector idxNonMatch = sq[is_na(colMatch)];
-      if (idxNonMatch.length() > 0) {
-	warning("Factor levels not observed in training:  employing proxy");
-	int proxy = colTrain.length() + 1;
-	colMatch[idxNonMatch] = proxy;
-      }
-
-      colMatch = colMatch - 1;  // match() is one-based.
-      IntegerMatrix::Column xCol = xFac(_, col);
-      IntegerVector colT(xCol);
-      IntegerVector colRemap = colMatch[colT];
-      xFac(_, col) = colRemap;
-    }
+    colTest[col] = as<std::vector<std::string> >(levelTest[col]);
+    colTrain[col] = as<std::vector<std::string> >(levelTrain[col]);
   }
+  if (PBPredict::FactorRemap(xFac.begin(), xFac.nrow(), colTest, colTrain))
+    warning("Factor levels not observed in training:  employing proxy");
 }
 
 
@@ -177,6 +174,199 @@ RcppExport SEXP RcppPredBlockNum(SEXP sX) {
 }
 
 
+/**
+   @brief Bundles mutually-exclusive indicator columns of a training block
+   into factors.  The bundle map is recorded in the signature, which
+   accompanies the trained forest.
+
+   @param sPredBlock is the unbundled block.
+
+   @param sCardMax bounds the cardinality of a bundle.
+
+   @return PredBlock in bundled form, or the original if nothing bundles.
+ */
+RcppExport SEXP RcppPredBlockBundle(SEXP sPredBlock, SEXP sCardMax) {
+  unsigned int nRow, nPredNum, nPredFac;
+  NumericMatrix blockNum;
+  IntegerMatrix blockFac;
+  RcppPredblock::Unwrap(sPredBlock, nRow, nPredNum, nPredFac, blockNum, blockFac);
+  List predBlock(sPredBlock);
+
+  std::vector<unsigned int> bundle, level;
+  unsigned int nBundle = nPredNum > 0 ? Bundle::Detect(blockNum.begin(), nPredNum, nRow, as<unsigned int>(sCardMax), bundle, level) : 0;
+  if (nBundle == 0)
+    return predBlock;
+
+  std::vector<unsigned int> feFac(blockFac.begin(), blockFac.end());
+  std::vector<unsigned int> facCard(as<std::vector<unsigned int> >(predBlock["facCard"]));
+  std::vector<double> numOut;
+  std::vector<unsigned int> facOut, cardOut;
+  Bundle::Encode(blockNum.begin(), nPredFac > 0 ? &feFac[0] : 0, nPredFac > 0 ? &facCard[0] : 0, nPredNum, nPredFac, nRow, bundle, level, nBundle, numOut, facOut, cardOut);
+  unsigned int nNumOut = numOut.size() / nRow;
+  unsigned int nFacOut = cardOut.size();
+
+  std::vector<unsigned int> predOrig, levelOff, levelCol;
+  Bundle::Origin(bundle, level, nPredFac, nBundle, predOrig, levelOff, levelCol);
+  IntegerVector origOut(predOrig.size());
+  for (unsigned int predIdx = 0; predIdx < predOrig.size(); predIdx++) {
+    origOut[predIdx] = predOrig[predIdx] == Bundle::noBundle ? NA_INTEGER : predOrig[predIdx] + 1;
+  }
+
+  List sigTrain(as<List>(predBlock["signature"]));
+  IntegerVector predMap(as<IntegerVector>(sigTrain["predMap"]));
+  SEXP sColNames = predBlock["colNames"];
+  CharacterVector colNames(0);
+  if (!Rf_isNull(sColNames)) {
+    CharacterVector colTrain(sColNames);
+    colNames = CharacterVector(predOrig.size());
+    for (unsigned int predIdx = 0; predIdx < predOrig.size(); predIdx++) {
+      if (predOrig[predIdx] == Bundle::noBundle)
+        colNames[predIdx] = "bundle" + std::to_string(predIdx - nNumOut - nPredFac + 1);
+      else
+        colNames[predIdx] = colTrain[predMap[predOrig[predIdx]]];
+    }
+  }
+
+  List signature = List::create(
+        _["predMap"] = predMap,
+        _["level"] = sigTrain["level"],
+        _["bundle"] = bundle,
+        _["bundleLevel"] = level,
+        _["nBundle"] = nBundle,
+        _["predOrig"] = origOut
+	);
+  signature.attr("class") = "Signature";
+
+  List bundled = List::create(
+      _["colNames"] = Rf_isNull(sColNames) ? sColNames : (SEXP) colNames,
+      _["rowNames"] = predBlock["rowNames"],
+      _["blockNum"] = nNumOut > 0 ? NumericMatrix(nRow, nNumOut, numOut.begin()) : NumericMatrix(0, 0),
+      _["nPredNum"] = nNumOut,
+      _["blockFac"] = IntegerMatrix(nRow, nFacOut, facOut.begin()),
+      _["nPredFac"] = nFacOut,
+      _["nRow"] = nRow,
+      _["facCard"] = IntegerVector(cardOut.begin(), cardOut.end()),
+      _["signature"] = signature
+      );
+  bundled.attr("class") = "PredBlock";
+
+  return bundled;
+}
+
+
+/**
+   @brief Rewrites a prediction block in the bundled form of its training
+   block.
+
+   @param sSigTrain is the training signature, holding the bundle map.
+
+   @return PredBlock in bundled form.
+ */
+RcppExport SEXP RcppPredBlockBundleT(SEXP sPredBlock, SEXP sSigTrain) {
+  unsigned int nRow, nPredNum, nPredFac;
+  NumericMatrix blockNum;
+  IntegerMatrix blockFac;
+  RcppPredblock::Unwrap(sPredBlock, nRow, nPredNum, nPredFac, blockNum, blockFac);
+  std::vector<unsigned int> bundle, level;
+  unsigned int nBundle = RcppPredblock::BundleUnwrap(sSigTrain, bundle, level);
+  if (bundle.size() != nPredNum)
+    stop("Signature mismatch");
+
+  std::vector<double> numOutT;
+  std::vector<int> facOutT;
+  Bundle::EncodeT(transpose(blockNum).begin(), nPredFac > 0 ? transpose(blockFac).begin() : 0, nPredNum, nPredFac, nRow, bundle, level, nBundle, numOutT, facOutT);
+  unsigned int nNumOut = nRow > 0 ? numOutT.size() / nRow : 0;
+  unsigned int nFacOut = nPredFac + nBundle;
+
+  std::vector<unsigned int> predOrig, levelOff, levelCol;
+  Bundle::Origin(bundle, level, nPredFac, nBundle, predOrig, levelOff, levelCol);
+  List predBlock(sPredBlock);
+  IntegerVector facTest(as<IntegerVector>(predBlock["facCard"]));
+  IntegerVector facCard(nFacOut);
+  for (unsigned int facIdx = 0; facIdx < nPredFac; facIdx++) {
+    facCard[facIdx] = facTest[facIdx];
+  }
+  for (unsigned int bIdx = 0; bIdx < nBundle; bIdx++) {
+    facCard[nPredFac + bIdx] = levelOff[bIdx + 1] - levelOff[bIdx];
+  }
+
+  List bundled = List::create(
+      _["colNames"] = R_NilValue,
+      _["rowNames"] = predBlock["rowNames"],
+      _["blockNum"] = nNumOut > 0 ? transpose(NumericMatrix(nNumOut, nRow, numOutT.begin())) : NumericMatrix(0, 0),
+      _["nPredNum"] = nNumOut,
+      _["blockFac"] = transpose(IntegerMatrix(nFacOut, nRow, facOutT.begin())),
+      _["nPredFac"] = nFacOut,
+      _["nRow"] = nRow,
+      _["facCard"] = facCard,
+      _["signature"] = predBlock["signature"]
+      );
+  bundled.attr("class") = "PredBlock";
+
+  return bundled;
+}
+
+
+/**
+   @brief Collapses training rows duplicated in both predictors and
+   response, for training as distinct rows weighted by multiplicity.
+
+   @param sY is the response, with factors passed by code.
+
+   @return List of the collapsed PredBlock, the one-based distinct row of
+   each original row, the one-based representative of each distinct row and
+   the multiplicities, or NULL if all rows are distinct.
+ */
+RcppExport SEXP RcppDedup(SEXP sPredBlock, SEXP sY) {
+  unsigned int nRow, nPredNum, nPredFac;
+  NumericMatrix blockNum;
+  IntegerMatrix blockFac;
+  RcppPredblock::Unwrap(sPredBlock, nRow, nPredNum, nPredFac, blockNum, blockFac);
+  NumericVector y = as<NumericVector>(sY);
+  if ((unsigned int) y.length() != nRow)
+    stop("Response length must match row count");
+
+  std::vector<unsigned int> feFac(blockFac.begin(), blockFac.end());
+  std::vector<unsigned int> rowUnique, mult;
+  unsigned int nUnique = Dedup::Collapse(blockNum.begin(), nPredFac > 0 ? &feFac[0] : 0, y.begin(), nPredNum, nPredFac, nRow, rowUnique, mult);
+  if (nUnique == nRow)
+    return R_NilValue;
+
+  std::vector<double> numOut, yOut;
+  std::vector<unsigned int> facOut;
+  Dedup::Gather(blockNum.begin(), nPredFac > 0 ? &feFac[0] : 0, y.begin(), nPredNum, nPredFac, nRow, rowUnique, nUnique, numOut, facOut, yOut);
+
+  IntegerVector uniqueOut(nRow);
+  IntegerVector rowRep(nUnique);
+  for (unsigned int row = 0; row < nRow; row++) {
+    uniqueOut[row] = rowUnique[row] + 1;
+    if (rowRep[rowUnique[row]] == 0)
+      rowRep[rowUnique[row]] = row + 1;
+  }
+
+  List predBlock(sPredBlock);
+  List collapsed = List::create(
+      _["colNames"] = predBlock["colNames"],
+      _["rowNames"] = R_NilValue,
+      _["blockNum"] = nPredNum > 0 ? NumericMatrix(nUnique, nPredNum, numOut.begin()) : NumericMatrix(0, 0),
+      _["nPredNum"] = nPredNum,
+      _["blockFac"] = nPredFac > 0 ? IntegerMatrix(nUnique, nPredFac, facOut.begin()) : IntegerMatrix(0),
+      _["nPredFac"] = nPredFac,
+      _["nRow"] = nUnique,
+      _["facCard"] = predBlock["facCard"],
+      _["signature"] = predBlock["signature"]
+      );
+  collapsed.attr("class") = "PredBlock";
+
+  return List::create(
+      _["predBlock"] = collapsed,
+      _["rowUnique"] = uniqueOut,
+      _["rowRep"] = rowRep,
+      _["obsWeight"] = IntegerVector(mult.begin(), mult.end())
+      );
+}
+
+
 /**
    @brief Unwraps field values useful for prediction.
  */
@@ -203,3 +393,25 @@ void RcppPredblock::SignatureUnwrap(SEXP sSignature, IntegerVector &_predMap, Li
   _predMap = as<IntegerVector>((SEXP) signature["predMap"]);
   _level = as<List>(signature["level"]);
 }
+
+
+/**
+   @brief Unwraps the bundle map, if any, recorded in a training signature.
+
+   @param _bundle outputs the bundle index of each numeric column.
+
+   @param _level outputs the level of each bundled column.
+
+   @return count of bundles, with output vector parameters.
+ */
+unsigned int RcppPredblock::BundleUnwrap(SEXP sSignature, std::vector<unsigned int> &_bundle, std::vector<unsigned int> &_level) {
+  List signature(sSignature);
+  if (!signature.inherits("Signature"))
+    stop("Expecting Signature");
+  if (!signature.containsElementNamed("nBundle"))
+    return 0;
+
+  _bundle = as<std::vector<unsigned int> >(signature["bundle"]);
+  _level = as<std::vector<unsigned int> >(signature["bundleLevel"]);
+  return as<unsigned int>(signature["nBundle"]);
+}
@@ -29,6 +29,7 @@
 #define ARBORIST_RCPP_PREDBLOCK_H
 
 #include <Rcpp.h>
+#include <vector>
 using namespace Rcpp;
 
 class RcppPredblock {
@@ -36,6 +37,7 @@ class RcppPredblock {
   static void Unwrap(SEXP sPredBlock, unsigned int &_nRow, unsigned int &_nPredNum, unsigned int &_nPredFac, NumericMatrix &_blockNum, IntegerMatrix &_blockFac);
   static void SignatureUnwrap(SEXP sSignature, IntegerVector &_predMap, List &_level);
   static void FactorRemap(IntegerMatrix &xFac, List &level, List &levelTrain);
+  static unsigned int BundleUnwrap(SEXP sSignature, std::vector<unsigned int> &_bundle, std::vector<unsigned int> &_level);
 };
 
 
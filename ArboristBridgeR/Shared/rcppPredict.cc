@@ -34,6 +34,8 @@ using namespace Rcpp;
 #include "predict.h"
 #include "forest.h"
 #include "leaf.h"
+#include "predcache.h"
+#include "parallel.h"
 
 #include <algorithm>
 //#include <iostream>
@@ -63,19 +65,61 @@ double MSE(const double yValid[], NumericVector y, double &rsq) {
 
 
 /**
-   @brief Predction for regression.
+   @brief Converts the front end's tree selection to zero-based indices.
+
+   @param sTrees is a vector of one-based tree indices, or null.
+
+   @return selected tree indices, empty if all trees consulted.
+ */
+static std::vector<unsigned int> TreeSel(SEXP sTrees) {
+  std::vector<unsigned int> treeSel;
+  if (!Rf_isNull(sTrees)) {
+    IntegerVector trees(sTrees);
+    for (int i = 0; i < trees.length(); i++)
+      treeSel.push_back(trees[i] - 1);
+  }
+
+  return treeSel;
+}
+
+
+/**
+   @brief Utility for computing mean-square error of each output of a
+   multi-output prediction.
+
+   @param yPred holds the predictions, one column per output.
+
+   @param yTest holds the test responses, conforming to 'yPred'.
+
+   @param rsq outputs the r-squared statistic of each output.
+
+   @return mean-square error of each output, with output parameter.
+ */
+NumericVector MSEMulti(NumericMatrix yPred, NumericMatrix yTest, NumericVector &rsq) {
+  NumericVector mse(yPred.ncol());
+  rsq = NumericVector(yPred.ncol());
+  for (int outIdx = 0; outIdx < yPred.ncol(); outIdx++) {
+    mse[outIdx] = MSE(&yPred(0, outIdx), yTest(_, outIdx), rsq[outIdx]);
+  }
+
+  return mse;
+}
+
+
+/**
+   @brief Predction for regression.  Multi-output forests predict a
+   matrix, with one column per output.
 
    @return Wrapped zero, with copy-out parameters.
  */
-RcppExport SEXP RcppPredictReg(SEXP sPredBlock, SEXP sForest, SEXP sLeaf, SEXP sYTest, bool bag) {
+RcppExport SEXP RcppPredictReg(SEXP sPredBlock, SEXP sForest, SEXP sLeaf, SEXP sYTest, bool bag, const std::vector<unsigned int> &treeSel) {
   unsigned int nPredNum, nPredFac, nRow;
   NumericMatrix blockNum;
   IntegerMatrix blockFac;
   RcppPredblock::Unwrap(sPredBlock, nRow, nPredNum, nPredFac, blockNum, blockFac);
 
-  std::vector<unsigned int> origin, facOrig, facSplit;
-  std::vector<ForestNode> forestNode;
-  RcppForest::Unwrap(sForest, origin, facOrig, facSplit, forestNode);
+  ForestCompact forest;
+  RcppForest::UnwrapCompact(sForest, nPredNum, forest);
   
   std::vector<double> yRanked;
   std::vector<unsigned int> leafOrigin;
@@ -84,9 +128,42 @@ RcppExport SEXP RcppPredictReg(SEXP sPredBlock, SEXP sForest, SEXP sLeaf, SEXP s
   unsigned int rowTrain;
   std::vector<unsigned int> rank;
   RcppLeaf::UnwrapReg(sLeaf, yRanked, leafOrigin, leafNode, bagRow, rowTrain, rank);
+  std::vector<double> score;
+  RcppLeaf::UnwrapScore(sLeaf, score);
+
+  if (!score.empty()) {
+    unsigned int nOut = score.size() / leafNode.size();
+    std::vector<double> yOut(nRow * nOut);
+    Predict::RegressionMulti(nPredNum > 0 ? transpose(blockNum).begin() : 0, nPredFac > 0 ? transpose(blockFac).begin() : 0, nPredNum, nPredFac, forest, leafOrigin, leafNode, bagRow, rank, score, yRanked, yOut, bag ? rowTrain : 0, treeSel, RcppForest::ModelId(sForest));
+    NumericMatrix yPred(transpose(NumericMatrix(nOut, nRow, yOut.begin())));
+
+    List prediction;
+    if (Rf_isNull(sYTest)) {
+      prediction = List::create(
+	_["yPred"] = yPred,
+	_["qPred"] = NumericMatrix(0)
+      );
+      prediction.attr("class") = "PredictReg";
+    }
+    else {
+      NumericMatrix yTest(sYTest);
+      if (yTest.nrow() != (int) nRow || yTest.ncol() != (int) nOut)
+	stop("Test matrix must conform to prediction");
+      NumericVector rsq;
+      NumericVector mse = MSEMulti(yPred, yTest, rsq);
+      prediction = List::create(
+	_["yPred"] = yPred,
+	_["mse"] = mse,
+	_["rsq"] = rsq,
+	_["qPred"] = NumericMatrix(0)
+      );
+      prediction.attr("class") = "ValidReg";
+    }
+    return prediction;
+  }
 
   std::vector<double> yPred(nRow);
-  Predict::Regression(nPredNum > 0 ? transpose(blockNum).begin() : 0, nPredFac > 0 ? transpose(blockFac).begin() : 0, nPredNum, nPredFac, forestNode, origin, facOrig, facSplit, leafOrigin, leafNode, bagRow, rank, yRanked, yPred, bag ? rowTrain : 0);
+  Predict::Regression(nPredNum > 0 ? transpose(blockNum).begin() : 0, nPredFac > 0 ? transpose(blockFac).begin() : 0, nPredNum, nPredFac, forest, leafOrigin, leafNode, bagRow, rank, yRanked, yPred, bag ? rowTrain : 0, treeSel, RcppForest::ModelId(sForest));
 
   List prediction;
   if (Rf_isNull(sYTest)) { // Prediction
@@ -114,12 +191,12 @@ RcppExport SEXP RcppPredictReg(SEXP sPredBlock, SEXP sForest, SEXP sLeaf, SEXP s
 
 
 RcppExport SEXP RcppValidateReg(SEXP sPredBlock, SEXP sForest, SEXP sLeaf, SEXP sYTest) {
-  return RcppPredictReg(sPredBlock, sForest, sLeaf, sYTest, true);
+  return RcppPredictReg(sPredBlock, sForest, sLeaf, sYTest, true, std::vector<unsigned int>());
 }
 
 
-RcppExport SEXP RcppTestReg(SEXP sPredBlock, SEXP sForest, SEXP sLeaf, SEXP sYTest) {
-  return RcppPredictReg(sPredBlock, sForest, sLeaf, sYTest, false);
+RcppExport SEXP RcppTestReg(SEXP sPredBlock, SEXP sForest, SEXP sLeaf, SEXP sYTest, SEXP sTrees) {
+  return RcppPredictReg(sPredBlock, sForest, sLeaf, sYTest, false, TreeSel(sTrees));
 }
 
 
@@ -128,15 +205,14 @@ RcppExport SEXP RcppTestReg(SEXP sPredBlock, SEXP sForest, SEXP sLeaf, SEXP sYTe
 
    @return Prediction list.
  */
-RcppExport SEXP RcppPredictCtg(SEXP sPredBlock, SEXP sForest, SEXP sLeaf, SEXP sYTest, bool bag, bool doProb) {
+RcppExport SEXP RcppPredictCtg(SEXP sPredBlock, SEXP sForest, SEXP sLeaf, SEXP sYTest, bool bag, bool doProb, const std::vector<unsigned int> &treeSel, double earlyTol) {
   unsigned int nPredNum, nPredFac, nRow;
   NumericMatrix blockNum;
   IntegerMatrix blockFac;
   RcppPredblock::Unwrap(sPredBlock, nRow, nPredNum, nPredFac, blockNum, blockFac);
     
-  std::vector<unsigned int> origin, facOrig, facSplit;
-  std::vector<ForestNode> forestNode;
-  RcppForest::Unwrap(sForest, origin, facOrig, facSplit, forestNode);
+  ForestCompact forest;
+  RcppForest::UnwrapCompact(sForest, nPredNum, forest);
 
   std::vector<unsigned int> leafOrigin;
   std::vector<LeafNode> leafNode;
@@ -191,7 +267,8 @@ RcppExport SEXP RcppPredictCtg(SEXP sPredBlock, SEXP sForest, SEXP sLeaf, SEXP s
   IntegerVector censusCore = IntegerVector(nRow * ctgWidth);
   std::vector<int> yPred(nRow);
   NumericVector probCore = doProb ? NumericVector(nRow * ctgWidth) : NumericVector(0);
-  Predict::Classification(nPredNum > 0 ? transpose(blockNum).begin() : 0, nPredFac > 0 ? transpose(blockFac).begin() : 0, nPredNum, nPredFac, forestNode, origin, facOrig, facSplit, leafOrigin, leafNode, bagRow, weight, yPred, censusCore.begin(), testCore, validate ? confCore.begin() : 0, misPredCore, doProb ? probCore.begin() : 0, bag ? rowTrain : 0);
+  std::vector<unsigned int> treesUsed(earlyTol < 0.0 ? 0 : nRow);
+  Predict::Classification(nPredNum > 0 ? transpose(blockNum).begin() : 0, nPredFac > 0 ? transpose(blockFac).begin() : 0, nPredNum, nPredFac, forest, leafOrigin, leafNode, bagRow, weight, yPred, censusCore.begin(), testCore, validate ? confCore.begin() : 0, misPredCore, doProb ? probCore.begin() : 0, bag ? rowTrain : 0, treeSel, earlyTol, earlyTol < 0.0 ? 0 : &treesUsed[0], RcppForest::ModelId(sForest));
 
   List predBlock(sPredBlock);
   IntegerMatrix census = transpose(IntegerMatrix(ctgWidth, nRow, censusCore.begin()));
@@ -239,18 +316,21 @@ RcppExport SEXP RcppPredictCtg(SEXP sPredBlock, SEXP sForest, SEXP sLeaf, SEXP s
    );
    prediction.attr("class") = "PredictCtg";
   }
+  if (earlyTol >= 0.0) {
+    prediction["treesUsed"] = IntegerVector(treesUsed.begin(), treesUsed.end());
+  }
 
   return prediction;
 }
 
 
 RcppExport SEXP RcppValidateVotes(SEXP sPredBlock, SEXP sForest, SEXP sLeaf, SEXP sYTest) {
-  return RcppPredictCtg(sPredBlock, sForest, sLeaf, sYTest, true, false);
+  return RcppPredictCtg(sPredBlock, sForest, sLeaf, sYTest, true, false, std::vector<unsigned int>(), -1.0);
 }
 
 
 RcppExport SEXP RcppValidateProb(SEXP sPredBlock, SEXP sForest, SEXP sLeaf, SEXP sYTest) {
-  return RcppPredictCtg(sPredBlock, sForest, sLeaf, sYTest, true, true);
+  return RcppPredictCtg(sPredBlock, sForest, sLeaf, sYTest, true, true, std::vector<unsigned int>(), -1.0);
 }
 
 
@@ -265,10 +345,14 @@ RcppExport SEXP RcppValidateProb(SEXP sPredBlock, SEXP sForest, SEXP sLeaf, SEXP
 
    @param sVotes outputs the vote predictions.
 
+   @param sTrees lists the one-based trees to consult, or is null if all.
+
+   @param sEarlyTol is the early-exit tolerance, or negative if disabled.
+
    @return Prediction object.
  */
-RcppExport SEXP RcppTestVotes(SEXP sPredBlock, SEXP sForest, SEXP sLeaf, SEXP sYTest) {
-  return RcppPredictCtg(sPredBlock, sForest, sLeaf, sYTest, false, false);
+RcppExport SEXP RcppTestVotes(SEXP sPredBlock, SEXP sForest, SEXP sLeaf, SEXP sYTest, SEXP sTrees, SEXP sEarlyTol) {
+  return RcppPredictCtg(sPredBlock, sForest, sLeaf, sYTest, false, false, TreeSel(sTrees), as<double>(sEarlyTol));
 }
 
 
@@ -283,10 +367,14 @@ RcppExport SEXP RcppTestVotes(SEXP sPredBlock, SEXP sForest, SEXP sLeaf, SEXP sY
 
    @param sVotes outputs the vote predictions.
 
+   @param sTrees lists the one-based trees to consult, or is null if all.
+
+   @param sEarlyTol is the early-exit tolerance, or negative if disabled.
+
    @return Prediction object.
  */
-RcppExport SEXP RcppTestProb(SEXP sPredBlock, SEXP sForest, SEXP sLeaf, SEXP sYTest) {
-  return RcppPredictCtg(sPredBlock, sForest, sLeaf, sYTest, false, true);
+RcppExport SEXP RcppTestProb(SEXP sPredBlock, SEXP sForest, SEXP sLeaf, SEXP sYTest, SEXP sTrees, SEXP sEarlyTol) {
+  return RcppPredictCtg(sPredBlock, sForest, sLeaf, sYTest, false, true, TreeSel(sTrees), as<double>(sEarlyTol));
 }
 
 
@@ -309,17 +397,18 @@ RcppExport SEXP RcppTestProb(SEXP sPredBlock, SEXP sForest, SEXP sLeaf, SEXP sYT
 
    @param bag is true iff validating.
 
+   @param treeSel lists the trees to consult, or is empty if all.
+
    @return Prediction list.
 */
-RcppExport SEXP RcppPredictQuant(SEXP sPredBlock, SEXP sForest, SEXP sLeaf, SEXP sQuantVec, SEXP sQBin, SEXP sYTest, bool bag) {
+RcppExport SEXP RcppPredictQuant(SEXP sPredBlock, SEXP sForest, SEXP sLeaf, SEXP sQuantVec, SEXP sQBin, SEXP sYTest, bool bag, const std::vector<unsigned int> &treeSel) {
   unsigned int nPredNum, nPredFac, nRow;
   NumericMatrix blockNum;
   IntegerMatrix blockFac;
   RcppPredblock::Unwrap(sPredBlock, nRow, nPredNum, nPredFac, blockNum, blockFac);
     
-  std::vector<unsigned int> origin, facOrig, facSplit;
-  std::vector<ForestNode> forestNode;
-  RcppForest::Unwrap(sForest, origin, facOrig, facSplit, forestNode);
+  ForestCompact forest;
+  RcppForest::UnwrapCompact(sForest, nPredNum, forest);
 
   std::vector<double> yRanked;
   std::vector<unsigned int> leafOrigin;
@@ -332,7 +421,7 @@ RcppExport SEXP RcppPredictQuant(SEXP sPredBlock, SEXP sForest, SEXP sLeaf, SEXP
   std::vector<double> yPred(nRow);
   std::vector<double> quantVecCore(as<std::vector<double> >(sQuantVec));
   std::vector<double> qPredCore(nRow * quantVecCore.size());
-  Predict::Quantiles(nPredNum > 0 ? transpose(blockNum).begin() : 0, nPredFac > 0 ? transpose(blockFac).begin() : 0, nPredNum, nPredFac, forestNode, origin, facOrig, facSplit, leafOrigin, leafNode, bagRow, rank, yRanked, yPred, quantVecCore, as<int>(sQBin), qPredCore,  bag ? rowTrain : 0);
+  Predict::Quantiles(nPredNum > 0 ? transpose(blockNum).begin() : 0, nPredFac > 0 ? transpose(blockFac).begin() : 0, nPredNum, nPredFac, forest, leafOrigin, leafNode, bagRow, rank, yRanked, yPred, quantVecCore, as<int>(sQBin), qPredCore,  bag ? rowTrain : 0, treeSel, RcppForest::ModelId(sForest));
 
   NumericMatrix qPred(transpose(NumericMatrix(quantVecCore.size(), nRow, qPredCore.begin())));
   List prediction;
@@ -360,10 +449,188 @@ RcppExport SEXP RcppPredictQuant(SEXP sPredBlock, SEXP sForest, SEXP sLeaf, SEXP
 
 
 RcppExport SEXP RcppValidateQuant(SEXP sPredBlock, SEXP sForest, SEXP sLeaf, SEXP sQuantVec, SEXP sQBin, SEXP sYTest) {
-  return RcppPredictQuant(sPredBlock, sForest, sLeaf, sQuantVec, sQBin, sYTest, true);
+  return RcppPredictQuant(sPredBlock, sForest, sLeaf, sQuantVec, sQBin, sYTest, true, std::vector<unsigned int>());
+}
+
+
+RcppExport SEXP RcppTestQuant(SEXP sPredBlock, SEXP sForest, SEXP sLeaf, SEXP sQuantVec, SEXP sQBin, SEXP sYTest, SEXP sTrees) {
+  return RcppPredictQuant(sPredBlock, sForest, sLeaf, sQuantVec, sQBin, sYTest, false, TreeSel(sTrees));
+}
+
+
+/**
+   @brief Unwrapped trained state and outputs of one model in a batch.
+   Core prediction holds references into these, so they must persist
+   until the batch completes.
+ */
+class BatchModel {
+ public:
+  bool isCtg;
+  ForestCompact forest;
+  std::vector<unsigned int> leafOrigin;
+  std::vector<LeafNode> leafNode;
+  std::vector<BagRow> bagRow;
+  unsigned int rowTrain;
+  std::vector<double> yRanked; // Regression only.
+  std::vector<unsigned int> rank; // "
+  std::vector<double> yPred; // "
+  std::vector<double> qPred; // "
+  std::vector<double> score; // Multi-output regression only.
+  std::vector<double> yOut; // "
+  std::vector<double> weight; // Classification only.
+  CharacterVector levelsTrain; // "
+  std::vector<int> yPredCtg; // "
+  IntegerVector census; // "
+  NumericVector prob; // "
+  std::vector<unsigned int> yTest; // Empty:  batches do not validate.
+  std::vector<double> error; // "
+};
+
+
+/**
+   @brief Predicts a list of models over a single pass through the
+   observations.
+
+   @param sPredBlock contains the blocked observations, shared by all models.
+
+   @param sModels is a list of (forest, leaf) pairs.
+
+   @param sQuantVec lists the quantiles for regression models, or is null.
+
+   @param sQBin is the quantile bin parameter.
+
+   @param sDoProb is true iff classification models report probabilities.
+
+   @return list of predictions, by model.
+ */
+RcppExport SEXP RcppPredictBatch(SEXP sPredBlock, SEXP sModels, SEXP sQuantVec, SEXP sQBin, SEXP sDoProb) {
+  unsigned int nPredNum, nPredFac, nRow;
+  NumericMatrix blockNum;
+  IntegerMatrix blockFac;
+  RcppPredblock::Unwrap(sPredBlock, nRow, nPredNum, nPredFac, blockNum, blockFac);
+  NumericMatrix blockNumT = nPredNum > 0 ? transpose(blockNum) : NumericMatrix(0);
+  IntegerMatrix blockFacT = nPredFac > 0 ? transpose(blockFac) : IntegerMatrix(0);
+
+  bool doQuant = !Rf_isNull(sQuantVec);
+  std::vector<double> quantVec = doQuant ? as<std::vector<double> >(sQuantVec) : std::vector<double>(0);
+  bool doProb = as<bool>(sDoProb);
+
+  List models(sModels);
+  std::vector<BatchModel *> batchModel(models.length());
+  PredictBatch *batch = new PredictBatch(nPredNum > 0 ? blockNumT.begin() : 0, nPredFac > 0 ? blockFacT.begin() : 0, nPredNum, nPredFac, nRow);
+  for (int i = 0; i < models.length(); i++) {
+    List model(models[i]);
+    BatchModel *bm = new BatchModel();
+    batchModel[i] = bm;
+    RcppForest::UnwrapCompact(model["forest"], nPredNum, bm->forest);
+    List leaf(model["leaf"]);
+    bm->isCtg = leaf.inherits("LeafCtg");
+    if (bm->isCtg) {
+      RcppLeaf::UnwrapCtg(leaf, bm->leafOrigin, bm->leafNode, bm->bagRow, bm->rowTrain, bm->weight, bm->levelsTrain);
+      unsigned int ctgWidth = bm->levelsTrain.length();
+      bm->yPredCtg = std::vector<int>(nRow);
+      bm->census = IntegerVector(nRow * ctgWidth);
+      bm->prob = doProb ? NumericVector(nRow * ctgWidth) : NumericVector(0);
+      batch->AddCtg(bm->forest, bm->leafOrigin, bm->leafNode, bm->bagRow, bm->weight, bm->yPredCtg.empty() ? 0 : &bm->yPredCtg[0], bm->census.begin(), bm->yTest, 0, bm->error, doProb ? bm->prob.begin() : 0, 0, std::vector<unsigned int>(), -1.0, 0, RcppForest::ModelId(model["forest"]));
+    }
+    else {
+      RcppLeaf::UnwrapReg(leaf, bm->yRanked, bm->leafOrigin, bm->leafNode, bm->bagRow, bm->rowTrain, bm->rank);
+      RcppLeaf::UnwrapScore(leaf, bm->score);
+      bm->yPred = std::vector<double>(nRow);
+      bm->yOut = std::vector<double>(bm->score.empty() ? 0 : nRow * (bm->score.size() / bm->leafNode.size()));
+      bm->qPred = std::vector<double>(doQuant ? nRow * quantVec.size() : 0);
+      batch->AddReg(bm->forest, bm->leafOrigin, bm->leafNode, bm->bagRow, bm->rank, bm->yRanked, bm->yPred, 0, std::vector<unsigned int>(), doQuant ? &quantVec : 0, as<int>(sQBin), bm->qPred.empty() ? 0 : &bm->qPred[0], bm->score.empty() ? 0 : &bm->score, bm->yOut.empty() ? 0 : &bm->yOut[0], RcppForest::ModelId(model["forest"]));
+    }
+  }
+  batch->Run();
+  delete batch;
+
+  List predBlock(sPredBlock);
+  List prediction(models.length());
+  for (int i = 0; i < models.length(); i++) {
+    BatchModel *bm = batchModel[i];
+    if (bm->isCtg) {
+      unsigned int ctgWidth = bm->levelsTrain.length();
+      IntegerMatrix census = transpose(IntegerMatrix(ctgWidth, nRow, bm->census.begin()));
+      census.attr("dimnames") = List::create(predBlock["rowNames"], bm->levelsTrain);
+      NumericMatrix prob = doProb ? transpose(NumericMatrix(ctgWidth, nRow, bm->prob.begin())) : NumericMatrix(0);
+      if (doProb) {
+	prob.attr("dimnames") = List::create(predBlock["rowNames"], bm->levelsTrain);
+      }
+      for (unsigned int row = 0; row < nRow; row++) // Bases to unity for front end.
+	bm->yPredCtg[row]++;
+      List predCtg = List::create(
+	_["yPred"] = bm->yPredCtg,
+	_["census"] = census,
+	_["prob"] = prob
+      );
+      predCtg.attr("class") = "PredictCtg";
+      prediction[i] = predCtg;
+    }
+    else {
+      List predReg = List::create(
+        _["yPred"] = bm->yOut.empty() ? wrap(bm->yPred) : SEXP(transpose(NumericMatrix(bm->yOut.size() / nRow, nRow, bm->yOut.begin()))),
+	_["qPred"] = doQuant ? transpose(NumericMatrix(quantVec.size(), nRow, bm->qPred.begin())) : NumericMatrix(0)
+      );
+      predReg.attr("class") = "PredictReg";
+      prediction[i] = predReg;
+    }
+    delete bm;
+  }
+  prediction.attr("names") = models.attr("names");
+
+  return prediction;
 }
 
 
-RcppExport SEXP RcppTestQuant(SEXP sPredBlock, SEXP sForest, SEXP sLeaf, SEXP sQuantVec, SEXP sQBin, SEXP sYTest) {
-  return RcppPredictQuant(sPredBlock, sForest, sLeaf, sQuantVec, sQBin, sYTest, false);
+/**
+   @brief Configures the core's prediction cache and reports its counters.
+
+   @param sCapacity is the number of rows to retain, zero to disable, or
+   null to leave the capacity unchanged.
+
+   @param sReset is true iff cached rows and counters are to be discarded.
+
+   @return list of hit and miss counts, prior to any reset.
+ */
+RcppExport SEXP RcppPredictCache(SEXP sCapacity, SEXP sReset) {
+  unsigned long hits, misses;
+  PredictCache::Counters(hits, misses);
+  List counters = List::create(
+    _["hits"] = double(hits),
+    _["misses"] = double(misses)
+  );
+
+  if (!Rf_isNull(sCapacity))
+    PredictCache::Immutables(as<unsigned int>(sCapacity));
+  else if (as<bool>(sReset))
+    PredictCache::Invalidate();
+
+  return counters;
+}
+
+
+/**
+   @brief Configures the threading of the core's parallel regions, for
+   training as well as prediction.
+
+   @param sNThread is the number of threads per region, zero for the
+   OpenMP default, or null to leave unchanged.
+
+   @param sInlineWork is the number of row-tree walks below which
+   prediction runs on the calling thread, or null to leave unchanged.
+
+   @return list of the settings prior to any change.
+ */
+RcppExport SEXP RcppThreads(SEXP sNThread, SEXP sInlineWork) {
+  List settings = List::create(
+    _["nThread"] = Parallel::NThread(),
+    _["inlineWork"] = Parallel::InlineWork()
+  );
+
+  unsigned int nThread = Rf_isNull(sNThread) ? Parallel::NThread() : as<unsigned int>(sNThread);
+  unsigned int inlineWork = Rf_isNull(sInlineWork) ? Parallel::InlineWork() : as<unsigned int>(sInlineWork);
+  Parallel::Set(nThread, inlineWork);
+
+  return settings;
 }
@@ -68,6 +68,26 @@ void RcppProxyCtg(IntegerVector y, NumericVector classWeight, std::vector<double
 }
 
 
+/**
+   @brief Wraps the predictor selection in effect at the close of training.
+
+   @param predMap maps core predictor indices back to front-end positions.
+
+   @param probOut outputs the selection probability of each predictor.
+
+   @param retiredOut outputs whether each predictor has been retired.
+
+   @return void, with output reference parameters.
+ */
+void RcppAdaptation(IntegerVector predMap, NumericVector &probOut, LogicalVector &retiredOut) {
+  std::vector<double> probAdapt;
+  std::vector<unsigned int> retiredAdapt;
+  (void) Train::Adaptation(probAdapt, retiredAdapt);
+  probOut = NumericVector(probAdapt.begin(), probAdapt.end())[predMap];
+  retiredOut = LogicalVector(retiredAdapt.begin(), retiredAdapt.end())[predMap];
+}
+
+
 /**
    @brief Constructs classification forest.
 
@@ -81,9 +101,15 @@ void RcppProxyCtg(IntegerVector y, NumericVector classWeight, std::vector<double
 
    @param sTotLevels is an upper bound on the number of levels to construct for each tree.
 
+   @param sCheckpoint, if nonempty, names a log from which training resumes.
+
+   @param sStratum, if nonempty, gives the zero-based stratum of each row.
+
+   @param sStratumSamp gives the per-tree sample count of each stratum.
+
    @return Wrapped length of forest vector, with output parameters.
  */
-RcppExport SEXP RcppTrainCtg(SEXP sPredBlock, SEXP sRowRank, SEXP sYOneBased, SEXP sNTree, SEXP sNSamp, SEXP sSampleWeight, SEXP sWithRepl, SEXP sTrainBlock, SEXP sMinNode, SEXP sMinRatio, SEXP sTotLevels, SEXP sPredFixed, SEXP sProbVec, SEXP sClassWeight) {
+RcppExport SEXP RcppTrainCtg(SEXP sPredBlock, SEXP sRowRank, SEXP sYOneBased, SEXP sNTree, SEXP sNSamp, SEXP sSampleWeight, SEXP sObsWeight, SEXP sWithRepl, SEXP sTrainBlock, SEXP sMinNode, SEXP sMinRatio, SEXP sTotLevels, SEXP sPredFixed, SEXP sProbVec, SEXP sClassWeight, SEXP sCheckpoint, SEXP sAdaptTrees, SEXP sRetireRatio, SEXP sStratum, SEXP sStratumSamp) {
   List predBlock(sPredBlock);
   if (!predBlock.inherits("PredBlock"))
     stop("Expecting PredBlock");
@@ -118,11 +144,14 @@ RcppExport SEXP RcppTrainCtg(SEXP sPredBlock, SEXP sRowRank, SEXP sYOneBased, SE
 
   unsigned int nTree = as<unsigned int>(sNTree);
   NumericVector sampleWeight(as<NumericVector>(sSampleWeight));
+  IntegerVector obsWeight(sObsWeight);
+  IntegerVector stratum(sStratum);
+  IntegerVector stratumSamp(sStratumSamp);
 
   unsigned int nPred = nPredNum + nPredFac;
   NumericVector predProb = NumericVector(sProbVec)[predMap];
 
-  Train::Init(xNum.begin(), (unsigned int*) facCard.begin(), cardMax, nPredNum, nPredFac, nRow, nTree, as<unsigned int>(sNSamp), sampleWeight.begin(), as<bool>(sWithRepl), as<unsigned int>(sTrainBlock), as<unsigned int>(sMinNode), as<double>(sMinRatio), as<unsigned int>(sTotLevels), ctgWidth, as<unsigned int>(sPredFixed), predProb.begin());
+  Train::Init(xNum.begin(), (unsigned int*) facCard.begin(), cardMax, nPredNum, nPredFac, nRow, nTree, as<unsigned int>(sNSamp), sampleWeight.begin(), as<bool>(sWithRepl), as<unsigned int>(sTrainBlock), as<unsigned int>(sMinNode), as<double>(sMinRatio), as<unsigned int>(sTotLevels), ctgWidth, as<unsigned int>(sPredFixed), predProb.begin(), 0, 0, as<std::string>(sCheckpoint), obsWeight.length() > 0 ? (unsigned int *) obsWeight.begin() : 0, 1, stratum.length() > 0 ? (unsigned int *) stratum.begin() : 0, stratumSamp.length() > 0 ? (unsigned int *) stratumSamp.begin() : 0, stratumSamp.length(), as<unsigned int>(sAdaptTrees), as<double>(sRetireRatio));
 
   std::vector<unsigned int> origin(nTree);
   std::vector<unsigned int> facOrig(nTree);
@@ -135,18 +164,34 @@ RcppExport SEXP RcppTrainCtg(SEXP sPredBlock, SEXP sRowRank, SEXP sYOneBased, SE
   std::vector<BagRow> bagRow;
   std::vector<double> weight;
 
-  Train::Classification((unsigned int*) feRow.begin(), (unsigned int*) feRank.begin(), (unsigned int*) feInvNum.begin(), as<std::vector<unsigned int> >(y), ctgWidth, proxy, origin, facOrig, predInfo.begin(), forestNode, facSplit, leafOrigin, leafNode, bagRow, weight);
+  unsigned int treeDone = Train::Classification((unsigned int*) feRow.begin(), (unsigned int*) feRank.begin(), (unsigned int*) feInvNum.begin(), as<std::vector<unsigned int> >(y), ctgWidth, proxy, origin, facOrig, predInfo.begin(), forestNode, facSplit, leafOrigin, leafNode, bagRow, weight);
+  if (treeDone < nTree)
+    stop("Training interrupted");
 
+  NumericVector probAdapt;
+  LogicalVector retired;
+  RcppAdaptation(predMap, probAdapt, retired);
 
   return List::create(
-      _["forest"] = RcppForest::Wrap(origin, facOrig, facSplit, forestNode),
+      _["forest"] = RcppForest::Wrap(origin, facOrig, facSplit, forestNode, nPredNum),
       _["leaf"] = RcppLeaf::WrapCtg(leafOrigin, leafNode, bagRow, nRow, weight, CharacterVector(yOneBased.attr("levels"))),
-      _["predInfo"] = predInfo[predMap] // Maps back from core order.
+      _["predInfo"] = predInfo[predMap], // Maps back from core order.
+      _["predProb"] = probAdapt,
+      _["retired"] = retired
   );
 }
 
 
-RcppExport SEXP RcppTrainReg(SEXP sPredBlock, SEXP sRowRank, SEXP sY, SEXP sNTree, SEXP sNSamp, SEXP sSampleWeight, SEXP sWithRepl, SEXP sTrainBlock, SEXP sMinNode, SEXP sMinRatio, SEXP sTotLevels, SEXP sPredFixed, SEXP sProbVec, SEXP sRegMono) {
+/**
+   @brief Constructs regression forest.  A matrix response trains a
+   multi-output forest, whose outputs share splits.
+
+   @param sY is the response, either a vector or a matrix with one
+   column per output.  The leading column drives ranks.
+
+   @return Wrapped length of forest vector, with output parameters.
+ */
+RcppExport SEXP RcppTrainReg(SEXP sPredBlock, SEXP sRowRank, SEXP sY, SEXP sNTree, SEXP sNSamp, SEXP sSampleWeight, SEXP sObsWeight, SEXP sWithRepl, SEXP sTrainBlock, SEXP sMinNode, SEXP sMinRatio, SEXP sTotLevels, SEXP sPredFixed, SEXP sProbVec, SEXP sRegMono, SEXP sCheckpoint, SEXP sAdaptTrees, SEXP sRetireRatio, SEXP sStratum, SEXP sStratumSamp) {
   List predBlock(sPredBlock);
   if (!predBlock.inherits("PredBlock"))
     stop("Expecting PredBlock");
@@ -169,19 +214,25 @@ RcppExport SEXP RcppTrainReg(SEXP sPredBlock, SEXP sRowRank, SEXP sY, SEXP sNTre
   
   unsigned int nTree = as<unsigned int>(sNTree);
   NumericVector sampleWeight(as<NumericVector>(sSampleWeight));
+  IntegerVector obsWeight(sObsWeight);
+  IntegerVector stratum(sStratum);
+  IntegerVector stratumSamp(sStratumSamp);
 
   unsigned int nPred = nPredNum + nPredFac;
   NumericVector predProb = NumericVector(sProbVec)[predMap];
   NumericVector regMono = NumericVector(sRegMono)[predMap];
-  
-  Train::Init(xNum.begin(), (unsigned int*) facCard.begin(), cardMax, nPredNum, nPredFac, nRow, nTree, as<unsigned int>(sNSamp), sampleWeight.begin(), as<bool>(sWithRepl), as<unsigned int>(sTrainBlock), as<unsigned int>(sMinNode), as<double>(sMinRatio), as<unsigned int>(sTotLevels), 0, as<unsigned int>(sPredFixed), predProb.begin(), regMono.begin());
+
+  NumericVector y(sY);
+  unsigned int nOut = Rf_isMatrix(sY) ? NumericMatrix(sY).ncol() : 1;
+
+  Train::Init(xNum.begin(), (unsigned int*) facCard.begin(), cardMax, nPredNum, nPredFac, nRow, nTree, as<unsigned int>(sNSamp), sampleWeight.begin(), as<bool>(sWithRepl), as<unsigned int>(sTrainBlock), as<unsigned int>(sMinNode), as<double>(sMinRatio), as<unsigned int>(sTotLevels), 0, as<unsigned int>(sPredFixed), predProb.begin(), regMono.begin(), 0, as<std::string>(sCheckpoint), obsWeight.length() > 0 ? (unsigned int *) obsWeight.begin() : 0, nOut, stratum.length() > 0 ? (unsigned int *) stratum.begin() : 0, stratumSamp.length() > 0 ? (unsigned int *) stratumSamp.begin() : 0, stratumSamp.length(), as<unsigned int>(sAdaptTrees), as<double>(sRetireRatio));
 
   IntegerMatrix feRow = as<IntegerMatrix>(rowRank["row"]);
   IntegerMatrix feRank = as<IntegerMatrix>(rowRank["rank"]);
 
-  NumericVector y(sY);
-  NumericVector yRanked = clone(y).sort();
-  IntegerVector row2Rank = match(y, yRanked) - 1;
+  NumericVector yLead(y.begin(), y.begin() + nRow);
+  NumericVector yRanked = clone(yLead).sort();
+  IntegerVector row2Rank = match(yLead, yRanked) - 1;
 
   std::vector<unsigned int> origin(nTree);
   std::vector<unsigned int> facOrig(nTree);
@@ -193,12 +244,27 @@ RcppExport SEXP RcppTrainReg(SEXP sPredBlock, SEXP sRowRank, SEXP sY, SEXP sNTre
   std::vector<BagRow> bagRow;
   std::vector<unsigned int> rank;
   std::vector<unsigned int> facSplit;
+  std::vector<double> score; // Multi-output only.
+
+  unsigned int treeDone;
+  if (nOut > 1) { // Column-major matrix is output-major.
+    treeDone = Train::RegressionMulti((unsigned int*) feRow.begin(), (unsigned int*) feRank.begin(), (unsigned int*) feInvNum.begin(), as<std::vector<double> >(y), as<std::vector<unsigned int> >(row2Rank), origin, facOrig, predInfo.begin(), forestNode, facSplit, leafOrigin, leafNode, bagRow, rank, score);
+  }
+  else {
+    treeDone = Train::Regression((unsigned int*) feRow.begin(), (unsigned int*) feRank.begin(), (unsigned int*) feInvNum.begin(), as<std::vector<double> >(y), as<std::vector<unsigned int> >(row2Rank), origin, facOrig, predInfo.begin(), forestNode, facSplit, leafOrigin, leafNode, bagRow, rank);
+  }
+  if (treeDone < nTree)
+    stop("Training interrupted");
 
-  Train::Regression((unsigned int*) feRow.begin(), (unsigned int*) feRank.begin(), (unsigned int*) feInvNum.begin(), as<std::vector<double> >(y), as<std::vector<unsigned int> >(row2Rank), origin, facOrig, predInfo.begin(), forestNode, facSplit, leafOrigin, leafNode, bagRow, rank);
+  NumericVector probAdapt;
+  LogicalVector retired;
+  RcppAdaptation(predMap, probAdapt, retired);
 
   return List::create(
-      _["forest"] = RcppForest::Wrap(origin, facOrig, facSplit, forestNode),
-      _["leaf"] = RcppLeaf::WrapReg(leafOrigin, leafNode, bagRow, nRow, rank, as<std::vector<double> >(yRanked)),
-      _["predInfo"] = predInfo[predMap] // Maps back from core order.
+      _["forest"] = RcppForest::Wrap(origin, facOrig, facSplit, forestNode, nPredNum),
+      _["leaf"] = RcppLeaf::WrapReg(leafOrigin, leafNode, bagRow, nRow, rank, as<std::vector<double> >(yRanked), score),
+      _["predInfo"] = predInfo[predMap], // Maps back from core order.
+      _["predProb"] = probAdapt,
+      _["retired"] = retired
     );
 }
@@ -22,6 +22,8 @@
 #include "splitsig.h"
 #include "predblock.h"
 #include "runset.h"
+#include "parallel.h"
+#include "trainctx.h"
 
 // Testing only:
 //#include <iostream>
@@ -31,17 +33,19 @@
 
 /**
    @brief Static entry for regression.
+
+   @param _outSum holds per-sample sums of a multi-output response, if any.
  */
-Bottom *Bottom::FactoryReg(SamplePred *_samplePred, unsigned int _bagCount) {
-  return new Bottom(_samplePred, new SPReg(_samplePred, _bagCount), _bagCount, PBTrain::NPred(), PBTrain::NPredFac());
+Bottom *Bottom::FactoryReg(const TrainCtx *ctx, SamplePred *_samplePred, unsigned int _bagCount, const FltVal *_outSum) {
+  return new Bottom(ctx, _samplePred, new SPReg(ctx, _samplePred, _bagCount, _outSum), _bagCount, PBTrain::NPred(), PBTrain::NPredFac());
 }
 
 
 /**
    @brief Static entry for classification.
  */
-Bottom *Bottom::FactoryCtg(SamplePred *_samplePred, SampleNode *_sampleCtg, unsigned int _bagCount) {
-  return new Bottom(_samplePred, new SPCtg(_samplePred, _sampleCtg, _bagCount), _bagCount, PBTrain::NPred(), PBTrain::NPredFac());
+Bottom *Bottom::FactoryCtg(const TrainCtx *ctx, SamplePred *_samplePred, SampleNode *_sampleCtg, unsigned int _bagCount) {
+  return new Bottom(ctx, _samplePred, new SPCtg(ctx, _samplePred, _sampleCtg, _bagCount), _bagCount, PBTrain::NPred(), PBTrain::NPredFac());
 }
 
 
@@ -52,27 +56,29 @@ Bottom *Bottom::FactoryCtg(SamplePred *_samplePred, SampleNode *_sampleCtg, unsi
 
    @param splitCount specifies the number of splits to map.
  */
-Bottom::Bottom(SamplePred *_samplePred, SplitPred *_splitPred, unsigned int _bagCount, unsigned int _nPred, unsigned int _nPredFac) : nPred(_nPred), nPredFac(_nPredFac), bagCount(_bagCount), samplePath(new SamplePath[bagCount]), frontCount(1), bvLeft(new BV(bagCount)), bvDead(new BV(bagCount)), samplePred(_samplePred), splitPred(_splitPred), splitSig(new SplitSig()), run(splitPred->Runs()) {
+Bottom::Bottom(const TrainCtx *ctx, SamplePred *_samplePred, SplitPred *_splitPred, unsigned int _bagCount, unsigned int _nPred, unsigned int _nPredFac) : nPred(_nPred), nPredFac(_nPredFac), bagCount(_bagCount), samplePath(new SamplePath[bagCount]), frontCount(1), bvLeft(new BV(bagCount)), bvDead(new BV(bagCount)), samplePred(_samplePred), splitPred(_splitPred), splitSig(new SplitSig(nPred)), run(splitPred->Runs()) {
   levelFront = new Level(1, nPred, bagCount);
   level.push_front(levelFront);
 
   levelFront->Node(0, 0, bagCount, bagCount);
-  levelFront->RootDef(nPred);
+  levelFront->RootDef(ctx);
 
   splitPred->SetBottom(this);
 }
 
 
 /**
-   @brief Adds a new definition at the root level.
+   @brief Adds a new definition at the root level.  Retired predictors,
+   being unstaged, are left undefined.
 
-   @param nPred is the number of predictors.
+   @param ctx holds the fit's predictor retirements.
 
    @return void.
  */
-void Level::RootDef(unsigned int nPred) {
+void Level::RootDef(const TrainCtx *ctx) {
   for (unsigned int predIdx = 0; predIdx < nPred; predIdx++) {
-    Define(0, predIdx, PBTrain::FacCard(predIdx), 0);
+    if (!ctx->Retired(predIdx))
+      Define(0, predIdx, PBTrain::FacCard(predIdx), 0);
   }
 }
 
@@ -341,30 +347,11 @@ void Bottom::DefForward(unsigned int levelIdx, unsigned int predIdx) {
    @return void.
  */
 void Bottom::Split(const IndexNode indexNode[]) {
-  // Guards cast to int for OpenMP 2.0 back-compatibility.
-  int splitPos;
-#pragma omp parallel default(shared) private(splitPos)
-  {
-#pragma omp for schedule(dynamic, 1)
-    for (splitPos = 0; splitPos < int(splitCoord.size()); splitPos++) {
-      splitCoord[splitPos].Split(samplePred, indexNode, splitPred);
-    }
-  }
-
+  splitPred->SplitLevel(splitCoord, indexNode);
   splitCoord.clear();
 }
 
 
-/**
-   @brief Dispatches the staged node to the appropriate splitting family.
-
-   @return void.
- */
-void SplitCoord::Split(const SamplePred *samplePred, const IndexNode indexNode[], SplitPred *splitPred) {
-  splitPred->Split(splitPos, &indexNode[levelIdx], samplePred->PredBase(predIdx, bufIdx));
-}
-
-
 /**
    @brief Restages predictors and splits as pairs with equal priority.
 
@@ -373,7 +360,7 @@ void SplitCoord::Split(const SamplePred *samplePred, const IndexNode indexNode[]
 void Bottom::Restage() {
   int nodeIdx;
 
-#pragma omp parallel default(shared) private(nodeIdx)
+#pragma omp parallel default(shared) private(nodeIdx) num_threads(Parallel::Threads())
   {
 #pragma omp for schedule(dynamic, 1)
     for (nodeIdx = 0; nodeIdx < int(restageCoord.size()); nodeIdx++) {
@@ -515,11 +502,11 @@ void Level::Singletons(const unsigned int reachOffset[], const SPNode targ[], co
 
    @return void.
  */
-void Bottom::SSWrite(unsigned int splitIdx, unsigned int lhSampCount, unsigned int lhIdxCount, double info) {
+void Bottom::SSWrite(unsigned int splitIdx, unsigned int lhSampCount, unsigned int lhIdxCount, double info, unsigned int naLHCount) {
   unsigned int levelIdx, predIdx, bufIdx;
   int runsetPos;
   SplitRef(splitIdx, levelIdx, predIdx, runsetPos, bufIdx);
-  splitSig->Write(levelIdx, predIdx, runsetPos, bufIdx, lhSampCount, lhIdxCount, info);
+  splitSig->Write(levelIdx, predIdx, runsetPos, bufIdx, lhSampCount, lhIdxCount, info, naLHCount);
 }
 
 
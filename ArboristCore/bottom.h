@@ -21,6 +21,7 @@
 #include <deque>
 #include <vector>
 #include <map>
+#include "param.h"
 
 
 /**
@@ -214,7 +215,7 @@ class Level {
   void PathInit(unsigned int &mrraIdx, unsigned int path, unsigned int levelIdx, unsigned int start);
   void Node(unsigned int levelIdx, unsigned int start, unsigned int extent, unsigned int par);
   void CellBounds(const SplitPair &mrra, unsigned int &startIdx, unsigned int &extent);
-  void RootDef(unsigned int nPred);
+  void RootDef(const class TrainCtx *ctx);
   void FrontDef(const class Bottom *bottom, unsigned int mrraIdx, unsigned int predIdx, unsigned int runCount, unsigned int sourceBit);
   void OffsetClone(const SplitPair &mrra, unsigned int reachOffset[]);
   void Singletons(const unsigned int reachOffset[], const class SPNode targ[], const SplitPair &mrra, Level *levelFront);  
@@ -371,8 +372,6 @@ class SplitCoord {
     _bufIdx = bufIdx;
   }
 
-  void Split(const class SamplePred *samplePred, const class IndexNode indexNode[], class SplitPred *splitPred);
-
 
   inline bool HasRuns() {
     return setPos >= 0;
@@ -444,10 +443,10 @@ class Bottom {
 
   
  public:
-  static Bottom *FactoryReg(class SamplePred *_samplePred, unsigned int _bagCount);
-  static Bottom *FactoryCtg(class SamplePred *_samplePred, class SampleNode *_sampleCtg, unsigned int _bagCount);
+  static Bottom *FactoryReg(const class TrainCtx *ctx, class SamplePred *_samplePred, unsigned int _bagCount, const FltVal *_outSum = 0);
+  static Bottom *FactoryCtg(const class TrainCtx *ctx, class SamplePred *_samplePred, class SampleNode *_sampleCtg, unsigned int _bagCount);
   
-  Bottom(class SamplePred *_samplePred, class SplitPred *_splitPred, unsigned int _bagCount, unsigned int _nPred, unsigned int _nPredFac);
+  Bottom(const class TrainCtx *ctx, class SamplePred *_samplePred, class SplitPred *_splitPred, unsigned int _bagCount, unsigned int _nPred, unsigned int _nPredFac);
   ~Bottom();
   void LevelInit();
   void Split(const class IndexNode indexNode[]);
@@ -455,7 +454,7 @@ class Bottom {
   void LevelClear();
   const std::vector<class SSNode*> Split(class Index *index, class IndexNode indexNode[]);
   void ReachingPath(unsigned int _splitIdx, unsigned int path, unsigned int levelIdx, unsigned int start, unsigned int extent);
-  void SSWrite(unsigned int splitPos, unsigned int lhSampCount, unsigned lhIdxCount, double info);
+  void SSWrite(unsigned int splitPos, unsigned int lhSampCount, unsigned lhIdxCount, double info, unsigned int naLHCount = 0);
   void PathLeft(unsigned int sIdx) const;
   void PathRight(unsigned int sIdx) const ;
   void PathExtinct(unsigned int sIdx) const ;
@@ -0,0 +1,269 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file bundle.cc
+
+   @brief Methods for bundling exclusive sparse predictors.
+
+   @author Mark Seligman
+ */
+
+#include "bundle.h"
+#include "bv.h"
+
+#include <algorithm>
+
+//#include <iostream>
+//using namespace std;
+
+const unsigned int Bundle::noBundle;
+
+
+/**
+   @brief Greedily assigns indicator columns to bundles, no two members of
+   which are set at the same row.  Columns are visited by decreasing
+   population and placed in the first bundle admitting them.
+
+   @param feNum is the column-major block of numeric predictors.
+
+   @param cardMax bounds the cardinality of a bundle, including its
+   zero level.
+
+   @param bundle outputs the bundle index of each numeric column, or
+   'noBundle' if left unbundled.
+
+   @param level outputs the one-based level of each bundled column.
+
+   @return count of bundles formed.
+ */
+unsigned int Bundle::Detect(const double feNum[], unsigned int nPredNum, unsigned int nRow, unsigned int cardMax, std::vector<unsigned int> &bundle, std::vector<unsigned int> &level) {
+  bundle = std::vector<unsigned int>(nPredNum, noBundle);
+  level = std::vector<unsigned int>(nPredNum, 0);
+
+  // Candidates are fully-observed indicators:  nonzero values are unity.
+  // Keys order by decreasing population, then by column.
+  //
+  std::vector<std::pair<unsigned int, unsigned int> > cand;
+  for (unsigned int col = 0; col < nPredNum; col++) {
+    const double *xCol = &feNum[col * nRow];
+    unsigned int nz = 0;
+    unsigned int row;
+    for (row = 0; row < nRow; row++) {
+      if (xCol[row] == 1.0)
+        nz++;
+      else if (xCol[row] != 0.0) // Includes NaN.
+        break;
+    }
+    if (row == nRow && nz > 0)
+      cand.push_back(std::make_pair(nRow - nz, col));
+  }
+  std::sort(cand.begin(), cand.end());
+
+  std::vector<BV *> cover; // Rows set by each bundle's members.
+  std::vector<unsigned int> members;
+  std::vector<unsigned int> setRow;
+  for (auto cc : cand) {
+    unsigned int col = cc.second;
+    const double *xCol = &feNum[col * nRow];
+    setRow.clear();
+    for (unsigned int row = 0; row < nRow; row++) {
+      if (xCol[row] != 0.0)
+        setRow.push_back(row);
+    }
+
+    unsigned int fit = cover.size();
+    for (unsigned int bIdx = 0; bIdx < cover.size() && fit == cover.size(); bIdx++) {
+      if (members[bIdx] + 1 >= cardMax)
+        continue;
+      bool clash = false;
+      for (unsigned int i = 0; i < setRow.size() && !clash; i++)
+        clash = cover[bIdx]->TestBit(setRow[i]);
+      if (!clash)
+        fit = bIdx;
+    }
+    if (fit == cover.size()) {
+      cover.push_back(new BV(nRow));
+      members.push_back(0);
+    }
+    for (auto row : setRow)
+      cover[fit]->SetBit(row);
+    members[fit]++;
+    bundle[col] = fit;
+  }
+  for (auto bv : cover)
+    delete bv;
+
+  // Singletons save nothing and are dissolved.  Survivors are renumbered
+  // and their levels assigned in column order.
+  //
+  std::vector<unsigned int> bundleIdx(members.size(), noBundle);
+  unsigned int nBundle = 0;
+  for (unsigned int bIdx = 0; bIdx < members.size(); bIdx++) {
+    if (members[bIdx] > 1)
+      bundleIdx[bIdx] = nBundle++;
+  }
+  std::vector<unsigned int> levelTop(nBundle, 0);
+  for (unsigned int col = 0; col < nPredNum; col++) {
+    if (bundle[col] != noBundle) {
+      bundle[col] = bundleIdx[bundle[col]];
+      if (bundle[col] != noBundle)
+        level[col] = ++levelTop[bundle[col]];
+    }
+  }
+
+  return nBundle;
+}
+
+
+/**
+   @brief Rewrites a column-major training block in bundled form.
+
+   @param feFac is the column-major block of zero-based factor codes.
+
+   @param facCard are the factor cardinalities.
+
+   @param numOut outputs the unbundled numeric columns.
+
+   @param facOut outputs the factor columns, followed by the bundles.
+
+   @param cardOut outputs the cardinalities of 'facOut' columns.
+
+   @return void, with output vector parameters.
+ */
+void Bundle::Encode(const double feNum[], const unsigned int feFac[], const unsigned int facCard[], unsigned int nPredNum, unsigned int nPredFac, unsigned int nRow, const std::vector<unsigned int> &bundle, const std::vector<unsigned int> &level, unsigned int nBundle, std::vector<double> &numOut, std::vector<unsigned int> &facOut, std::vector<unsigned int> &cardOut) {
+  numOut.clear();
+  facOut = std::vector<unsigned int>(feFac, feFac + nPredFac * nRow);
+  facOut.resize((nPredFac + nBundle) * nRow, 0);
+  cardOut = std::vector<unsigned int>(facCard, facCard + nPredFac);
+  cardOut.resize(nPredFac + nBundle, 1);
+
+  for (unsigned int col = 0; col < nPredNum; col++) {
+    const double *xCol = &feNum[col * nRow];
+    if (bundle[col] == noBundle) {
+      numOut.insert(numOut.end(), xCol, xCol + nRow);
+      continue;
+    }
+    unsigned int facIdx = nPredFac + bundle[col];
+    unsigned int *code = &facOut[facIdx * nRow];
+    for (unsigned int row = 0; row < nRow; row++) {
+      if (xCol[row] != 0.0)
+        code[row] = level[col];
+    }
+    cardOut[facIdx] = std::max(cardOut[facIdx], level[col] + 1);
+  }
+}
+
+
+/**
+   @brief Rewrites a row-major prediction block in bundled form.  Rows
+   setting several members of a bundle, unseen in training, take the
+   lowest such level.  Missing values are read as zero.
+
+   @param numOutT outputs the unbundled numeric values, by row.
+
+   @param facOutT outputs the factor values, by row, followed by the
+   bundle levels.
+
+   @return void, with output vector parameters.
+ */
+void Bundle::EncodeT(const double feNumT[], const int feFacT[], unsigned int nPredNum, unsigned int nPredFac, unsigned int nRow, const std::vector<unsigned int> &bundle, const std::vector<unsigned int> &level, unsigned int nBundle, std::vector<double> &numOutT, std::vector<int> &facOutT) {
+  unsigned int nNumOut = std::count(bundle.begin(), bundle.end(), noBundle);
+  unsigned int nFacOut = nPredFac + nBundle;
+  numOutT = std::vector<double>(nRow * nNumOut);
+  facOutT = std::vector<int>(nRow * nFacOut, 0);
+  for (unsigned int row = 0; row < nRow; row++) {
+    const double *xRow = &feNumT[row * nPredNum];
+    double *numRow = &numOutT[row * nNumOut];
+    int *facRow = &facOutT[row * nFacOut];
+    for (unsigned int facIdx = 0; facIdx < nPredFac; facIdx++)
+      facRow[facIdx] = feFacT[row * nPredFac + facIdx];
+
+    unsigned int numIdx = 0;
+    for (unsigned int col = 0; col < nPredNum; col++) {
+      if (bundle[col] == noBundle) {
+        numRow[numIdx++] = xRow[col];
+      }
+      else if (xRow[col] != 0.0 && xRow[col] == xRow[col]) {
+        int &code = facRow[nPredFac + bundle[col]];
+        if (code == 0 || (unsigned int) code > level[col])
+          code = level[col];
+      }
+    }
+  }
+}
+
+
+/**
+   @brief Maps bundled predictors back to their front-end origins.
+
+   @param predOrig outputs the front-end index of each bundled-block
+   predictor:  numeric columns precede factors.  Bundles map to 'noBundle'.
+
+   @param levelOff outputs the starting offset of each bundle's levels
+   within 'levelCol', with a trailing sentinel.
+
+   @param levelCol outputs the numeric column encoded by each bundle
+   level.  Zero levels, encoding no column, map to 'noBundle'.
+
+   @return void, with output vector parameters.
+ */
+void Bundle::Origin(const std::vector<unsigned int> &bundle, const std::vector<unsigned int> &level, unsigned int nPredFac, unsigned int nBundle, std::vector<unsigned int> &predOrig, std::vector<unsigned int> &levelOff, std::vector<unsigned int> &levelCol) {
+  unsigned int nPredNum = bundle.size();
+  predOrig.clear();
+  std::vector<unsigned int> card(nBundle, 1);
+  for (unsigned int col = 0; col < nPredNum; col++) {
+    if (bundle[col] == noBundle)
+      predOrig.push_back(col);
+    else
+      card[bundle[col]] = std::max(card[bundle[col]], level[col] + 1);
+  }
+  for (unsigned int facIdx = 0; facIdx < nPredFac; facIdx++)
+    predOrig.push_back(nPredNum + facIdx);
+  predOrig.resize(predOrig.size() + nBundle, noBundle);
+
+  levelOff = std::vector<unsigned int>(nBundle + 1, 0);
+  for (unsigned int bIdx = 0; bIdx < nBundle; bIdx++)
+    levelOff[bIdx + 1] = levelOff[bIdx] + card[bIdx];
+  levelCol = std::vector<unsigned int>(levelOff[nBundle], noBundle);
+  for (unsigned int col = 0; col < nPredNum; col++) {
+    if (bundle[col] != noBundle)
+      levelCol[levelOff[bundle[col]] + level[col]] = col;
+  }
+}
+
+
+/**
+   @brief Resolves an exported factor split on a bundle into the original
+   columns sending rows left.
+
+   @param facSplitTree holds the tree's exported factor-split bits, one
+   per element.
+
+   @param bitOff is the split's starting bit, as exported with the node.
+
+   @param bundleIdx is the bundle's index among the bundles.
+
+   @param colLeft outputs the numeric columns whose set rows go left.
+
+   @return true iff rows setting none of the bundle's columns go left.
+ */
+bool Bundle::SplitColumns(const std::vector<unsigned int> &facSplitTree, unsigned int bitOff, const std::vector<unsigned int> &levelOff, const std::vector<unsigned int> &levelCol, unsigned int bundleIdx, std::vector<unsigned int> &colLeft) {
+  colLeft.clear();
+  bool zeroLeft = false;
+  unsigned int card = levelOff[bundleIdx + 1] - levelOff[bundleIdx];
+  for (unsigned int code = 0; code < card; code++) {
+    if (facSplitTree[bitOff + code] == 0)
+      continue;
+    if (code == 0)
+      zeroLeft = true;
+    else
+      colLeft.push_back(levelCol[levelOff[bundleIdx] + code]);
+  }
+
+  return zeroLeft;
+}
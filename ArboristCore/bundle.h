@@ -0,0 +1,49 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file bundle.h
+
+   @brief Class definitions for bundling mutually-exclusive sparse
+   numeric predictors into factors.
+
+   @author Mark Seligman
+ */
+
+#ifndef ARBORIST_BUNDLE_H
+#define ARBORIST_BUNDLE_H
+
+#include <vector>
+#include <climits>
+
+/**
+   @brief Preprocessing stage collapsing mutually-exclusive indicator
+   columns, such as one-hot expansions, into synthetic factors.  A bundle's
+   level encodes which of its member columns, if any, is set:  level zero
+   for none and one-based member offsets otherwise.
+
+   Bundled blocks order predictors as unbundled numerics, followed by the
+   original factors, followed by the bundles.  The bundle map, consisting
+   of per-column bundle and level vectors, is owned by the front end and
+   must accompany the forest for prediction and export.
+ */
+class Bundle {
+ public:
+  static const unsigned int noBundle = UINT_MAX;
+
+  static unsigned int Detect(const double feNum[], unsigned int nPredNum, unsigned int nRow, unsigned int cardMax, std::vector<unsigned int> &bundle, std::vector<unsigned int> &level);
+
+  static void Encode(const double feNum[], const unsigned int feFac[], const unsigned int facCard[], unsigned int nPredNum, unsigned int nPredFac, unsigned int nRow, const std::vector<unsigned int> &bundle, const std::vector<unsigned int> &level, unsigned int nBundle, std::vector<double> &numOut, std::vector<unsigned int> &facOut, std::vector<unsigned int> &cardOut);
+
+  static void EncodeT(const double feNumT[], const int feFacT[], unsigned int nPredNum, unsigned int nPredFac, unsigned int nRow, const std::vector<unsigned int> &bundle, const std::vector<unsigned int> &level, unsigned int nBundle, std::vector<double> &numOutT, std::vector<int> &facOutT);
+
+  static void Origin(const std::vector<unsigned int> &bundle, const std::vector<unsigned int> &level, unsigned int nPredFac, unsigned int nBundle, std::vector<unsigned int> &predOrig, std::vector<unsigned int> &levelOff, std::vector<unsigned int> &levelCol);
+
+  static bool SplitColumns(const std::vector<unsigned int> &facSplitTree, unsigned int bitOff, const std::vector<unsigned int> &levelOff, const std::vector<unsigned int> &levelCol, unsigned int bundleIdx, std::vector<unsigned int> &colLeft);
+};
+
+#endif
@@ -162,10 +162,10 @@ BVJagged::~BVJagged() {
  */
 unsigned int BVJagged::RowHeight(unsigned int rowIdx) const {
   if (rowIdx < nRow - 1) {
-    return sizeof(unsigned int) * (rowOrigin[rowIdx + 1] - rowOrigin[rowIdx]);
+    return slotElts * (rowOrigin[rowIdx + 1] - rowOrigin[rowIdx]);
   }
   else {
-    return NElt() - sizeof(unsigned int) * rowOrigin[rowIdx];
+    return NElt() - slotElts * rowOrigin[rowIdx];
   }
 }
 
@@ -0,0 +1,208 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file checkpoint.cc
+
+   @brief Methods for persisting and restoring completed blocks of a training run.
+
+   @author Mark Seligman
+ */
+
+#include "checkpoint.h"
+#include "forest.h"
+#include "response.h"
+#include "trainctx.h"
+
+#include <fstream>
+#include <cstdio>
+#include <algorithm>
+
+// Testing only:
+//#include <iostream>
+//using namespace std;
+
+
+/**
+   @brief Constructor.
+
+   @param _path names the log file, which need not yet exist.
+ */
+Checkpoint::Checkpoint(const std::string &_path) : path(_path), readOff(0) {
+}
+
+
+/**
+   @brief Builds the identifying record of a run.  Resumption is only
+   attempted from a log having an identical header.
+
+   @param fingerprint hashes the training parameters and inputs, so that
+   a log is not spliced into a fit over other data or settings.
+
+   @return void, with side-effected record.
+ */
+void Checkpoint::Header(unsigned int nTree, unsigned int trainBlock, unsigned int nRow, unsigned int nPred, unsigned long long fingerprint) {
+  static const unsigned int magic = 0x41524243; // "ARBC"
+  static const unsigned int version = 3;
+  std::vector<unsigned int> header { magic, version, nTree, trainBlock, nRow, nPred, (unsigned int) (fingerprint >> 32), (unsigned int) fingerprint };
+
+  record.clear();
+  Put(header, 0, header.size());
+}
+
+
+/**
+   @brief Reads the next length-prefixed record from the log.
+
+   @param in is the input stream.
+
+   @return true iff a complete record was read.
+ */
+bool Checkpoint::ReadRecord(std::istream &in) {
+  unsigned int len;
+  if (!in.read((char *) &len, sizeof(len)))
+    return false;
+
+  record.resize(len);
+  readOff = 0;
+  return len == 0 || in.read((char *) &record[0], len);
+}
+
+
+/**
+   @brief Appends the record under construction to the log, flushing
+   before return.  A write interrupted midway leaves an incomplete
+   trailing record, which is discarded on resumption.
+
+   @return void.
+ */
+void Checkpoint::WriteRecord() {
+  std::ofstream out(path.c_str(), std::ios::binary | std::ios::app);
+  unsigned int len = record.size();
+  out.write((const char *) &len, sizeof(len));
+  if (len > 0)
+    out.write((const char *) &record[0], len);
+  out.flush();
+}
+
+
+/**
+   @brief Discards any bytes beyond the last complete record, via a copy
+   renamed over the original.
+
+   @param fileLen is the length of the complete prefix.
+
+   @return void.
+ */
+void Checkpoint::Truncate(std::streamoff fileLen) {
+  std::string tmpPath = path + ".tmp";
+  {
+    std::ifstream in(path.c_str(), std::ios::binary);
+    std::ofstream out(tmpPath.c_str(), std::ios::binary | std::ios::trunc);
+    std::vector<char> buf(1 << 16);
+    while (fileLen > 0) {
+      std::streamoff chunk = std::min(fileLen, (std::streamoff) buf.size());
+      in.read(&buf[0], chunk);
+      out.write(&buf[0], chunk);
+      fileLen -= chunk;
+    }
+  }
+  std::rename(tmpPath.c_str(), path.c_str());
+}
+
+
+/**
+   @brief Restores the blocks recorded by a previous run having the same
+   parameters and inputs.  Otherwise, including when the log belongs to
+   a different run, a fresh one is begun in its place.
+
+   @param fingerprint hashes the run's parameters and inputs.
+
+   @param forest is the crescent forest, assumed empty.
+
+   @param response holds the crescent leaf set, assumed empty.
+
+   @param predInfo outputs the information accumulated over restored blocks.
+
+   @param ctx outputs the adaptation state as of the last restored block.
+
+   @return index of the first tree remaining to train.
+ */
+unsigned int Checkpoint::Resume(unsigned int nTree, unsigned int trainBlock, unsigned int nRow, unsigned int nPred, unsigned long long fingerprint, Forest *forest, Response *response, double predInfo[], TrainCtx *ctx) {
+  Header(nTree, trainBlock, nRow, nPred, fingerprint);
+  std::vector<unsigned char> header(record);
+
+  std::ifstream in(path.c_str(), std::ios::binary);
+  if (!in || !ReadRecord(in) || record != header) {
+    in.close();
+    record = header;
+    std::remove(path.c_str());
+    WriteRecord();
+    return 0;
+  }
+
+  std::streamoff fileLen = sizeof(unsigned int) + record.size();
+  unsigned int treeEnd = 0;
+  std::vector<unsigned char> rngState;
+  while (ReadRecord(in)) {
+    std::vector<unsigned int> extent;
+    Get(extent, 0);
+    forest->Restore(this, extent[0]);
+    response->Restore(this, extent[0]);
+    std::vector<double> info;
+    Get(info, 0);
+    for (unsigned int predIdx = 0; predIdx < nPred; predIdx++)
+      predInfo[predIdx] = info[predIdx];
+    ctx->Restore(this);
+    rngState.clear();
+    Get(rngState, 0);
+
+    treeEnd = extent[1];
+    fileLen += sizeof(unsigned int) + record.size();
+  }
+  in.clear();
+  in.seekg(0, std::ios::end);
+  bool partial = in.tellg() > fileLen;
+  in.close();
+
+  if (partial)
+    Truncate(fileLen);
+  if (treeEnd > 0)
+    ctx->RNGRestore(rngState);
+
+  return treeEnd;
+}
+
+
+/**
+   @brief Appends a record of a newly-completed block.
+
+   @param tStart is the index of the block's first tree.
+
+   @param tEnd is the index one beyond the block's last tree.
+
+   @param predInfo is the information accumulated through the block.
+
+   @param ctx holds the adaptation state in force.
+
+   @param rngState is the fit's generator state as of the next block.
+
+   @return void.
+ */
+void Checkpoint::Commit(unsigned int tStart, unsigned int tEnd, const Forest *forest, const Response *response, const double predInfo[], unsigned int nPred, const TrainCtx *ctx, const std::vector<unsigned char> &rngState) {
+  record.clear();
+  std::vector<unsigned int> extent { tStart, tEnd };
+  Put(extent, 0, extent.size());
+  forest->Dump(this, tStart, tEnd);
+  response->Dump(this, tStart, tEnd);
+  std::vector<double> info(predInfo, predInfo + nPred);
+  Put(info, 0, nPred);
+  ctx->Dump(this);
+  Put(rngState, 0, rngState.size());
+
+  WriteRecord();
+}
@@ -0,0 +1,95 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file checkpoint.h
+
+   @brief Class definitions for persisting completed blocks of a training run, so that an interrupted run may resume.
+
+   @author Mark Seligman
+
+ */
+
+#ifndef ARBORIST_CHECKPOINT_H
+#define ARBORIST_CHECKPOINT_H
+
+#include <vector>
+#include <string>
+#include <cstring>
+#include <ios>
+
+
+/**
+   @brief Append-only log of trained blocks.  The leading record
+   identifies the run; each subsequent record holds the forest and leaf
+   segments of one block, the accumulated predictor information, the
+   adaptive selection state and the fit's generator state as of the
+   following block.
+ */
+class Checkpoint {
+  const std::string path;
+  std::vector<unsigned char> record; // Record under construction or review.
+  unsigned int readOff; // Read position within 'record'.
+
+  bool ReadRecord(std::istream &in);
+  void WriteRecord();
+  void Header(unsigned int nTree, unsigned int trainBlock, unsigned int nRow, unsigned int nPred, unsigned long long fingerprint);
+  void Truncate(std::streamoff fileLen);
+
+ public:
+  Checkpoint(const std::string &_path);
+  unsigned int Resume(unsigned int nTree, unsigned int trainBlock, unsigned int nRow, unsigned int nPred, unsigned long long fingerprint, class Forest *forest, class Response *response, double predInfo[], class TrainCtx *ctx);
+  void Commit(unsigned int tStart, unsigned int tEnd, const class Forest *forest, const class Response *response, const double predInfo[], unsigned int nPred, const class TrainCtx *ctx, const std::vector<unsigned char> &rngState);
+
+
+  /**
+     @brief Appends a length-prefixed slice of a vector of plain values
+     to the record under construction.
+
+     @param vec is the vector to excerpt.
+
+     @param from is the starting position of the slice.
+
+     @param to is the position one beyond the slice.
+
+     @return void.
+   */
+  template<typename T> void Put(const std::vector<T> &vec, unsigned int from, unsigned int to) {
+    unsigned int len = to - from;
+    unsigned int off = record.size();
+    record.resize(off + sizeof(len) + len * sizeof(T));
+    std::memcpy(&record[off], &len, sizeof(len));
+    if (len > 0)
+      std::memcpy(&record[off + sizeof(len)], &vec[from], len * sizeof(T));
+  }
+
+
+  /**
+     @brief Extracts a slice appended by Put(), widening the recipient
+     vector as needed.
+
+     @param vec outputs the slice.
+
+     @param at is the starting position of the slice within 'vec'.
+
+     @return length of the slice.
+   */
+  template<typename T> unsigned int Get(std::vector<T> &vec, unsigned int at) {
+    unsigned int len;
+    std::memcpy(&len, &record[readOff], sizeof(len));
+    readOff += sizeof(len);
+    if (vec.size() < at + len)
+      vec.resize(at + len);
+    if (len > 0)
+      std::memcpy(&vec[at], &record[readOff], len * sizeof(T));
+    readOff += len * sizeof(T);
+
+    return len;
+  }
+};
+
+#endif
@@ -0,0 +1,190 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file dedup.cc
+
+   @brief Methods for collapsing duplicate observations.
+
+   @author Mark Seligman
+ */
+
+#include "dedup.h"
+#include "hash.h"
+
+#include <unordered_map>
+#include <algorithm>
+#include <cstring>
+#include <cmath>
+
+//#include <iostream>
+//using namespace std;
+
+
+/**
+   @brief Builds a bitwise comparison key for a row.  Signed zeros and
+   missing values are canonicalized, so that rows equal in value share
+   a key.
+
+   @param row is the row to encode.
+
+   @param key outputs the encoded numeric, factor and response values.
+
+   @return void, with output vector parameter.
+ */
+void Dedup::RowKey(const double feNum[], const unsigned int feFac[], const double y[], unsigned int nPredNum, unsigned int nPredFac, unsigned int nRow, unsigned int row, std::vector<unsigned long long> &key) {
+  key.clear();
+  for (unsigned int col = 0; col <= nPredNum; col++) {
+    double x = col < nPredNum ? feNum[col * nRow + row] : y[row];
+    if (std::isnan(x))
+      x = NAN;
+    else if (x == 0.0)
+      x = 0.0;
+    unsigned long long bits;
+    memcpy(&bits, &x, sizeof(bits));
+    key.push_back(bits);
+  }
+  for (unsigned int col = 0; col < nPredFac; col++) {
+    key.push_back(feFac[col * nRow + row]);
+  }
+}
+
+
+/**
+   @brief Identifies duplicate rows by hashing, confirming each match by
+   full comparison.
+
+   @param y is the response, with categories encoded as values.
+
+   @param rowUnique outputs the index of each row's distinct
+   representative.  Representatives are numbered in order of first
+   appearance.
+
+   @param mult outputs the multiplicity of each distinct row.
+
+   @return count of distinct rows.
+ */
+unsigned int Dedup::Collapse(const double feNum[], const unsigned int feFac[], const double y[], unsigned int nPredNum, unsigned int nPredFac, unsigned int nRow, std::vector<unsigned int> &rowUnique, std::vector<unsigned int> &mult) {
+  rowUnique = std::vector<unsigned int>(nRow);
+  mult.clear();
+
+  std::unordered_multimap<unsigned long long, unsigned int> uniqueOf;
+  std::vector<unsigned int> uniqueRow; // First appearance of each.
+  std::vector<unsigned long long> key, keyUnique;
+  for (unsigned int row = 0; row < nRow; row++) {
+    RowKey(feNum, feFac, y, nPredNum, nPredFac, nRow, row, key);
+    unsigned long long hash = Hash::Vec(key, 0);
+    unsigned int uIdx = uniqueRow.size();
+    auto range = uniqueOf.equal_range(hash);
+    for (auto it = range.first; it != range.second; it++) {
+      RowKey(feNum, feFac, y, nPredNum, nPredFac, nRow, uniqueRow[it->second], keyUnique);
+      if (keyUnique == key) {
+        uIdx = it->second;
+        break;
+      }
+    }
+    if (uIdx == uniqueRow.size()) {
+      uniqueRow.push_back(row);
+      mult.push_back(0);
+      uniqueOf.insert(std::make_pair(hash, uIdx));
+    }
+    rowUnique[row] = uIdx;
+    mult[uIdx]++;
+  }
+
+  return uniqueRow.size();
+}
+
+
+/**
+   @brief Compacts column-major predictor blocks and response onto the
+   distinct rows.
+
+   @param numOut outputs the numeric block of distinct rows.
+
+   @param facOut outputs the factor block of distinct rows.
+
+   @param yOut outputs the response of distinct rows.
+
+   @return void, with output vector parameters.
+ */
+void Dedup::Gather(const double feNum[], const unsigned int feFac[], const double y[], unsigned int nPredNum, unsigned int nPredFac, unsigned int nRow, const std::vector<unsigned int> &rowUnique, unsigned int nUnique, std::vector<double> &numOut, std::vector<unsigned int> &facOut, std::vector<double> &yOut) {
+  numOut = std::vector<double>(nPredNum * nUnique);
+  facOut = std::vector<unsigned int>(nPredFac * nUnique);
+  yOut = std::vector<double>(nUnique);
+  for (unsigned int row = 0; row < nRow; row++) {
+    unsigned int uIdx = rowUnique[row];
+    for (unsigned int col = 0; col < nPredNum; col++)
+      numOut[col * nUnique + uIdx] = feNum[col * nRow + row];
+    for (unsigned int col = 0; col < nPredFac; col++)
+      facOut[col * nUnique + uIdx] = feFac[col * nRow + row];
+    yOut[uIdx] = y[row];
+  }
+}
+
+
+/**
+   @brief Maps exported bags from distinct rows back to the original rows.
+   Duplicates are interchangeable, so a distinct row's sample count is
+   apportioned as evenly as possible among its copies.  Copies replace
+   their source entry in place, so bags remain grouped by leaf.
+
+   @param rowTree holds the distinct rows bagged by each tree, outputting
+   the original rows.
+
+   @param sCountTree holds their respective sample counts, likewise
+   expanded.
+
+   @param extentTree holds the per-leaf entry counts, outputting the
+   expanded counts.
+
+   @param rankTree, if nonnull, holds per-entry ranks, copied to each
+   expanded entry.
+
+   @return void, with output vector parameters.
+ */
+void Dedup::BagExpand(const std::vector<unsigned int> &rowUnique, std::vector<std::vector<unsigned int> > &rowTree, std::vector<std::vector<unsigned int> > &sCountTree, std::vector<std::vector<unsigned int> > &extentTree, std::vector<std::vector<unsigned int> > *rankTree) {
+  unsigned int nUnique = rowUnique.empty() ? 0 : *std::max_element(rowUnique.begin(), rowUnique.end()) + 1;
+  std::vector<unsigned int> copyOff(nUnique + 1, 0);
+  for (auto uIdx : rowUnique)
+    copyOff[uIdx + 1]++;
+  for (unsigned int uIdx = 0; uIdx < nUnique; uIdx++)
+    copyOff[uIdx + 1] += copyOff[uIdx];
+  std::vector<unsigned int> copyRow(rowUnique.size());
+  std::vector<unsigned int> copyTop(copyOff.begin(), copyOff.end() - 1);
+  for (unsigned int row = 0; row < rowUnique.size(); row++)
+    copyRow[copyTop[rowUnique[row]]++] = row;
+
+  for (unsigned int tIdx = 0; tIdx < rowTree.size(); tIdx++) {
+    std::vector<unsigned int> rowOut, sCountOut, rankOut;
+    unsigned int entry = 0;
+    for (auto &extent : extentTree[tIdx]) {
+      unsigned int extentOut = 0;
+      for (unsigned int entryEnd = entry + extent; entry < entryEnd; entry++) {
+        unsigned int uIdx = rowTree[tIdx][entry];
+        unsigned int nCopy = copyOff[uIdx + 1] - copyOff[uIdx];
+        unsigned int base = sCountTree[tIdx][entry] / nCopy;
+        unsigned int extra = sCountTree[tIdx][entry] - base * nCopy;
+        for (unsigned int copy = 0; copy < nCopy; copy++) {
+          unsigned int sCount = base + (copy < extra ? 1 : 0);
+          if (sCount > 0) {
+            rowOut.push_back(copyRow[copyOff[uIdx] + copy]);
+            sCountOut.push_back(sCount);
+            if (rankTree != 0)
+              rankOut.push_back((*rankTree)[tIdx][entry]);
+            extentOut++;
+          }
+        }
+      }
+      extent = extentOut;
+    }
+    rowTree[tIdx] = rowOut;
+    sCountTree[tIdx] = sCountOut;
+    if (rankTree != 0)
+      (*rankTree)[tIdx] = rankOut;
+  }
+}
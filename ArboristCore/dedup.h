@@ -0,0 +1,38 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file dedup.h
+
+   @brief Class definitions for collapsing duplicate observations.
+
+   @author Mark Seligman
+ */
+
+#ifndef ARBORIST_DEDUP_H
+#define ARBORIST_DEDUP_H
+
+#include <vector>
+
+/**
+   @brief Ingestion stage collapsing rows identical in both predictors and
+   response into a single row weighted by its multiplicity.  The
+   multiplicities are passed to training as observation weights, under
+   which sampling proceeds as though over the original rows.
+ */
+class Dedup {
+  static void RowKey(const double feNum[], const unsigned int feFac[], const double y[], unsigned int nPredNum, unsigned int nPredFac, unsigned int nRow, unsigned int row, std::vector<unsigned long long> &key);
+
+ public:
+  static unsigned int Collapse(const double feNum[], const unsigned int feFac[], const double y[], unsigned int nPredNum, unsigned int nPredFac, unsigned int nRow, std::vector<unsigned int> &rowUnique, std::vector<unsigned int> &mult);
+
+  static void Gather(const double feNum[], const unsigned int feFac[], const double y[], unsigned int nPredNum, unsigned int nPredFac, unsigned int nRow, const std::vector<unsigned int> &rowUnique, unsigned int nUnique, std::vector<double> &numOut, std::vector<unsigned int> &facOut, std::vector<double> &yOut);
+
+  static void BagExpand(const std::vector<unsigned int> &rowUnique, std::vector<std::vector<unsigned int> > &rowTree, std::vector<std::vector<unsigned int> > &sCountTree, std::vector<std::vector<unsigned int> > &extentTree, std::vector<std::vector<unsigned int> > *rankTree = 0);
+};
+
+#endif
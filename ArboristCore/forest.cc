@@ -19,6 +19,10 @@
 #include "predblock.h"
 #include "rowrank.h"
 #include "predict.h"
+#include "checkpoint.h"
+
+#include <algorithm>
+#include <cmath>
 
 //#include <iostream>
 using namespace std;
@@ -27,15 +31,7 @@ using namespace std;
 /**
    @brief Crescent constructor for training.
 */
-Forest::Forest(std::vector<ForestNode> &_forestNode, std::vector<unsigned int> &_origin, std::vector<unsigned int> &_facOrigin, std::vector<unsigned int> &_facVec) : nTree(_origin.size()), forestNode(_forestNode), treeOrigin(_origin), facOrigin(_facOrigin), facVec(_facVec), predict(0) {
-  facSplit = new BVJagged(facVec, _facOrigin);
-}
-
-
-/**
-   @brief Constructor for prediction.
-*/
-Forest::Forest(std::vector<ForestNode> &_forestNode, std::vector<unsigned int> &_origin, std::vector<unsigned int> &_facOrigin, std::vector<unsigned int> &_facVec, Predict *_predict) : nTree(_origin.size()), forestNode(_forestNode), treeOrigin(_origin), facOrigin(_facOrigin), facVec(_facVec), predict(_predict) {
+Forest::Forest(std::vector<ForestNode> &_forestNode, std::vector<unsigned int> &_origin, std::vector<unsigned int> &_facOrigin, std::vector<unsigned int> &_facVec) : nTree(_origin.size()), forestNode(_forestNode), treeOrigin(_origin), facOrigin(_facOrigin), facVec(_facVec) {
   facSplit = new BVJagged(facVec, _facOrigin);
 }
 
@@ -48,118 +44,286 @@ Forest::~Forest() {
 
 
 /**
-   @brief Dispatches prediction method based on available predictor types.
+   @brief Compiles the inference form of a trained forest.  Called once
+   per model, as training completes or as an older front-end forest is
+   first read.  Leaves carry their leaf index, numeric splits their
+   threshold code.  Factor splits carry either their level set, inlined
+   as a mask, or their bit offset into the packed level sets.
 
-   @param bag is the packed in-bag representation, if validating.
+   @param forestNode are the trained nodes, with numeric splits in value
+   space.
+
+   @param origin are the per-tree node offsets.
+
+   @param _facOrigin are the per-tree slot offsets of the level sets.
+
+   @param _facVec are the packed level sets.
+
+   @param nPredNum is the number of numeric predictors, which precede
+   the factors.
 
    @return void.
  */
-void Forest::PredictAcross(unsigned int rowStart, unsigned int rowEnd, const class BitMatrix *bag) const {
-  if (PredBlock::NPredFac() == 0)
-    PredictAcrossNum(rowStart, rowEnd, bag);
-  else if (PredBlock::NPredNum() == 0)
-    PredictAcrossFac(rowStart, rowEnd, bag);
-  else
-    PredictAcrossMixed(rowStart, rowEnd, bag);
+void ForestCompact::Compile(const std::vector<ForestNode> &forestNode, const std::vector<unsigned int> &origin, const std::vector<unsigned int> &_facOrigin, const std::vector<unsigned int> &_facVec, unsigned int nPredNum) {
+  treeOrigin = origin;
+  facOrigin = _facOrigin;
+  facVec = _facVec;
+  predictNode = std::vector<PredictNode>(forestNode.size());
+  farNode.clear();
+  facMask.clear();
+  CodeSplits(forestNode, nPredNum);
+
+  unsigned int nTree = NTree();
+  for (unsigned int tc = 0; tc < nTree; tc++) {
+    unsigned int nodeEnd = tc + 1 < nTree ? treeOrigin[tc + 1] : forestNode.size();
+    std::vector<unsigned int> facWidth;
+    FacWidths(forestNode, nPredNum, tc, nodeEnd, facWidth);
+    for (unsigned int i = treeOrigin[tc]; i < nodeEnd; i++) {
+      unsigned int pred, bump;
+      double num;
+      bool naLeft;
+      forestNode[i].Ref(pred, bump, num, naLeft);
+      unsigned int payload;
+      if (bump == 0) {
+        payload = pred;
+        pred = 0;
+      }
+      else if (pred >= nPredNum) {
+        payload = FacPayload(tc, num, facWidth[i - treeOrigin[tc]]);
+      }
+      else {
+        std::vector<double>::iterator cutBase = cut.begin() + cutOrigin[pred];
+        payload = std::lower_bound(cutBase, cut.begin() + cutOrigin[pred + 1], num) - cutBase;
+      }
+      predictNode[i].Set(pred, bump, payload, naLeft, farNode);
+    }
+  }
 }
 
 
 /**
-   @brief Multi-row prediction for regression tree, with predictors of only numeric.
+   @brief Collects the distinct thresholds of each numeric predictor
+   over the forest.  Numeric splits are coded by their threshold's
+   index, and observations likewise, a row at a time, so that traversal
+   compares integers while the coding cost is amortized over all trees.
 
-   @param bag enumerates the in-bag rows, if validating.
-
-   @return Void with output vector parameter.
+   @return void.
  */
-void Forest::PredictAcrossNum(unsigned int rowStart, unsigned int rowEnd, const class BitMatrix *bag) const {
-  int row;
-
-#pragma omp parallel default(shared) private(row)
-  {
-#pragma omp for schedule(dynamic, 1)
-    for (row = int(rowStart); row < int(rowEnd); row++) {
-    PredictRowNum(row, PBPredict::RowNum(row), row - rowStart, bag);
+void ForestCompact::CodeSplits(const std::vector<ForestNode> &forestNode, unsigned int nPredNum) {
+  std::vector<std::vector<double> > cutPred(nPredNum);
+  for (unsigned int i = 0; i < forestNode.size(); i++) {
+    unsigned int pred, bump;
+    double num;
+    forestNode[i].Ref(pred, bump, num);
+    if (bump != 0 && pred < nPredNum)
+      cutPred[pred].push_back(num);
   }
+
+  cut.clear();
+  cutOrigin = std::vector<unsigned int>(nPredNum + 1);
+  for (unsigned int numIdx = 0; numIdx < nPredNum; numIdx++) {
+    std::vector<double> &predCut = cutPred[numIdx];
+    std::sort(predCut.begin(), predCut.end());
+    predCut.erase(std::unique(predCut.begin(), predCut.end()), predCut.end());
+    cutOrigin[numIdx] = cut.size();
+    cut.insert(cut.end(), predCut.begin(), predCut.end());
   }
+  cutOrigin[nPredNum] = cut.size();
 }
 
 
 /**
-   @brief Multi-row prediction for regression tree, with predictors of both numeric and factor type.
+   @brief Recovers the bit width of each factor split in a tree.
+   Training lays out a tree's level sets contiguously, so that each
+   set extends to the offset of the next.  The final set is bounded by
+   the tree's slot-aligned extent, whose padding bits are clear.
 
-   @param bag enumerates the in-bag rows, if validating.
+   @param nodeEnd is one beyond the tree's last node.
 
-   @return Void with output vector parameter.
+   @param facWidth outputs the split width of each factor node.
+
+   @return void, with output vector parameter.
  */
-void Forest::PredictAcrossFac(unsigned int rowStart, unsigned int rowEnd, const class BitMatrix *bag) const {
-  int row;
-
-#pragma omp parallel default(shared) private(row)
-  {
-#pragma omp for schedule(dynamic, 1)
-    for (row = int(rowStart); row < int(rowEnd); row++) {
-      PredictRowFac(row, PBPredict::RowFac(row), row - rowStart, bag);
+void ForestCompact::FacWidths(const std::vector<ForestNode> &forestNode, unsigned int nPredNum, unsigned int tc, unsigned int nodeEnd, std::vector<unsigned int> &facWidth) const {
+  unsigned int nodeStart = treeOrigin[tc];
+  facWidth = std::vector<unsigned int>(nodeEnd - nodeStart);
+  std::vector<unsigned int> offset;
+  for (unsigned int i = nodeStart; i < nodeEnd; i++) {
+    unsigned int pred, bump;
+    double num;
+    forestNode[i].Ref(pred, bump, num);
+    if (bump != 0 && pred >= nPredNum)
+      offset.push_back(num);
   }
+  if (offset.empty())
+    return;
+
+  std::sort(offset.begin(), offset.end());
+  unsigned int slotEnd = tc + 1 < NTree() ? facOrigin[tc + 1] : facVec.size();
+  unsigned int bitEnd = (slotEnd - facOrigin[tc]) * BV::SlotElts();
+  for (unsigned int i = nodeStart; i < nodeEnd; i++) {
+    unsigned int pred, bump;
+    double num;
+    forestNode[i].Ref(pred, bump, num);
+    if (bump != 0 && pred >= nPredNum) {
+      std::vector<unsigned int>::iterator next = std::upper_bound(offset.begin(), offset.end(), (unsigned int) num);
+      facWidth[i - nodeStart] = (next == offset.end() ? bitEnd : *next) - (unsigned int) num;
+    }
+  }
+}
+
+
+/**
+   @brief Encodes a factor split for the compact node.  Splits narrow
+   enough to fit a mask have their level set copied into 'facMask' and
+   are tested without reference to the packed level sets.
+
+   @param bitOff is the split's bit offset within the tree.
+
+   @param width is the number of bits spanned by the split.
+
+   @return mask index, flagged, or bit offset.
+ */
+unsigned int ForestCompact::FacPayload(unsigned int tc, unsigned int bitOff, unsigned int width) {
+  if (width > PredictNode::maskWidth)
+    return bitOff;
+
+  unsigned long long mask = 0;
+  for (unsigned int bit = 0; bit < width; bit++) {
+    if (FacBit(tc, bitOff + bit))
+      mask |= 1ull << bit;
   }
+  facMask.push_back(mask);
 
+  return (facMask.size() - 1) | PredictNode::maskBit;
 }
 
 
 /**
-   @brief Multi-row prediction with predictors of both numeric and factor type.
+   @brief Tests a bit of a tree's packed level sets.
 
-   @param rowStart is the first row in the block.
+   @param pos is the bit position within the tree.
 
-   @param rowEnd is the first row beyond the block.
+   @return true iff the bit is set.
+ */
+inline bool ForestCompact::FacBit(unsigned int tc, unsigned int pos) const {
+  unsigned int mask;
+  unsigned int slot = BV::SlotMask(pos, mask);
+  return (facVec[facOrigin[tc] + slot] & mask) != 0;
+}
 
-   @param bag indicates whether prediction is restricted to out-of-bag data.
 
-   @return Void with output vector parameter.
+/**
+   @brief Determines the branch taken by a factor observation.  Level
+   codes beyond a mask, such as the proxy for unseen levels, branch
+   right.
+
+   @param payload is the compact node's factor payload.
+
+   @param code is the observation's level code.
+
+   @return true iff the observation branches left.
  */
-void Forest::PredictAcrossMixed(unsigned int rowStart, unsigned int rowEnd, const class BitMatrix *bag) const {
-  int row;
-
-#pragma omp parallel default(shared) private(row)
-  {
-#pragma omp for schedule(dynamic, 1)
-    for (row = int(rowStart); row < int(rowEnd); row++) {
-    PredictRowMixed(row, PBPredict::RowNum(row), PBPredict::RowFac(row), row - rowStart, bag);
+inline bool ForestCompact::FacLeft(unsigned int tc, unsigned int payload, int code) const {
+  if (payload & PredictNode::maskBit) {
+    return (unsigned int) code < PredictNode::maskWidth && ((facMask[payload & ~PredictNode::maskBit] >> code) & 1ull) != 0;
   }
+  else {
+    return FacBit(tc, payload + code);
   }
+}
 
+
+/**
+   @brief Codes a row's numeric observations by the forest's thresholds:
+   each code counts the thresholds lying strictly below the value, so
+   that a value branches left of a threshold iff its code does not
+   exceed the threshold's own index.  Missing values receive a code
+   exceeding all others.
+
+   @param row is the row to code.
+
+   @param rowCode[] outputs the codes, by numeric predictor.
+
+   @return void, with output vector parameter.
+ */
+void ForestCompact::CodeRow(unsigned int row, unsigned int rowCode[]) const {
+  const double *rowNum = PBPredict::RowNum(row);
+  for (unsigned int numIdx = 0; numIdx < (unsigned int) PredBlock::NPredNum(); numIdx++) {
+    double x = rowNum[numIdx];
+    std::vector<double>::const_iterator cutBase = cut.begin() + cutOrigin[numIdx];
+    rowCode[numIdx] = std::isnan(x) ? PBPredict::naCode : std::lower_bound(cutBase, cut.begin() + cutOrigin[numIdx + 1], x) - cutBase;
+  }
+}
+
+
+/**
+   @brief Dispatches single-row prediction based on available predictor types.
+
+   @param predict assigns proxy leaves to bagged rows.
+
+   @param row is the row of data over which a prediction is made.
+
+   @param rowCode[] is the row's numeric data, coded by CodeRow().
+
+   @param leaves[] outputs the row's leaf index in each tree walked.
+
+   @param bag is the packed in-bag representation, if validating.
+
+   @param tcSel[] are the indices of the trees to walk.
+
+   @param nSel is the number of trees to walk.
+
+   @return void, with output vector parameter.
+ */
+void ForestCompact::PredictRow(const Predict *predict, unsigned int row, const unsigned int rowCode[], unsigned int leaves[], const class BitMatrix *bag, const unsigned int tcSel[], unsigned int nSel) const {
+  if (PredBlock::NPredFac() == 0)
+    PredictRowNum(predict, row, rowCode, leaves, bag, tcSel, nSel);
+  else if (PredBlock::NPredNum() == 0)
+    PredictRowFac(predict, row, PBPredict::RowFac(row), leaves, bag, tcSel, nSel);
+  else
+    PredictRowMixed(predict, row, rowCode, PBPredict::RowFac(row), leaves, bag, tcSel, nSel);
 }
 
 
 /**
    @brief Prediction with predictors of only numeric type.
 
+   @param predict assigns proxy leaves to bagged rows.
+
    @param row is the row of data over which a prediction is made.
 
-   @param rowT is a numeric data array section corresponding to the row.
+   @param rowT is the coded numeric data array section corresponding to the row.
 
    @param bag indexes out-of-bag rows, and may be null.
 
+   @param tcSel[] are the indices of the trees to walk.
+
+   @param nSel is the number of trees to walk.
+
    @return Void with output vector parameter.
  */
 
-void Forest::PredictRowNum(unsigned int row, const double rowT[], unsigned int blockRow, const class BitMatrix *bag) const {
-  for (int tc = 0; tc < nTree; tc++) {
+void ForestCompact::PredictRowNum(const Predict *predict, unsigned int row, const unsigned int rowT[], unsigned int leaves[], const class BitMatrix *bag, const unsigned int tcSel[], unsigned int nSel) const {
+  for (unsigned int selIdx = 0; selIdx < nSel; selIdx++) {
+    unsigned int tc = tcSel[selIdx];
     if (bag->TestBit(row, tc)) {
-      predict->BagIdx(blockRow, tc);
+      predict->BagIdx(leaves, tc);
       continue;
     }
 
-    unsigned int treeBase = treeOrigin[tc];
+    const PredictNode *treeNode = &predictNode[treeOrigin[tc]];
     unsigned int idx = 0;
     unsigned int bump;
     unsigned int pred; // N.B.:  Use BlockIdx() if numericals not numbered from 0.
-    double num;
-    forestNode[treeBase].Ref(pred, bump, num);
+    unsigned int payload;
+    bool naLeft;
+    treeNode[0].Ref(farNode.data(), pred, bump, payload, naLeft);
     while (bump != 0) {
-      idx += (rowT[pred] <= num ? bump : bump + 1);
-      forestNode[treeBase + idx].Ref(pred, bump, num);
+      idx += (PredictNode::LeftCode(rowT[pred], payload, naLeft, PBPredict::naCode) ? bump : bump + 1);
+      treeNode[idx].Ref(farNode.data(), pred, bump, payload, naLeft);
     }
-    predict->LeafIdx(blockRow, tc, pred);
+    leaves[tc] = payload;
   }
 }
 
@@ -167,34 +331,40 @@ void Forest::PredictRowNum(unsigned int row, const double rowT[], unsigned int b
 /**
    @brief Prediction with factor-valued predictors only.
 
+   @param predict assigns proxy leaves to bagged rows.
+
    @param row is the row of data over which a prediction is made.
 
    @param rowT is a factor data array section corresponding to the row.
 
    @param bag indexes out-of-bag rows, and may be null.
 
+   @param tcSel[] are the indices of the trees to walk.
+
+   @param nSel is the number of trees to walk.
+
    @return Void with output vector parameter.
  */
-void Forest::PredictRowFac(unsigned int row, const int rowT[], unsigned int blockRow, const class BitMatrix *bag) const {
-  int tc;
-  for (tc = 0; tc < nTree; tc++) {
+void ForestCompact::PredictRowFac(const Predict *predict, unsigned int row, const int rowT[], unsigned int leaves[], const class BitMatrix *bag, const unsigned int tcSel[], unsigned int nSel) const {
+  for (unsigned int selIdx = 0; selIdx < nSel; selIdx++) {
+    unsigned int tc = tcSel[selIdx];
     if (bag->TestBit(row, tc)) {
-      predict->BagIdx(blockRow, tc);
+      predict->BagIdx(leaves, tc);
       continue;
     }
 
-    unsigned int treeBase = treeOrigin[tc];
+    const PredictNode *treeNode = &predictNode[treeOrigin[tc]];
     unsigned int idx = 0;
     unsigned int bump;
     unsigned int pred; // N.B.: Use BlockIdx() if not factor-only (zero based).
-    double num;
-    forestNode[treeBase].Ref(pred, bump, num);
+    unsigned int payload;
+    bool naLeft;
+    treeNode[0].Ref(farNode.data(), pred, bump, payload, naLeft);
     while (bump != 0) {
-      unsigned int bitOff = (unsigned int) num + rowT[pred];
-      idx += facSplit->TestBit(tc, bitOff) ? bump : bump + 1;
-      forestNode[treeBase + idx].Ref(pred, bump, num);
+      idx += FacLeft(tc, payload, rowT[pred]) ? bump : bump + 1;
+      treeNode[idx].Ref(farNode.data(), pred, bump, payload, naLeft);
     }
-    predict->LeafIdx(blockRow, tc, pred);
+    leaves[tc] = payload;
   }
 }
 
@@ -202,37 +372,44 @@ void Forest::PredictRowFac(unsigned int row, const int rowT[], unsigned int bloc
 /**
    @brief Prediction with predictors of both numeric and factor type.
 
+   @param predict assigns proxy leaves to bagged rows.
+
    @param row is the row of data over which a prediction is made.
 
-   @param rowNT is a numeric data array section corresponding to the row.
+   @param rowNT is the coded numeric data array section corresponding to the row.
 
    @param rowFT is a factor data array section corresponding to the row.
 
    @param bag indexes out-of-bag rows, and may be null.
 
+   @param tcSel[] are the indices of the trees to walk.
+
+   @param nSel is the number of trees to walk.
+
    @return Void with output vector parameter.
  */
-void Forest::PredictRowMixed(unsigned int row, const double rowNT[], const int rowFT[], unsigned int blockRow, const class BitMatrix *bag) const {
-  int tc;
-  for (tc = 0; tc < nTree; tc++) {
+void ForestCompact::PredictRowMixed(const Predict *predict, unsigned int row, const unsigned int rowNT[], const int rowFT[], unsigned int leaves[], const class BitMatrix *bag, const unsigned int tcSel[], unsigned int nSel) const {
+  for (unsigned int selIdx = 0; selIdx < nSel; selIdx++) {
+    unsigned int tc = tcSel[selIdx];
     if (bag->TestBit(row, tc)) {
-      predict->BagIdx(blockRow, tc);
+      predict->BagIdx(leaves, tc);
       continue;
     }
 
-    unsigned int treeBase = treeOrigin[tc];
+    const PredictNode *treeNode = &predictNode[treeOrigin[tc]];
     unsigned int idx = 0;
     unsigned int bump;
     unsigned int pred;
-    double num;
-    forestNode[treeBase].Ref(pred, bump, num);
+    unsigned int payload;
+    bool naLeft;
+    treeNode[0].Ref(farNode.data(), pred, bump, payload, naLeft);
     while (bump != 0) {
       bool isFactor;
       unsigned int blockIdx = PredBlock::BlockIdx(pred, isFactor);
-      idx += isFactor ? (facSplit->TestBit(tc, (unsigned int) num + rowFT[blockIdx]) ? bump : bump + 1) : (rowNT[blockIdx] <= num ? bump : bump + 1);
-      forestNode[treeBase + idx].Ref(pred, bump, num);
+      idx += isFactor ? (FacLeft(tc, payload, rowFT[blockIdx]) ? bump : bump + 1) : (PredictNode::LeftCode(rowNT[blockIdx], payload, naLeft, PBPredict::naCode) ? bump : bump + 1);
+      treeNode[idx].Ref(farNode.data(), pred, bump, payload, naLeft);
     }
-    predict->LeafIdx(blockRow, tc, pred);
+    leaves[tc] = payload;
   }
 }
 
@@ -278,6 +455,116 @@ void Forest::Origins(unsigned int tIdx) {
 }
 
 
+/**
+   @brief Reorders the nodes of a newly-trained tree so that frequently
+   taken paths are contiguous.  Children remain adjacent siblings, as
+   the bump encoding requires, but sibling pairs are laid out depth-first
+   with the pair below the more heavily populated child placed first.
+   Descent along the heavier branches then moves forward through memory
+   a pair at a time, instead of jumping by a breadth-first level.  Node
+   contents, including leaf indices, are unchanged.
+
+   @param tIdx is the index of the tree, which must be the last produced.
+
+   @param leafMap maps each sample of the tree to its leaf index.
+
+   @return void, with reordered forest nodes.
+ */
+void Forest::HotLayout(unsigned int tIdx, const std::vector<unsigned int> &leafMap) {
+  unsigned int treeBase = treeOrigin[tIdx];
+  unsigned int height = Height() - treeBase;
+  if (height < 3)
+    return;
+
+  std::vector<unsigned int> leafCount;
+  for (unsigned int sIdx = 0; sIdx < leafMap.size(); sIdx++) {
+    unsigned int leafIdx = leafMap[sIdx];
+    if (leafIdx >= leafCount.size())
+      leafCount.resize(leafIdx + 1, 0);
+    leafCount[leafIdx]++;
+  }
+
+  // Children follow parents in breadth-first order, so a reverse sweep
+  // accumulates subtree populations.
+  std::vector<unsigned int> weight(height);
+  for (int idx = height - 1; idx >= 0; idx--) {
+    unsigned int pred, bump;
+    double num;
+    forestNode[treeBase + idx].Ref(pred, bump, num);
+    weight[idx] = bump == 0 ? (pred < leafCount.size() ? leafCount[pred] : 0) : weight[idx + bump] + weight[idx + bump + 1];
+  }
+
+  std::vector<unsigned int> newIdx(height);
+  newIdx[0] = 0;
+  unsigned int idxNext = 1;
+  std::vector<unsigned int> pending; // Nonterminals awaiting placement of children.
+  pending.push_back(0);
+  while (!pending.empty()) {
+    unsigned int idx = pending.back();
+    pending.pop_back();
+    unsigned int pred, bump;
+    double num;
+    forestNode[treeBase + idx].Ref(pred, bump, num);
+    unsigned int lhIdx = idx + bump;
+    newIdx[lhIdx] = idxNext++;
+    newIdx[lhIdx + 1] = idxNext++;
+
+    unsigned int hot = weight[lhIdx + 1] > weight[lhIdx] ? lhIdx + 1 : lhIdx;
+    unsigned int cold = hot == lhIdx ? lhIdx + 1 : lhIdx;
+    if (forestNode[treeBase + cold].Nonterminal())
+      pending.push_back(cold);
+    if (forestNode[treeBase + hot].Nonterminal())
+      pending.push_back(hot);
+  }
+
+  std::vector<ForestNode> treeNode(forestNode.begin() + treeBase, forestNode.end());
+  for (unsigned int idx = 0; idx < height; idx++) {
+    unsigned int pred, bump;
+    double num;
+    bool naLeft;
+    treeNode[idx].Ref(pred, bump, num, naLeft);
+    forestNode[treeBase + newIdx[idx]].Set(pred, bump == 0 ? 0 : newIdx[idx + bump] - newIdx[idx], num, naLeft);
+  }
+}
+
+
+/**
+   @brief Records the forest segment of a block of completed trees.
+   Splitting values remain in rank space until SplitUpdate().
+
+   @param ckpt is the checkpoint record under construction.
+
+   @param tStart is the index of the block's first tree.
+
+   @param tEnd is the index one beyond the block's last tree.
+
+   @return void.
+ */
+void Forest::Dump(Checkpoint *ckpt, unsigned int tStart, unsigned int tEnd) const {
+  ckpt->Put(treeOrigin, tStart, tEnd);
+  ckpt->Put(facOrigin, tStart, tEnd);
+  ckpt->Put(forestNode, treeOrigin[tStart], forestNode.size());
+  ckpt->Put(facVec, facOrigin[tStart], facVec.size());
+}
+
+
+/**
+   @brief Appends a forest segment recorded by Dump().
+
+   @param ckpt is the checkpoint record under review.
+
+   @param tStart is the index of the segment's first tree.
+
+   @return void.
+ */
+void Forest::Restore(Checkpoint *ckpt, unsigned int tStart) {
+  ckpt->Get(treeOrigin, tStart);
+  ckpt->Get(facOrigin, tStart);
+  ckpt->Get(forestNode, forestNode.size());
+  ckpt->Get(facVec, facVec.size());
+}
+
+
 /**
    @brief Post-pass to update numerical splitting values from ranks.
 
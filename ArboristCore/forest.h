@@ -23,6 +23,7 @@
    @brief To replace parallel array access.
  */
 class ForestNode {
+  static const unsigned int naLeftBit = 1u << 31; // Packed into 'bump'.
   unsigned int pred;
   unsigned int bump;
   double num;
@@ -49,9 +50,9 @@ class ForestNode {
   }
 
 
-  inline void Set(unsigned int _pred, unsigned int _bump, double _num) {
+  inline void Set(unsigned int _pred, unsigned int _bump, double _num, bool _naLeft = false) {
     pred = _pred;
-    bump = _bump;
+    bump = _naLeft ? _bump | naLeftBit : _bump;
     num = _num;
   }
 
@@ -84,9 +85,166 @@ class ForestNode {
   
   inline void Ref(unsigned int &_pred, unsigned int &_bump, double &_num) const {
     _pred = pred;
-    _bump = bump;
+    _bump = bump & ~naLeftBit;
     _num = num;
   }
+
+
+  /**
+     @brief As above, but also reporting the direction of missing values.
+
+     @param _naLeft outputs true iff missing values are sent left.
+   */
+  inline void Ref(unsigned int &_pred, unsigned int &_bump, double &_num, bool &_naLeft) const {
+    _pred = pred;
+    _bump = bump & ~naLeftBit;
+    _num = num;
+    _naLeft = (bump & naLeftBit) != 0;
+  }
+};
+
+
+/**
+   @brief Full-width node fields, for nodes whose values overflow the
+   compact encoding.
+ */
+class FarNode {
+ public:
+  unsigned int pred;
+  unsigned int bump;
+  unsigned int payload;
+};
+
+
+/**
+   @brief Compact encoding of a forest node for inference:  8 bytes in
+   place of ForestNode's 16.  The payload holds the leaf index, the
+   numeric threshold code or the factor bit offset, according to the
+   node's type.  Nodes whose predictor or bump overflow the short fields
+   escape to a side table of FarNodes, indexed by the payload.
+ */
+class PredictNode {
+ public:
+  static const unsigned int maskBit = 1u << 31; // Flags factor payload as mask index.
+  static const unsigned int maskWidth = 64; // Widest factor split held as a mask.
+
+ private:
+  static const unsigned int naLeftBit = 0x8000; // Packed into 'bump'.
+  static const unsigned int bumpEscape = 0x7fff; // Bump field of escaped node.
+  static const unsigned int predMax = 0xffff;
+  unsigned int payload;
+  unsigned short pred;
+  unsigned short bump;
+
+ public:
+  /**
+     @brief Encodes a node, escaping to the side table as needed.
+
+     @param farNode accumulates the overflow records.
+
+     @return void.
+   */
+  inline void Set(unsigned int _pred, unsigned int _bump, unsigned int _payload, bool _naLeft, std::vector<FarNode> &farNode) {
+    if (_bump < bumpEscape && _pred <= predMax) {
+      pred = _pred;
+      bump = _bump;
+      payload = _payload;
+    }
+    else {
+      FarNode far;
+      far.pred = _pred;
+      far.bump = _bump;
+      far.payload = _payload;
+      pred = 0;
+      bump = bumpEscape;
+      payload = farNode.size();
+      farNode.push_back(far);
+    }
+    if (_naLeft)
+      bump |= naLeftBit;
+  }
+
+
+  /**
+     @brief Decodes a node.
+
+     @param farNode is the base of the overflow records.
+
+     @return void, with output reference parameters.
+   */
+  inline void Ref(const FarNode farNode[], unsigned int &_pred, unsigned int &_bump, unsigned int &_payload, bool &_naLeft) const {
+    _naLeft = (bump & naLeftBit) != 0;
+    _bump = bump & ~naLeftBit;
+    if (_bump != bumpEscape) {
+      _pred = pred;
+      _payload = payload;
+    }
+    else {
+      const FarNode &far = farNode[payload];
+      _pred = far.pred;
+      _bump = far.bump;
+      _payload = far.payload;
+    }
+  }
+
+
+  /**
+     @brief Determines the branch taken by a numeric observation, coded
+     by ForestCompact::CodeRow().  Missing values receive the highest code,
+     so are sent right unless the split directs otherwise.
+
+     @param code is the observation's code.
+
+     @param cutCode is the code of the splitting threshold.
+
+     @return true iff the observation branches left.
+   */
+  static inline bool LeftCode(unsigned int code, unsigned int cutCode, bool naLeft, unsigned int naCode) {
+    return code <= cutCode || (naLeft && code == naCode);
+  }
+};
+
+
+/**
+   @brief Inference form of a trained forest.  Compiled once per model
+   from the training nodes, then held by the front end, so that
+   prediction neither rebuilds nor consults ForestNode.  Nodes take the
+   compact encoding.  Numeric splits are coded by the index of their
+   threshold in a per-predictor cut table, and narrow factor splits are
+   inlined as masks.
+ */
+class ForestCompact {
+  void CodeSplits(const std::vector<ForestNode> &forestNode, unsigned int nPredNum);
+  void FacWidths(const std::vector<ForestNode> &forestNode, unsigned int nPredNum, unsigned int tc, unsigned int nodeEnd, std::vector<unsigned int> &facWidth) const;
+  unsigned int FacPayload(unsigned int tc, unsigned int bitOff, unsigned int width);
+  bool FacBit(unsigned int tc, unsigned int pos) const;
+  bool FacLeft(unsigned int tc, unsigned int payload, int code) const;
+
+ public:
+  std::vector<unsigned int> treeOrigin; // Per-tree offsets into 'predictNode'.
+  std::vector<unsigned int> facOrigin; // Per-tree slot offsets into 'facVec'.
+  std::vector<unsigned int> facVec; // Packed level sets of factor splits.
+  std::vector<PredictNode> predictNode;
+  std::vector<FarNode> farNode; // Overflow records of predictNode.
+  std::vector<unsigned long long> facMask; // Level sets of narrow factor splits.
+  std::vector<double> cut; // Distinct numeric thresholds, by predictor.
+  std::vector<unsigned int> cutOrigin; // Per-predictor offsets into 'cut'.
+
+  void Compile(const std::vector<ForestNode> &forestNode, const std::vector<unsigned int> &origin, const std::vector<unsigned int> &_facOrigin, const std::vector<unsigned int> &_facVec, unsigned int nPredNum);
+
+  void CodeRow(unsigned int row, unsigned int rowCode[]) const;
+  void PredictRow(const class Predict *predict, unsigned int row, const unsigned int rowCode[], unsigned int leaves[], const class BitMatrix *bag, const unsigned int tcSel[], unsigned int nSel) const;
+  void PredictRowNum(const class Predict *predict, unsigned int row, const unsigned int rowT[], unsigned int leaves[], const class BitMatrix *bag, const unsigned int tcSel[], unsigned int nSel) const;
+  void PredictRowFac(const class Predict *predict, unsigned int row, const int rowT[], unsigned int leaves[], const class BitMatrix *bag, const unsigned int tcSel[], unsigned int nSel) const;
+  void PredictRowMixed(const class Predict *predict, unsigned int row, const unsigned int rowNT[], const int rowIT[], unsigned int leaves[], const class BitMatrix *bag, const unsigned int tcSel[], unsigned int nSel) const;
+
+
+  /**
+     @return number of trees in the forest.
+   */
+  inline unsigned int NTree() const {
+    return treeOrigin.size();
+  }
 };
 
 
@@ -100,24 +258,13 @@ class Forest {
   std::vector<unsigned int> &treeOrigin;
   std::vector<unsigned int> &facOrigin;
   std::vector<unsigned int> &facVec;
-  class Predict *predict;
   class BVJagged *facSplit; // Consolidation of per-tree values.
 
-  void PredictAcrossNum(unsigned int rowStart, unsigned int rowEnd, const class BitMatrix *bag) const;
-  void PredictAcrossFac(unsigned int rowStart, unsigned int rowEnd, const class BitMatrix *bag) const;
-  void PredictAcrossMixed(unsigned int rowStart, unsigned int rowEnd, const class BitMatrix *bag) const;
  public:
 
   void SplitUpdate(const class RowRank *rowRank) const;
 
-  void PredictAcross(unsigned int rowStart, unsigned int rowEnd, const class BitMatrix *bag) const ;
-  
-  void PredictRowNum(unsigned int row, const double rowT[], unsigned int rowBlock, const class BitMatrix *bag) const;
-  void PredictRowFac(unsigned int row, const int rowT[], unsigned int rowBlock, const class BitMatrix *bag) const;
-  void PredictRowMixed(unsigned int row, const double rowNT[], const int rowIT[], unsigned int rowBlock, const class BitMatrix *bag) const;
-
   Forest(std::vector<ForestNode> &_forestNode, std::vector<unsigned int> &_origin, std::vector<unsigned int> &_facOrigin, std::vector<unsigned int> &_facVec);
-  Forest(std::vector<ForestNode> &_forestNode, std::vector<unsigned int> &_origin, std::vector<unsigned int> &_facOrigin, std::vector<unsigned int> &_facVec, class Predict *_predict);
   ~Forest();
 
   void NodeInit(unsigned int treeHeight);
@@ -155,8 +302,8 @@ class Forest {
 
      @return void.
   */
-  inline void NonterminalProduce(unsigned int tIdx, unsigned int nodeIdx, unsigned int _predIdx, unsigned int _bump, double _split) {
-    forestNode[NodeIdx(tIdx, nodeIdx)].Set(_predIdx, _bump, _split);
+  inline void NonterminalProduce(unsigned int tIdx, unsigned int nodeIdx, unsigned int _predIdx, unsigned int _bump, double _split, bool _naLeft) {
+    forestNode[NodeIdx(tIdx, nodeIdx)].Set(_predIdx, _bump, _split, _naLeft);
   }
 
 
@@ -257,6 +404,9 @@ class Forest {
   void NodeProduce(unsigned int _predIdx, unsigned int _bump, double _split);
   void BitProduce(const class BV *splitBits, unsigned int bitEnd);
   void Origins(unsigned int tIdx);
+  void HotLayout(unsigned int tIdx, const std::vector<unsigned int> &leafMap);
+  void Dump(class Checkpoint *ckpt, unsigned int tStart, unsigned int tEnd) const;
+  void Restore(class Checkpoint *ckpt, unsigned int tStart);
 };
 
 #endif
@@ -0,0 +1,47 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file hash.cc
+
+   @brief Methods for non-cryptographic hashing.
+
+   @author Mark Seligman
+ */
+
+#include "hash.h"
+
+#include <cstring>
+
+//#include <iostream>
+//using namespace std;
+
+
+/**
+   @brief Hashes a byte range a word at a time.
+
+   @param seed is the state to chain from.
+
+   @return updated hash.
+ */
+unsigned long long Hash::Bytes(const void *base, size_t len, unsigned long long seed) {
+  const unsigned char *byte = static_cast<const unsigned char *>(base);
+  unsigned long long h = Mix(seed ^ (len * 0x9e3779b97f4a7c15ULL));
+  size_t off = 0;
+  for (; off + sizeof(h) <= len; off += sizeof(h)) {
+    unsigned long long word;
+    std::memcpy(&word, byte + off, sizeof(word));
+    h = Mix(h ^ word);
+  }
+  if (off < len) {
+    unsigned long long tail = 0;
+    std::memcpy(&tail, byte + off, len - off);
+    h = Mix(h ^ tail);
+  }
+
+  return h;
+}
@@ -0,0 +1,68 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file hash.h
+
+   @brief Non-cryptographic hashing shared by ingestion, caching and
+   checkpointing.
+
+   @author Mark Seligman
+
+ */
+
+#ifndef ARBORIST_HASH_H
+#define ARBORIST_HASH_H
+
+#include <vector>
+#include <cstddef>
+
+
+/**
+   @brief Chainable 64-bit hash over plain values.  Suitable for bucketing
+   and fingerprinting, with collisions confirmed by the caller where
+   correctness depends on it.
+ */
+class Hash {
+ public:
+  static unsigned long long Bytes(const void *base, size_t len, unsigned long long seed);
+
+
+  /**
+     @brief Finalizing mix of a 64-bit hash state.
+   */
+  static inline unsigned long long Mix(unsigned long long h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+  }
+
+
+  /**
+     @brief Chains the hash of a vector's contents onto a seed.
+
+     @return updated hash.
+   */
+  template<typename T> static unsigned long long Vec(const std::vector<T> &vec, unsigned long long seed) {
+    return vec.empty() ? Mix(seed + 1) : Bytes(&vec[0], vec.size() * sizeof(T), seed);
+  }
+
+
+  /**
+     @brief Chains the hash of a single plain value onto a seed.
+
+     @return updated hash.
+   */
+  template<typename T> static unsigned long long Val(const T &val, unsigned long long seed) {
+    return Bytes(&val, sizeof(T), seed);
+  }
+};
+
+#endif
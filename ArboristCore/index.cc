@@ -21,6 +21,7 @@
 #include "splitsig.h"
 #include "samplepred.h"
 #include "bottom.h"
+#include "trainctx.h"
 
 // Testing only:
 //#include <iostream>
@@ -28,88 +29,71 @@
 //#include <time.h>
 //clock_t clock(void);
 
+const unsigned int IndexNode::noDefer;
+const unsigned int Index::noCarry;
 
-unsigned int Index::totLevels = 0;
 
 /**
-   @brief Initialization of static invariants.
-
-   @param _minNode is the minimum node size for splitting.
-
-   @param _totLevels is the maximum number of levels to evaluate.
-
-   @return void.
+   @brief Per-tree constructor.  Sets up root node for level zero.
  */
-void Index::Immutables(unsigned int _minNode, unsigned int _totLevels) {
-  NodeCache::Immutables(_minNode);
-  totLevels = _totLevels;
+Index::Index(TrainCtx *_ctx, SamplePred *_samplePred, PreTree *_preTree, Bottom *_bottom, int _nSamp, int _bagCount, double _sum) : ctx(_ctx), bagCount(_bagCount), samplePred(_samplePred), preTree(_preTree), bottom(_bottom) {
+  levelBase = 0;
+  levelWidth = 1;
+  leafCount = 1;
+  carryCount = carryNext = 0;
+  indexNode = new IndexNode[1];
+  indexNode[0].Init(0, 0, 0, _bagCount, _nSamp, _sum, 0.0, 0);
 }
 
 
 /**
-   @brief Reset of statics.
+   @brief Destructor.
 
    @return void.
  */
-void Index::DeImmutables() {
-  totLevels = 0;
-  NodeCache::DeImmutables();
+Index::~Index() {
 }
 
 
-unsigned int NodeCache::minNode = 0;
-
-void NodeCache::Immutables(unsigned int _minNode) {
-  minNode = _minNode;
+IndexNode::IndexNode() : splitIdx(0), lhStart(0), idxCount(0), sCount(0), sum(0.0), minInfo(0.0), ptId(0), path(0), deferIdx(noDefer) {
 }
 
-
-void NodeCache::DeImmutables() {
-  minNode = 0;
-}
+NodeCache::NodeCache() : IndexNode(), held(0), defer(false), terminal(true) {}
 
 
 /**
-   @brief Per-tree constructor.  Sets up root node for level zero.
- */
-Index::Index(SamplePred *_samplePred, PreTree *_preTree, Bottom *_bottom, int _nSamp, int _bagCount, double _sum) : bagCount(_bagCount), samplePred(_samplePred), preTree(_preTree), bottom(_bottom) {
-  levelBase = 0;
-  levelWidth = 1;
-  indexNode = new IndexNode[1];
-  indexNode[0].Init(0, 0, 0, _bagCount, _nSamp, _sum, 0.0, 0);
-}
-
+   @brief Determines whether a successor node persists to the next level.
 
-/**
-   @brief Destructor.
-
-   @return void.
+   @return true iff the node is large enough to split.
  */
-Index::~Index() {
+bool Index::Splitable(unsigned int idxCount, unsigned int sCount) const {
+  return ctx->Splitable(idxCount, sCount);
 }
 
 
-IndexNode::IndexNode() : splitIdx(0), lhStart(0), idxCount(0), sCount(0), sum(0.0), minInfo(0.0), ptId(0), path(0) {
+double Index::MinInfo(double info) const {
+  return ctx->MinInfo(info);
 }
 
-NodeCache::NodeCache() : IndexNode(), terminal(true) {}
 
 /**
    @brief Instantiates a block of PreTees for bulk return, but may or may
    not build them concurrently.
 
+   @param ctx holds the fit's parameters.
+
    @param sampleBlock contains the sample objects characterizing the roots.
 
    @param treeBlock is the number of trees to train in this block.
 
    @return brace of 'treeBlock'-many PreTree objects.
 */
-PreTree **Index::BlockTrees(Sample **sampleBlock, int treeBlock) {
+PreTree **Index::BlockTrees(TrainCtx *ctx, Sample **sampleBlock, int treeBlock) {
   PreTree **ptBlock = new PreTree*[treeBlock];
 
   for (int blockIdx = 0; blockIdx < treeBlock; blockIdx ++) {
     Sample *sample = sampleBlock[blockIdx];
-    ptBlock[blockIdx] = OneTree(sample->SmpPred(), sample->Bot(), Sample::NSamp(), sample->BagCount(), sample->BagSum());
+    ptBlock[blockIdx] = OneTree(ctx, sample->SmpPred(), sample->Bot(), sample->BagSCount(), sample->BagCount(), sample->BagSum());
   }
   
   return ptBlock;
@@ -121,9 +105,9 @@ PreTree **Index::BlockTrees(Sample **sampleBlock, int treeBlock) {
 
    @return void.
  */
-PreTree *Index::OneTree(SamplePred *_samplePred, Bottom *_bottom, int _nSamp, int _bagCount, double _sum) {
-  PreTree *_preTree = new PreTree(_bagCount);
-  Index *index = new Index(_samplePred, _preTree, _bottom, _nSamp, _bagCount, _sum);
+PreTree *Index::OneTree(TrainCtx *ctx, SamplePred *_samplePred, Bottom *_bottom, int _nSamp, int _bagCount, double _sum) {
+  PreTree *_preTree = new PreTree(ctx, _bagCount);
+  Index *index = new Index(ctx, _samplePred, _preTree, _bottom, _nSamp, _bagCount, _sum);
   index->Levels();
   delete index;
 
@@ -133,7 +117,12 @@ PreTree *Index::OneTree(SamplePred *_samplePred, Bottom *_bottom, int _nSamp, in
 
 /**
    @brief Main loop for per-level splitting.  Assumes root node and attendant per-tree
-   data structures have been initialized.
+   data structures have been initialized.  Cancellation leaves the
+   frontier terminal, as if the level limit had been reached.  Under a
+   leaf budget, each pass expands the most informative splits of the
+   entire frontier, carrying the remainder forward unsplit, so that a
+   pass constitutes a round of best-first growth rather than a level.
+   The level limit then bounds the number of rounds.
 
    @return void.
 */
@@ -143,7 +132,7 @@ void  Index::Levels() {
     bottom->LevelInit();
     unsigned int splitNext, lhNext, leafNext;
     NodeCache *nodeCache = LevelConsume(levelCount, splitNext, lhNext, leafNext);
-    if (splitNext != 0 && level + 1 != totLevels) {
+    if (splitNext != 0 && level + 1 != ctx->totLevels && !ctx->Interrupted()) {
       LevelProduce(nodeCache, level, levelCount, splitNext, lhNext, leafNext);
       levelCount = splitNext;
     }
@@ -155,7 +144,7 @@ void  Index::Levels() {
   }
 }
 //  ASSERTION:
-//   levelBase + levelWidth == preTree->TreeHeight()
+//   levelBase + levelWidth - carryCount == preTree->TreeHeight()
 
 
 /**
@@ -170,6 +159,8 @@ NodeCache *Index::CacheNodes(const std::vector<SSNode*> &argMax) {
   NodeCache *nodeCache = new NodeCache[argMax.size()];
   for (unsigned int splitIdx = 0; splitIdx < argMax.size(); splitIdx++) {
     nodeCache[splitIdx].Cache(&indexNode[splitIdx], argMax[splitIdx]);
+    if (indexNode[splitIdx].Carried())
+      nodeCache[splitIdx].Hold(&deferSplit[indexNode[splitIdx].deferIdx]);
   }
   delete [] indexNode;
 
@@ -177,6 +168,44 @@ NodeCache *Index::CacheNodes(const std::vector<SSNode*> &argMax) {
 }
 
 
+/**
+   @brief Enforces the leaf budget, if any, by expanding the frontier's
+   most informative splits.  The frontier comprises the level's fresh
+   candidates together with those carried from earlier rounds, so that
+   ranking is best-first over the tree.  Candidates not expanded are
+   deferred to a later round while budget remains, and are otherwise
+   left terminal.
+
+   @param nodeCache holds the level's cached nodes and split signatures.
+
+   @return void.
+ */
+void Index::Budget(NodeCache nodeCache[], unsigned int levelCount) {
+  carryNext = 0;
+  if (!ctx->Budgeted())
+    return;
+
+  std::vector<BudgetCand> cand;
+  for (unsigned int splitIdx = 0; splitIdx < levelCount; splitIdx++) {
+    if (nodeCache[splitIdx].SS() != 0)
+      cand.push_back(BudgetCand(nodeCache[splitIdx].SS()->info, nodeCache[splitIdx].IdxCount(), splitIdx));
+  }
+  unsigned int expandCount = ctx->Budget(cand, leafCount);
+
+  bool budgetLeft = ctx->BudgetLeft(leafCount);
+  for (unsigned int candIdx = expandCount; candIdx < cand.size(); candIdx++) {
+    NodeCache *node = &nodeCache[cand[candIdx].levelIdx];
+    if (budgetLeft) {
+      node->Defer();
+      carryNext++;
+    }
+    else {
+      node->SS() = 0;
+    }
+  }
+}
+
+
 /**
    @brief Counts splits and leaves in the next level.
 
@@ -190,7 +219,7 @@ unsigned int Index::LevelCensus(NodeCache nodeCache[], unsigned int levelCount,
   lhSplitNext = leafNext = 0;
   unsigned int rhSplitNext = 0;
   for (unsigned int splitIdx = 0; splitIdx < levelCount; splitIdx++)
-    nodeCache[splitIdx].SplitCensus(lhSplitNext, rhSplitNext, leafNext);
+    nodeCache[splitIdx].SplitCensus(ctx, lhSplitNext, rhSplitNext, leafNext);
   
   // Restaging is implemented as a patient stable partition.
   //
@@ -206,6 +235,8 @@ unsigned int Index::LevelCensus(NodeCache nodeCache[], unsigned int levelCount,
    @brief Splitable nodes only:  takes census next level's left, right split
    nodes nodes and leaves.
 
+   @param ctx determines whether successors are large enough to split.
+
    @param lhSplitNext outputs count of LH index nodes in next level.
 
    @param rhSplitNext outputs count of RH index nodes in next level.
@@ -214,19 +245,23 @@ unsigned int Index::LevelCensus(NodeCache nodeCache[], unsigned int levelCount,
 
    @return void, plus output reference parameters.
 */
-void NodeCache::SplitCensus(unsigned int &lhSplitNext, unsigned int &rhSplitNext, unsigned int &leafNext) {
+void NodeCache::SplitCensus(const TrainCtx *ctx, unsigned int &lhSplitNext, unsigned int &rhSplitNext, unsigned int &leafNext) {
   if (ssNode == 0)
     return;
+  if (defer) { // Carried as its own left-hand successor.
+    lhSplitNext++;
+    return;
+  }
 
   ssNode->LHSizes(lhSCount, lhIdxCount);
-  if (Splitable(lhIdxCount)) {
+  if (ctx->Splitable(lhIdxCount, lhSCount)) {
     lhSplitNext++;
   }
   else {
     leafNext++;
   }
 
-  if (Splitable(idxCount - lhIdxCount)) {
+  if (ctx->Splitable(idxCount - lhIdxCount, sCount - lhSCount)) {
     rhSplitNext++;
   }
   else
@@ -244,6 +279,7 @@ void NodeCache::SplitCensus(unsigned int &lhSplitNext, unsigned int &rhSplitNext
 */
 NodeCache *Index::LevelConsume(unsigned int levelCount, unsigned int &splitNext, unsigned int &lhSplitNext, unsigned int &leafNext) {
   NodeCache *nodeCache = CacheNodes(bottom->Split(this, indexNode));
+  Budget(nodeCache, levelCount);
   splitNext = LevelCensus(nodeCache, levelCount, lhSplitNext, leafNext);
 
   // Next level of pre-tree needs sufficient space to consume splits
@@ -258,8 +294,12 @@ NodeCache *Index::LevelConsume(unsigned int levelCount, unsigned int &splitNext,
 
 
 void Index::LevelProduce(NodeCache *nodeCache, unsigned int level, unsigned int levelCount, unsigned int splitNext, unsigned int lhSplitNext, unsigned int leafNext) {
-  levelBase += levelWidth;
+  // Carried nodes retain their pretree indices, so only the remaining
+  // nodes advance the base.  These occupy the head of the upcoming
+  // level, while carried nodes occupy the tail.
+  levelBase += levelWidth - carryCount;
   levelWidth = splitNext + leafNext;
+  CarryClear();
 
   ntLH = new bool[levelWidth];
   ntRH = new bool[levelWidth];
@@ -276,6 +316,9 @@ void Index::LevelProduce(NodeCache *nodeCache, unsigned int level, unsigned int
     nodeCache[splitIdx].Successors(this, preTree, samplePred, bottom, lhSplitNext, lhCount, rhCount);
   }
   LRLive(bottom, nodeCache, level);
+  deferSplit = std::move(deferNext);
+  deferNext.clear();
+  carryCount = carryNext;
 
   // Assigns start values to consecutive nodes at next level.
   /*
@@ -298,7 +341,13 @@ void Index::LevelProduce(NodeCache *nodeCache, unsigned int level, unsigned int
   @return void.
 */
 void NodeCache::Consume(PreTree *preTree, SamplePred *samplePred, Bottom *bottom) {
-  if (ssNode != 0) {
+  if (ssNode == 0 || defer)
+    return;
+
+  if (held != 0) {
+    lhSum = ssNode->NonTerminalHeld(samplePred, preTree, lhStart, lhStart + idxCount - 1, ptId, ptL, ptR, held->lhRun);
+  }
+  else {
     lhSum = ssNode->NonTerminal(samplePred, preTree, splitIdx, lhStart, lhStart + idxCount - 1, ptId, ptL, ptR, bottom->Runs());
   }
 }
@@ -331,26 +380,81 @@ void NodeCache::Consume(PreTree *preTree, SamplePred *samplePred, Bottom *bottom
    @return void, plus output reference parameters.
 */
 void NodeCache::Successors(Index *index, PreTree *preTree, SamplePred *samplePred, Bottom *bottom, unsigned int lhSplitNext, unsigned int &lhSplitCount, unsigned int &rhSplitCount) {
-  if (ssNode != 0) {
-    if (Splitable(lhIdxCount)) {
+  if (ssNode != 0 && defer) {
+    terminal = false;
+    unsigned int lNext = lhSplitCount++;
+    unsigned int pathNext = index->NextCarry(lNext, ptId, lhStart, idxCount, sCount, sum, minInfo, path, ssNode, held);
+    bottom->ReachingPath(splitIdx, pathNext, lNext, lhStart, idxCount);
+  }
+  else if (ssNode != 0) {
+    double minInfo = index->MinInfo(ssNode->info);
+    if (index->Splitable(lhIdxCount, lhSCount)) {
       terminal = false;
       unsigned int lNext = lhSplitCount++;
       unsigned int start = lhStart;
-      unsigned int pathNext = index->NextLH(lNext, ptL, start, lhIdxCount, lhSCount, lhSum, ssNode->MinInfo(), path);
+      unsigned int pathNext = index->NextLH(lNext, ptL, start, lhIdxCount, lhSCount, lhSum, minInfo, path);
       bottom->ReachingPath(splitIdx, pathNext, lNext, start, lhIdxCount);
     }
 
-    if (Splitable(idxCount - lhIdxCount)) {
+    if (index->Splitable(idxCount - lhIdxCount, sCount - lhSCount)) {
       terminal = false;
       unsigned int rNext = lhSplitNext + rhSplitCount++;
       unsigned int start = lhStart + lhIdxCount;
-      unsigned int pathNext = index->NextRH(rNext, ptR, start, idxCount - lhIdxCount, sCount - lhSCount, sum - lhSum, ssNode->MinInfo(), path);
+      unsigned int pathNext = index->NextRH(rNext, ptR, start, idxCount - lhIdxCount, sCount - lhSCount, sum - lhSum, minInfo, path);
       bottom->ReachingPath(splitIdx, pathNext, rNext, start, idxCount - lhIdxCount);
     }
   }
 }
 
 
+/**
+   @brief Carries a node whose split is deferred into the upcoming
+   level, unchanged, as its own left-hand successor.  The node retains
+   its pretree index, which is mapped to an offset at the tail of the
+   level.
+
+   @param ss is the deferred split.
+
+   @param held is the split's carried state, if carried previously.
+
+   @return path to the successor.
+ */
+unsigned int Index::NextCarry(unsigned int idxNext, unsigned int ptId, unsigned int _start, unsigned int idxCount, unsigned int sCount, double sum, double minInfo, unsigned char _path, const SSNode *ss, const DeferSplit *held) {
+  unsigned int pathNext = _path << 1;
+  indexNode[idxNext].Init(idxNext, _start, ptId, idxCount, sCount, sum, minInfo, pathNext);
+  indexNode[idxNext].deferIdx = deferNext.size();
+
+  DeferSplit defer;
+  defer.ss = *ss;
+  if (held != 0)
+    defer.lhRun = held->lhRun;
+  else
+    ss->LHRuns(bottom->Runs(), defer.lhRun);
+  deferNext.push_back(std::move(defer));
+
+  if (ptCarry.size() < levelBase)
+    ptCarry.resize(levelBase, noCarry);
+  ptCarry[ptId] = levelWidth - carryNext + carryPT.size();
+  carryPT.push_back(ptId);
+
+  SetLH(ptId);
+  return pathNext;
+}
+
+
+/**
+   @brief Unmaps the pretree indices carried into the level just
+   concluded.
+
+   @return void.
+ */
+void Index::CarryClear() {
+  for (auto ptId : carryPT)
+    ptCarry[ptId] = noCarry;
+  carryPT.clear();
+}
+
+
 /**
    @brief Packs live lh/rh information into bit vectors and zero-pads up to the next slot boundary.
 
@@ -429,6 +533,10 @@ bool Index::LevelOffSample(unsigned int sIdx, unsigned int &levelOff) const {
 
     return true;
   }
+  else if (ptIdx < ptCarry.size() && ptCarry[ptIdx] != noCarry) {
+    levelOff = ptCarry[ptIdx];
+    return true;
+  }
   else {
     levelOff = 0; // dummy value.
     return false;
@@ -18,6 +18,8 @@
 #define ARBORIST_INDEX_H
 
 #include <vector>
+#include <climits>
+#include "splitsig.h"
 
 /**
    Index tree node fields associated with the response, viz., invariant across
@@ -40,6 +42,8 @@ class IndexNode {
   double minInfo; // Minimum acceptable information on which to split.
   unsigned int ptId; // Index of associated PTSerial node.
   unsigned char path; // Bitwise record of recent reaching L/R path.
+  unsigned int deferIdx; // Split held over from an earlier round, iff carried.
+  static const unsigned int noDefer = UINT_MAX;
 
   double PrebiasReg();
   double PrebiasCtg(const double sumSquares[]);
@@ -97,6 +101,19 @@ class IndexNode {
     sum = _sum;
     minInfo = _minInfo;
     path = _path;
+    deferIdx = noDefer;
+  }
+
+
+  /**
+     @brief Determines whether the node was carried, unsplit, from an
+     earlier round.  Carried nodes are not re-evaluated, as their split
+     is already known.
+
+     @return true iff a deferred split is held for the node.
+   */
+  inline bool Carried() const {
+    return deferIdx != noDefer;
   }
 
   inline void PathCoords(unsigned int &_start, unsigned int &_extent) {
@@ -153,25 +170,39 @@ class IndexNode {
 };
 
 
+/**
+   @brief Split of a node deferred under a leaf budget.  The node is
+   carried unsplit through restaging, as the sole successor of itself,
+   which preserves the extent and ordering of its indices.  Its split
+   therefore remains valid for replay in a later round, save for the
+   coordinates of factor runs, which are copied.
+ */
+class DeferSplit {
+ public:
+  SSNode ss;
+  std::vector<unsigned int> lhRun; // Factor:  rank, start, end of left runs.
+};
+
+
 /**
    @brief Caches intermediate IndexNode contents during intra-level transfer.
 */
 class NodeCache : public IndexNode {
   class SSNode *ssNode; // Convenient to cache for LH/RH partition.
+  const DeferSplit *held; // Split carried from an earlier round, if any.
+  bool defer; // Whether the split is deferred to a later round.
   bool terminal; // True unless next-level descendants produced.
-  static unsigned int minNode;
   unsigned int lhIdxCount; // Total indices over LH:  splits only.
   unsigned int lhSCount; // Total samples cover LH:  splits only.
   double lhSum; // Sum of responses over LH:  splits only.
   unsigned int ptL; // LH index into pre-tree:  splits only.
   unsigned int ptR; // RH index into pre-tree:  splits only.
  public:
-  static void Immutables(unsigned int _minNode);
-  static void DeImmutables();
   NodeCache();
+
   void Consume(class PreTree *preTree, class SamplePred *samplePred, class Bottom *bottom);
   void Successors(class Index *index, class PreTree *preTree, class SamplePred *samplePred, class Bottom *bottom, unsigned int lhSplitNext, unsigned int &lhCount, unsigned int &rhCount);
-  void SplitCensus(unsigned int &lhSplitNext, unsigned int &rhSplitNext, unsigned int &leafNext);
+  void SplitCensus(const class TrainCtx *ctx, unsigned int &lhSplitNext, unsigned int &rhSplitNext, unsigned int &leafNext);
 
   /**
      @brief Copies indexNode entry into corresponding nodeCache.
@@ -189,33 +220,42 @@ class NodeCache : public IndexNode {
     ptId = nd->ptId;
     minInfo = nd->minInfo;
     path = nd->path,
+    deferIdx = nd->deferIdx;
     ptL = ptR = 0; // Terminal until shown otherwise.
     SS() = argMax;
+    held = 0;
+    defer = false;
   }
 
 
-  inline class SSNode *&SS() {
-    return ssNode;
+  /**
+     @brief Attaches the split carried from an earlier round.
+
+     @param _held is the carried split.
+
+     @return void.
+   */
+  inline void Hold(DeferSplit *_held) {
+    held = _held;
+    SS() = &_held->ss;
   }
-  
 
-  /**
-    @brief Invoked from the RHS or LHS of a split to determine whether the node persists to the next level.
-    
-    MUST guarantee that no zero-length "splits" have been introduced.
-    Not only are these nonsensical, but they are also dangerous, as they violate
-    various assumptions about the integrity of the intermediate respresentation.
 
-    @param _idxCount is the count of indices subsumed by the node.
+  /**
+     @brief Defers the node's split to a later round.
 
-    @return true iff the node subsumes more than minimal count of buffer elements.
-  */
-  inline bool Splitable(unsigned int _idxCount) const {
-    return _idxCount > minNode;
+     @return void.
+   */
+  inline void Defer() {
+    defer = true;
   }
 
 
+  inline class SSNode *&SS() {
+    return ssNode;
+  }
   
+
   /**
      @brief Transmits location coordinates for interlevel activity.
 
@@ -236,10 +276,12 @@ class NodeCache : public IndexNode {
 };
 
 class Index {
-  static unsigned int totLevels;
+  class TrainCtx *ctx;
   NodeCache *CacheNodes(const std::vector<class SSNode*> &argMax);
   void ArgMax(NodeCache nodeCache[]);
   unsigned int LevelCensus(NodeCache nodeCache[], unsigned int levelCount, unsigned int &lhSplitNext, unsigned int &leafNext);
+  void Budget(NodeCache nodeCache[], unsigned int levelCount);
+  void CarryClear();
   NodeCache *LevelConsume(unsigned int levelCount, unsigned int &splitNext, unsigned int &lhSplitNext, unsigned int &leafNext);
   void LevelProduce(NodeCache *nodeCache, unsigned int level, unsigned int levelCount, unsigned int splitNext, unsigned int lhSplitNext, unsigned int leafNext);
  protected:
@@ -247,20 +289,26 @@ class Index {
   const unsigned int bagCount;
   unsigned int levelBase; // Pre-tree index at which level's nodes begin.
   unsigned int levelWidth; // Count of pretree nodes at frontier.
+  unsigned int leafCount; // Leaves grown so far, iff budgeted.
+  unsigned int carryCount; // Carried nodes in the current level.
+  unsigned int carryNext; // Carried nodes in the upcoming level.
+  std::vector<DeferSplit> deferSplit; // Splits held by carried nodes.
+  std::vector<DeferSplit> deferNext; // "" upcoming level.
+  std::vector<unsigned int> carryPT; // Pretree index of each carried node.
+  std::vector<unsigned int> ptCarry; // Level offset of carried pretree nodes.
+  static const unsigned int noCarry = UINT_MAX;
   bool *ntLH;
   bool *ntRH;
-  static class PreTree *OneTree(class SamplePred *_samplePred, class Bottom *_bottom, int _nSamp, int _bagCount, double _bagSum);
+  static class PreTree *OneTree(class TrainCtx *ctx, class SamplePred *_samplePred, class Bottom *_bottom, int _nSamp, int _bagCount, double _bagSum);
 
  public:
-  static void Immutables(unsigned int _minNode, unsigned int _totLevels);
-  static void DeImmutables();
   class SamplePred *samplePred;
   class PreTree *preTree;
   class Bottom *bottom;
-  Index(class SamplePred *_samplePred, class PreTree *_preTree, class Bottom *_bottom, int _nSamp, int _bagCount, double _sum);
+  Index(class TrainCtx *_ctx, class SamplePred *_samplePred, class PreTree *_preTree, class Bottom *_bottom, int _nSamp, int _bagCount, double _sum);
   ~Index();
 
-  static class PreTree **BlockTrees(class Sample **sampleBlock, int _treeBlock);
+  static class PreTree **BlockTrees(class TrainCtx *ctx, class Sample **sampleBlock, int _treeBlock);
   void SetPrebias();
   void Levels();
   void PredicateBits(class BV *bitsLH, class BV *bitsRH, int &lhIdxTot, int &rhIdxTot) const;
@@ -277,6 +325,17 @@ class Index {
   }
 
 
+  bool Splitable(unsigned int idxCount, unsigned int sCount) const;
+
+
+  /**
+     @brief Derives an information threshold for a split's successors.
+
+     @return information threshold.
+   */
+  double MinInfo(double info) const;
+
+
   inline unsigned int SCount(int splitIdx) const {
     return indexNode[splitIdx].sCount;
   }
@@ -309,6 +368,8 @@ class Index {
     return pathNext;
   }
 
+  unsigned int NextCarry(unsigned int idxNext, unsigned int ptId, unsigned int _start, unsigned int idxCount, unsigned int sCount, double sum, double minInfo, unsigned char _path, const class SSNode *ss, const DeferSplit *held);
+
 
   /**
      @brief Computes a level-relative offset for an indexed Pretree node.
@@ -316,9 +377,11 @@ class Index {
      @param ptId is the node index, assumed to be at or above 'levelBase'.
 
      @return the level-relative offset.  A negative offset, in particular,
-     distinguishes nodes belonging to earlier levels.
+     distinguishes nodes belonging to earlier levels, unless carried.
   */
   inline int LevelOffPT(unsigned int ptId) const {
+    if (ptId < levelBase && ptId < ptCarry.size() && ptCarry[ptId] != noCarry)
+      return ptCarry[ptId];
     return ptId - levelBase;
   }
 
@@ -17,6 +17,8 @@
 #include "predblock.h"
 #include "sample.h"
 #include "bv.h"
+#include "checkpoint.h"
+#include "dedup.h"
 
 #include <algorithm>
 using namespace std;
@@ -28,8 +30,12 @@ Leaf::Leaf(std::vector<unsigned int> &_origin, std::vector<LeafNode> &_leafNode,
 
 
 /**
+   @param _scoreOut, if non-null, holds per-leaf scores of a multi-output
+   response.
+
+   @param _nOut is the number of outputs.
  */
-LeafReg::LeafReg(std::vector<unsigned int> &_origin, std::vector<LeafNode> &_leafNode, std::vector<BagRow> &_bagRow, std::vector<unsigned int> &_rank) : Leaf(_origin, _leafNode, _bagRow),  rank(_rank) {
+LeafReg::LeafReg(std::vector<unsigned int> &_origin, std::vector<LeafNode> &_leafNode, std::vector<BagRow> &_bagRow, std::vector<unsigned int> &_rank, std::vector<double> *_scoreOut, unsigned int _nOut) : Leaf(_origin, _leafNode, _bagRow),  rank(_rank), scoreOut(_scoreOut), nOut(_nOut) {
 }
 
 
@@ -56,6 +62,8 @@ void Leaf::Reserve(unsigned int leafEst, unsigned int bagEst) {
 void LeafReg::Reserve(unsigned int leafEst, unsigned int bagEst) {
   Leaf::Reserve(leafEst, bagEst);
   rank.reserve(bagEst);
+  if (scoreOut != 0)
+    scoreOut->reserve(leafEst * nOut);
 }
 
 
@@ -126,6 +134,8 @@ void LeafReg::Leaves(const Sample *sample, const std::vector<unsigned int> &leaf
   NodeExtent(sample, leafMap, leafCount, tIdx);
   RowBag(sample, leafMap, leafCount, tIdx);
   Scores(sample, leafMap, leafCount, tIdx);
+  if (scoreOut != 0)
+    ScoresOut((const SampleReg *) sample, leafMap, leafCount, tIdx);
 }
 
 
@@ -153,6 +163,34 @@ void LeafReg::Scores(const Sample *sample, const std::vector<unsigned int> &leaf
 }
 
 
+/**
+   @brief Derives per-output scores for a multi-output tree, as Scores()
+   does for the leading output.  A lone output is read from the sample's
+   sums, as the sampler records separate outputs only when there are
+   several.
+
+   @return void, with side-effected score vector.
+ */
+void LeafReg::ScoresOut(const SampleReg *sample, const std::vector<unsigned int> &leafMap, unsigned int leafCount, unsigned int tIdx) {
+  unsigned int outBase = Origin(tIdx) * nOut;
+  scoreOut->insert(scoreOut->end(), leafCount * nOut, 0.0);
+  std::vector<unsigned int> sCount(leafCount);
+  for (unsigned int sIdx = 0; sIdx < sample->BagCount(); sIdx++) {
+    unsigned int leafIdx = leafMap[sIdx];
+    for (unsigned int outIdx = 0; outIdx < nOut; outIdx++) {
+      (*scoreOut)[outBase + leafIdx * nOut + outIdx] += nOut == 1 ? sample->Sum(sIdx) : sample->OutSum(sIdx, outIdx);
+    }
+    sCount[leafIdx] += sample->SCount(sIdx);
+  }
+
+  for (unsigned int leafIdx = 0; leafIdx < leafCount; leafIdx++) {
+    for (unsigned int outIdx = 0; outIdx < nOut; outIdx++) {
+      (*scoreOut)[outBase + leafIdx * nOut + outIdx] /= sCount[leafIdx];
+    }
+  }
+}
+
+
 /**
    @brief Writes the current tree origin and computes the extent of each leaf node.
 
@@ -210,6 +248,73 @@ void Leaf::RowBag(const Sample *sample, const std::vector<unsigned int> &leafMap
 }
 
 
+/**
+   @brief Rebuilds leaf extents and the bag from rows routed through the
+   forest, as though every row were bagged once by every tree.  Within a
+   leaf, rows are bagged in increasing order.
+
+   @param rowLeaf gives the tree-relative leaf reached by each row,
+   row-major.
+
+   @param nRow is the number of rows routed.
+
+   @return void, with side-effected extents and bag.
+ */
+void Leaf::RefitBag(const std::vector<unsigned int> &rowLeaf, unsigned int nRow) {
+  for (unsigned int idx = 0; idx < leafNode.size(); idx++) {
+    leafNode[idx].Count() = 0;
+  }
+  for (unsigned int row = 0; row < nRow; row++) {
+    for (unsigned int tIdx = 0; tIdx < nTree; tIdx++) {
+      leafNode[NodeIdx(tIdx, rowLeaf[row * nTree + tIdx])].Count()++;
+    }
+  }
+
+  std::vector<unsigned int> sampleOffset(leafNode.size());
+  SampleOffset(sampleOffset, 0, leafNode.size(), 0);
+  BagRow brInit;
+  brInit.Init();
+  bagRow.assign(nRow * nTree, brInit);
+  for (unsigned int row = 0; row < nRow; row++) {
+    for (unsigned int tIdx = 0; tIdx < nTree; tIdx++) {
+      bagRow[sampleOffset[NodeIdx(tIdx, rowLeaf[row * nTree + tIdx])]++].Set(row, 1);
+    }
+  }
+}
+
+
+/**
+   @brief Refits scores and ranks to rows routed through the forest.
+   Leaves reached by no row keep their scores.
+
+   @param rowLeaf gives the tree-relative leaf reached by each row,
+   row-major.
+
+   @param y is the response of the routed rows.
+
+   @param row2Rank is the rank of each routed row's response.
+
+   @return void, with side-effected leaves, bag and ranks.
+ */
+void LeafReg::Refit(const std::vector<unsigned int> &rowLeaf, const std::vector<double> &y, const std::vector<unsigned int> &row2Rank) {
+  RefitBag(rowLeaf, y.size());
+  rank = std::vector<unsigned int>(y.size() * NTree());
+  unsigned int bagIdx = 0;
+  for (unsigned int idx = 0; idx < NodeCount(); idx++) {
+    unsigned int extent = Extent(idx);
+    if (extent == 0)
+      continue;
+    double sum = 0.0;
+    for (unsigned int bagEnd = bagIdx + extent; bagIdx < bagEnd; bagIdx++) {
+      unsigned int row = Row(bagIdx);
+      rank[bagIdx] = row2Rank[row];
+      sum += y[row];
+    }
+    Score(idx) = sum / extent;
+  }
+}
+
+
 void LeafReg::RankInit(unsigned int bagCount, unsigned int init) {
   rank.insert(rank.end(), bagCount, 0);
 }
@@ -297,6 +402,57 @@ void LeafCtg::Scores(const SampleCtg *sample, const std::vector<unsigned int> &l
 }
 
 
+/**
+   @brief Refits weights and scores to rows routed through the forest.
+   Leaves reached by no row keep their weights and scores.
+
+   @param rowLeaf gives the tree-relative leaf reached by each row,
+   row-major.
+
+   @param yCtg is the zero-based response of the routed rows.
+
+   @param yProxy are the rows' category weights.  A leaf whose rows all
+   have zero weight is refit by row counts.
+
+   @return void, with side-effected leaves, bag and weights.
+ */
+void LeafCtg::Refit(const std::vector<unsigned int> &rowLeaf, const std::vector<unsigned int> &yCtg, const std::vector<double> &yProxy) {
+  unsigned int nRow = yCtg.size();
+  RefitBag(rowLeaf, nRow);
+  unsigned int bagIdx = 0;
+  for (unsigned int idx = 0; idx < NodeCount(); idx++) {
+    unsigned int extent = Extent(idx);
+    if (extent == 0)
+      continue;
+    double *leafWeight = &weight[idx * ctgWidth];
+    std::fill(leafWeight, leafWeight + ctgWidth, 0.0);
+    double leafSum = 0.0;
+    unsigned int bagStart = bagIdx;
+    for (unsigned int bagEnd = bagIdx + extent; bagIdx < bagEnd; bagIdx++) {
+      unsigned int row = Row(bagIdx);
+      leafWeight[yCtg[row]] += yProxy[row];
+      leafSum += yProxy[row];
+    }
+    if (leafSum <= 0.0) { // Weightless proxies:  falls back to row counts.
+      for (unsigned int idxBag = bagStart; idxBag < bagIdx; idxBag++)
+        leafWeight[yCtg[Row(idxBag)]] += 1.0;
+      leafSum = extent;
+    }
+
+    double maxWeight = 0.0;
+    unsigned int argMax = 0;
+    for (unsigned int ctg = 0; ctg < ctgWidth; ctg++) {
+      leafWeight[ctg] /= leafSum;
+      if (leafWeight[ctg] > maxWeight) {
+        maxWeight = leafWeight[ctg];
+        argMax = ctg;
+      }
+    }
+    Score(idx) = argMax + maxWeight / (nRow * NTree());
+  }
+}
+
+
 /**
  */
 unsigned int LeafCtg::LeafCount(std::vector<unsigned int> _origin, unsigned int weightLen, unsigned int _ctgWidth, unsigned int tIdx) {
@@ -347,8 +503,14 @@ void LeafCtg::ForestWeight(double *defaultWeight) const {
 
 
 /**
+   @brief Exports per-tree leaf and bag contents.
+
+   @param rowUnique, if nonempty, maps each original row to the distinct
+   row trained in its place.  Bags are then reported over original rows.
+
+   @return void, with output reference parameters.
  */
-void LeafReg::Export(const std::vector<unsigned int> &_origin, const std::vector<LeafNode> &_leafNode, const vector<BagRow> &_bagRow, const std::vector<unsigned int> &_rank, std::vector<std::vector<unsigned int> > &rowTree, std::vector<std::vector<unsigned int> > &sCountTree, std::vector<std::vector<double> > &scoreTree, std::vector<std::vector<unsigned int> >&extentTree, std::vector< std::vector<unsigned int> > &rankTree) {
+void LeafReg::Export(const std::vector<unsigned int> &_origin, const std::vector<LeafNode> &_leafNode, const vector<BagRow> &_bagRow, const std::vector<unsigned int> &_rank, std::vector<std::vector<unsigned int> > &rowTree, std::vector<std::vector<unsigned int> > &sCountTree, std::vector<std::vector<double> > &scoreTree, std::vector<std::vector<unsigned int> >&extentTree, std::vector< std::vector<unsigned int> > &rankTree, const std::vector<unsigned int> &rowUnique) {
   Leaf::Export(_origin, _leafNode, _bagRow, rowTree, sCountTree);
   LeafNode::Export(_origin, _leafNode, scoreTree, extentTree);
   unsigned int bagOrig = 0;
@@ -358,6 +520,8 @@ void LeafReg::Export(const std::vector<unsigned int> &_origin, const std::vector
     TreeExport(_rank, bagOrig, bagCount, rankTree[tIdx]);
     bagOrig += bagCount;
   }
+  if (!rowUnique.empty())
+    Dedup::BagExpand(rowUnique, rowTree, sCountTree, extentTree, &rankTree);
 }
 
 
@@ -424,8 +588,14 @@ void LeafNode::TreeExport(const std::vector<LeafNode> &_leafNode, unsigned int t
 
 
 /**
+   @brief Exports per-tree leaf and bag contents.
+
+   @param rowUnique, if nonempty, maps each original row to the distinct
+   row trained in its place.  Bags are then reported over original rows.
+
+   @return void, with output reference parameters.
  */
-void LeafCtg::Export(const std::vector<unsigned int> &_origin, const std::vector<LeafNode> &_leafNode, const std::vector<BagRow> &_bagRow, const std::vector<double> &_weight, unsigned int _ctgWidth, std::vector<std::vector<unsigned int> > &rowTree, std::vector<std::vector<unsigned int> > &sCountTree, std::vector<std::vector<double> > &scoreTree, std::vector<std::vector<unsigned int> > &extentTree, std::vector<std::vector<double> > &weightTree) {
+void LeafCtg::Export(const std::vector<unsigned int> &_origin, const std::vector<LeafNode> &_leafNode, const std::vector<BagRow> &_bagRow, const std::vector<double> &_weight, unsigned int _ctgWidth, std::vector<std::vector<unsigned int> > &rowTree, std::vector<std::vector<unsigned int> > &sCountTree, std::vector<std::vector<double> > &scoreTree, std::vector<std::vector<unsigned int> > &extentTree, std::vector<std::vector<double> > &weightTree, const std::vector<unsigned int> &rowUnique) {
   Leaf::Export(_origin, _leafNode, _bagRow, rowTree, sCountTree);
   LeafNode::Export(_origin, _leafNode, scoreTree, extentTree);
   for (unsigned int tIdx = 0; tIdx < _origin.size(); tIdx++) {
@@ -433,6 +603,8 @@ void LeafCtg::Export(const std::vector<unsigned int> &_origin, const std::vector
     weightTree[tIdx] = std::vector<double>(leafCount * _ctgWidth);
     TreeExport(_weight, _ctgWidth, _origin[tIdx] * _ctgWidth, leafCount, weightTree[tIdx]);
   }
+  if (!rowUnique.empty())
+    Dedup::BagExpand(rowUnique, rowTree, sCountTree, extentTree);
 }
 
 
@@ -445,3 +617,94 @@ void LeafCtg::TreeExport(const std::vector<double> &leafWeight, unsigned int _ct
     }
   }
 }
+
+
+/**
+   @brief Records the leaf segment of a block of completed trees.
+
+   @param ckpt is the checkpoint record under construction.
+
+   @param tStart is the index of the block's first tree.
+
+   @param tEnd is the index one beyond the block's last tree.
+
+   @return starting offset of the block's bagged rows.
+ */
+unsigned int Leaf::Dump(Checkpoint *ckpt, unsigned int tStart, unsigned int tEnd) const {
+  unsigned int bagBlock = 0;
+  for (unsigned int leafIdx = origin[tStart]; leafIdx < leafNode.size(); leafIdx++) {
+    bagBlock += leafNode[leafIdx].Extent();
+  }
+  unsigned int bagBase = bagRow.size() - bagBlock;
+
+  ckpt->Put(origin, tStart, tEnd);
+  ckpt->Put(leafNode, origin[tStart], leafNode.size());
+  ckpt->Put(bagRow, bagBase, bagRow.size());
+
+  return bagBase;
+}
+
+
+/**
+   @brief Appends a leaf segment recorded by Dump().
+
+   @param ckpt is the checkpoint record under review.
+
+   @param tStart is the index of the segment's first tree.
+
+   @return void.
+ */
+void Leaf::Restore(Checkpoint *ckpt, unsigned int tStart) {
+  ckpt->Get(origin, tStart);
+  ckpt->Get(leafNode, leafNode.size());
+  ckpt->Get(bagRow, bagRow.size());
+}
+
+
+/**
+   @brief Appends per-sample ranks, and any multi-output scores, to the
+   base segment.
+
+   @return starting offset of the block's bagged rows.
+ */
+unsigned int LeafReg::Dump(Checkpoint *ckpt, unsigned int tStart, unsigned int tEnd) const {
+  unsigned int bagBase = Leaf::Dump(ckpt, tStart, tEnd);
+  ckpt->Put(rank, bagBase, rank.size());
+  if (scoreOut != 0)
+    ckpt->Put(*scoreOut, Origin(tStart) * nOut, scoreOut->size());
+
+  return bagBase;
+}
+
+
+/**
+   @return void.
+ */
+void LeafReg::Restore(Checkpoint *ckpt, unsigned int tStart) {
+  Leaf::Restore(ckpt, tStart);
+  ckpt->Get(rank, rank.size());
+  if (scoreOut != 0)
+    ckpt->Get(*scoreOut, scoreOut->size());
+}
+
+
+/**
+   @brief Appends per-leaf category weights to the base segment.
+
+   @return starting offset of the block's bagged rows.
+ */
+unsigned int LeafCtg::Dump(Checkpoint *ckpt, unsigned int tStart, unsigned int tEnd) const {
+  unsigned int bagBase = Leaf::Dump(ckpt, tStart, tEnd);
+  ckpt->Put(weight, Origin(tStart) * ctgWidth, weight.size());
+
+  return bagBase;
+}
+
+
+/**
+   @return void.
+ */
+void LeafCtg::Restore(Checkpoint *ckpt, unsigned int tStart) {
+  Leaf::Restore(ckpt, tStart);
+  ckpt->Get(weight, weight.size());
+}
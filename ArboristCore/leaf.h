@@ -79,7 +79,7 @@ class LeafNode {
 
      @return void, with output reference parameters.
    */
-  inline void Ref(double &_score, unsigned int _extent) const {
+  inline void Ref(double &_score, unsigned int &_extent) const {
     _score = score;
     _extent = extent;
   }
@@ -143,6 +143,7 @@ class Leaf {
   static unsigned int BagCount(const std::vector<unsigned int> &_origin, const std::vector<LeafNode> &_leafNode, unsigned int tIdx);
   static void Export(const std::vector<unsigned int> &_origin, const std::vector<LeafNode> &_leafNode, const std::vector<BagRow> &_bagRow, std::vector< std::vector<unsigned int> > &rowTree, std::vector< std::vector<unsigned int> >&sCountTree);
   void NodeExtent(const class Sample *sample, std::vector<unsigned int> leafMap, unsigned int leafCount, unsigned int tIdx);
+  void RefitBag(const std::vector<unsigned int> &rowLeaf, unsigned int nRow);
 
  public:
   Leaf(std::vector<unsigned int> &_origin, std::vector<LeafNode> &_leafNode, std::vector<BagRow> &_bagRow);
@@ -152,12 +153,14 @@ class Leaf {
   virtual void Leaves(const class Sample *sample, const std::vector<unsigned int> &leafMap, unsigned int tIdx) = 0;
   virtual void RankInit(unsigned int bagCount, unsigned int init) = 0;
   virtual void RankSet(unsigned int sOff, const class Sample *sample, unsigned int sIdx) = 0;
+  virtual unsigned int Dump(class Checkpoint *ckpt, unsigned int tStart, unsigned int tEnd) const;
+  virtual void Restore(class Checkpoint *ckpt, unsigned int tStart);
 
   class BitMatrix *ForestBag(unsigned int rowTrain);
   
   void SampleOffset(std::vector<unsigned int> &sampleOffset, unsigned int leafBase, unsigned int leafCount, unsigned int sampleBase) const;
 
-  inline unsigned Origin(unsigned int tIdx) {
+  inline unsigned Origin(unsigned int tIdx) const {
     return origin[tIdx];
   }
 
@@ -216,14 +219,21 @@ class Leaf {
   inline unsigned int SCount(unsigned int idx) const {
     return bagRow[idx].SCount();
   }
+
+  inline unsigned int Row(unsigned int idx) const {
+    return bagRow[idx].Row();
+  }
 };
 
 
 class LeafReg : public Leaf {
   std::vector<unsigned int> &rank;
+  std::vector<double> *scoreOut; // Multi-output:  scores by leaf, then output.
+  const unsigned int nOut;
   static void TreeExport(const std::vector<unsigned int> &_rank, unsigned int bagOrig, unsigned int bagCount, std::vector<unsigned int> &rankTree);
 
   void Scores(const class Sample *sample, const std::vector<unsigned int> &leafMap, unsigned int leafCount, unsigned int tIdx);
+  void ScoresOut(const class SampleReg *sample, const std::vector<unsigned int> &leafMap, unsigned int leafCount, unsigned int tIdx);
 
 
   /**
@@ -257,14 +267,17 @@ class LeafReg : public Leaf {
 
 
  public:
-  LeafReg(std::vector<unsigned int> &_origin, std::vector<LeafNode> &_leafNode, std::vector<BagRow> &_bagRow, std::vector<unsigned int> &_rank);
+  LeafReg(std::vector<unsigned int> &_origin, std::vector<LeafNode> &_leafNode, std::vector<BagRow> &_bagRow, std::vector<unsigned int> &_rank, std::vector<double> *_scoreOut = 0, unsigned int _nOut = 1);
   ~LeafReg();
-  static void Export(const std::vector<unsigned int> &_origin, const std::vector<LeafNode> &_leafNode, const std::vector<BagRow> &_bagRow, const std::vector<unsigned int> &_rank, std::vector<std::vector<unsigned int> >&rowTree, std::vector<std::vector<unsigned int> > &sCountTree, std::vector<std::vector<double> > &scoreTree, std::vector<std::vector<unsigned int> >&extentTree, std::vector< std::vector<unsigned int> > &rankTree);
+  static void Export(const std::vector<unsigned int> &_origin, const std::vector<LeafNode> &_leafNode, const std::vector<BagRow> &_bagRow, const std::vector<unsigned int> &_rank, std::vector<std::vector<unsigned int> >&rowTree, std::vector<std::vector<unsigned int> > &sCountTree, std::vector<std::vector<double> > &scoreTree, std::vector<std::vector<unsigned int> >&extentTree, std::vector< std::vector<unsigned int> > &rankTree, const std::vector<unsigned int> &rowUnique = std::vector<unsigned int>());
   
   void Reserve(unsigned int leafEst, unsigned int bagEst);
   void Leaves(const class Sample *sample, const std::vector<unsigned int> &leafMap, unsigned int tIdx);
+  void Refit(const std::vector<unsigned int> &rowLeaf, const std::vector<double> &y, const std::vector<unsigned int> &row2Rank);
   void RankInit(unsigned int bagCount, unsigned int init);
   void RankSet(unsigned int sOff, const class Sample *sample, unsigned int sIdx);
+  unsigned int Dump(class Checkpoint *ckpt, unsigned int tStart, unsigned int tEnd) const;
+  void Restore(class Checkpoint *ckpt, unsigned int tStart);
 
   
   /**
@@ -283,7 +296,34 @@ class LeafReg : public Leaf {
   inline unsigned int BagTot() const {
     return rank.size();
   }
-  
+
+
+  /**
+     @return number of outputs scored per leaf.
+   */
+  inline unsigned int NOut() const {
+    return nOut;
+  }
+
+
+  /**
+     @brief Looks up a multi-output leaf score.
+
+     @param outIdx is the output index.
+
+     @return score of the leaf at the output.
+   */
+  inline double GetScoreOut(int tIdx, unsigned int leafIdx, unsigned int outIdx) const {
+    return ScoreOut(NodeIdx(tIdx, leafIdx), outIdx);
+  }
+
+
+  /**
+     @brief As above, but indexed by absolute leaf offset.
+   */
+  inline double ScoreOut(unsigned int idx, unsigned int outIdx) const {
+    return (*scoreOut)[idx * nOut + outIdx];
+  }
 };
 
 
@@ -314,12 +354,14 @@ class LeafCtg : public Leaf {
   LeafCtg(std::vector<unsigned int> &_origin, std::vector<LeafNode> &_leafNode, std::vector<BagRow> &_bagRow, std::vector<double> &_weight);
   ~LeafCtg();
 
-  static void Export(const std::vector<unsigned int> &_origin, const std::vector<LeafNode> &_leafNode, const std::vector<BagRow> &_bagRow, const std::vector<double> &_weight, unsigned int _ctgWidth, std::vector<std::vector<unsigned int> > &rowTree, std::vector<std::vector<unsigned int> > &sCountTree, std::vector<std::vector<double> > &scoreTree, std::vector<std::vector<unsigned int> > &extentTree, std::vector<std::vector<double> > &_weightTree);
+  static void Export(const std::vector<unsigned int> &_origin, const std::vector<LeafNode> &_leafNode, const std::vector<BagRow> &_bagRow, const std::vector<double> &_weight, unsigned int _ctgWidth, std::vector<std::vector<unsigned int> > &rowTree, std::vector<std::vector<unsigned int> > &sCountTree, std::vector<std::vector<double> > &scoreTree, std::vector<std::vector<unsigned int> > &extentTree, std::vector<std::vector<double> > &_weightTree, const std::vector<unsigned int> &rowUnique = std::vector<unsigned int>());
 
   void Reserve(unsigned int leafEst, unsigned int bagEst);
   
   void RankInit(unsigned int bagCount, unsigned int init) {}
   void RankSet(unsigned int sOff, const class Sample *sample, unsigned int sIdx) {}
+  unsigned int Dump(class Checkpoint *ckpt, unsigned int tStart, unsigned int tEnd) const;
+  void Restore(class Checkpoint *ckpt, unsigned int tStart);
 
   
   inline unsigned int CtgWidth() const {
@@ -350,6 +392,7 @@ class LeafCtg : public Leaf {
   }
 
   void Leaves(const class Sample *sample, const std::vector<unsigned int> &leafMap, unsigned int tIdx);
+  void Refit(const std::vector<unsigned int> &rowLeaf, const std::vector<unsigned int> &yCtg, const std::vector<double> &yProxy);
 
   void ForestWeight(double *defaultWeight) const;
 };
@@ -0,0 +1,55 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file parallel.cc
+
+   @brief Methods for the settings of parallel regions.
+
+   @author Mark Seligman
+ */
+
+#include "parallel.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+unsigned int Parallel::nThread = 0;
+unsigned int Parallel::inlineWork = Parallel::inlineDefault;
+
+
+/**
+   @brief Sets the thread count and inline threshold.
+
+   @param _nThread is the number of threads per region, or zero for
+   the OpenMP default.
+
+   @param _inlineWork is the work below which prediction runs on the
+   calling thread.
+
+   @return void.
+ */
+void Parallel::Set(unsigned int _nThread, unsigned int _inlineWork) {
+  nThread = _nThread;
+  inlineWork = _inlineWork;
+}
+
+
+/**
+   @return number of threads engaged by a parallel region.
+ */
+unsigned int Parallel::Threads() {
+  if (nThread > 0)
+    return nThread;
+
+#ifdef _OPENMP
+  return omp_get_max_threads();
+#else
+  return 1;
+#endif
+}
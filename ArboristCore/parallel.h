@@ -0,0 +1,67 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file parallel.h
+
+   @brief Process-wide settings governing the parallel regions of both
+   training and prediction.
+
+   @author Mark Seligman
+
+ */
+
+#ifndef ARBORIST_PARALLEL_H
+#define ARBORIST_PARALLEL_H
+
+
+/**
+   @brief Thread count and inline threshold, shared by all parallel
+   regions.  OpenMP retains its team between regions, so a region costs
+   a wake-up rather than a thread creation; regions with too little
+   work to repay even that run on the calling thread.  Settings persist
+   until changed by a bridge.
+ */
+class Parallel {
+  static unsigned int nThread; // Zero iff OpenMP default.
+  static unsigned int inlineWork; // Work below which regions run inline.
+ public:
+  static const unsigned int inlineDefault = 1 << 14;
+
+  static void Set(unsigned int _nThread, unsigned int _inlineWork);
+  static unsigned int Threads();
+
+
+  /**
+     @return number of threads explicitly requested, or zero.
+   */
+  static inline unsigned int NThread() {
+    return nThread;
+  }
+
+
+  /**
+     @brief Determines whether a region is worth parallelizing.
+
+     @param work is the region's size, in the caller's units.
+
+     @return true iff work suffices to engage the team.
+   */
+  static inline bool Engage(unsigned long work) {
+    return work >= inlineWork;
+  }
+
+
+  /**
+     @return work threshold below which regions run inline.
+   */
+  static inline unsigned int InlineWork() {
+    return inlineWork;
+  }
+};
+
+#endif
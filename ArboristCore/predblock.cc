@@ -15,6 +15,8 @@
 
 #include "predblock.h"
 
+#include <map>
+
 unsigned int PredBlock::nPredNum = 0;
 unsigned int PredBlock::nPredFac = 0;
 unsigned int PredBlock::nRow = 0;
@@ -78,3 +80,54 @@ void PBPredict::DeImmutables() {
   feFacT = 0;
   PredBlock::DeImmutables();
 }
+
+
+/**
+   @brief Recodes test factor values to the level order seen in training,
+   once, before prediction.  Levels absent from training receive the
+   proxy code one past the highest training level.
+
+   @param feFac is the column-major block of zero-based factor codes.
+
+   @param nRow is the number of rows in the block.
+
+   @param levelTest are the level names of each test factor.
+
+   @param levelTrain are the level names of each training factor.
+
+   @return true iff some test level was not observed in training.
+ */
+bool PBPredict::FactorRemap(int feFac[], unsigned int nRow, const std::vector<std::vector<std::string> > &levelTest, const std::vector<std::vector<std::string> > &levelTrain) {
+  bool unseen = false;
+  for (unsigned int col = 0; col < levelTest.size(); col++) {
+    const std::vector<std::string> &colTest = levelTest[col];
+    const std::vector<std::string> &colTrain = levelTrain[col];
+    if (colTest == colTrain)
+      continue;
+
+    std::map<std::string, int> trainCode;
+    for (unsigned int i = 0; i < colTrain.size(); i++)
+      trainCode[colTrain[i]] = i;
+
+    std::vector<int> remap(colTest.size());
+    for (unsigned int i = 0; i < colTest.size(); i++) {
+      std::map<std::string, int>::const_iterator it = trainCode.find(colTest[i]);
+      if (it == trainCode.end()) {
+        remap[i] = colTrain.size();
+        unseen = true;
+      }
+      else {
+        remap[i] = it->second;
+      }
+    }
+
+    int *colFac = &feFac[col * nRow];
+    for (unsigned int row = 0; row < nRow; row++) {
+      int code = colFac[row];
+      if (code >= 0 && code < int(remap.size()))
+        colFac[row] = remap[code];
+    }
+  }
+
+  return unseen;
+}
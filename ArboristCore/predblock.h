@@ -17,6 +17,8 @@
 #define ARBORIST_PREDBLOCK_H
 
 #include <vector>
+#include <string>
+#include <climits>
 
 /**
    @brief For now, all members are static and initialized once per training or
@@ -67,6 +69,14 @@ class PredBlock {
     return nRow;
   }
 
+
+  /**
+     @return rank shared by missing numeric values:  exceeds all observed ranks.
+   */
+  static inline unsigned int NARank() {
+    return nRow;
+  }
+
   /**
      @return number of observation predictors.
   */
@@ -182,6 +192,17 @@ class PBTrain : public PredBlock {
     unsigned int predBase = predIdx * nRow;
     return 0.5 * (feNum[predBase + rowLow] + feNum[predBase + rowHigh]);
   }
+
+
+  /**
+     @brief Looks up a numeric predictor's value at a row.  Same
+     indexing assumption as MeanVal().
+
+     @return predictor value, NaN if missing.
+   */
+  static inline double NumVal(unsigned int predIdx, unsigned int row) {
+    return feNum[predIdx * nRow + row];
+  }
 };
 
 
@@ -189,10 +210,12 @@ class PBPredict : public PredBlock {
  public:
   static double *feNumT;
   static int *feFacT;
+  static const unsigned int naCode = UINT_MAX; // Code of missing values.
 
   static void Immutables(double *_feNumT, int *_feFacT, unsigned int _nPredNum, unsigned int _nPredFac, unsigned int _nRow);
 
   static void DeImmutables();
+  static bool FactorRemap(int feFac[], unsigned int nRow, const std::vector<std::vector<std::string> > &levelTest, const std::vector<std::vector<std::string> > &levelTrain);
 
   /**
      @return base address for (transposed) numeric values at row.
@@ -0,0 +1,214 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file predcache.cc
+
+   @brief Methods for caching per-row prediction outputs.
+
+   @author Mark Seligman
+ */
+
+#include "predcache.h"
+#include "hash.h"
+
+//#include <iostream>
+//using namespace std;
+
+std::vector<CacheShard *> PredictCache::shard;
+std::atomic<unsigned long> PredictCache::hits(0);
+std::atomic<unsigned long> PredictCache::misses(0);
+
+
+/**
+   @brief Sets the capacity, discarding any previous contents.  A zero
+   capacity disables caching.
+
+   @param capacity is the total number of rows retained.
+
+   @return void.
+ */
+void PredictCache::Immutables(unsigned int capacity) {
+  DeImmutables();
+  if (capacity == 0)
+    return;
+
+  unsigned int shardCap = (capacity + nShard - 1) / nShard;
+  for (unsigned int i = 0; i < nShard; i++) {
+    shard.push_back(new CacheShard(shardCap));
+  }
+}
+
+
+/**
+   @brief Disables caching and releases its storage.
+
+   @return void.
+ */
+void PredictCache::DeImmutables() {
+  for (unsigned int i = 0; i < shard.size(); i++) {
+    delete shard[i];
+  }
+  shard.clear();
+  hits = 0;
+  misses = 0;
+}
+
+
+/**
+   @brief Discards all entries, retaining capacity.  To be called from
+   outside of prediction whenever models are reloaded.
+
+   @return void.
+ */
+void PredictCache::Invalidate() {
+  for (unsigned int i = 0; i < shard.size(); i++) {
+    shard[i]->Clear();
+  }
+  hits = 0;
+  misses = 0;
+}
+
+
+/**
+   @brief Reports lookup outcomes since the last reset.
+
+   @return void, with output reference parameters.
+ */
+void PredictCache::Counters(unsigned long &_hits, unsigned long &_misses) {
+  _hits = hits;
+  _misses = misses;
+}
+
+
+/**
+   @brief Looks up a row's outputs under a given model.
+
+   @param modelKey is the fingerprint of the model.
+
+   @param rowKey[] are the row's coded observations.
+
+   @param value[] outputs the cached outputs, on a hit.
+
+   @param width is the number of outputs per row.
+
+   @return true iff the row was found.
+ */
+bool PredictCache::Lookup(unsigned long long modelKey, const unsigned int rowKey[], unsigned int keyLen, double value[], unsigned int width) {
+  unsigned long long hash = Hash::Bytes(rowKey, keyLen * sizeof(unsigned int), modelKey);
+  bool found = shard[(hash >> 32) % nShard]->Lookup(hash, modelKey, rowKey, keyLen, value, width);
+  if (found)
+    hits++;
+  else
+    misses++;
+
+  return found;
+}
+
+
+/**
+   @brief Records a row's outputs under a given model.
+
+   @return void.
+ */
+void PredictCache::Insert(unsigned long long modelKey, const unsigned int rowKey[], unsigned int keyLen, const double value[], unsigned int width) {
+  unsigned long long hash = Hash::Bytes(rowKey, keyLen * sizeof(unsigned int), modelKey);
+  shard[(hash >> 32) % nShard]->Insert(hash, modelKey, rowKey, keyLen, value, width);
+}
+
+
+/**
+   @brief Constructor.  Slots are allocated up front.
+ */
+CacheShard::CacheShard(unsigned int capacity) : entry(std::vector<CacheEntry>(capacity)), hand(0) {
+  Clear();
+}
+
+
+/**
+   @brief Empties the shard.
+
+   @return void.
+ */
+void CacheShard::Clear() {
+  std::lock_guard<std::mutex> guard(lock);
+  for (unsigned int slot = 0; slot < entry.size(); slot++) {
+    entry[slot].live = false;
+    entry[slot].referenced = false;
+  }
+  slotOf.clear();
+  hand = 0;
+}
+
+
+/**
+   @brief Compares the full key on a hash match, so that collisions
+   read as misses.
+
+   @return true iff the row was found.
+ */
+bool CacheShard::Lookup(unsigned long long hash, unsigned long long modelKey, const unsigned int rowKey[], unsigned int keyLen, double value[], unsigned int width) {
+  std::lock_guard<std::mutex> guard(lock);
+  std::unordered_map<unsigned long long, unsigned int>::const_iterator it = slotOf.find(hash);
+  if (it == slotOf.end())
+    return false;
+
+  CacheEntry &hit = entry[it->second];
+  if (hit.modelKey != modelKey || hit.rowKey.size() != keyLen || hit.value.size() != width || std::memcmp(&hit.rowKey[0], rowKey, keyLen * sizeof(unsigned int)) != 0)
+    return false;
+
+  std::memcpy(value, &hit.value[0], width * sizeof(double));
+  hit.referenced = true;
+  return true;
+}
+
+
+/**
+   @brief Sweeps the CLOCK hand to the first unreferenced slot, clearing
+   reference bits as it passes.
+
+   @return slot index to overwrite.
+ */
+unsigned int CacheShard::Victim() {
+  while (entry[hand].live && entry[hand].referenced) {
+    entry[hand].referenced = false;
+    hand = (hand + 1) % entry.size();
+  }
+  unsigned int slot = hand;
+  hand = (hand + 1) % entry.size();
+
+  return slot;
+}
+
+
+/**
+   @brief Stores a row's outputs, replacing any entry of the same hash.
+
+   @return void.
+ */
+void CacheShard::Insert(unsigned long long hash, unsigned long long modelKey, const unsigned int rowKey[], unsigned int keyLen, const double value[], unsigned int width) {
+  std::lock_guard<std::mutex> guard(lock);
+  std::unordered_map<unsigned long long, unsigned int>::const_iterator it = slotOf.find(hash);
+  unsigned int slot;
+  if (it != slotOf.end()) {
+    slot = it->second;
+  }
+  else {
+    slot = Victim();
+    if (entry[slot].live)
+      slotOf.erase(entry[slot].hash);
+    slotOf[hash] = slot;
+  }
+
+  CacheEntry &ent = entry[slot];
+  ent.hash = hash;
+  ent.modelKey = modelKey;
+  ent.rowKey.assign(rowKey, rowKey + keyLen);
+  ent.value.assign(value, value + width);
+  ent.referenced = false;
+  ent.live = true;
+}
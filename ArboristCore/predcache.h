@@ -0,0 +1,95 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file predcache.h
+
+   @brief Data structures and methods for caching per-row prediction
+   outputs across prediction calls.
+
+   @author Mark Seligman
+
+ */
+
+#ifndef ARBORIST_PREDCACHE_H
+#define ARBORIST_PREDCACHE_H
+
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <unordered_map>
+#include <cstring>
+
+
+/**
+   @brief A cached row:  the model and coded observations identifying
+   it, together with its prediction outputs.
+ */
+class CacheEntry {
+ public:
+  unsigned long long hash;
+  unsigned long long modelKey;
+  std::vector<unsigned int> rowKey;
+  std::vector<double> value;
+  bool referenced; // CLOCK bit, set on each hit.
+  bool live;
+};
+
+
+/**
+   @brief One independently-locked partition of the cache, evicting by
+   the CLOCK approximation to least-recently-used.
+ */
+class CacheShard {
+  std::mutex lock;
+  std::vector<CacheEntry> entry;
+  std::unordered_map<unsigned long long, unsigned int> slotOf; // Hash to slot.
+  unsigned int hand; // CLOCK position.
+
+  unsigned int Victim();
+
+ public:
+  CacheShard(unsigned int capacity);
+
+  bool Lookup(unsigned long long hash, unsigned long long modelKey, const unsigned int rowKey[], unsigned int keyLen, double value[], unsigned int width);
+  void Insert(unsigned long long hash, unsigned long long modelKey, const unsigned int rowKey[], unsigned int keyLen, const double value[], unsigned int width);
+  void Clear();
+};
+
+
+/**
+   @brief Bounded, concurrent cache of prediction outputs, keyed by a
+   model fingerprint and the row's coded observations.  Disabled unless
+   given a capacity.  Persists between prediction calls, so bridges must
+   invalidate it on model reload; fingerprints also distinguish models,
+   so an omitted invalidation costs only capacity.
+ */
+class PredictCache {
+  static const unsigned int nShard = 16;
+  static std::vector<CacheShard *> shard;
+  static std::atomic<unsigned long> hits;
+  static std::atomic<unsigned long> misses;
+
+ public:
+  static void Immutables(unsigned int capacity);
+  static void DeImmutables();
+  static void Invalidate();
+  static void Counters(unsigned long &_hits, unsigned long &_misses);
+
+  static bool Lookup(unsigned long long modelKey, const unsigned int rowKey[], unsigned int keyLen, double value[], unsigned int width);
+  static void Insert(unsigned long long modelKey, const unsigned int rowKey[], unsigned int keyLen, const double value[], unsigned int width);
+
+
+  /**
+     @return true iff a capacity has been set.
+   */
+  static inline bool Enabled() {
+    return !shard.empty();
+  }
+};
+
+#endif
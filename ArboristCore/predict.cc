@@ -19,8 +19,12 @@
 #include "predict.h"
 #include "quant.h"
 #include "bv.h"
+#include "predcache.h"
+#include "hash.h"
+#include "parallel.h"
 
 #include <cfloat>
+#include <cmath>
 #include <algorithm>
 //#include <iostream>
 //using namespace std;
@@ -28,78 +32,458 @@
 
 /**
    @brief Static entry for regression case.
+
+   @param treeSel lists the trees to consult, in order, or is empty if all.
+
+   @param modelId identifies the model to the prediction cache, if nonzero.
  */
-void Predict::Regression(double *_blockNumT, int *_blockFacT, unsigned int _nPredNum, unsigned int _nPredFac, std::vector<ForestNode> &_forestNode, std::vector<unsigned int> &_origin, std::vector<unsigned int> &_facOff, std::vector<unsigned int> &_facSplit, std::vector<unsigned int> &_leafOrigin, std::vector<LeafNode> &_leafNode, std::vector<BagRow> &_bagRow, std::vector<unsigned int> &_rank, const std::vector<double> &yRanked, std::vector<double> &yPred, unsigned int bagTrain) {
-  int nTree = _origin.size();
-  unsigned int _nRow = yPred.size();
-  PBPredict::Immutables(_blockNumT, _blockFacT, _nPredNum, _nPredFac, _nRow);
-  LeafReg *leafReg = new LeafReg(_leafOrigin, _leafNode, _bagRow, _rank);
-  PredictReg *predictReg = new PredictReg(leafReg, yRanked, nTree, _nRow, _leafNode.size());
-  Forest *forest =  new Forest(_forestNode, _origin, _facOff, _facSplit, predictReg);
-  BitMatrix *bag = leafReg->ForestBag(bagTrain);
-  predictReg->PredictAcross(forest, yPred, bag);
-
-  delete bag;
-  delete predictReg;
-  delete forest;
-  delete leafReg;
-  PBPredict::DeImmutables();
+void Predict::Regression(double *_blockNumT, int *_blockFacT, unsigned int _nPredNum, unsigned int _nPredFac, const ForestCompact &_forest, std::vector<unsigned int> &_leafOrigin, std::vector<LeafNode> &_leafNode, std::vector<BagRow> &_bagRow, std::vector<unsigned int> &_rank, const std::vector<double> &yRanked, std::vector<double> &yPred, unsigned int bagTrain, const std::vector<unsigned int> &treeSel, unsigned long long modelId) {
+  PredictBatch *batch = new PredictBatch(_blockNumT, _blockFacT, _nPredNum, _nPredFac, yPred.size());
+  batch->AddReg(_forest, _leafOrigin, _leafNode, _bagRow, _rank, yRanked, yPred, bagTrain, treeSel, 0, 0, 0, 0, 0, modelId);
+  batch->Run();
+
+  delete batch;
+}
+
+
+/**
+   @brief Static entry for multi-output regression.  The leading output is
+   scored into a scratch vector, as its ranks serve only the scalar path.
+
+   @param _scoreOut holds the per-leaf output scores, leaf-major.
+
+   @param yOut outputs the scores, row-major, with one column per output.
+
+   @param treeSel lists the trees to consult, in order, or is empty if all.
+
+   @param modelId identifies the model to the prediction cache, if nonzero.
+ */
+void Predict::RegressionMulti(double *_blockNumT, int *_blockFacT, unsigned int _nPredNum, unsigned int _nPredFac, const ForestCompact &_forest, std::vector<unsigned int> &_leafOrigin, std::vector<LeafNode> &_leafNode, std::vector<BagRow> &_bagRow, std::vector<unsigned int> &_rank, std::vector<double> &_scoreOut, const std::vector<double> &yRanked, std::vector<double> &yOut, unsigned int bagTrain, const std::vector<unsigned int> &treeSel, unsigned long long modelId) {
+  unsigned int nOut = _scoreOut.size() / _leafNode.size();
+  std::vector<double> yPred(yOut.size() / nOut);
+  PredictBatch *batch = new PredictBatch(_blockNumT, _blockFacT, _nPredNum, _nPredFac, yPred.size());
+  batch->AddReg(_forest, _leafOrigin, _leafNode, _bagRow, _rank, yRanked, yPred, bagTrain, treeSel, 0, 0, 0, &_scoreOut, &yOut[0], modelId);
+  batch->Run();
+
+  delete batch;
 }
 
 
 /**
    @brief Static entry for regression case.
+
+   @param treeSel lists the trees to consult, in order, or is empty if all.
+
+   @param modelId identifies the model to the prediction cache, if nonzero.
  */
-void Predict::Quantiles(double *_blockNumT, int *_blockFacT, unsigned int _nPredNum, unsigned int _nPredFac, std::vector<ForestNode> &_forestNode, std::vector<unsigned int> &_origin, std::vector<unsigned int> &_facOff, std::vector<unsigned int> &_facSplit, std::vector<unsigned int> &_leafOrigin, std::vector<LeafNode> &_leafNode, std::vector<BagRow> &_bagRow, std::vector<unsigned int> &_rank, const std::vector<double> &yRanked, std::vector<double> &yPred, const std::vector<double> &quantVec, unsigned int qBin, std::vector<double> &qPred, unsigned int bagTrain) {
-  int nTree = _origin.size();
-  unsigned int _nRow = yPred.size();
-  PBPredict::Immutables(_blockNumT, _blockFacT, _nPredNum, _nPredFac, _nRow);
+void Predict::Quantiles(double *_blockNumT, int *_blockFacT, unsigned int _nPredNum, unsigned int _nPredFac, const ForestCompact &_forest, std::vector<unsigned int> &_leafOrigin, std::vector<LeafNode> &_leafNode, std::vector<BagRow> &_bagRow, std::vector<unsigned int> &_rank, const std::vector<double> &yRanked, std::vector<double> &yPred, const std::vector<double> &quantVec, unsigned int qBin, std::vector<double> &qPred, unsigned int bagTrain, const std::vector<unsigned int> &treeSel, unsigned long long modelId) {
+  PredictBatch *batch = new PredictBatch(_blockNumT, _blockFacT, _nPredNum, _nPredFac, yPred.size());
+  batch->AddReg(_forest, _leafOrigin, _leafNode, _bagRow, _rank, yRanked, yPred, bagTrain, treeSel, &quantVec, qBin, &qPred[0], 0, 0, modelId);
+  batch->Run();
+
+  delete batch;
+}
+
+
+/**
+   @brief Entry for separate classification prediction.
+
+   @param treeSel lists the trees to consult, in order, or is empty if all.
+
+   @param earlyTol is negative if all trees are to vote, zero if voting
+   may stop once the outcome is determined, and otherwise the tolerated
+   probability that stopping changes the outcome, under the model
+   described at PredictCtg::Decided().
+
+   @param treesUsed outputs the number of trees walked per row, if non-null.
+ */
+void Predict::Classification(double *_blockNumT, int *_blockFacT, unsigned int _nPredNum, unsigned int _nPredFac, const ForestCompact &_forest, std::vector<unsigned int> &_leafOrigin, std::vector<LeafNode> &_leafNode, std::vector<BagRow> &_bagRow, std::vector<double> &_leafInfoCtg, std::vector<int> &yPred, int *_census, const std::vector<unsigned int> &_yTest, int *_conf, std::vector<double> &_error, double *_prob, unsigned int bagTrain, const std::vector<unsigned int> &treeSel, double earlyTol, unsigned int *treesUsed, unsigned long long modelId) {
+  PredictBatch *batch = new PredictBatch(_blockNumT, _blockFacT, _nPredNum, _nPredFac, yPred.size());
+  batch->AddCtg(_forest, _leafOrigin, _leafNode, _bagRow, _leafInfoCtg, &yPred[0], _census, _yTest, _conf, _error, _prob, bagTrain, treeSel, earlyTol, treesUsed, modelId);
+  batch->Run();
+
+  delete batch;
+}
+
+
+/**
+   @brief Static entry for refitting regression leaves to new data.  The
+   new rows are routed through the unchanged trees, and the leaves' scores,
+   extents, bag and ranks are rebuilt from the rows reaching them.  Every
+   new row is bagged once by every tree, so the refit forest admits no
+   out-of-bag prediction.  Leaves reached by no row keep their scores,
+   with zero extent.  Multi-output scores are not refit.
+
+   @param y is the response of the new rows.
+
+   @param _leafNode holds the leaves to refit, in place.
+
+   @param _bagRow outputs the refit bag.
+
+   @param _rank outputs the refit bag's response ranks.
+
+   @param yRanked outputs the new response, sorted, for quantiles.
+
+   @return void, with output vector parameters.
+ */
+void Predict::RefitRegression(double *_blockNumT, int *_blockFacT, unsigned int _nPredNum, unsigned int _nPredFac, const ForestCompact &_forest, const std::vector<double> &y, std::vector<unsigned int> &_leafOrigin, std::vector<LeafNode> &_leafNode, std::vector<BagRow> &_bagRow, std::vector<unsigned int> &_rank, std::vector<double> &yRanked) {
+  unsigned int nRow = y.size();
+  std::vector<unsigned int> rowLeaf(nRow * _forest.NTree());
+  PredictBatch *batch = new PredictBatch(_blockNumT, _blockFacT, _nPredNum, _nPredFac, nRow);
+  batch->AddLeaf(_forest, _leafNode.size(), rowLeaf);
+  batch->Run();
+  delete batch;
+
+  std::vector<unsigned int> rank2Row(nRow);
+  for (unsigned int row = 0; row < nRow; row++)
+    rank2Row[row] = row;
+  std::stable_sort(rank2Row.begin(), rank2Row.end(), [&y](unsigned int a, unsigned int b) { return y[a] < y[b]; });
+  std::vector<unsigned int> row2Rank(nRow);
+  yRanked = std::vector<double>(nRow);
+  for (unsigned int rank = 0; rank < nRow; rank++) {
+    row2Rank[rank2Row[rank]] = rank;
+    yRanked[rank] = y[rank2Row[rank]];
+  }
+
   LeafReg *leafReg = new LeafReg(_leafOrigin, _leafNode, _bagRow, _rank);
-  PredictReg *predictReg = new PredictReg(leafReg, yRanked, nTree, _nRow, _leafNode.size());
-  Forest *forest =  new Forest(_forestNode, _origin, _facOff, _facSplit, predictReg);
-  BitMatrix *bag = leafReg->ForestBag(bagTrain);
-  Quant *quant = new Quant(predictReg, leafReg, quantVec, qBin);
-  predictReg->PredictAcross(forest, yPred, quant, &qPred[0], bag);
-
-  delete bag;
-  delete predictReg;
+  leafReg->Refit(rowLeaf, y, row2Rank);
   delete leafReg;
-  delete quant;
-  delete forest;
-  
-  PBPredict::DeImmutables();
 }
 
 
 /**
-   @brief Entry for separate classification prediction.
+   @brief Static entry for refitting classification leaves to new data,
+   as with regression.  Leaves reached by no row keep their weights.
+
+   @param yCtg is the zero-based response of the new rows.
+
+   @param yProxy are the rows' category weights, as passed to training.
+
+   @param _leafInfoCtg holds the leaf weights to refit, in place.
+
+   @return void, with output vector parameters.
  */
-void Predict::Classification(double *_blockNumT, int *_blockFacT, unsigned int _nPredNum, unsigned int _nPredFac, std::vector<ForestNode> &_forestNode, std::vector<unsigned int> &_origin, std::vector<unsigned int> &_facOff, std::vector<unsigned int> &_facSplit, std::vector<unsigned int> &_leafOrigin, std::vector<LeafNode> &_leafNode, std::vector<BagRow> &_bagRow, std::vector<double> &_leafInfoCtg, std::vector<int> &yPred, int *_census, const std::vector<unsigned int> &_yTest, int *_conf, std::vector<double> &_error, double *_prob, unsigned int bagTrain) {
-  int nTree = _origin.size();
-  unsigned int _nRow = yPred.size();
-  PBPredict::Immutables(_blockNumT, _blockFacT, _nPredNum, _nPredFac, _nRow);
-  LeafCtg *leafCtg = new LeafCtg(_leafOrigin, _leafNode, _bagRow, _leafInfoCtg);
-  PredictCtg *predictCtg = new PredictCtg(leafCtg, nTree, _nRow, _leafNode.size());
-  Forest *forest = new Forest(_forestNode, _origin, _facOff, _facSplit, predictCtg);
-  BitMatrix *bag = leafCtg->ForestBag(bagTrain);
-  predictCtg->PredictAcross(forest, bag, _census, yPred, _yTest, _conf, _error, _prob);
+void Predict::RefitClassification(double *_blockNumT, int *_blockFacT, unsigned int _nPredNum, unsigned int _nPredFac, const ForestCompact &_forest, const std::vector<unsigned int> &yCtg, const std::vector<double> &yProxy, std::vector<unsigned int> &_leafOrigin, std::vector<LeafNode> &_leafNode, std::vector<BagRow> &_bagRow, std::vector<double> &_leafInfoCtg) {
+  unsigned int nRow = yCtg.size();
+  std::vector<unsigned int> rowLeaf(nRow * _forest.NTree());
+  PredictBatch *batch = new PredictBatch(_blockNumT, _blockFacT, _nPredNum, _nPredFac, nRow);
+  batch->AddLeaf(_forest, _leafNode.size(), rowLeaf);
+  batch->Run();
+  delete batch;
 
-  delete predictCtg;
-  delete forest;
+  LeafCtg *leafCtg = new LeafCtg(_leafOrigin, _leafNode, _bagRow, _leafInfoCtg);
+  leafCtg->Refit(rowLeaf, yCtg, yProxy);
   delete leafCtg;
-  delete bag;
+}
+
+
+/**
+   @brief Sets the observations shared by all models of the batch.
+ */
+PredictBatch::PredictBatch(double *_blockNumT, int *_blockFacT, unsigned int _nPredNum, unsigned int _nPredFac, unsigned int _nRow) : nRow(_nRow), rowTile(tileMin) {
+  PBPredict::Immutables(_blockNumT, _blockFacT, _nPredNum, _nPredFac, _nRow);
+}
+
+
+PredictBatch::~PredictBatch() {
+  for (unsigned int i = 0; i < predict.size(); i++) {
+    delete bag[i];
+    delete predict[i];
+    delete leaf[i];
+  }
   PBPredict::DeImmutables();
 }
 
 
-PredictCtg::PredictCtg(const LeafCtg *_leafCtg, int _nTree, unsigned int _nRow, unsigned int _nonLeafIdx) : Predict(_nTree, _nRow, _nonLeafIdx), leafCtg(_leafCtg), ctgWidth(leafCtg->CtgWidth()), defaultScore(ctgWidth), defaultWeight(new double[ctgWidth]) {
+/**
+   @brief Completes the registration of a model with its forest and bag.
+   The forest arrives compiled, so registration costs nothing per node.
+
+   @param _leaf is the model's leaf set, or null if only routing rows.
+
+   @param _forest is the model's compiled forest, owned by the caller.
+
+   @return void.
+ */
+void PredictBatch::Add(Leaf *_leaf, Predict *_predict, const ForestCompact &_forest, unsigned int bagTrain, unsigned long long cacheKey) {
+  BitMatrix *_bag = _leaf == 0 ? new BitMatrix(0, 0) : _leaf->ForestBag(bagTrain);
+  _predict->Bind(&_forest, _bag, cacheKey);
+
+  leaf.push_back(_leaf);
+  predict.push_back(_predict);
+  forest.push_back(&_forest);
+  bag.push_back(_bag);
+}
+
+
+/**
+   @brief Seeds a model's cache key, if its rows are to be cached.  The
+   key derives from the caller's identifier for the model rather than
+   from the model's contents, which would cost a pass over the forest
+   on every call.  Out-of-bag prediction depends on the row's position
+   as well as its values, so is never cached.
+
+   @param modelId identifies the model, or is zero if not to be cached.
+
+   @return seed key, or zero if rows are not cached.
+ */
+unsigned long long PredictBatch::ModelKey(unsigned long long modelId, const std::vector<unsigned int> &treeSel, unsigned int bagTrain) {
+  if (!PredictCache::Enabled() || bagTrain != 0 || modelId == 0)
+    return 0;
+
+  return Hash::Vec(treeSel, Hash::Val(modelId, 0));
+}
+
+
+/**
+   @brief Registers a regression model, with quantiles if requested.
+
+   @param quantVec lists the quantiles to predict, if non-null.
+
+   @param scoreOut holds multi-output leaf scores, if non-null.
+
+   @param yOut receives the multi-output scores, if non-null.
+
+   @param modelId identifies the model to the prediction cache, or is
+   zero if its rows are not to be cached.  Callers must present a fresh
+   identifier whenever the model changes.
+
+   @return void.
+ */
+void PredictBatch::AddReg(const ForestCompact &_forest, std::vector<unsigned int> &_leafOrigin, std::vector<LeafNode> &_leafNode, std::vector<BagRow> &_bagRow, std::vector<unsigned int> &_rank, const std::vector<double> &yRanked, std::vector<double> &yPred, unsigned int bagTrain, const std::vector<unsigned int> &treeSel, const std::vector<double> *quantVec, unsigned int qBin, double *qPred, std::vector<double> *scoreOut, double *yOut, unsigned long long modelId) {
+  LeafReg *leafReg = new LeafReg(_leafOrigin, _leafNode, _bagRow, _rank, scoreOut, scoreOut != 0 ? scoreOut->size() / _leafNode.size() : 1);
+  PredictReg *predictReg = new PredictReg(leafReg, yRanked, _forest.NTree(), nRow, _leafNode.size(), treeSel, yPred, quantVec, qBin, qPred, yOut);
+  unsigned long long cacheKey = ModelKey(modelId, treeSel, bagTrain);
+  if (cacheKey != 0) {
+    if (quantVec != 0) {
+      cacheKey = Hash::Vec(*quantVec, cacheKey);
+      cacheKey = Hash::Val(qBin, cacheKey);
+    }
+    cacheKey = Hash::Val(scoreOut != 0, cacheKey);
+    cacheKey |= 1; // Nonzero.
+  }
+  Add(leafReg, predictReg, _forest, bagTrain, cacheKey);
+}
+
+
+/**
+   @brief Registers a classification model.
+
+   @param modelId identifies the model to the prediction cache, or is
+   zero if its rows are not to be cached.
+
+   @return void.
+ */
+void PredictBatch::AddCtg(const ForestCompact &_forest, std::vector<unsigned int> &_leafOrigin, std::vector<LeafNode> &_leafNode, std::vector<BagRow> &_bagRow, std::vector<double> &_leafInfoCtg, int *yPred, int *census, const std::vector<unsigned int> &yTest, int *conf, std::vector<double> &error, double *prob, unsigned int bagTrain, const std::vector<unsigned int> &treeSel, double earlyTol, unsigned int *treesUsed, unsigned long long modelId) {
+  LeafCtg *leafCtg = new LeafCtg(_leafOrigin, _leafNode, _bagRow, _leafInfoCtg);
+  PredictCtg *predictCtg = new PredictCtg(leafCtg, _forest.NTree(), nRow, _leafNode.size(), treeSel, yPred, census, yTest, conf, error, prob, earlyTol, treesUsed);
+  unsigned long long cacheKey = ModelKey(modelId, treeSel, bagTrain);
+  if (cacheKey != 0) {
+    cacheKey = Hash::Val(earlyTol, cacheKey);
+    unsigned int width = predictCtg->CacheWidth();
+    cacheKey = Hash::Val(width, cacheKey);
+    cacheKey |= 1; // Nonzero.
+  }
+  Add(leafCtg, predictCtg, _forest, bagTrain, cacheKey);
+}
+
+
+/**
+   @brief Registers a model routing rows to their leaves, without
+   scoring.  Rows are not cached, as no outputs are scored.
+
+   @param nonLeafIdx is the forest's leaf count.
+
+   @param rowLeaf outputs the leaf reached by each row, row-major by
+   tree.
+
+   @return void.
+ */
+void PredictBatch::AddLeaf(const ForestCompact &_forest, unsigned int nonLeafIdx, std::vector<unsigned int> &rowLeaf) {
+  PredictLeaf *predictLeaf = new PredictLeaf(_forest.NTree(), nRow, nonLeafIdx, rowLeaf);
+  Add(0, predictLeaf, _forest, 0, 0);
+}
+
+
+/**
+   @brief Predicts every registered model in a single parallel region.
+   Each worker owns a tile of rows at a time and passes it through all
+   models before moving on, so that the tile's observations are read
+   from memory once.  Coded rows, leaf indices and scores live in
+   per-worker scratch, as do the keys and values of cached rows.
+   Requests too small to repay waking the team run on the calling
+   thread.
+
+   @return void, with models' output parameters side-effected.
+ */
+void PredictBatch::Run() {
+  unsigned int nModel = predict.size();
+  unsigned long work = 0;
+  for (unsigned int model = 0; model < nModel; model++) {
+    work += (unsigned long) nRow * predict[model]->NSel();
+  }
+  bool engage = Parallel::Engage(work);
+  unsigned int nThread = engage ? Parallel::Threads() : 1;
+  TileRows(nThread);
+
+  int tile;
+#pragma omp parallel default(shared) private(tile) if(engage) num_threads(nThread)
+  {
+    unsigned int *rowCode = new unsigned int[std::max(PredBlock::NPredNum(), 1)];
+    unsigned int *rowKey = new unsigned int[std::max(PredBlock::NPred(), 1)];
+    std::vector<unsigned int *> leaves(nModel);
+    std::vector<double *> scratch(nModel);
+    unsigned int cacheWidth = 1;
+    for (unsigned int model = 0; model < nModel; model++) {
+      leaves[model] = new unsigned int[predict[model]->NTree()];
+      predict[model]->ClearLeaves(leaves[model]);
+      scratch[model] = new double[std::max(predict[model]->ScratchWidth(), 1u)];
+      cacheWidth = std::max(cacheWidth, predict[model]->CacheWidth());
+    }
+    double *cacheVal = new double[cacheWidth];
+#pragma omp for schedule(dynamic, 1)
+    for (tile = 0; tile < int(TileCount()); tile++) {
+      unsigned int rowEnd = std::min((tile + 1) * rowTile, nRow);
+      for (unsigned int model = 0; model < nModel; model++) {
+	for (unsigned int row = tile * rowTile; row < rowEnd; row++) {
+	  PredictRow(model, row, rowCode, leaves[model], scratch[model], rowKey, cacheVal);
+	}
+      }
+    }
+    for (unsigned int model = 0; model < nModel; model++) {
+      delete [] scratch[model];
+      delete [] leaves[model];
+    }
+    delete [] cacheVal;
+    delete [] rowKey;
+    delete [] rowCode;
+  }
+
+  for (unsigned int model = 0; model < nModel; model++) {
+    predict[model]->Finish();
+  }
+}
+
+
+/**
+   @brief Sizes tiles to give each thread several to balance over,
+   within bounds keeping per-tile scheduling cost small and the tile's
+   observations resident in cache.
+
+   @param nThread is the number of threads engaged.
+
+   @return void.
+ */
+void PredictBatch::TileRows(unsigned int nThread) {
+  rowTile = nRow / (nThread * tilesPerThread);
+  if (rowTile < tileMin)
+    rowTile = tileMin;
+  else if (rowTile > tileMax)
+    rowTile = tileMax;
+}
+
+
+/**
+   @brief Predicts a single row of a model, consulting the prediction
+   cache if the model's rows are cached.  The row is keyed by its
+   observations as coded by the cut table compiled with the model, so
+   that rows differing only between thresholds share an entry, and
+   keys are stable across calls.  The lookup precedes any walk, and
+   the key doubles as the coded row on a miss.
+
+   @param rowCode[] is scratch space for the coded row, if uncached.
+
+   @param rowKey[] is scratch space for the key.
+
+   @param cacheVal[] is scratch space for the cached outputs.
+
+   @return void.
+ */
+void PredictBatch::PredictRow(unsigned int model, unsigned int row, unsigned int rowCode[], unsigned int leaves[], double scratch[], unsigned int rowKey[], double cacheVal[]) {
+  Predict *pred = predict[model];
+  if (pred->CacheKey() == 0) {
+    forest[model]->CodeRow(row, rowCode);
+    pred->PredictRow(row, rowCode, leaves, scratch);
+    return;
+  }
+
+  unsigned int nPredNum = PredBlock::NPredNum();
+  forest[model]->CodeRow(row, rowKey);
+  const int *rowFac = PBPredict::RowFac(row);
+  for (int i = 0; i < PredBlock::NPredFac(); i++)
+    rowKey[nPredNum + i] = rowFac[i];
+
+  unsigned int width = pred->CacheWidth();
+  if (PredictCache::Lookup(pred->CacheKey(), rowKey, PredBlock::NPred(), cacheVal, width)) {
+    pred->CacheRestore(row, cacheVal);
+  }
+  else {
+    pred->PredictRow(row, rowKey, leaves, scratch);
+    pred->CacheSave(row, cacheVal);
+    PredictCache::Insert(pred->CacheKey(), rowKey, PredBlock::NPred(), cacheVal, width);
+  }
+}
+
+
+/**
+   @brief Base constructor.  An empty selection consults the entire forest.
+ */
+Predict::Predict(int _nTree, unsigned int _nRow, unsigned int _nonLeafIdx, const std::vector<unsigned int> &_treeSel) : nonLeafIdx(_nonLeafIdx), treeSel(_treeSel), nTree(_nTree), nRow(_nRow), forest(0), bag(0), cacheKey(0) {
+  if (treeSel.empty()) {
+    for (int tc = 0; tc < nTree; tc++)
+      treeSel.push_back(tc);
+  }
+}
+
+
+Predict::~Predict() {
+}
+
+
+/**
+   @brief Attaches the forest walked and the bag consulted.
+
+   @param _cacheKey is the model's fingerprint, or zero if not cached.
+
+   @return void.
+ */
+void Predict::Bind(const ForestCompact *_forest, const BitMatrix *_bag, unsigned long long _cacheKey) {
+  forest = _forest;
+  bag = _bag;
+  cacheKey = _cacheKey;
+}
+
+
+/**
+   @brief Constructor.  Lazy defaults are set here, before any worker
+   reads them.
+ */
+PredictCtg::PredictCtg(const LeafCtg *_leafCtg, int _nTree, unsigned int _nRow, unsigned int _nonLeafIdx, const std::vector<unsigned int> &_treeSel, int *_yPred, int *_census, const std::vector<unsigned int> &_yTest, int *_conf, std::vector<double> &_error, double *_prob, double _earlyTol, unsigned int *_treesUsed) : Predict(_nTree, _nRow, _nonLeafIdx, _treeSel), leafCtg(_leafCtg), ctgWidth(leafCtg->CtgWidth()), earlyTol(_earlyTol), earlyBound(earlyTol > 0.0 && earlyTol < 1.0 ? -2.0 * log(earlyTol / NSel()) : 0.0), defaultScore(ctgWidth), defaultWeight(new double[ctgWidth]), yPred(_yPred), census(_census), yTest(_yTest), conf(_conf), error(_error), prob(_prob), treesUsed(_treesUsed) {
   for (unsigned int ctg = 0; ctg < ctgWidth; ctg++) {
     defaultWeight[ctg] = -1.0;
   }
+  (void) DefaultScore();
 }
 
 
-PredictReg::PredictReg(const LeafReg *_leafReg, const std::vector<double> &_yRanked, int _nTree, unsigned int _nRow, unsigned int _nonLeafIdx) : Predict(_nTree, _nRow, _nonLeafIdx), leafReg(_leafReg), yRanked(_yRanked), defaultScore(-DBL_MAX) {
+/**
+   @brief Constructor.  Lazy default is set here, before any worker reads it.
+
+   @param quantVec lists the quantiles to predict, if non-null.
+
+   @param _yOut receives multi-output scores, if non-null.
+ */
+PredictReg::PredictReg(const LeafReg *_leafReg, const std::vector<double> &_yRanked, int _nTree, unsigned int _nRow, unsigned int _nonLeafIdx, const std::vector<unsigned int> &_treeSel, std::vector<double> &_yPred, const std::vector<double> *quantVec, unsigned int qBin, double *_qPred, double *_yOut) : Predict(_nTree, _nRow, _nonLeafIdx, _treeSel), leafReg(_leafReg), yRanked(_yRanked), defaultScore(-DBL_MAX), yPred(_yPred), quant(0), qPred(_qPred), nOut(leafReg->NOut()), yOut(_yOut) {
+  (void) DefaultScore();
+  if (yOut != 0)
+    DefaultOut();
+  if (quantVec != 0)
+    quant = new Quant(this, leafReg, *quantVec, qBin);
+}
+
+
+PredictReg::~PredictReg() {
+  delete quant;
 }
 
 
@@ -122,6 +506,30 @@ double PredictReg::DefaultScore() {
 }
 
 
+/**
+   @brief Sets the default multi-output scores as the means of the leaf
+   scores, weighted by extent.
+
+   @return void.
+ */
+void PredictReg::DefaultOut() {
+  defaultOut = std::vector<double>(nOut);
+  double extentTot = 0.0;
+  for (unsigned int idx = 0; idx < leafReg->NodeCount(); idx++) {
+    double extent = leafReg->Extent(idx);
+    extentTot += extent;
+    for (unsigned int outIdx = 0; outIdx < nOut; outIdx++) {
+      defaultOut[outIdx] += extent * leafReg->ScoreOut(idx, outIdx);
+    }
+  }
+  if (extentTot > 0.0) {
+    for (unsigned int outIdx = 0; outIdx < nOut; outIdx++) {
+      defaultOut[outIdx] /= extentTot;
+    }
+  }
+}
+
+
 /**
    @brief Lazily sets default score.
 
@@ -153,6 +561,9 @@ unsigned int PredictCtg::DefaultScore() {
  */
 double PredictCtg::DefaultWeight(double *weightPredict) {
   if (defaultWeight[0] < 0.0) {
+    for (unsigned int ctg = 0; ctg < ctgWidth; ctg++) {
+      defaultWeight[ctg] = 0.0;
+    }
     leafCtg->ForestWeight(defaultWeight);
   }
 
@@ -168,38 +579,167 @@ double PredictCtg::DefaultWeight(double *weightPredict) {
 }
 
 
-Predict::Predict(int _nTree, unsigned int _nRow, unsigned int _nonLeafIdx) : nonLeafIdx(_nonLeafIdx), nTree(_nTree), nRow(_nRow) {
-  predictLeaves = new unsigned int[rowBlock * nTree];
+PredictCtg::~PredictCtg() {
+  delete [] defaultWeight;
 }
 
 
-Predict::~Predict() {
-  delete [] predictLeaves;
+/**
+   @brief Walks, scores and votes a single row.
+
+   @param scratch[] holds the row's votes, followed by its running
+   category counts.
+
+   @return void, with output parameters.
+ */
+void PredictCtg::PredictRow(unsigned int row, const unsigned int rowCode[], unsigned int leaves[], double scratch[]) {
+  unsigned int walked = NSel();
+  if (earlyTol < 0.0)
+    forest->PredictRow(this, row, rowCode, leaves, bag, TreeSel(), NSel());
+  else
+    walked = WalkEarly(row, rowCode, leaves, scratch + ctgWidth);
+  if (treesUsed != 0)
+    treesUsed[row] = walked;
+  Score(leaves, scratch);
+  if (prob != 0)
+    Prob(leaves, prob + row * ctgWidth);
+  yPred[row] = Vote(scratch, census + row * ctgWidth);
 }
 
 
-PredictCtg::~PredictCtg() {
-  delete [] defaultWeight;
+/**
+   @return prediction and census, followed by probabilities and tree
+   count as requested.
+ */
+unsigned int PredictCtg::CacheWidth() const {
+  return 1 + ctgWidth + (prob != 0 ? ctgWidth : 0) + (treesUsed != 0 ? 1 : 0);
+}
+
+
+/**
+   @brief Copies a row's outputs into the cache layout.
+
+   @return void, with output vector parameter.
+ */
+void PredictCtg::CacheSave(unsigned int row, double value[]) const {
+  unsigned int off = 0;
+  value[off++] = yPred[row];
+  for (unsigned int ctg = 0; ctg < ctgWidth; ctg++)
+    value[off++] = census[row * ctgWidth + ctg];
+  if (prob != 0) {
+    for (unsigned int ctg = 0; ctg < ctgWidth; ctg++)
+      value[off++] = prob[row * ctgWidth + ctg];
+  }
+  if (treesUsed != 0)
+    value[off++] = treesUsed[row];
 }
 
 
-void PredictCtg::PredictAcross(const Forest *forest, const BitMatrix *bag, int *census, std::vector<int> &yPred, const std::vector<unsigned int> &yTest, int *conf, std::vector<double> &error, double *prob) {
-  double *votes = new double[nRow * ctgWidth];
-  for (unsigned int i = 0; i < nRow * ctgWidth; i++)
-    votes[i] = 0;
-  for (unsigned int rowStart = 0; rowStart < nRow; rowStart += rowBlock) {
-    unsigned int rowEnd = std::min(rowStart + rowBlock, nRow);
-    forest->PredictAcross(rowStart, rowEnd, bag);
-    Score(votes, rowStart, rowEnd);
-    if (prob != 0)
-      Prob(prob, rowStart, rowEnd);
+/**
+   @brief Restores a row's outputs from the cache.
+
+   @return void.
+ */
+void PredictCtg::CacheRestore(unsigned int row, const double value[]) {
+  unsigned int off = 0;
+  yPred[row] = value[off++];
+  for (unsigned int ctg = 0; ctg < ctgWidth; ctg++)
+    census[row * ctgWidth + ctg] = value[off++];
+  if (prob != 0) {
+    for (unsigned int ctg = 0; ctg < ctgWidth; ctg++)
+      prob[row * ctgWidth + ctg] = value[off++];
   }
-  Vote(votes, census, &yPred[0]);
-  delete [] votes;
+  if (treesUsed != 0)
+    treesUsed[row] = value[off++];
+}
+
+
+/**
+   @brief Validates against the test vector, if any.
 
+   @return void.
+ */
+void PredictCtg::Finish() {
   if (yTest.size() > 0) {
-    Validate(yTest, &yPred[0], conf, error);
+    Validate(yTest, yPred, conf, error);
+  }
+}
+
+
+/**
+   @brief Walks the selected trees in order, one at a time, until the
+   leading category can no longer be overtaken.  Unwalked trees are
+   marked as bagged, so that scoring sees only the trees consulted.
+
+   @param ctgCount[] is scratch space for the running vote counts.
+
+   @return number of trees walked.
+ */
+unsigned int PredictCtg::WalkEarly(unsigned int row, const unsigned int rowCode[], unsigned int leaves[], double ctgCount[]) {
+  for (unsigned int ctg = 0; ctg < ctgWidth; ctg++) {
+    ctgCount[ctg] = 0.0;
+  }
+
+  const unsigned int *tcSel = TreeSel();
+  unsigned int selIdx = 0;
+  while (selIdx < NSel()) {
+    unsigned int tc = tcSel[selIdx];
+    forest->PredictRow(this, row, rowCode, leaves, bag, &tcSel[selIdx], 1);
+    if (!IsBagged(leaves, tc)) {
+      unsigned int ctg = leafCtg->GetScore(tc, leaves[tc]);
+      ctgCount[ctg] += 1.0;
+    }
+    if (Decided(ctgCount, NSel() - ++selIdx))
+      break;
+  }
+  for (unsigned int selOut = selIdx; selOut < NSel(); selOut++) {
+    BagIdx(leaves, tcSel[selOut]);
   }
+
+  return selIdx;
+}
+
+
+/**
+   @brief Determines whether the remaining trees can be dispensed with.
+   Each remaining tree moves the margin between the leader and the
+   runner-up by at most one vote, so a margin exceeding the number of
+   remaining trees is final.
+
+   Otherwise, if a tolerance is specified, the remaining votes are
+   modelled as independent steps of at most one vote, having no drift
+   toward the runner-up.  Hoeffding's inequality then bounds the
+   probability that they overturn margin 'm' over 'n' trees by
+   exp(-m^2 / 2n).  As the test is repeated after every tree, the
+   tolerance is split evenly across the NSel() checks, so that by the
+   union bound the chance of any premature stop is within tolerance.
+   The guarantee holds only under the model:  trees ordered so that
+   later ones favor the runner-up can defeat it.
+
+   @param ctgCount[] are the vote counts so far.
+
+   @param treesLeft is the number of trees not yet walked.
+
+   @return true iff voting may stop.
+ */
+bool PredictCtg::Decided(const double ctgCount[], unsigned int treesLeft) const {
+  if (treesLeft == 0)
+    return true;
+
+  double top = 0.0;
+  double runner = 0.0;
+  for (unsigned int ctg = 0; ctg < ctgWidth; ctg++) {
+    if (ctgCount[ctg] > top) {
+      runner = top;
+      top = ctgCount[ctg];
+    }
+    else if (ctgCount[ctg] > runner) {
+      runner = ctgCount[ctg];
+    }
+  }
+  double margin = top - runner;
+
+  return margin > treesLeft || (earlyBound > 0.0 && margin * margin >= earlyBound * treesLeft);
 }
 
 
@@ -238,149 +778,238 @@ void PredictCtg::Validate(const std::vector<unsigned int> &yTest, const int yPre
   }
 }
 
- 
+
 /**
    @brief Voting for non-bagged prediction.  Rounds jittered scores to category.
 
-   @param yCtg outputs predicted response.
+   @param votes[] are the row's jittered vote counts.
+
+   @param census[] outputs the row's de-jittered vote counts.
 
-   @return void, with output reference vector.
+   @return predicted category, with output vector parameter.
 */
-void PredictCtg::Vote(double *votes, int census[], int yPred[]) {
-  int row;
+int PredictCtg::Vote(const double votes[], int census[]) {
+  int argMax = -1;
+  double scoreMax = 0.0;
+  for (unsigned int ctg = 0; ctg < ctgWidth; ctg++) {
+    double ctgScore = votes[ctg]; // Jittered vote count.
+    if (ctgScore > scoreMax) {
+      scoreMax = ctgScore;
+      argMax = ctg;
+    }
+    census[ctg] = ctgScore; // De-jittered.
+  }
 
-#pragma omp parallel default(shared) private(row)
-  {
-#pragma omp for schedule(dynamic, 1)
-  for (row = 0; row < int(nRow); row++) {
-    int argMax = -1;
-    double scoreMax = 0.0;
-    double *score = votes + row * ctgWidth;
-    for (unsigned int ctg = 0; ctg < ctgWidth; ctg++) {
-      double ctgScore = score[ctg]; // Jittered vote count.
-      if (ctgScore > scoreMax) {
-	scoreMax = ctgScore;
-	argMax = ctg;
-      }
-      census[row * ctgWidth + ctg] = ctgScore; // De-jittered.
+  return argMax;
+}
+
+
+/**
+   @brief Computes a row's votes from its leaf predictions.
+
+   @param leaves[] are the row's per-tree leaf indices.
+
+   @param votes[] outputs the jittered vote counts.
+
+   @return void, with output vector parameter.
+ */
+void PredictCtg::Score(const unsigned int leaves[], double votes[]) {
+  for (unsigned int ctg = 0; ctg < ctgWidth; ctg++) {
+    votes[ctg] = 0.0;
+  }
+  unsigned int treesSeen = 0;
+  for (unsigned int selIdx = 0; selIdx < NSel(); selIdx++) {
+    unsigned int tc = TreeSel()[selIdx];
+    if (!IsBagged(leaves, tc)) {
+      treesSeen++;
+      double val = leafCtg->GetScore(tc, leaves[tc]);
+      unsigned int ctg = val; // Truncates jittered score for indexing.
+      votes[ctg] += 1 + val - ctg;
     }
-    yPred[row] = argMax;
   }
+  if (treesSeen == 0) {
+    votes[defaultScore] = 1;
   }
 }
 
 
 /**
-   @brief Computes score from leaf predictions.
+   @brief Accumulates a row's category probabilities from its leaves.
 
-   @return internal vote table, with output reference vector.
- */
-void PredictCtg::Score(double *votes, unsigned int rowStart, unsigned int rowEnd) {
-  int blockRow;
+   @param leaves[] are the row's per-tree leaf indices.
 
-// TODO:  Recast loop by blocks, to avoid
-// false sharing.
-#pragma omp parallel default(shared) private(blockRow)
-  {
-#pragma omp for schedule(dynamic, 1)
-  for (blockRow = 0; blockRow < int(rowEnd - rowStart); blockRow++) {
-    double *prediction = votes + (rowStart + blockRow) * ctgWidth;
-    unsigned int treesSeen = 0;
-    for (int tc = 0; tc < nTree; tc++) {
-      if (!IsBagged(blockRow, tc)) {
-	treesSeen++;
-	double val = leafCtg->GetScore(tc, LeafIdx(blockRow, tc));
-	unsigned int ctg = val; // Truncates jittered score for indexing.
-	prediction[ctg] += 1 + val - ctg;
-      }
-    }
-    if (treesSeen == 0) {
+   @param probRow[] outputs the normalized probabilities.
+
+   @return void, with output vector parameter.
+ */
+void PredictCtg::Prob(const unsigned int leaves[], double probRow[]) {
+  double rowSum = 0.0;
+  unsigned int treesSeen = 0;
+  for (unsigned int selIdx = 0; selIdx < NSel(); selIdx++) {
+    unsigned int tc = TreeSel()[selIdx];
+    if (!IsBagged(leaves, tc)) {
+      treesSeen++;
       for (unsigned int ctg = 0; ctg < ctgWidth; ctg++) {
-	prediction[ctg] = 0.0;
+	double idxWeight = leafCtg->WeightCtg(tc, leaves[tc], ctg);
+	probRow[ctg] += idxWeight;
+	rowSum += idxWeight;
       }
-      prediction[DefaultScore()] = 1;
     }
   }
+  if (treesSeen == 0) {
+    rowSum = DefaultWeight(probRow);
   }
+
+  double recipSum = 1.0 / rowSum;
+  for (unsigned int ctg = 0; ctg < ctgWidth; ctg++)
+    probRow[ctg] *= recipSum;
 }
 
 
-void PredictCtg::Prob(double *prob, unsigned int rowStart, unsigned int rowEnd) {
-  for (unsigned int blockRow = 0; blockRow < rowEnd - rowStart; blockRow++) {
-    double *probRow = prob + (rowStart + blockRow) * ctgWidth;
-    double rowSum = 0.0;
-    unsigned int treesSeen = 0;
-    for (int tc = 0; tc < nTree; tc++) {
-      if (!IsBagged(blockRow, tc)) {
-	treesSeen++;
-	for (unsigned int ctg = 0; ctg < ctgWidth; ctg++) {
-	  double idxWeight = leafCtg->WeightCtg(tc, LeafIdx(blockRow, tc), ctg);
-	  probRow[ctg] += idxWeight;
-	  rowSum += idxWeight;
-	}
-      }
-    }
-    if (treesSeen == 0) {
-      rowSum = DefaultWeight(probRow);
-    }
+/**
+   @brief Walks and scores a single row, with quantiles if requested.
 
-    double recipSum = 1.0 / rowSum;
-    for (unsigned int ctg = 0; ctg < ctgWidth; ctg++)
-      probRow[ctg] *= recipSum;
-  }
+   @return void, with side-effected prediction vectors.
+ */
+void PredictReg::PredictRow(unsigned int row, const unsigned int rowCode[], unsigned int leaves[], double scratch[]) {
+  forest->PredictRow(this, row, rowCode, leaves, bag, TreeSel(), NSel());
+  yPred[row] = Score(leaves);
+  if (quant != 0)
+    quant->PredictRow(row, leaves, qPred);
+  if (yOut != 0)
+    ScoreOut(leaves, &yOut[row * nOut]);
 }
 
 
 /**
+   @return score, followed by quantiles and outputs if requested.
  */
-void PredictReg::PredictAcross(const Forest *forest, std::vector<double> &yPred, const BitMatrix *bag) {
-  for (unsigned int rowStart = 0; rowStart < nRow; rowStart += rowBlock) {
-    unsigned int rowEnd = std::min(rowStart + rowBlock, nRow);
-    forest->PredictAcross(rowStart, rowEnd, bag);
-    Score(rowStart, rowEnd, &yPred[rowStart]);
-  }
+unsigned int PredictReg::CacheWidth() const {
+  return 1 + (quant != 0 ? quant->QCount() : 0) + (yOut != 0 ? nOut : 0);
 }
 
 
 /**
-   @brief Predictions for a block of rows, with quantiles.
+   @brief Copies a row's score and quantiles into the cache layout.
 
-   @return void, with side-effected prediction vectors.
+   @return void, with output vector parameter.
  */
-void PredictReg::PredictAcross(const Forest *forest, std::vector<double> &yPred, Quant *quant, double qPred[], const BitMatrix *bag) {
-  for (unsigned int rowStart = 0; rowStart < nRow; rowStart += rowBlock) {
-    unsigned int rowEnd = std::min(rowStart + rowBlock, nRow);
-    forest->PredictAcross(rowStart, rowEnd, bag);
-    Score(rowStart, rowEnd, &yPred[rowStart]);
-    quant->PredictAcross(rowStart, rowEnd, qPred);
+void PredictReg::CacheSave(unsigned int row, double value[]) const {
+  value[0] = yPred[row];
+  unsigned int qCount = quant != 0 ? quant->QCount() : 0;
+  for (unsigned int i = 0; i < qCount; i++)
+    value[1 + i] = qPred[row * qCount + i];
+  if (yOut != 0) {
+    for (unsigned int outIdx = 0; outIdx < nOut; outIdx++)
+      value[1 + qCount + outIdx] = yOut[row * nOut + outIdx];
   }
 }
 
 
+/**
+   @brief Restores a row's score and quantiles from the cache.
+
+   @return void.
+ */
+void PredictReg::CacheRestore(unsigned int row, const double value[]) {
+  yPred[row] = value[0];
+  unsigned int qCount = quant != 0 ? quant->QCount() : 0;
+  for (unsigned int i = 0; i < qCount; i++)
+    qPred[row * qCount + i] = value[1 + i];
+  if (yOut != 0) {
+    for (unsigned int outIdx = 0; outIdx < nOut; outIdx++)
+      yOut[row * nOut + outIdx] = value[1 + qCount + outIdx];
+  }
+}
+
 
 /**
-  @brief Sets regression scores from leaf predictions.
+  @brief Derives a row's regression score from its leaf predictions.
 
-  @param yPred outputs the score predictions.
+  @param leaves[] are the row's per-tree leaf indices.
 
-  @return void, with output refererence vector.
+  @return mean score over trees in which the row is not bagged.
  */
-void PredictReg::Score(unsigned int rowStart, unsigned int rowEnd, double yPred[]) {
-  int blockRow;
+double PredictReg::Score(const unsigned int leaves[]) {
+  double score = 0.0;
+  int treesSeen = 0;
+  for (unsigned int selIdx = 0; selIdx < NSel(); selIdx++) {
+    unsigned int tc = TreeSel()[selIdx];
+    if (!IsBagged(leaves, tc)) {
+      treesSeen++;
+      score += leafReg->GetScore(tc, leaves[tc]);
+    }
+  }
 
-#pragma omp parallel default(shared) private(blockRow)
-  {
-#pragma omp for schedule(dynamic, 1)
-  for (blockRow = 0; blockRow < int(rowEnd - rowStart); blockRow++) {
-      double score = 0.0;
-      int treesSeen = 0;
-      for (int tc = 0; tc < nTree; tc++) {
-        if (!IsBagged(blockRow, tc)) {
-          treesSeen++;
-          score += leafReg->GetScore(tc, LeafIdx(blockRow, tc));
-        }
-      }
-      yPred[blockRow] = treesSeen > 0 ? score / treesSeen : DefaultScore();
+  return treesSeen > 0 ? score / treesSeen : defaultScore;
+}
+
+
+/**
+  @brief Derives a row's multi-output scores from its leaves, as with
+  the scalar score.
+
+  @param leaves[] are the row's per-tree leaf indices.
+
+  @param outRow[] outputs the row's scores.
+
+  @return void, with output parameter.
+ */
+void PredictReg::ScoreOut(const unsigned int leaves[], double outRow[]) const {
+  for (unsigned int outIdx = 0; outIdx < nOut; outIdx++)
+    outRow[outIdx] = 0.0;
+  int treesSeen = 0;
+  for (unsigned int selIdx = 0; selIdx < NSel(); selIdx++) {
+    unsigned int tc = TreeSel()[selIdx];
+    if (!IsBagged(leaves, tc)) {
+      treesSeen++;
+      for (unsigned int outIdx = 0; outIdx < nOut; outIdx++)
+        outRow[outIdx] += leafReg->GetScoreOut(tc, leaves[tc], outIdx);
     }
   }
+
+  for (unsigned int outIdx = 0; outIdx < nOut; outIdx++)
+    outRow[outIdx] = treesSeen > 0 ? outRow[outIdx] / treesSeen : defaultOut[outIdx];
+}
+
+
+/**
+   @brief Constructor.
+
+   @param _rowLeaf outputs the leaf reached by each row, row-major by tree.
+ */
+PredictLeaf::PredictLeaf(int _nTree, unsigned int _nRow, unsigned int _nonLeafIdx, std::vector<unsigned int> &_rowLeaf) : Predict(_nTree, _nRow, _nonLeafIdx, std::vector<unsigned int>()), rowLeaf(_rowLeaf) {
+}
+
+
+/**
+   @brief Walks a single row, recording its leaves.
+
+   @return void, with side-effected leaf vector.
+ */
+void PredictLeaf::PredictRow(unsigned int row, const unsigned int rowCode[], unsigned int leaves[], double scratch[]) {
+  forest->PredictRow(this, row, rowCode, leaves, bag, TreeSel(), NSel());
+  std::copy(leaves, leaves + nTree, rowLeaf.begin() + row * nTree);
+}
+
+
+/**
+   @return zero, as no outputs are cached.
+ */
+unsigned int PredictLeaf::CacheWidth() const {
+  return 0;
+}
+
+
+/**
+   @brief Never invoked, as rows are not cached.
+ */
+void PredictLeaf::CacheSave(unsigned int row, double value[]) const {
+}
+
+
+/**
+   @brief Never invoked, as rows are not cached.
+ */
+void PredictLeaf::CacheRestore(unsigned int row, const double value[]) {
 }
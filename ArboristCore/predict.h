@@ -18,58 +18,159 @@
 
 #include <vector>
 
+/**
+   @brief Traversal and scoring are fused per row:  each worker codes a
+   row, walks the forest for it into private scratch, then scores it
+   immediately.
+ */
 class Predict {
   const unsigned int nonLeafIdx; // Inattainable leaf index value.
+  std::vector<unsigned int> treeSel; // Trees consulted, in walking order.
  protected:
-  static const int rowBlock = 8192;
   const int nTree;
   const unsigned int nRow;
-  unsigned int *predictLeaves;
+  const class ForestCompact *forest;
+  const class BitMatrix *bag;
+  unsigned long long cacheKey; // Model fingerprint; zero iff not cached.
 
  public:  
   
-  Predict(int _nTree, unsigned int _nRow, unsigned int _nonLeafIdx);
+  Predict(int _nTree, unsigned int _nRow, unsigned int _nonLeafIdx, const std::vector<unsigned int> &_treeSel);
   virtual ~Predict();
 
-  static void Regression(double *_blockNumT, int *_blockFacT, unsigned int _nPredNum, unsigned int _nPredFac, std::vector<class ForestNode> &_forestNode, std::vector<unsigned int> &_origin, std::vector<unsigned int> &_facOff, std::vector<unsigned int> &_facSplit, std::vector<unsigned int> &_leafOrigin, std::vector<class LeafNode> &_leafNode, std::vector<class BagRow> &_bagRow, std::vector<unsigned int> &_rank, const std::vector<double> &yRanked, std::vector<double> &yPred, unsigned int bagTrain);
+  static void Regression(double *_blockNumT, int *_blockFacT, unsigned int _nPredNum, unsigned int _nPredFac, const class ForestCompact &_forest, std::vector<unsigned int> &_leafOrigin, std::vector<class LeafNode> &_leafNode, std::vector<class BagRow> &_bagRow, std::vector<unsigned int> &_rank, const std::vector<double> &yRanked, std::vector<double> &yPred, unsigned int bagTrain, const std::vector<unsigned int> &treeSel = std::vector<unsigned int>(), unsigned long long modelId = 0);
+
+
+  static void RegressionMulti(double *_blockNumT, int *_blockFacT, unsigned int _nPredNum, unsigned int _nPredFac, const class ForestCompact &_forest, std::vector<unsigned int> &_leafOrigin, std::vector<class LeafNode> &_leafNode, std::vector<class BagRow> &_bagRow, std::vector<unsigned int> &_rank, std::vector<double> &_scoreOut, const std::vector<double> &yRanked, std::vector<double> &yOut, unsigned int bagTrain, const std::vector<unsigned int> &treeSel = std::vector<unsigned int>(), unsigned long long modelId = 0);
+
+  static void Quantiles(double *_blockNumT, int *_blockFacT, unsigned int _nPredNum, unsigned int _nPredFac, const class ForestCompact &_forest, std::vector<unsigned int> &_leafOrigin, std::vector<LeafNode> &_leafNode, std::vector<class BagRow> &_bagRow, std::vector<unsigned int> &_rank, const std::vector<double> &yRanked, std::vector<double> &yPred, const std::vector<double> &quantVec, unsigned int qBin, std::vector<double> &qPred, unsigned int bagTrain, const std::vector<unsigned int> &treeSel = std::vector<unsigned int>(), unsigned long long modelId = 0);
+
+  static void Classification(double *_blockNumT, int *_blockFacT, unsigned int _nPredNum, unsigned int _nPredFac, const class ForestCompact &_forest, std::vector<unsigned int> &_leafOrigin, std::vector<LeafNode> &_leafNode, std::vector<class BagRow> &_bagRow, std::vector<double> &_leafInfoCtg, std::vector<int> &yPred, int *_census, const std::vector<unsigned int> &_yTest, int *_conf, std::vector<double> &_error, double *_prob, unsigned int bagTrain, const std::vector<unsigned int> &treeSel = std::vector<unsigned int>(), double earlyTol = -1.0, unsigned int *treesUsed = 0, unsigned long long modelId = 0);
 
+  static void RefitRegression(double *_blockNumT, int *_blockFacT, unsigned int _nPredNum, unsigned int _nPredFac, const class ForestCompact &_forest, const std::vector<double> &y, std::vector<unsigned int> &_leafOrigin, std::vector<class LeafNode> &_leafNode, std::vector<class BagRow> &_bagRow, std::vector<unsigned int> &_rank, std::vector<double> &yRanked);
 
-  static void Quantiles(double *_blockNumT, int *_blockFacT, unsigned int _nPredNum, unsigned int _nPredFac, std::vector<ForestNode> &_forestNode, std::vector<unsigned int> &_origin, std::vector<unsigned int> &_facOff, std::vector<unsigned int> &_facSplit, std::vector<unsigned int> &_leafOrigin, std::vector<LeafNode> &_leafNode, std::vector<class BagRow> &_bagRow, std::vector<unsigned int> &_rank, const std::vector<double> &yRanked, std::vector<double> &yPred, const std::vector<double> &quantVec, unsigned int qBin, std::vector<double> &qPred, unsigned int bagTrain);
+  static void RefitClassification(double *_blockNumT, int *_blockFacT, unsigned int _nPredNum, unsigned int _nPredFac, const class ForestCompact &_forest, const std::vector<unsigned int> &yCtg, const std::vector<double> &yProxy, std::vector<unsigned int> &_leafOrigin, std::vector<class LeafNode> &_leafNode, std::vector<class BagRow> &_bagRow, std::vector<double> &_leafInfoCtg);
+
+  void Bind(const class ForestCompact *_forest, const class BitMatrix *_bag, unsigned long long _cacheKey = 0);
 
-  static void Classification(double *_blockNumT, int *_blockFacT, unsigned int _nPredNum, unsigned int _nPredFac, std::vector<class ForestNode> &_forestNode, std::vector<unsigned int> &_origin, std::vector<unsigned int> &_facOff, std::vector<unsigned int> &_facSplit, std::vector<unsigned int> &_leafOrigin, std::vector<LeafNode> &_leafNode, std::vector<class BagRow> &_bagRow, std::vector<double> &_leafInfoCtg, std::vector<int> &yPred, int *_census, const std::vector<unsigned int> &_yTest, int *_conf, std::vector<double> &_error, double *_prob, unsigned int bagTrain);
 
   /**
-     @brief Assigns a proxy leaf index at the prediction coordinates passed.
+     @brief Walks and scores a single row.
+
+     @param row is the row to predict.
+
+     @param rowCode[] is the row's numeric data, coded by the forest.
+
+     @param leaves[] is the worker's leaf scratch for this model.
+
+     @param scratch[] is the worker's scoring scratch for this model.
 
      @return void.
    */
-  inline void BagIdx(unsigned int blockRow, unsigned int tc) {
-    predictLeaves[nTree * blockRow + tc] = nonLeafIdx;
+  virtual void PredictRow(unsigned int row, const unsigned int rowCode[], unsigned int leaves[], double scratch[]) = 0;
+
+
+  /**
+     @brief Post-pass summary, such as validation.
+   */
+  virtual void Finish() {
   }
 
-  
+
+  /**
+     @return number of doubles of scoring scratch needed per worker.
+   */
+  virtual unsigned int ScratchWidth() const {
+    return 0;
+  }
+
+
+  /**
+     @return number of outputs per row, as held by the prediction cache.
+   */
+  virtual unsigned int CacheWidth() const = 0;
+
+
+  /**
+     @brief Copies a row's outputs into the cache's layout.
+
+     @return void, with output vector parameter.
+   */
+  virtual void CacheSave(unsigned int row, double value[]) const = 0;
+
+
+  /**
+     @brief Copies a row's cached outputs back into the model's outputs.
+
+     @return void.
+   */
+  virtual void CacheRestore(unsigned int row, const double value[]) = 0;
+
+
+  /**
+     @return fingerprint under which rows are cached, or zero if rows
+     are not cached.
+   */
+  inline unsigned long long CacheKey() const {
+    return cacheKey;
+  }
+
+
+  /**
+     @return number of trees in the forest.
+   */
+  inline int NTree() const {
+    return nTree;
+  }
+
+
+  /**
+     @return number of trees consulted.
+   */
+  inline unsigned int NSel() const {
+    return treeSel.size();
+  }
+
+
   /**
+     @return base of the consulted tree indices.
    */
-  inline bool IsBagged(unsigned int blockRow, unsigned int tc) const {
-    return predictLeaves[nTree * blockRow + tc] == nonLeafIdx;
+  inline const unsigned int *TreeSel() const {
+    return &treeSel[0];
   }
 
 
   /**
-     @brief Assigns a true leaf index at the prediction coordinates passed.
+     @brief Marks every tree as bagged, so that trees outside the
+     selection never contribute to scoring.
+
+     @param leaves[] are the per-tree leaf indices of a worker's scratch.
 
      @return void.
    */
-  inline void LeafIdx(unsigned int blockRow, unsigned int tc, unsigned int leafIdx) {
-    predictLeaves[nTree * blockRow + tc] = leafIdx;
+  inline void ClearLeaves(unsigned int leaves[]) const {
+    for (int tc = 0; tc < nTree; tc++)
+      leaves[tc] = nonLeafIdx;
+  }
+
+
+  /**
+     @brief Assigns a proxy leaf index to a tree in which the row is bagged.
+
+     @param leaves[] are the row's per-tree leaf indices.
+
+     @return void.
+   */
+  inline void BagIdx(unsigned int leaves[], unsigned int tc) const {
+    leaves[tc] = nonLeafIdx;
   }
 
   
   /**
-     @brief Accessor for prediction at specified coordinates.
+     @return true iff the row's leaf for this tree is the bagged proxy.
    */
-  inline unsigned int LeafIdx(unsigned int blockRow, unsigned int tc) const {
-    return predictLeaves[nTree * blockRow + tc];
+  inline bool IsBagged(const unsigned int leaves[], unsigned int tc) const {
+    return leaves[tc] == nonLeafIdx;
   }
 };
 
@@ -78,14 +179,24 @@ class PredictReg : public Predict {
   const class LeafReg *leafReg;
   const std::vector<double> &yRanked;
   double defaultScore;
-  void Score(unsigned int rowStart, unsigned int rowEnd, double yPred[]);
+  std::vector<double> &yPred;
+  class Quant *quant; // Null unless predicting quantiles.
+  double *qPred;
+  const unsigned int nOut; // Outputs per row.
+  double *yOut; // Multi-output:  scores by row, then output, or null.
+  std::vector<double> defaultOut;
+  double Score(const unsigned int leaves[]);
+  void ScoreOut(const unsigned int leaves[], double outRow[]) const;
   double DefaultScore();
+  void DefaultOut();
  public:
-  PredictReg(const class LeafReg *_leafReg, const std::vector<double> &_yRanked, int _nTree, unsigned int _nRow, unsigned int _nonLeafIdx);
-  ~PredictReg() {}
+  PredictReg(const class LeafReg *_leafReg, const std::vector<double> &_yRanked, int _nTree, unsigned int _nRow, unsigned int _nonLeafIdx, const std::vector<unsigned int> &_treeSel, std::vector<double> &_yPred, const std::vector<double> *quantVec = 0, unsigned int qBin = 0, double *_qPred = 0, double *_yOut = 0);
+  ~PredictReg();
 
-  void PredictAcross(const class Forest *forest, std::vector<double> &yPred, const class BitMatrix *bag);
-  void PredictAcross(const Forest *forest, std::vector<double> &yPred, class Quant *quant, double qPred[], const BitMatrix *bag);
+  void PredictRow(unsigned int row, const unsigned int rowCode[], unsigned int leaves[], double scratch[]);
+  unsigned int CacheWidth() const;
+  void CacheSave(unsigned int row, double value[]) const;
+  void CacheRestore(unsigned int row, const double value[]);
 
   
   /**
@@ -112,18 +223,100 @@ class PredictReg : public Predict {
 class PredictCtg : public Predict {
   const class LeafCtg *leafCtg;
   const unsigned int ctgWidth;
+  const double earlyTol; // Negative iff walking all trees.
+  const double earlyBound; // Squared-margin scale of sequential test, per check.
   unsigned int defaultScore;
   double *defaultWeight;
+  int *yPred;
+  int *census;
+  const std::vector<unsigned int> &yTest;
+  int *conf;
+  std::vector<double> &error;
+  double *prob; // Null unless probabilities requested.
+  unsigned int *treesUsed; // Null unless tree counts requested.
+  unsigned int WalkEarly(unsigned int row, const unsigned int rowCode[], unsigned int leaves[], double ctgCount[]);
+  bool Decided(const double ctgCount[], unsigned int treesLeft) const;
   void Validate(const std::vector<unsigned int> &yTest, const int yPred[], int confusion[], std::vector<double> &error);
-  void Vote(double *votes, int census[], int yPred[]);
-  void Prob(double *prob, unsigned int rowStart, unsigned int rowEnd);
-  void Score(double *votes, unsigned int rowStart, unsigned int rowEnd);
+  int Vote(const double votes[], int census[]);
+  void Prob(const unsigned int leaves[], double probRow[]);
+  void Score(const unsigned int leaves[], double votes[]);
   unsigned int DefaultScore();
   double DefaultWeight(double *weightPredict);
  public:
-  PredictCtg(const class LeafCtg *_leafCtg, int _nTree, unsigned _nRow, unsigned int _nonLeafIdx);
+  PredictCtg(const class LeafCtg *_leafCtg, int _nTree, unsigned _nRow, unsigned int _nonLeafIdx, const std::vector<unsigned int> &_treeSel, int *_yPred, int *_census, const std::vector<unsigned int> &_yTest, int *_conf, std::vector<double> &_error, double *_prob, double _earlyTol = -1.0, unsigned int *_treesUsed = 0);
   ~PredictCtg();
 
-  void PredictAcross(const class Forest *forest, const class BitMatrix *bag, int *census, std::vector<int> &yPred, const std::vector<unsigned int> &yTest, int *conf, std::vector<double> &error, double *prob);
+  void PredictRow(unsigned int row, const unsigned int rowCode[], unsigned int leaves[], double scratch[]);
+  void Finish();
+  unsigned int CacheWidth() const;
+  void CacheSave(unsigned int row, double value[]) const;
+  void CacheRestore(unsigned int row, const double value[]);
+
+
+  /**
+     @return votes and running counts, per category.
+   */
+  unsigned int ScratchWidth() const {
+    return 2 * ctgWidth;
+  }
+};
+
+
+/**
+   @brief Routes rows through the forest without scoring, recording the
+   leaf reached in each tree.  Used to refit leaves to new data.
+ */
+class PredictLeaf : public Predict {
+  std::vector<unsigned int> &rowLeaf; // Tree-relative leaves:  row-major.
+ public:
+  PredictLeaf(int _nTree, unsigned int _nRow, unsigned int _nonLeafIdx, std::vector<unsigned int> &_rowLeaf);
+
+  void PredictRow(unsigned int row, const unsigned int rowCode[], unsigned int leaves[], double scratch[]);
+  unsigned int CacheWidth() const;
+  void CacheSave(unsigned int row, double value[]) const;
+  void CacheRestore(unsigned int row, const double value[]);
+};
+
+
+/**
+   @brief Scores any number of models over a single pass through the
+   observations.  Rows are scheduled in tiles; each tile is run through
+   every model in turn while its observations remain in cache.  Models
+   must have been trained on the same predictor signature.
+ */
+class PredictBatch {
+  static const unsigned int tileMin = 16; // Bounds on rows per tile.
+  static const unsigned int tileMax = 1024;
+  static const unsigned int tilesPerThread = 8; // Slack for load balance.
+  const unsigned int nRow;
+  unsigned int rowTile; // Rows per scheduling unit.
+  std::vector<class Leaf *> leaf;
+  std::vector<class Predict *> predict;
+  std::vector<const class ForestCompact *> forest;
+  std::vector<class BitMatrix *> bag;
+
+  void Add(class Leaf *_leaf, class Predict *_predict, const class ForestCompact &_forest, unsigned int bagTrain, unsigned long long cacheKey);
+  void PredictRow(unsigned int model, unsigned int row, unsigned int rowCode[], unsigned int leaves[], double scratch[], unsigned int rowKey[], double cacheVal[]);
+  void TileRows(unsigned int nThread);
+  static unsigned long long ModelKey(unsigned long long modelId, const std::vector<unsigned int> &treeSel, unsigned int bagTrain);
+
+  /**
+     @return number of tiles spanning the rows.
+   */
+  inline unsigned int TileCount() const {
+    return (nRow + rowTile - 1) / rowTile;
+  }
+
+ public:
+  PredictBatch(double *_blockNumT, int *_blockFacT, unsigned int _nPredNum, unsigned int _nPredFac, unsigned int _nRow);
+  ~PredictBatch();
+
+  void AddReg(const class ForestCompact &_forest, std::vector<unsigned int> &_leafOrigin, std::vector<LeafNode> &_leafNode, std::vector<class BagRow> &_bagRow, std::vector<unsigned int> &_rank, const std::vector<double> &yRanked, std::vector<double> &yPred, unsigned int bagTrain, const std::vector<unsigned int> &treeSel = std::vector<unsigned int>(), const std::vector<double> *quantVec = 0, unsigned int qBin = 0, double *qPred = 0, std::vector<double> *scoreOut = 0, double *yOut = 0, unsigned long long modelId = 0);
+
+  void AddCtg(const class ForestCompact &_forest, std::vector<unsigned int> &_leafOrigin, std::vector<LeafNode> &_leafNode, std::vector<class BagRow> &_bagRow, std::vector<double> &_leafInfoCtg, int *yPred, int *census, const std::vector<unsigned int> &yTest, int *conf, std::vector<double> &error, double *prob, unsigned int bagTrain, const std::vector<unsigned int> &treeSel = std::vector<unsigned int>(), double earlyTol = -1.0, unsigned int *treesUsed = 0, unsigned long long modelId = 0);
+
+  void AddLeaf(const class ForestCompact &_forest, unsigned int nonLeafIdx, std::vector<unsigned int> &rowLeaf);
+
+  void Run();
 };
 #endif
@@ -19,6 +19,7 @@
 #include "forest.h"
 #include "predblock.h"
 #include "samplepred.h"
+#include "trainctx.h"
 
 //#include <iostream>
 using namespace std;
@@ -30,57 +31,19 @@ using namespace std;
 // the need to revise dangling non-terminals from an earlier level.
 //
 
-unsigned int PreTree::nPred = 0;
-unsigned int PreTree::heightEst = 0;
-
-/**
-   @brief Caches the row count and computes an initial estimate of node count.
-
-   @param _nSamp is the number of samples.
-
-   @param _minH is the minimal splitable index node size.
-
-   @return void.
- */
-void PreTree::Immutables(unsigned int _nPred, unsigned int _nSamp, unsigned int _minH) {
-  nPred = _nPred;
-
-  // Static initial estimate of pre-tree heights employs a minimal enclosing
-  // balanced tree.  This is probably naive, given that decision trees
-  // are not generally balanced.
-  //
-  // In any case, 'heightEst' is re-estimated following construction of the
-  // first PreTree block.  Hence the value is not really immutable.  Nodes
-  // can also be reallocated during the interlevel pass as needed.
-  //
-  unsigned twoL = 1; // 2^level, beginning from level zero (root).
-  while (twoL * _minH < _nSamp) {
-    twoL <<= 1;
-  }
-
-  // Terminals plus accumulated nonterminals.
-  heightEst = (twoL << 2); // - 1, for exact count.
-}
-
-
-void PreTree::DeImmutables() {
-  nPred = heightEst = 0;
-}
-
-
 /**
    @brief Per-tree initializations.
 
-   @param _treeBlock is the number of PreTree initialize.
+   @param ctx supplies the predictor count and allocation height estimate.
 
-   @return void.
+   @param _bagCount is the number of bagged samples.
  */
-PreTree::PreTree(unsigned int _bagCount) : height(1), leafCount(1), bitEnd(0), bagCount(_bagCount) {
+PreTree::PreTree(const TrainCtx *ctx, unsigned int _bagCount) : nPred(ctx->nPred), height(1), leafCount(1), bitEnd(0), bagCount(_bagCount) {
   sample2PT = new unsigned int[bagCount];
   for (unsigned int i = 0; i < bagCount; i++) {
     sample2PT[i] = 0;
   }
-  nodeCount = heightEst;   // Initial height estimate.
+  nodeCount = ctx->heightEst;   // Initial height estimate.
   nodeVec = new PTNode[nodeCount];
   nodeVec[0].id = 0; // Root.
   nodeVec[0].lhId = 0; // Initializes as terminal.
@@ -105,20 +68,6 @@ void PreTree::LHBit(int idx, unsigned int pos) {
 }
 
 
-/**
-   @brief Refines the height estimate using the actual height of a
-   constructed PreTree.
-
-   @param height is an actual height value.
-
-   @return void.
- */
-void PreTree::Reserve(unsigned int height) {
-  while (heightEst <= height) // Assigns next power-of-two above 'height'.
-    heightEst <<= 1;
-}
-
-
 /**
    @brief Allocates a zero-valued bit string for the current (pre)tree.
 
@@ -135,6 +84,7 @@ BV *PreTree::BitFactory() {
    @brief Per-tree finalizer.
  */
 PreTree::~PreTree() {
+  delete splitBits; // Nonzero iff never consumed.
   delete [] nodeVec;
   delete [] sample2PT;
   delete [] info;
@@ -194,15 +144,21 @@ void PreTree::NonTerminalFac(double _info, unsigned int _predIdx, unsigned int _
 
    @param _predIdx is the splitting predictor index.
 
+   @param _rkHigh is the lowest rank on the right, possibly the NA rank,
+   in which case the split value degenerates to the highest observed rank.
+
+   @param _naLeft is true iff missing values are sent left.
+
    @param _id is the node index.
 
    @return void.
 */
-void PreTree::NonTerminalNum(double _info, unsigned int _predIdx, unsigned int _rkLow, unsigned int _rkHigh, unsigned int _id, unsigned int &ptLH, unsigned int &ptRH) {
+void PreTree::NonTerminalNum(double _info, unsigned int _predIdx, unsigned int _rkLow, unsigned int _rkHigh, bool _naLeft, unsigned int _id, unsigned int &ptLH, unsigned int &ptRH) {
   TerminalOffspring(_id, ptLH, ptRH);
   PTNode *ptS = &nodeVec[_id];
   ptS->predIdx = _predIdx;
-  ptS->splitVal.rkMean = 0.5 * (double(_rkLow) + double(_rkHigh));
+  ptS->splitVal.rkMean = _rkHigh == PredBlock::NARank() ? _rkLow : 0.5 * (double(_rkLow) + double(_rkHigh));
+  ptS->naLeft = _naLeft;
   info[_predIdx] += _info;
 }
 
@@ -270,6 +226,7 @@ const std::vector<unsigned int> PreTree::DecTree(Forest *forest, unsigned int tI
   NodeConsume(forest, tIdx);
   forest->BitProduce(splitBits, bitEnd);
   delete splitBits;
+  splitBits = 0;
 
   for (unsigned int i = 0; i < nPred; i++)
     predInfo[i] += info[i];
@@ -303,7 +260,8 @@ void PreTree::NodeConsume(Forest *forest, unsigned int tIdx) {
  */
 void PTNode::Consume(Forest *forest, unsigned int tIdx) {
   if (lhId > 0) { // i.e., nonterminal
-    forest->NonterminalProduce(tIdx, id, predIdx, lhId - id, PredBlock::IsFactor(predIdx) ? splitVal.offset : splitVal.rkMean);
+    bool isFactor = PredBlock::IsFactor(predIdx);
+    forest->NonterminalProduce(tIdx, id, predIdx, lhId - id, isFactor ? splitVal.offset : splitVal.rkMean, !isFactor && naLeft);
   }
 }
 
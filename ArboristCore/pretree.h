@@ -38,13 +38,13 @@ class PTNode {
     unsigned int offset; // Bit-vector offset:  factor.
     double rkMean; // Mean rank:  numeric.
   } splitVal;
+  bool naLeft; // Numeric only:  missing values sent left.
   void Consume(class Forest *forest, unsigned int tIdx);
 };
 
 
 class PreTree {
-  static unsigned int nPred;
-  static unsigned int heightEst;
+  const unsigned int nPred;
   PTNode *nodeVec; // Vector of tree nodes.
   int nodeCount; // Allocation height of node vector.
   int height;
@@ -59,11 +59,8 @@ class PreTree {
   unsigned int bagCount;
 
  public:
-  PreTree(unsigned int _bagCount);
+  PreTree(const class TrainCtx *ctx, unsigned int _bagCount);
   ~PreTree();
-  static void Immutables(unsigned int _nPred, unsigned int _nSamp, unsigned int _minH);
-  static void DeImmutables();
-  static void Reserve(unsigned int height);
 
   const std::vector<unsigned int> DecTree(class Forest *forest, unsigned int tIdx, double predInfo[]);
   void NodeConsume(class Forest *forest, unsigned int tIdx);
@@ -83,6 +80,21 @@ class PreTree {
   }
 
 
+  /**
+     @brief Assigns frontier node directly, for trainers which partition
+     samples without Replay().
+
+     @param sIdx is the index of a sample.
+
+     @param ptId is the pretree index of the sample's node.
+
+     @return void.
+   */
+  inline void SampleFrontier(unsigned int sIdx, unsigned int ptId) {
+    sample2PT[sIdx] = ptId;
+  }
+
+
   inline unsigned int LeafCount() const {
     return leafCount;
   }
@@ -99,7 +111,7 @@ class PreTree {
 
   void LHBit(int idx, unsigned int pos);
   void NonTerminalFac(double _info, unsigned int _predIdx, unsigned int _id, unsigned int &ptLH, unsigned int &ptRH);
-  void NonTerminalNum(double _info, unsigned int _predIdx, unsigned int _rkLow, unsigned int _rkHigh, unsigned int _id, unsigned int &ptLH, unsigned int &ptRH);
+  void NonTerminalNum(double _info, unsigned int _predIdx, unsigned int _rkLow, unsigned int _rkHigh, bool _naLeft, unsigned int _id, unsigned int &ptLH, unsigned int &ptRH);
 
   double Replay(class SamplePred *samplePred, unsigned int predIdx, unsigned int targBit, int start, int end, unsigned int ptId);
   
@@ -46,25 +46,17 @@ Quant::~Quant() {
 
 
 /**
-   @brief Fills in the quantile leaves for each row within a contiguous block.
+   @brief Fills in the quantiles of a single row.  Invoked by the
+   prediction worker owning the row.
 
-   @param predictLeaves contains the predicted leaf indices.
+   @param row is the row at which to predict.
 
-   @param rowStart is the first row at which to predict.
-
-   @param rowEnd is first row at which not to predict.
+   @param leaves[] are the row's per-tree leaf indices.
 
    @return void, with output parameter matrix.
  */
-void Quant::PredictAcross(unsigned int rowStart, unsigned int rowEnd, double qPred[]) {
-  int row;
-#pragma omp parallel default(shared) private(row)
-  {
-#pragma omp for schedule(dynamic, 1)
-    for (row = rowStart; row < int(rowEnd); row++) {
-      Leaves(row - rowStart, &qPred[qCount * row]);
-    }
-  }
+void Quant::PredictRow(unsigned int row, const unsigned int leaves[], double qPred[]) {
+  Leaves(leaves, &qPred[qCount * row]);
 }
 
 
@@ -127,7 +119,7 @@ void Quant::SmudgeLeaves() {
 
    @return void, with output vector parameter.
  */
-void Quant::Leaves(unsigned int blockRow, double qRow[]) {
+void Quant::Leaves(const unsigned int leaves[], double qRow[]) {
   unsigned int *sampRanks = new unsigned int[binSize];
   for (unsigned int i = 0; i < binSize; i++)
     sampRanks[i] = 0;
@@ -135,9 +127,10 @@ void Quant::Leaves(unsigned int blockRow, double qRow[]) {
   // Scores each rank seen at every predicted leaf.
   //
   unsigned int totRanks = 0;
-  for (unsigned int tn = 0; tn < leafReg->NTree(); tn++) {
-    if (!predictReg->IsBagged(blockRow, tn)) {
-      unsigned int leafIdx = predictReg->LeafIdx(blockRow, tn);
+  for (unsigned int selIdx = 0; selIdx < predictReg->NSel(); selIdx++) {
+    unsigned int tn = predictReg->TreeSel()[selIdx];
+    if (!predictReg->IsBagged(leaves, tn)) {
+      unsigned int leafIdx = leaves[tn];
       totRanks += (logSmudge == 0) ? RanksExact(tn, leafIdx, sampRanks) : RanksSmudge(tn, leafIdx, sampRanks);
     }
   }
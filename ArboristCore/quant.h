@@ -37,13 +37,21 @@ class Quant {
   
   unsigned int BinSize(unsigned int nRow, unsigned int qBin, unsigned int &_logSmudge);
   void SmudgeLeaves();
-  void Leaves(unsigned int rowBlock, double qRow[]);
+  void Leaves(const unsigned int leaves[], double qRow[]);
   unsigned int RanksExact(unsigned int tIdx, unsigned int leafIdx, unsigned int sampRanks[]);
   unsigned int RanksSmudge(unsigned int tIdx, unsigned int LeafIdx, unsigned int sampRanks[]);
  public:
   Quant(const class PredictReg *_predictReg, const class LeafReg *_leafReg, const std::vector<double> &_qVec, unsigned int qBin);
   ~Quant();
-  void PredictAcross(unsigned int rowStart, unsigned int rowEnd, double qPred[]);
+  void PredictRow(unsigned int row, const unsigned int leaves[], double qPred[]);
+
+
+  /**
+     @return number of quantiles predicted per row.
+   */
+  inline unsigned int QCount() const {
+    return qCount;
+  }
 };
 
 #endif
@@ -21,6 +21,9 @@
 #include "rowrank.h"
 #include "index.h"
 #include "pretree.h"
+#include "shard.h"
+#include "trainctx.h"
+#include "hash.h"
 
 //#include <iostream>
 using namespace std;
@@ -65,8 +68,9 @@ Response::Response(const std::vector<double> &_y, std::vector<unsigned int> &lea
 
    @param _y is the vector numerical/proxy response values.
 
+   @param scoreOut, if non-null, outputs per-leaf multi-output scores.
  */
-Response::Response(const std::vector<double> &_y, std::vector<unsigned int> &leafOrigin, std::vector<LeafNode> &leafNode, std::vector<BagRow> &bagRow, std::vector<unsigned int> &rank) : y(_y), leaf(new LeafReg(leafOrigin, leafNode, bagRow, rank)) {
+Response::Response(const std::vector<double> &_y, std::vector<unsigned int> &leafOrigin, std::vector<LeafNode> &leafNode, std::vector<BagRow> &bagRow, std::vector<unsigned int> &rank, std::vector<double> *scoreOut, unsigned int nOut) : y(_y), leaf(new LeafReg(leafOrigin, leafNode, bagRow, rank, scoreOut, nOut)) {
 }
 
 
@@ -90,10 +94,14 @@ ResponseReg::~ResponseReg() {
 
    @param yRanked is the sorted response.
 
+   @param _scoreOut, if non-null, outputs per-leaf multi-output scores.
+
+   @param _nOut is the number of response outputs.
+
    @return void, with output reference vector.
  */
-ResponseReg *Response::FactoryReg(const std::vector<double> &yNum, const std::vector<unsigned int> &_row2Rank, std::vector<unsigned int> &_leafOrigin, std::vector<LeafNode> &_leafNode, std::vector<BagRow> &bagRow, std::vector<unsigned int> &_rank) {
-  return new ResponseReg(yNum, _row2Rank, _leafOrigin, _leafNode, bagRow, _rank);
+ResponseReg *Response::FactoryReg(const std::vector<double> &yNum, const std::vector<unsigned int> &_row2Rank, std::vector<unsigned int> &_leafOrigin, std::vector<LeafNode> &_leafNode, std::vector<BagRow> &bagRow, std::vector<unsigned int> &_rank, std::vector<double> *_scoreOut, unsigned int _nOut) {
+  return new ResponseReg(yNum, _row2Rank, _leafOrigin, _leafNode, bagRow, _rank, _scoreOut, _nOut);
 }
 
 
@@ -104,86 +112,121 @@ ResponseReg *Response::FactoryReg(const std::vector<double> &yNum, const std::ve
 
    @param yRanked outputs the sorted response needed for quantile ranking.
  */
-ResponseReg::ResponseReg(const std::vector<double> &_y, const std::vector<unsigned int> &_row2Rank, std::vector<unsigned int> &leafOrigin, std::vector<LeafNode> &leafNode, std::vector<BagRow> &bagRow, std::vector<unsigned int> &rank) : Response(_y, leafOrigin, leafNode, bagRow, rank), row2Rank(_row2Rank) {
+ResponseReg::ResponseReg(const std::vector<double> &_y, const std::vector<unsigned int> &_row2Rank, std::vector<unsigned int> &leafOrigin, std::vector<LeafNode> &leafNode, std::vector<BagRow> &bagRow, std::vector<unsigned int> &rank, std::vector<double> *scoreOut, unsigned int nOut) : Response(_y, leafOrigin, leafNode, bagRow, rank, scoreOut, nOut), row2Rank(_row2Rank) {
 }
 
 
 /**
    @brief Causes a block of classification trees to be sampled.
 
+   @param ctx holds the fit's parameters.
+
    @param rowRank is the predictor rank information.
 
    @param blockSize is the number of trees in the block.
 
-   @return block of SampleCtg instances.
+   @param sampleBlock outputs the block's Sample instances, which live
+   until the block has been consumed.
+
+   @return block of PreTree instances, with output reference parameter.
  */
-PreTree **Response::BlockTree(const RowRank *rowRank, unsigned int blockSize) {
+PreTree **Response::BlockTree(TrainCtx *ctx, const RowRank *rowRank, unsigned int blockSize, Sample **&sampleBlock) {
   sampleBlock = new Sample*[blockSize];
   for (unsigned int i = 0; i < blockSize; i++) {
-    sampleBlock[i] = Sampler(rowRank);
+    sampleBlock[i] = Sampler(ctx, rowRank);
   }
 
-  return Index::BlockTrees(sampleBlock, blockSize);
+  return ctx->nShard > 0 ? ShardTrain::BlockTrees(ctx, sampleBlock, rowRank, blockSize) : Index::BlockTrees(ctx, sampleBlock, blockSize);
 }
 
 
 /**
    @return Regression-style Sample object.
  */
-Sample *ResponseReg::Sampler(const class RowRank *rowRank) {
-  return Sample::FactoryReg(Y(), rowRank, row2Rank);
+Sample *ResponseReg::Sampler(const TrainCtx *ctx, const RowRank *rowRank) {
+  return Sample::FactoryReg(ctx, Y(), rowRank, row2Rank);
 }
 
 
 /**
    @return Classification-style Sample object.
  */
-Sample *ResponseCtg::Sampler(const class RowRank *rowRank) {
-  return Sample::FactoryCtg(Y(), rowRank, yCtg);
+Sample *ResponseCtg::Sampler(const TrainCtx *ctx, const RowRank *rowRank) {
+  return Sample::FactoryCtg(ctx, Y(), rowRank, yCtg);
 }
 
 
 /**
-   @brief Deletes Sample objects belonging to the current block.
+   @brief Deletes Sample objects belonging to a consumed block.
 
-   @param blockSize is the number of objects in the current block.
+   @param sampleBlock is the block of Sample objects.
+
+   @param blockSize is the number of objects in the block.
 
    @return void.
  */
-void Response::DeBlock(unsigned int blockSize) {
+void Response::DeBlock(Sample **sampleBlock, unsigned int blockSize) {
   for (unsigned int blockIdx = 0; blockIdx < blockSize; blockIdx++) {
     delete sampleBlock[blockIdx];
   }
   delete [] sampleBlock;
-  sampleBlock = 0;
 }
 
 
 /**
    @brief Fills in leaves for a tree.
 
-   @param leafMap maps sampled indices to leaf indices.
+   @param sample is the tree's Sample object.
 
-   @param blockIdx is the block-based index of a Sample.
+   @param leafMap maps sampled indices to leaf indices.
 
    @param tIdx is the absolute tree index.
 
    @return void, with side-effected Leaf object.
  */
-void Response::Leaves(const std::vector<unsigned int> &leafMap, unsigned int blockIdx, unsigned int tIdx) {
-  leaf->Leaves(sampleBlock[blockIdx], leafMap, tIdx);    
+void Response::Leaves(const Sample *sample, const std::vector<unsigned int> &leafMap, unsigned int tIdx) {
+  leaf->Leaves(sample, leafMap, tIdx);
+}
+
+
+/**
+   @brief Records the leaf segment of a block of completed trees.
+
+   @return void.
+ */
+void Response::Dump(Checkpoint *ckpt, unsigned int tStart, unsigned int tEnd) const {
+  leaf->Dump(ckpt, tStart, tEnd);
 }
 
 
 /**
-   @brief Exposes in-bag vectors within sample block.
+   @brief Appends a leaf segment recorded by Dump().
 
-   @param blockIdx is the block-based index of a Sample.
+   @return void.
+ */
+void Response::Restore(Checkpoint *ckpt, unsigned int tStart) {
+  leaf->Restore(ckpt, tStart);
+}
+
+
+/**
+   @brief Chains a hash of the response onto a seed.
+
+   @return updated hash.
+ */
+unsigned long long Response::Fingerprint(unsigned long long seed) const {
+  return Hash::Vec(y, seed);
+}
+
+
+/**
+   @brief Chains a hash of the categorical response and its proxy onto a
+   seed.
 
-   @return the in-bag vector for the tree at the referenced index.
+   @return updated hash.
  */
-const BV *Response::TreeBag(unsigned int blockIdx) {
-  return sampleBlock[blockIdx]->TreeBag();
+unsigned long long ResponseCtg::Fingerprint(unsigned long long seed) const {
+  return Hash::Vec(yCtg, Response::Fingerprint(seed));
 }
 
 
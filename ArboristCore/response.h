@@ -26,25 +26,26 @@
 class Response {
   const std::vector<double> &y;
   class Leaf *leaf;
-  class Sample** sampleBlock;
  public:
   Response(const std::vector<double> &_y, std::vector<unsigned int> &leafOrigin, std::vector<class LeafNode> &leafNode, std::vector<class BagRow> &bagRow, std::vector<double> &weight, unsigned int ctgWidth);
-  Response(const std::vector<double> &_y, std::vector<unsigned int> &leafOrigin, std::vector<class LeafNode> &leafNode, std::vector<class BagRow> &bagRow, std::vector<unsigned int> &rank);
+  Response(const std::vector<double> &_y, std::vector<unsigned int> &leafOrigin, std::vector<class LeafNode> &leafNode, std::vector<class BagRow> &bagRow, std::vector<unsigned int> &rank, std::vector<double> *scoreOut, unsigned int nOut);
   virtual ~Response();
 
   const std::vector<double> &Y() {
     return y;
   }
-  static class ResponseReg *FactoryReg(const std::vector<double> &yNum, const std::vector<unsigned int> &_row2Rank, std::vector<unsigned int> &_leafOrigin, std::vector<class LeafNode> &_leafNode, std::vector<class BagRow> &bagRow, std::vector<unsigned int> &_rank);
+  static class ResponseReg *FactoryReg(const std::vector<double> &yNum, const std::vector<unsigned int> &_row2Rank, std::vector<unsigned int> &_leafOrigin, std::vector<class LeafNode> &_leafNode, std::vector<class BagRow> &bagRow, std::vector<unsigned int> &_rank, std::vector<double> *_scoreOut = 0, unsigned int _nOut = 1);
   static class ResponseCtg *FactoryCtg(const std::vector<unsigned int> &feCtg, const std::vector<double> &feProxy, std::vector<unsigned int> &leafOrigin, std::vector<class LeafNode> &leafNode, std::vector<class BagRow> &bagRow,std::vector<double> &weight, unsigned int ctgWidth);
 
-  class PreTree **BlockTree(const class RowRank *rowRank, unsigned int blockSize);
-  const class BV *TreeBag(unsigned int blockIdx);
+  class PreTree **BlockTree(class TrainCtx *ctx, const class RowRank *rowRank, unsigned int blockSize, class Sample **&sampleBlock);
   void LeafReserve(unsigned int leafEst, unsigned int bagEst);
-  void DeBlock(unsigned int blockSize);
-  void Leaves(const std::vector<unsigned int> &leafMap, unsigned int blockIdx, unsigned int tIdx);
+  void DeBlock(class Sample **sampleBlock, unsigned int blockSize);
+  void Leaves(const class Sample *sample, const std::vector<unsigned int> &leafMap, unsigned int tIdx);
+  void Dump(class Checkpoint *ckpt, unsigned int tStart, unsigned int tEnd) const;
+  void Restore(class Checkpoint *ckpt, unsigned int tStart);
+  virtual unsigned long long Fingerprint(unsigned long long seed) const;
 
-  virtual class Sample* Sampler(const class RowRank *rowRank) = 0;
+  virtual class Sample* Sampler(const class TrainCtx *ctx, const class RowRank *rowRank) = 0;
 };
 
 
@@ -55,9 +56,9 @@ class ResponseReg : public Response {
   const std::vector<unsigned int> &row2Rank; // Facilitates rank[] output.
  public:
 
-  ResponseReg(const std::vector<double> &_y, const std::vector<unsigned int> &_row2Rank, std::vector<unsigned int> &leafOrigin, std::vector<class LeafNode> &leafNode, std::vector<class BagRow> &bagRow, std::vector<unsigned int> &rank);
+  ResponseReg(const std::vector<double> &_y, const std::vector<unsigned int> &_row2Rank, std::vector<unsigned int> &leafOrigin, std::vector<class LeafNode> &leafNode, std::vector<class BagRow> &bagRow, std::vector<unsigned int> &rank, std::vector<double> *scoreOut, unsigned int nOut);
   ~ResponseReg();
-  class Sample *Sampler(const class RowRank *rowRank);
+  class Sample *Sampler(const class TrainCtx *ctx, const class RowRank *rowRank);
 };
 
 /**
@@ -69,7 +70,8 @@ class ResponseCtg : public Response {
 
   ResponseCtg(const std::vector<unsigned int> &_yCtg, const std::vector<double> &_proxy, std::vector<unsigned int> &leafOrigin, std::vector<LeafNode> &leafNode, std::vector<class BagRow> &bagRow, std::vector<double> &weight, unsigned int ctgWidth);
   ~ResponseCtg();
-  class Sample *Sampler(const class RowRank *rowRank);
+  unsigned long long Fingerprint(unsigned long long seed) const;
+  class Sample *Sampler(const class TrainCtx *ctx, const class RowRank *rowRank);
 };
 
 #endif
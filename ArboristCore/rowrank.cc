@@ -16,6 +16,7 @@
 #include "rowrank.h"
 #include "predblock.h"
 #include "callback.h"
+#include "hash.h"
 #include "math.h"
 
 #include <algorithm>
@@ -39,25 +40,34 @@
 
    @param nRow is the number of observation rows. 
 
-   @param rank outputs the tie-classed predictor ranks.
+   @param rank outputs the tie-classed predictor ranks.  Missing values
+   receive the NA rank, 'nRow', which exceeds all observed ranks.
 
    @param feInvNum outputs a rank-to-row map.
 
    @output void, with output vector parameters.
  */
 void RowRank::PreSortNum(const double _feNum[], unsigned int _nPredNum, unsigned int _nRow, unsigned int _rowOrd[], unsigned int _rank[], unsigned int _feInvNum[]) {
-  // Builds the ranked numeric block.
+  // Builds the ranked numeric block.  Missing values are partitioned to
+  // the tail of each column, so that only observed values are sorted.
   //
   double *numOrd = new double[_nRow * _nPredNum];
+  unsigned int *nObs = new unsigned int[_nPredNum];
   unsigned int colOff = 0;
   for (unsigned int num = 0; num < _nPredNum; num++, colOff += _nRow) {
+    unsigned int obsIdx = 0;
+    unsigned int naIdx = _nRow;
     for (unsigned int row = 0; row < _nRow; row++) {
-      _rowOrd[colOff + row] = row; // Initializes permutation vector.
-      numOrd[colOff + row] = _feNum[colOff + row];
+      double x = _feNum[colOff + row];
+      unsigned int idx = isnan(x) ? --naIdx : obsIdx++;
+      _rowOrd[colOff + idx] = row; // Initializes permutation vector.
+      numOrd[colOff + idx] = x;
     }
+    nObs[num] = obsIdx;
   }
-  Sort(_nRow, _nPredNum, numOrd, _rowOrd);
-  Ranks(_nRow, _nPredNum, numOrd, _rowOrd, _rank, _feInvNum);
+  Sort(_nRow, _nPredNum, numOrd, _rowOrd, nObs);
+  Ranks(_nRow, _nPredNum, numOrd, _rowOrd, nObs, _rank, _feInvNum);
+  delete [] nObs;
   delete [] numOrd;
 }
 
@@ -105,15 +115,18 @@ void RowRank::PreSortFac(const unsigned int _feFac[], unsigned int _nPredFac, un
 
  @param perm outputs the permutation vectors.
 
+ @param nObs is the number of observed (leading) values in each column.
+
  @return void, with output vector parameters.
 */
-void RowRank::Sort(unsigned int _nRow, unsigned int _nPredNum, double numOrd[], unsigned int perm[]) {
+void RowRank::Sort(unsigned int _nRow, unsigned int _nPredNum, double numOrd[], unsigned int perm[], const unsigned int nObs[]) {
   unsigned int colOff = 0;  
 
   // Unstable sort suffices, as row consistency does not appear necessary.
   //
   for (unsigned int numIdx = 0; numIdx < _nPredNum; numIdx++, colOff += _nRow) {
-    CallBack::QSortD(numOrd + colOff, perm + colOff, 1, _nRow);
+    if (nObs[numIdx] > 0)
+      CallBack::QSortD(numOrd + colOff, perm + colOff, 1, nObs[numIdx]);
   }
 }
 
@@ -141,7 +154,7 @@ void RowRank::Sort(unsigned int _nRow, unsigned int _nPredFac, unsigned int facO
 
    @return void, with output parameter matrix.
 */
-void RowRank::Ranks(unsigned int _nRow, unsigned int _nPredNum, double _numOrd[], unsigned int _row[], unsigned int _rank[], unsigned int _invRank[]) {
+void RowRank::Ranks(unsigned int _nRow, unsigned int _nPredNum, double _numOrd[], unsigned int _row[], const unsigned int _nObs[], unsigned int _rank[], unsigned int _invRank[]) {
   unsigned int colOff = 0;
   unsigned int numIdx; 
 
@@ -149,7 +162,7 @@ void RowRank::Ranks(unsigned int _nRow, unsigned int _nPredNum, double _numOrd[]
   {
     //  #pragma omp for schedule(static, 1) nowait
     for (numIdx = 0; numIdx < _nPredNum; numIdx++, colOff += _nRow) {
-      Ranks(_nRow, _numOrd + colOff, _row + colOff, _rank + colOff, _invRank + colOff);
+      Ranks(_nRow, _nObs[numIdx], _numOrd + colOff, _row + colOff, _rank + colOff, _invRank + colOff);
     }
   }
 }
@@ -185,18 +198,24 @@ void RowRank::Ranks(unsigned int _nRow, unsigned int _nPredFac, unsigned int _fa
 
    @param invRank[] maps ranks to one (of possibly many) associated row.
 
+   @param nObs is the number of observed values, which lead the column.
+
    @return void, with output vector parameters.
 */
-void RowRank::Ranks(unsigned int _nRow, const double xCol[], const unsigned int row[], unsigned int rank[], unsigned int invRank[]) {
+void RowRank::Ranks(unsigned int _nRow, unsigned int nObs, const double xCol[], const unsigned int row[], unsigned int rank[], unsigned int invRank[]) {
   unsigned int rk = 0;
   double prevX = xCol[0];
-  for (unsigned int rw = 0; rw < _nRow; rw++) {
+  for (unsigned int rw = 0; rw < nObs; rw++) {
     double curX = xCol[rw];
     rk = curX == prevX ? rk : rk + 1;
     rank[rw] = rk;
     invRank[rk] = row[rw];  // Assignment of row within a run is arbitrary.
     prevX = curX;
   }
+  // Missing values share the NA rank, which has no inverse.
+  for (unsigned int rw = nObs; rw < _nRow; rw++) {
+    rank[rw] = _nRow;
+  }
   // Values of invRank[] at indices beyond final 'rk' value are undefined.
 }
 
@@ -227,13 +246,24 @@ void RowRank::Ranks(unsigned int _nRow, const unsigned int xCol[], unsigned int
 
    @param _feInvNum is the rank-to-row mapping for numeric predictors.
  */
-RowRank::RowRank(const unsigned int _feRow[], const unsigned int _feRank[], const unsigned int _feInvNum[], unsigned int _nRow, unsigned int _nPredDense) : nRow(_nRow), nBlock(0), nPredDense(_nPredDense), feInvNum(_feInvNum) {
+RowRank::RowRank(const unsigned int _feRow[], const unsigned int _feRank[], const unsigned int _feInvNum[], unsigned int _nRow, unsigned int _nPredDense) : nRow(_nRow), nBlock(0), nPredDense(_nPredDense), feInvNum(_feInvNum), rankCount(std::vector<unsigned int>(_nPredDense)) {
   unsigned int dim = nRow * nPredDense;
 
   rowRank = new RRNode[dim];
   for (unsigned int i = 0; i < dim; i++) {
     rowRank[i].Set(_feRow[i], _feRank[i]);
   }
+
+  // Ranks ascend within a predictor's column, with missing values last.
+  for (unsigned int predIdx = 0; predIdx < nPredDense; predIdx++) {
+    unsigned int rankTop = 0;
+    for (unsigned int idx = 0; idx < nRow; idx++) {
+      unsigned int rank = _feRank[predIdx * nRow + idx];
+      if (rank < nRow)
+        rankTop = rank + 1;
+    }
+    rankCount[predIdx] = rankTop;
+  }
   //  blockRank = new BlockRank[nBlock];
 }
 
@@ -262,3 +292,14 @@ double RowRank::MeanRank(unsigned int predIdx, double rkMean) const {
   unsigned int rankHigh = ceil(rkMean);
   return PBTrain::MeanVal(predIdx, Rank2Row(predIdx, rankLow), Rank2Row(predIdx, rankHigh));
 }
+
+
+/**
+   @brief Chains a hash of the predictor orderings onto a seed.
+
+   @return updated hash.
+ */
+unsigned long long RowRank::Fingerprint(unsigned long long seed) const {
+  unsigned long long key = Hash::Bytes(rowRank, nRow * nPredDense * sizeof(RRNode), seed);
+  return Hash::Vec(rankCount, key);
+}
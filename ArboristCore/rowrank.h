@@ -56,12 +56,13 @@ class RowRank {
   const unsigned int *feInvNum; // Numeric predictors only:  split assignment.
   RRNode *rowRank;
   BlockRank *blockRank;
+  std::vector<unsigned int> rankCount; // Distinct observed ranks, by predictor.
 
-  static void Sort(unsigned int _nRow, unsigned int _nPredNum, double numOrd[], unsigned int perm[]);
+  static void Sort(unsigned int _nRow, unsigned int _nPredNum, double numOrd[], unsigned int perm[], const unsigned int nObs[]);
   static void Sort(unsigned int _nRow, unsigned int _nPredFac, unsigned int facOrd[], unsigned int perm[]);
-  static void Ranks(unsigned int _nRow, unsigned int _nPredNum, double _numOrd[], unsigned int _row[], unsigned int _rank[], unsigned int _invRank[]);
+  static void Ranks(unsigned int _nRow, unsigned int _nPredNum, double _numOrd[], unsigned int _row[], const unsigned int _nObs[], unsigned int _rank[], unsigned int _invRank[]);
   static void Ranks(unsigned int _nRow, unsigned int _nPredFac, unsigned int _facOrd[], unsigned int _rank[]);
-  static void Ranks(unsigned int _nRow, const double xCol[], const unsigned int row[], unsigned int rank[], unsigned int invRank[]);
+  static void Ranks(unsigned int _nRow, unsigned int nObs, const double xCol[], const unsigned int row[], unsigned int rank[], unsigned int invRank[]);
   static void Ranks(unsigned int _nRow, const unsigned int xCol[], unsigned int rank[]);
 
  public:
@@ -98,6 +99,18 @@ class RowRank {
   }
   
   double MeanRank(unsigned int predIdx, double rkMean) const;
+  unsigned long long Fingerprint(unsigned long long seed) const;
+
+
+  /**
+     @brief Counts distinct observed values of a numeric predictor,
+     whose ranks are dense.
+
+     @return count of distinct ranks, excluding that of missing values.
+   */
+  inline unsigned int RankCount(unsigned int predIdx) const {
+    return rankCount[predIdx];
+  }
 };
 
 #endif
@@ -14,14 +14,12 @@
  */
 
 #include "runset.h"
-#include "callback.h"
+#include "trainctx.h"
 
 // Testing only:
 //#include <iostream>
 using namespace std;
 
-unsigned int RunSet::ctgWidth = 0;
-
 /**
    Run objects are allocated per-tree, and live throughout training.
 
@@ -62,7 +60,6 @@ unsigned int RunSet::ctgWidth = 0;
    for factors, or to a nonsensical zero, for numerical.
  */
 Run::Run(unsigned int _ctgWidth) : ctgWidth(_ctgWidth) {
-  RunSet::ctgWidth = ctgWidth;
   runSet = 0;
   facRun = 0;
   bHeap = 0;
@@ -116,10 +113,12 @@ void Run::OffsetsReg() {
 /**
    @brief Classification:  only wide run sets use the heap.
 
+   @param ctx supplies the variates ordering wide run sets.
+
    @return void.
 
 */
-void Run::OffsetsCtg() {
+void Run::OffsetsCtg(const TrainCtx *ctx) {
   if (setCount == 0)
     return;
 
@@ -153,7 +152,7 @@ void Run::OffsetsCtg() {
 
   if (ctgWidth > 2 && heapRuns > 0) { // Wide non-binary:  w.o. replacement.
     rvWide = new double[heapRuns];
-    CallBack::RUnif(heapRuns, rvWide);
+    ctx->RUnif(heapRuns, rvWide);
   }
 
   facRun = new FRNode[runCount];
@@ -171,7 +170,7 @@ void Run::OffsetsCtg() {
  */
 void Run::ResetRuns() {
   for (unsigned int i = 0; i < setCount; i++) {
-    runSet[i].Reset(facRun, bHeap, lhOut, ctgSum, rvWide);
+    runSet[i].Reset(facRun, bHeap, lhOut, ctgSum, rvWide, ctgWidth);
   }
 }
 
@@ -212,8 +211,11 @@ void RunSet::OffsetCache(unsigned int _runOff, unsigned int _heapOff, unsigned i
 /**
    @brief Updates relative vector addresses with their respective base
    addresses, now known.
+
+   @param _ctgWidth is the response cardinality.
  */
-void RunSet::Reset(FRNode *runBase, BHPair *heapBase, unsigned int *outBase, double *ctgBase, double *rvBase) {
+void RunSet::Reset(FRNode *runBase, BHPair *heapBase, unsigned int *outBase, double *ctgBase, double *rvBase, unsigned int _ctgWidth) {
+  ctgWidth = _ctgWidth;
   runZero = runBase + runOff;
   heapZero = heapBase + heapOff;
   outZero = outBase + outOff;
@@ -79,11 +79,11 @@ class RunSet {
   int runsLH; // Count of LH runs.
  public:
   const static unsigned int maxWidth = 10;
-  static unsigned int ctgWidth;
+  unsigned int ctgWidth; // Response cardinality, from the owning Run.
   unsigned int safeRunCount;
   unsigned int DeWide();
   void DePop(unsigned int pop = 0);
-  void Reset(FRNode*, BHPair*, unsigned int*, double*, double*);
+  void Reset(FRNode*, BHPair*, unsigned int*, double*, double*, unsigned int);
   void OffsetCache(unsigned int _runOff, unsigned int _heapOff, unsigned int _outOff);
   void HeapRandom();
   void HeapMean();
@@ -133,6 +133,16 @@ class RunSet {
   }
 
   
+  /**
+     @param outPos is a position in the output vector.
+
+     @return run slot dereferenced by the position.
+   */
+  inline unsigned int OutSlot(unsigned int outPos) const {
+    return outZero[outPos];
+  }
+
+
   /**
      @brief Sets run parameters and increments run count.
 
@@ -235,7 +245,7 @@ class Run {
 
   void LevelClear();
   void OffsetsReg();
-  void OffsetsCtg();
+  void OffsetsCtg(const class TrainCtx *ctx);
 
   inline RunSet *RSet(unsigned int rsIdx) {
     return &runSet[rsIdx];
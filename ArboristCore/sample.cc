@@ -15,73 +15,24 @@
 
 #include "sample.h"
 #include "bv.h"
-#include "callback.h"
 #include "rowrank.h"
 #include "samplepred.h"
 #include "bottom.h"
 #include "forest.h"
+#include "parallel.h"
+#include "trainctx.h"
+
+#include <algorithm>
 
 //#include <iostream>
 using namespace std;
 
-// Simulation-invariant values.
-//
-unsigned int Sample::nRow = 0;
-unsigned int Sample::nPred = 0;
-int Sample::nSamp = -1;
-
-unsigned int SampleCtg::ctgWidth = 0;
-
 /**
- @brief Lights off initializations needed for sampling.
-
- @param _nRow is the number of response/observation rows.
-
- @param _nSamp is the number of samples.
-
- @return void.
-*/
-void Sample::Immutables(unsigned int _nRow, unsigned int _nPred, int _nSamp, const double _feSampleWeight[], bool _withRepl, unsigned int _ctgWidth, int _nTree) {
-  nRow = _nRow;
-  nPred = _nPred;
-  nSamp = _nSamp;
-  CallBack::SampleInit(nRow, _feSampleWeight, _withRepl);
-  if (_ctgWidth > 0)
-    SampleCtg::Immutables(_ctgWidth, _nTree);
-}
-
-
-/**
-   @return void.
- */
-void SampleCtg::Immutables(unsigned int _ctgWidth, int _nTree) {
-  ctgWidth = _ctgWidth;
-}
-
+   @brief Constructor.
 
-/**
+   @param _ctx holds the fit's parameters.
  */
-void SampleCtg::DeImmutables() {
-  ctgWidth = 0;
-}
-
-
-/**
-   @brief Finalizer.
-
-   @return void.
-*/
-void Sample::DeImmutables() {
-  nRow = 0;
-  nPred = 0;
-  nSamp = -1;
-  SampleCtg::DeImmutables();
-}
-
-
-Sample::Sample() {
-  treeBag = new BV(nRow);
-  row2Sample = new int[nRow];
+Sample::Sample(const TrainCtx *_ctx) : row2Sample(0), ctx(_ctx), nRow(ctx->nRow), nPred(ctx->nPred), nSamp(ctx->nSamp), treeBag(0) {
   sampleNode = new SampleNode[nSamp]; // Lives until scoring.
 }
 
@@ -111,10 +62,11 @@ unsigned int *Sample::RowSample() {
   // sampling vector.
   //
   int *rvRow = new int[nSamp];
-  CallBack::SampleRows(nSamp, rvRow);
+  ctx->SampleRows(nSamp, rvRow);
   for (int i = 0; i < nSamp; i++) {
-    int row = rvRow[i];
-    sCountRow[row]++;
+    unsigned int row = ctx->SampleRow(rvRow[i]);
+    if (row < nRow) // Out-of-range draws are discarded.
+      sCountRow[row]++;
   }
   delete [] rvRow;
 
@@ -125,8 +77,8 @@ unsigned int *Sample::RowSample() {
 /**
    @brief Static entry for classification.
  */
-SampleCtg *Sample::FactoryCtg(const std::vector<double> &y, const RowRank *rowRank,  const std::vector<unsigned int> &yCtg) {
-  SampleCtg *sampleCtg = new SampleCtg();
+SampleCtg *Sample::FactoryCtg(const TrainCtx *ctx, const std::vector<double> &y, const RowRank *rowRank,  const std::vector<unsigned int> &yCtg) {
+  SampleCtg *sampleCtg = new SampleCtg(ctx);
   sampleCtg->Stage(yCtg, y, rowRank);
 
   return sampleCtg;
@@ -137,8 +89,8 @@ SampleCtg *Sample::FactoryCtg(const std::vector<double> &y, const RowRank *rowRa
    @brief Static entry for regression response.
 
  */
-SampleReg *Sample::FactoryReg(const std::vector<double> &y, const RowRank *rowRank, const std::vector<unsigned int> &row2Rank) {
-  SampleReg *sampleReg = new SampleReg();
+SampleReg *Sample::FactoryReg(const TrainCtx *ctx, const std::vector<double> &y, const RowRank *rowRank, const std::vector<unsigned int> &row2Rank) {
+  SampleReg *sampleReg = new SampleReg(ctx);
   sampleReg->Stage(y, row2Rank, rowRank);
 
   return sampleReg;
@@ -148,7 +100,7 @@ SampleReg *Sample::FactoryReg(const std::vector<double> &y, const RowRank *rowRa
 /**
    @brief Constructor.
  */
-SampleReg::SampleReg() : Sample() {
+SampleReg::SampleReg(const TrainCtx *_ctx) : Sample(_ctx), nOut(ctx->nOut) {
 }
 
 
@@ -156,7 +108,8 @@ SampleReg::SampleReg() : Sample() {
 /**
    @brief Inverts the randomly-sampled vector of rows.
 
-   @param y is the response vector.
+   @param y is the response vector, output-major if multi-output.  The
+   leading output is staged, as the others are accessed by sample index.
 
    @param row2Rank is the response ranking, by row.
 
@@ -167,11 +120,11 @@ SampleReg::SampleReg() : Sample() {
    @return count of in-bag samples.
 */
 void SampleReg::Stage(const std::vector<double> &y, const std::vector<unsigned int> &row2Rank, const RowRank *rowRank) {
-  std::vector<unsigned int> ctgProxy(nRow);
-  std::fill(ctgProxy.begin(), ctgProxy.end(), 0);
-  Sample::PreStage(y, ctgProxy, rowRank);
+  Sample::PreStage(y, std::vector<unsigned int>(), rowRank);
   SetRank(row2Rank);
-  bottom = Bottom::FactoryReg(samplePred, bagCount);
+  if (nOut > 1)
+    SetOutputs(y);
+  bottom = samplePred == 0 ? 0 : Bottom::FactoryReg(ctx, samplePred, bagCount, outSum.empty() ? 0 : &outSum[0]);
 }
 
 
@@ -185,6 +138,11 @@ void SampleReg::Stage(const std::vector<double> &y, const std::vector<unsigned i
 void SampleReg::SetRank(const std::vector<unsigned int> &row2Rank) {
   // Only client is quantile regression.
   sample2Rank = new unsigned int[bagCount];
+  if (!bagRow.empty()) { // Stratified:  visits only the bagged rows.
+    for (unsigned int sIdx = 0; sIdx < bagCount; sIdx++)
+      sample2Rank[sIdx] = row2Rank[bagRow[sIdx]];
+    return;
+  }
   for (unsigned int row = 0; row < nRow; row++) {
     int sIdx = SampleIdx(row);
     if (sIdx >= 0)
@@ -192,11 +150,33 @@ void SampleReg::SetRank(const std::vector<unsigned int> &row2Rank) {
   }
 }
 
+
+/**
+   @brief Records the sampled sums of each output, sample-major, so that
+   splitting reads a sample's outputs contiguously.
+
+   @param y is the output-major response matrix.
+
+   @return void.
+ */
+void SampleReg::SetOutputs(const std::vector<double> &y) {
+  outSum = std::vector<FltVal>(bagCount * nOut);
+  std::vector<unsigned int> sample2Row(bagCount);
+  RowInvert(sample2Row);
+  for (unsigned int sIdx = 0; sIdx < bagCount; sIdx++) {
+    unsigned int row = sample2Row[sIdx];
+    unsigned int sCount = SCount(sIdx);
+    for (unsigned int outIdx = 0; outIdx < nOut; outIdx++) {
+      outSum[sIdx * nOut + outIdx] = sCount * y[outIdx * nRow + row];
+    }
+  }
+}
+
   
 /**
    @brief Constructor.
  */
-SampleCtg::SampleCtg() : Sample() {
+SampleCtg::SampleCtg(const TrainCtx *_ctx) : Sample(_ctx) {
 }
 
 
@@ -214,7 +194,7 @@ SampleCtg::SampleCtg() : Sample() {
 //
 void SampleCtg::Stage(const std::vector<unsigned int> &yCtg, const std::vector<double> &y, const RowRank *rowRank) {
   Sample::PreStage(y, yCtg, rowRank);
-  bottom = Bottom::FactoryCtg(samplePred, sampleNode, bagCount);
+  bottom = samplePred == 0 ? 0 : Bottom::FactoryCtg(ctx, samplePred, sampleNode, bagCount);
 }
 
 
@@ -223,15 +203,41 @@ void SampleCtg::Stage(const std::vector<unsigned int> &yCtg, const std::vector<d
 
    @param y is the proxy / response:  classification / summary.
 
-   @param yCtg is true response / zero:  classification / regression.
+   @param yCtg is true response / empty:  classification / regression.
 
    @return vector of compressed indices into sample data structures.
  */
 void Sample::PreStage(const std::vector<double> &y, const std::vector<unsigned int> &yCtg, const RowRank *rowRank) {
+  bagSum = 0.0;
+  bagSCount = 0;
+  if (ctx->Stratified()) {
+    PreStageStrata(y, yCtg);
+  }
+  else {
+    PreStageRows(y, yCtg);
+  }
+
+  // Sharded training distributes predictor ranks to its workers directly.
+  if (ctx->nShard > 0) {
+    samplePred = 0;
+    return;
+  }
+  samplePred = SamplePred::Factory(nPred, bagCount, ctx->runShift);
+  PreStage(rowRank);
+}
+
+
+/**
+   @brief Bags the rows drawn by the fit's sampler.
+
+   @return void.
+ */
+void Sample::PreStageRows(const std::vector<double> &y, const std::vector<unsigned int> &yCtg) {
   unsigned int *sCountRow = RowSample();
+  treeBag = new BV(nRow);
+  row2Sample = new int[nRow];
   unsigned int slotBits = BV::SlotElts();
 
-  bagSum = 0.0;
   int slot = 0;
   unsigned int sIdx = 0;
   for (unsigned int base = 0; base < nRow; base += slotBits, slot++) {
@@ -242,8 +248,9 @@ void Sample::PreStage(const std::vector<double> &y, const std::vector<unsigned i
       unsigned int sCount = sCountRow[row];
       if (sCount > 0) {
         double val = sCount * y[row];
-	sampleNode[sIdx].Set(val, sCount, yCtg[row]);
+	sampleNode[sIdx].Set(val, sCount, yCtg.empty() ? 0 : yCtg[row]);
 	bagSum += val;
+	bagSCount += sCount;
         bits |= mask;
 	row2Sample[row] = sIdx++;
       }
@@ -255,25 +262,50 @@ void Sample::PreStage(const std::vector<double> &y, const std::vector<unsigned i
   }
   bagCount = sIdx;
   delete [] sCountRow;
+}
 
-  samplePred = SamplePred::Factory(nPred, bagCount);
-  PreStage(rowRank);
+
+/**
+   @brief Bags rows drawn stratum by stratum.  Samples are enumerated in
+   row order, as when bagging from the unstratified sampler, but only the
+   bagged rows are visited:  no per-row map or bit vector is built.
+
+   @return void.
+ */
+void Sample::PreStageStrata(const std::vector<double> &y, const std::vector<unsigned int> &yCtg) {
+  std::vector<std::pair<unsigned int, unsigned int> > bag;
+  ctx->StratumSample(bag);
+
+  bagRow = std::vector<unsigned int>(bag.size());
+  unsigned int sIdx = 0;
+  for (auto rowCount : bag) {
+    unsigned int row = rowCount.first;
+    unsigned int sCount = rowCount.second;
+    double val = sCount * y[row];
+    sampleNode[sIdx].Set(val, sCount, yCtg.empty() ? 0 : yCtg[row]);
+    bagSum += val;
+    bagSCount += sCount;
+    bagRow[sIdx++] = row;
+  }
+  bagCount = sIdx;
 }
 
 
 /**
-   @brief Loops through the predictors to stage.
+   @brief Loops through the predictors to stage.  Retired predictors are
+   never scheduled, so are left unstaged.
 
    @return void.
  */
 void Sample::PreStage(const RowRank *rowRank) {
   int predIdx;
 
-#pragma omp parallel default(shared) private(predIdx)
+#pragma omp parallel default(shared) private(predIdx) num_threads(Parallel::Threads())
   {
 #pragma omp for schedule(dynamic, 1)
     for (predIdx = 0; predIdx < int(nPred); predIdx++) {
-      PreStage(rowRank, predIdx);
+      if (!ctx->Retired(predIdx))
+        PreStage(rowRank, predIdx);
     }
   }
 }
@@ -294,6 +326,22 @@ void Sample::PreStage(const RowRank *rowRank, int predIdx) {
   //
   unsigned int spIdx = 0;
   std::vector<StagePack> stagePack(bagCount);
+  if (!bagRow.empty()) { // Stratified:  ranks bagged rows directly.
+    std::vector<std::pair<unsigned int, unsigned int> > rankSample(bagCount);
+    for (unsigned int sIdx = 0; sIdx < bagCount; sIdx++) {
+      rankSample[sIdx] = std::make_pair(ctx->RankOf(rowRank, predIdx, bagRow[sIdx]), sIdx);
+    }
+    std::sort(rankSample.begin(), rankSample.end());
+    for (auto rs : rankSample) {
+      unsigned int sCount;
+      FltVal ySum;
+      unsigned int ctg = Ref(rs.second, ySum, sCount);
+      stagePack[spIdx++].Set(rs.second, rs.first, sCount, ctg, ySum);
+    }
+    samplePred->Stage(stagePack, predIdx);
+    return;
+  }
+
   for (unsigned int idx = 0; idx < nRow; idx++) {
     unsigned int predRank;
     unsigned int row = rowRank->Lookup(predIdx, idx, predRank);
@@ -310,6 +358,10 @@ void Sample::PreStage(const RowRank *rowRank, int predIdx) {
 
 
 void Sample::RowInvert(std::vector<unsigned int> &sample2Row) const {
+  if (!bagRow.empty()) {
+    std::copy(bagRow.begin(), bagRow.end(), sample2Row.begin());
+    return;
+  }
   for (unsigned int row = 0; row < nRow; row++) {
     int sIdx = row2Sample[row];
     if (sIdx >= 0) {
@@ -37,6 +37,7 @@ class SampleNode {
 
   // Integer-sized container is likely overkill:  typically << #rows,
   // although sample weighting might yield run sizes approaching #rows.
+  // Observation weights, if any, are reflected in the sampled counts.
   unsigned int sCount;
 
  public:
@@ -85,45 +86,41 @@ class SampleNode {
  @brief Run of instances of a given row obtained from sampling for an individual tree.
 */
 class Sample {
-  int *row2Sample;
+  int *row2Sample; // Unstratified only.
   void PreStage(const class RowRank *rowRank);
   void PreStage(const class RowRank *rowRank, int predIdx);
+  void PreStageRows(const std::vector<double> &y, const std::vector<unsigned int> &yCtg);
+  void PreStageStrata(const std::vector<double> &y, const std::vector<unsigned int> &yCtg);
  protected:
-  static unsigned int nRow;
-  static unsigned int nPred;
-  static int nSamp;
+  std::vector<unsigned int> bagRow; // Bagged rows, by sample index, iff stratified.
+  const class TrainCtx *ctx;
+  const unsigned int nRow;
+  const unsigned int nPred;
+  const int nSamp;
   SampleNode *sampleNode;
   unsigned int bagCount;
+  unsigned int bagSCount; // Sum of sample counts:  'nSamp'.
   double bagSum;
-  class BV *treeBag;
+  class BV *treeBag; // Unstratified only.
   class SamplePred *samplePred;
   class Bottom *bottom;
   void PreStage(const std::vector<double> &y, const std::vector<unsigned int> &yCtg, const class RowRank *rowRank);
 
-  static unsigned int *RowSample();
+  unsigned int *RowSample();
 
  public:
-  static class SampleCtg *FactoryCtg(const std::vector<double> &y, const class RowRank *rowRank, const std::vector<unsigned int> &yCtg);
-  static class SampleReg *FactoryReg(const std::vector<double> &y, const class RowRank *rowRank, const std::vector<unsigned int> &row2Rank);
+  static class SampleCtg *FactoryCtg(const class TrainCtx *ctx, const std::vector<double> &y, const class RowRank *rowRank, const std::vector<unsigned int> &yCtg);
+  static class SampleReg *FactoryReg(const class TrainCtx *ctx, const std::vector<double> &y, const class RowRank *rowRank, const std::vector<unsigned int> &row2Rank);
 
-  static void Immutables(unsigned int _nRow, unsigned int _nPred, int _nSamp, const double _feSampleWeight[], bool _withRepl, unsigned int _ctgWidth, int _nTree);
-  static void DeImmutables();
-
-  Sample();
+  Sample(const class TrainCtx *_ctx);
   void RowInvert(std::vector<unsigned int> &sample2Row) const;
-  
-  /**
-     @brief Accessor for sample count.
-   */
-  static inline int NSamp() {
-    return nSamp;
-  }
 
   
   /**
      @param row row index at which to look up sample index.
 
-     @return Sample index associated with row, or -1 if none.
+     @return Sample index associated with row, or -1 if none.  Only
+     available without stratification, whose bags map rows by RowInvert().
    */
   inline int SampleIdx(unsigned int row) const {
     return row2Sample[row];
@@ -142,6 +139,14 @@ class Sample {
     return bagSum;
   }
 
+
+  /**
+     @return sum of in-bag sample counts, including observation weights.
+   */
+  inline unsigned int BagSCount() const {
+    return bagSCount;
+  }
+
   
   inline class Bottom *Bot() {
     return bottom;
@@ -182,9 +187,12 @@ class Sample {
 */
 class SampleReg : public Sample {
   unsigned int *sample2Rank; // Only client currently leaf-based methods.
+  const unsigned int nOut; // Response outputs.
+  std::vector<FltVal> outSum; // Multi-output:  sums by sample, then output.
   void SetRank(const std::vector<unsigned int> &row2Rank);
+  void SetOutputs(const std::vector<double> &y);
  public:
-  SampleReg();
+  SampleReg(const class TrainCtx *_ctx);
   ~SampleReg();
 
   inline unsigned int Rank(unsigned int sIdx) const {
@@ -192,6 +200,16 @@ class SampleReg : public Sample {
   }
 
 
+  /**
+     @param outIdx is the output index.
+
+     @return sum of a multi-output sample's values at the output.
+   */
+  inline FltVal OutSum(unsigned int sIdx, unsigned int outIdx) const {
+    return outSum[sIdx * nOut + outIdx];
+  }
+
+
   void Stage(const std::vector<double> &y, const std::vector<unsigned int> &row2Rank, const class RowRank *rowRank);
 };
 
@@ -200,12 +218,9 @@ class SampleReg : public Sample {
  @brief Classification-specific sampling.
 */
 class SampleCtg : public Sample {
-  static unsigned int ctgWidth;
  public:
-  SampleCtg();
+  SampleCtg(const class TrainCtx *_ctx);
   ~SampleCtg();
-  static void Immutables(unsigned int _ctgWidth, int _nTree);
-  static void DeImmutables();
 
   
   void Stage(const std::vector<unsigned int> &yCtg, const std::vector<double> &y, const class RowRank *rowRank);
@@ -18,39 +18,10 @@
 //#include <iostream>
 using namespace std;
 
-unsigned int SPNode::runShift = 0;
-
-/**
-   @brief Computes a packing width sufficient to hold all (zero-based) response
-   category values.
-
-   @param ctgWidth is the response cardinality.
-
-   @return void.
- */
-void SPNode::Immutables(unsigned int ctgWidth) {
-  unsigned int bits = 1;
-  runShift = 0;
-  // Ctg values are zero-based, so the first power of 2 greater than or
-  // equal to 'ctgWidth' has sufficient bits to hold all response values.
-  while (bits < ctgWidth) {
-    bits <<= 1;
-    runShift++;
-  }
-}
-
-
-/*
-**/
-void SPNode::DeImmutables() {
-  runShift = 0;
-}
-
-
 /**
    @brief Base class constructor.
  */
-SamplePred::SamplePred(unsigned int _nPred, unsigned int _bagCount) : bagCount(_bagCount), nPred(_nPred), bufferSize(_nPred * _bagCount), pitchSP(_bagCount * sizeof(SamplePred)), pitchSIdx(_bagCount * sizeof(unsigned int)) {
+SamplePred::SamplePred(unsigned int _nPred, unsigned int _bagCount, unsigned int _runShift) : bagCount(_bagCount), nPred(_nPred), runShift(_runShift), bufferSize(_nPred * _bagCount), pitchSP(_bagCount * sizeof(SamplePred)), pitchSIdx(_bagCount * sizeof(unsigned int)) {
   sampleIdx = new unsigned int[2* bufferSize];
   nodeVec = new SPNode[2 * bufferSize];
 }
@@ -68,10 +39,12 @@ SamplePred::~SamplePred() {
 /**
    @brief Static entry for sample staging.
 
+   @param _runShift is the packing width of the response category.
+
    @return SamplePred object for tree.
  */
-SamplePred *SamplePred::Factory(unsigned int _nPred, unsigned int _bagCount) {
-  SamplePred *samplePred = new SamplePred(_nPred, _bagCount);
+SamplePred *SamplePred::Factory(unsigned int _nPred, unsigned int _bagCount, unsigned int _runShift) {
+  SamplePred *samplePred = new SamplePred(_nPred, _bagCount, _runShift);
 
   return samplePred;
 }
@@ -93,7 +66,7 @@ void SamplePred::Stage(const std::vector<StagePack> &stagePack, unsigned int pre
   // TODO:  For sparse predictors, stage to DenseRank.
 
   for (unsigned int idx = 0; idx < stagePack.size(); idx++) {
-    unsigned int sIdx = spn++->Init(stagePack[idx]);
+    unsigned int sIdx = spn++->Init(stagePack[idx], runShift);
     *smpIdx++ = sIdx;
   }
 }
@@ -104,9 +77,11 @@ void SamplePred::Stage(const std::vector<StagePack> &stagePack, unsigned int pre
 
    @param stagePack holds packed staging values.
 
+   @param runShift is the packing width of the response category.
+
    @return upacked sample index.
  */
-unsigned int SPNode::Init(const StagePack &stagePack) {
+unsigned int SPNode::Init(const StagePack &stagePack, unsigned int runShift) {
   unsigned int sIdx, ctg;
   stagePack.Ref(sIdx, rank, sCount, ctg, ySum);
   sCount = (sCount << runShift) | ctg; // Packed representation.
@@ -54,15 +54,12 @@ class StagePack {
 /**
  */
 class SPNode {
-  static unsigned int runShift; // Pack:  nonzero iff categorical response.
  protected:
   FltVal ySum; // sum of response values associated with sample.
   unsigned int rank; // True rank, with ties identically receiving lowest applicable value.
   unsigned int sCount; // # occurrences of row sampled.  << # rows.
  public:
-  static void Immutables(unsigned int ctgWidth);
-  static void DeImmutables();
-  unsigned int Init(const StagePack &stagePack);
+  unsigned int Init(const StagePack &stagePack, unsigned int runShift);
 
   // These methods should only be called when the response is known
   // to be regression, as it relies on a packed representation specific
@@ -103,9 +100,11 @@ class SPNode {
 
      @param _yCtg outputs the response value.
 
+     @param runShift is the packing width of the response value.
+
      @return sample count, with output reference parameters.
    */
-  inline unsigned int CtgFields(FltVal &_ySum, unsigned int &_rank, unsigned int &_yCtg) const {
+  inline unsigned int CtgFields(FltVal &_ySum, unsigned int &_rank, unsigned int &_yCtg, unsigned int runShift) const {
     _ySum = ySum;
     _rank = rank;
     _yCtg = sCount & ((1 << runShift) - 1);
@@ -123,9 +122,11 @@ class SPNode {
 
      @param _yCtg outputs the response value.
 
+     @param runShift is the packing width of the response value.
+
      @return sample count of node, with output reference parameters.
    */
-  inline unsigned int CtgFields(FltVal &_ySum, unsigned int &_yCtg) const {
+  inline unsigned int CtgFields(FltVal &_ySum, unsigned int &_yCtg, unsigned int runShift) const {
     _ySum = ySum;
     _yCtg = sCount & ((1 << runShift) - 1);
 
@@ -179,6 +180,7 @@ class SamplePred {
 
   const unsigned int bagCount;
   const unsigned int nPred;
+  const unsigned int runShift; // Packing width of response category.
 
   // Predictor-based sample orderings, double-buffered by level value.
   //
@@ -196,9 +198,9 @@ class SamplePred {
   //
   unsigned int *sampleIdx; // RV index for this row.  Used by CTG as well as on replay.
  public:
-  SamplePred(unsigned int _nPred, unsigned int _bagCount);
+  SamplePred(unsigned int _nPred, unsigned int _bagCount, unsigned int _runShift);
   ~SamplePred();
-  static SamplePred *Factory(unsigned int _nPred, unsigned int _bagCount);
+  static SamplePred *Factory(unsigned int _nPred, unsigned int _bagCount, unsigned int _runShift);
 
   void Stage(const std::vector<StagePack> &stagePack, unsigned int predIdx);
  
@@ -263,6 +265,18 @@ class SamplePred {
   }
   
 
+  /**
+     @brief Looks up the sample indices parallel to an SPNode block.
+
+     @param spn is a position within the node vector.
+
+     @return sample index vector at the corresponding position.
+   */
+  inline const unsigned int *SampleIdx(const SPNode *spn) const {
+    return sampleIdx + (spn - nodeVec);
+  }
+
+
   /**
      @brief Returns buffer containing splitting information.
    */
@@ -0,0 +1,796 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file shard.cc
+
+   @brief Methods for training a single tree over a bag partitioned by rows.
+
+   @author Mark Seligman
+
+ */
+
+#include "shard.h"
+#include "sample.h"
+#include "rowrank.h"
+#include "pretree.h"
+#include "predblock.h"
+#include "splitpred.h"
+#include "splitsig.h"
+#include "index.h"
+#include "runset.h"
+#include "parallel.h"
+#include "trainctx.h"
+
+#include <algorithm>
+#include <climits>
+
+//#include <iostream>
+using namespace std;
+
+ShardLocal::ShardLocal(unsigned int nShard) : upBox(nShard) {
+}
+
+
+/**
+   @brief Posts a worker's message to the reducer.  The message is moved,
+   rather than copied.
+
+   @return void.
+ */
+void ShardLocal::Send(unsigned int shardIdx, std::vector<unsigned char> &msg) {
+  upBox[shardIdx] = std::move(msg);
+}
+
+
+/**
+   @brief Collects the message posted by a worker.
+
+   @return void, with output message.
+ */
+void ShardLocal::Recv(unsigned int shardIdx, std::vector<unsigned char> &msg) {
+  msg = std::move(upBox[shardIdx]);
+}
+
+
+/**
+   @brief Posts a message for all workers.
+
+   @return void.
+ */
+void ShardLocal::Broadcast(const std::vector<unsigned char> &msg) {
+  downBox = msg;
+}
+
+
+/**
+   @brief Copies the most recent broadcast on behalf of a worker.
+
+   @return void, with output message.
+ */
+void ShardLocal::Listen(unsigned int shardIdx, std::vector<unsigned char> &msg) {
+  msg = downBox;
+}
+
+
+/**
+   @brief Per-tree worker constructor.
+
+   @param _sBase is the tree-relative index of the first local sample.
+
+   @param _nLocal is the number of local samples.
+
+   @param _binWidth is the number of ranks per histogram bin, by predictor.
+ */
+Shard::Shard(unsigned int _shardIdx, unsigned int _sBase, unsigned int _nLocal, unsigned int nPred, const std::vector<unsigned int> &_binWidth) : shardIdx(_shardIdx), sBase(_sBase), nLocal(_nLocal), binWidth(_binWidth), sample(_nLocal), rank(nPred * _nLocal) {
+}
+
+
+/**
+   @brief Accumulates, for each live node, its response totals and rank
+   histograms over the scheduled candidate predictors.  Bins record sample
+   count, index count, response sum and, if categorical, per-category sums,
+   as well as the extreme ranks observed.
+
+   @param comm is the transport.
+
+   @param nStat is the number of accumulators per bin.
+
+   @return void.
+ */
+void Shard::Histogram(ShardComm *comm, unsigned int nStat) {
+  std::vector<unsigned char> msg;
+  comm->Listen(shardIdx, msg);
+  unsigned int off = ShardComm::Unpack(msg, 0, candOff);
+  off = ShardComm::Unpack(msg, off, candPred);
+  (void) ShardComm::Unpack(msg, off, candBin);
+
+  unsigned int levelCount = candOff.size() - 1;
+  unsigned int binTot = candBin.back();
+  std::vector<double> stat((levelCount + binTot) * nStat);
+  std::fill(stat.begin(), stat.end(), 0.0);
+  std::vector<unsigned int> rkMin(binTot);
+  std::fill(rkMin.begin(), rkMin.end(), UINT_MAX);
+  std::vector<unsigned int> rkMax(binTot);
+  std::fill(rkMax.begin(), rkMax.end(), 0);
+
+  for (unsigned int i = 0; i < nLocal; i++) {
+    const ShardSample &smp = sample[i];
+    if (smp.levelIdx == ShardTrain::extinct)
+      continue;
+
+    unsigned int nodeOff = smp.levelIdx * nStat;
+    stat[nodeOff] += smp.sCount;
+    stat[nodeOff + 1] += 1.0;
+    stat[nodeOff + 2] += smp.ySum;
+    if (nStat > 3)
+      stat[nodeOff + 3 + smp.ctg] += smp.ySum;
+
+    for (unsigned int cand = candOff[smp.levelIdx]; cand < candOff[smp.levelIdx + 1]; cand++) {
+      unsigned int predIdx = candPred[cand];
+      unsigned int rk = rank[predIdx * nLocal + i];
+      // Missing values occupy the predictor's final bin.
+      unsigned int bin = rk == PredBlock::NARank() ? candBin[cand + 1] - 1 : candBin[cand] + rk / binWidth[predIdx];
+      unsigned int binOff = (levelCount + bin) * nStat;
+      stat[binOff] += smp.sCount;
+      stat[binOff + 1] += 1.0;
+      stat[binOff + 2] += smp.ySum;
+      if (nStat > 3)
+        stat[binOff + 3 + smp.ctg] += smp.ySum;
+      rkMin[bin] = min(rkMin[bin], rk);
+      rkMax[bin] = max(rkMax[bin], rk);
+    }
+  }
+
+  msg.clear();
+  ShardComm::Pack(msg, stat);
+  ShardComm::Pack(msg, rkMin);
+  ShardComm::Pack(msg, rkMax);
+  comm->Send(shardIdx, msg);
+}
+
+
+/**
+   @brief Partitions local samples according to the broadcast splits.
+
+   @param comm is the transport.
+
+   @param nPred is the predictor count, denoting a terminal route.
+
+   @return void.
+ */
+void Shard::Route(ShardComm *comm, unsigned int nPred) {
+  std::vector<unsigned char> msg;
+  comm->Listen(shardIdx, msg);
+  std::vector<ShardRoute> route;
+  std::vector<unsigned char> lhCode;
+  unsigned int off = ShardComm::Unpack(msg, 0, route);
+  (void) ShardComm::Unpack(msg, off, lhCode);
+
+  for (unsigned int i = 0; i < nLocal; i++) {
+    ShardSample &smp = sample[i];
+    if (smp.levelIdx == ShardTrain::extinct)
+      continue;
+
+    const ShardRoute &rt = route[smp.levelIdx];
+    if (rt.predIdx == nPred) { // Carried unsplit, else terminal.
+      smp.levelIdx = rt.lNext;
+      continue;
+    }
+    unsigned int rk = rank[rt.predIdx * nLocal + i];
+    bool isLeft = PredBlock::IsFactor(rt.predIdx) ? lhCode[rt.bitOff + rk] != 0 : (rk == PredBlock::NARank() ? rt.naLeft : rk <= rt.rkCut);
+    smp.ptId = isLeft ? rt.ptL : rt.ptR;
+    smp.levelIdx = isLeft ? rt.lNext : rt.rNext;
+  }
+}
+
+
+/**
+   @brief Reports the terminal pretree node of each local sample.
+
+   @return void.
+ */
+void Shard::Frontier(ShardComm *comm) {
+  std::vector<unsigned int> ptId(nLocal);
+  for (unsigned int i = 0; i < nLocal; i++)
+    ptId[i] = sample[i].ptId;
+
+  std::vector<unsigned char> msg;
+  ShardComm::Pack(msg, ptId);
+  comm->Send(shardIdx, msg);
+}
+
+
+/**
+   @brief Builds a block of PreTrees from unstaged samples.
+
+   @param ctx holds the fit's parameters.
+
+   @param sampleBlock contains the sampled bags.
+
+   @param rowRank holds the presorted predictors.
+
+   @param treeBlock is the number of trees in the block.
+
+   @return block of PreTree references.
+ */
+PreTree **ShardTrain::BlockTrees(TrainCtx *ctx, Sample **sampleBlock, const RowRank *rowRank, int treeBlock) {
+  ShardTrain *shardTrain = new ShardTrain(ctx, rowRank);
+  PreTree **ptBlock = new PreTree*[treeBlock];
+  for (int blockIdx = 0; blockIdx < treeBlock; blockIdx++) {
+    ptBlock[blockIdx] = shardTrain->OneTree(sampleBlock[blockIdx], rowRank);
+  }
+  delete shardTrain;
+
+  return ptBlock;
+}
+
+
+/**
+   @brief Derives histogram geometry from predictor rank counts.  Factors
+   bin by code, while numeric predictors coarsen their observed ranks into
+   at most 'binMax' bins of equal rank width, followed by a bin for
+   missing values.
+ */
+ShardTrain::ShardTrain(TrainCtx *_ctx, const RowRank *rowRank) : ctx(_ctx), nShard(ctx->nShard), nPred(ctx->nPred), ctgWidth(ctx->ctgWidth), nStat(3 + ctgWidth), binWidth(nPred), binCount(nPred), comm(new ShardLocal(nShard)), shard(nShard), sBase(nShard + 1) {
+  for (unsigned int predIdx = 0; predIdx < nPred; predIdx++) {
+    if (PredBlock::IsFactor(predIdx)) {
+      binWidth[predIdx] = 1;
+      binCount[predIdx] = PBTrain::FacCard(predIdx);
+    }
+    else {
+      unsigned int rankCount = rowRank->RankCount(predIdx);
+      binWidth[predIdx] = max(1u, (rankCount + binMax - 1) / binMax);
+      binCount[predIdx] = (rankCount + binWidth[predIdx] - 1) / binWidth[predIdx] + 1;
+    }
+  }
+}
+
+
+ShardTrain::~ShardTrain() {
+  delete comm;
+}
+
+
+/**
+   @return index of shard owning the sample index passed.
+ */
+unsigned int ShardTrain::Owner(unsigned int sIdx) const {
+  return std::upper_bound(sBase.begin(), sBase.end(), sIdx) - sBase.begin() - 1;
+}
+
+
+/**
+   @brief Distributes the bag over the workers in contiguous slices.  As
+   sample indices increase with row, each shard holds a row partition.
+
+   @return void.
+ */
+void ShardTrain::Stage(const Sample *sample, const RowRank *rowRank) {
+  unsigned int bagCount = sample->BagCount();
+  for (unsigned int shardIdx = 0; shardIdx <= nShard; shardIdx++) {
+    sBase[shardIdx] = (static_cast<unsigned long>(shardIdx) * bagCount) / nShard;
+  }
+  for (unsigned int shardIdx = 0; shardIdx < nShard; shardIdx++) {
+    shard[shardIdx] = new Shard(shardIdx, sBase[shardIdx], sBase[shardIdx + 1] - sBase[shardIdx], nPred, binWidth);
+  }
+
+  for (unsigned int sIdx = 0; sIdx < bagCount; sIdx++) {
+    FltVal ySum;
+    unsigned int sCount;
+    unsigned int ctg = sample->Ref(sIdx, ySum, sCount);
+    shard[Owner(sIdx)]->SetSample(sIdx, ySum, sCount, ctg);
+  }
+
+  std::vector<unsigned int> sample2Row(ctx->Stratified() ? bagCount : 0);
+  if (ctx->Stratified())
+    sample->RowInvert(sample2Row);
+
+  int predIdx;
+#pragma omp parallel default(shared) private(predIdx) num_threads(Parallel::Threads())
+  {
+#pragma omp for schedule(dynamic, 1)
+    for (predIdx = 0; predIdx < int(nPred); predIdx++) {
+      if (ctx->Retired(predIdx))
+        continue;
+      if (ctx->Stratified()) { // Ranks only the bagged rows.
+        for (unsigned int sIdx = 0; sIdx < bagCount; sIdx++)
+          shard[Owner(sIdx)]->SetRank(predIdx, sIdx, ctx->RankOf(rowRank, predIdx, sample2Row[sIdx]));
+        continue;
+      }
+      for (unsigned int idx = 0; idx < PredBlock::NRow(); idx++) {
+        unsigned int rank;
+        unsigned int row = rowRank->Lookup(predIdx, idx, rank);
+        int sIdx = sample->SampleIdx(row);
+        if (sIdx >= 0) {
+          shard[Owner(sIdx)]->SetRank(predIdx, sIdx, rank);
+        }
+      }
+    }
+  }
+}
+
+
+/**
+   @brief Grows a single tree level by level:  broadcasts the candidate
+   schedule, reduces worker histograms, selects splits and broadcasts
+   the resulting routes.
+
+   @param sample is the unstaged bag.
+
+   @return PreTree built from the bag.
+ */
+PreTree *ShardTrain::OneTree(const Sample *sample, const RowRank *rowRank) {
+  Stage(sample, rowRank);
+  PreTree *preTree = new PreTree(ctx, sample->BagCount());
+
+  std::vector<unsigned int> ptFront(1, 0); // Pretree node of each live node.
+  std::vector<double> minFront(1, 0.0); // Minimal information for splitting.
+  std::vector<ShardSplit> heldFront(1); // Split held by each carried node.
+  heldFront[0].predIdx = nPred;
+  unsigned int leafCount = 1; // Leaves grown, iff budgeted.
+  for (unsigned int level = 0; ptFront.size() > 0; level++) {
+    unsigned int levelCount = ptFront.size();
+    bool levelNext = level + 1 != ctx->totLevels && !ctx->Interrupted();
+    std::vector<bool> candidate;
+    SplitPred::Candidates(ctx, levelCount, candidate);
+    std::vector<unsigned int> candOff, candPred, candBin;
+    unsigned int binTot = 0;
+    for (unsigned int levelIdx = 0; levelIdx < levelCount; levelIdx++) {
+      candOff.push_back(candPred.size());
+      for (unsigned int predIdx = 0; predIdx < nPred; predIdx++) {
+        if (candidate[levelIdx * nPred + predIdx] && heldFront[levelIdx].predIdx == nPred) {
+          candPred.push_back(predIdx);
+          candBin.push_back(binTot);
+          binTot += binCount[predIdx];
+        }
+      }
+    }
+    candOff.push_back(candPred.size());
+    candBin.push_back(binTot);
+
+    std::vector<unsigned char> msg;
+    ShardComm::Pack(msg, candOff);
+    ShardComm::Pack(msg, candPred);
+    ShardComm::Pack(msg, candBin);
+    comm->Broadcast(msg);
+
+    int shardIdx;
+#pragma omp parallel default(shared) private(shardIdx) num_threads(Parallel::Threads())
+    {
+#pragma omp for schedule(dynamic, 1)
+      for (shardIdx = 0; shardIdx < int(nShard); shardIdx++) {
+        shard[shardIdx]->Histogram(comm, nStat);
+      }
+    }
+
+    std::vector<double> stat((levelCount + binTot) * nStat);
+    std::fill(stat.begin(), stat.end(), 0.0);
+    std::vector<unsigned int> rkMin(binTot);
+    std::fill(rkMin.begin(), rkMin.end(), UINT_MAX);
+    std::vector<unsigned int> rkMax(binTot);
+    std::fill(rkMax.begin(), rkMax.end(), 0);
+    for (unsigned int shardIdx = 0; shardIdx < nShard; shardIdx++) {
+      std::vector<double> statShard;
+      std::vector<unsigned int> minShard, maxShard;
+      comm->Recv(shardIdx, msg);
+      unsigned int off = ShardComm::Unpack(msg, 0, statShard);
+      off = ShardComm::Unpack(msg, off, minShard);
+      (void) ShardComm::Unpack(msg, off, maxShard);
+      for (unsigned int i = 0; i < stat.size(); i++)
+        stat[i] += statShard[i];
+      for (unsigned int bin = 0; bin < binTot; bin++) {
+        rkMin[bin] = min(rkMin[bin], minShard[bin]);
+        rkMax[bin] = max(rkMax[bin], maxShard[bin]);
+      }
+    }
+
+    // Argmax over each node's candidates, relative to the node's pre-bias.
+    //
+    std::vector<unsigned int> argPred(levelCount);
+    std::vector<double> argInfo(levelCount);
+    std::vector<unsigned int> argLow(levelCount), argHigh(levelCount), argBit(levelCount);
+    std::vector<bool> argNA(levelCount, false);
+    std::vector<double> argStat(levelCount * nStat);
+    std::vector<unsigned char> lhCode;
+    unsigned int splitCount = 0;
+    for (unsigned int levelIdx = 0; levelIdx < levelCount; levelIdx++) {
+      const ShardSplit &held = heldFront[levelIdx];
+      if (held.predIdx < nPred) { // Carried:  split already known.
+        argPred[levelIdx] = held.predIdx;
+        argInfo[levelIdx] = held.info;
+        argLow[levelIdx] = held.rkLow;
+        argHigh[levelIdx] = held.rkHigh;
+        argNA[levelIdx] = held.naLeft;
+        argBit[levelIdx] = lhCode.size();
+        lhCode.insert(lhCode.end(), held.lhCode.begin(), held.lhCode.end());
+        std::copy(held.lhStat.begin(), held.lhStat.end(), argStat.begin() + levelIdx * nStat);
+        splitCount++;
+        continue;
+      }
+      const double *tot = &stat[levelIdx * nStat];
+      double preBias = Gain(0, tot);
+      double maxGini = preBias + minFront[levelIdx];
+      argPred[levelIdx] = nPred;
+      for (unsigned int cand = candOff[levelIdx]; cand < candOff[levelIdx + 1]; cand++) {
+        unsigned int predIdx = candPred[cand];
+        const double *candStat = &stat[(levelCount + candBin[cand]) * nStat];
+        std::vector<double> lhStat;
+        bool found;
+        bool naLeft = false;
+        if (PredBlock::IsFactor(predIdx)) {
+          std::vector<unsigned char> candCode;
+          found = SplitFac(candStat, binCount[predIdx], tot, maxGini, candCode, lhStat);
+          if (found) {
+            argBit[levelIdx] = lhCode.size();
+            lhCode.insert(lhCode.end(), candCode.begin(), candCode.end());
+          }
+        }
+        else {
+          found = SplitNum(candStat, &rkMin[candBin[cand]], &rkMax[candBin[cand]], binCount[predIdx], tot, maxGini, argLow[levelIdx], argHigh[levelIdx], naLeft, lhStat);
+        }
+        if (found) {
+          argPred[levelIdx] = predIdx;
+          argNA[levelIdx] = naLeft;
+          argInfo[levelIdx] = maxGini - preBias;
+          std::copy(lhStat.begin(), lhStat.end(), argStat.begin() + levelIdx * nStat);
+        }
+      }
+      splitCount += argPred[levelIdx] < nPred ? 1 : 0;
+    }
+
+    // Under a leaf budget, the frontier's most informative splits are
+    // routed, as in Index::Budget().  The remainder are carried unsplit
+    // while budget remains, and are otherwise terminal.
+    //
+    std::vector<bool> carry(levelCount, false);
+    if (ctx->Budgeted()) {
+      std::vector<BudgetCand> cand;
+      for (unsigned int levelIdx = 0; levelIdx < levelCount; levelIdx++) {
+        if (argPred[levelIdx] < nPred)
+          cand.push_back(BudgetCand(argInfo[levelIdx], stat[levelIdx * nStat + 1], levelIdx));
+      }
+      unsigned int expandCount = ctx->Budget(cand, leafCount);
+      bool budgetLeft = levelNext && ctx->BudgetLeft(leafCount);
+      for (unsigned int candIdx = expandCount; candIdx < cand.size(); candIdx++) {
+        if (budgetLeft)
+          carry[cand[candIdx].levelIdx] = true;
+        else
+          argPred[cand[candIdx].levelIdx] = nPred;
+      }
+      splitCount = expandCount;
+    }
+
+    preTree->CheckStorage(splitCount, splitCount);
+    std::vector<ShardRoute> route(levelCount);
+    std::vector<unsigned int> ptNext;
+    std::vector<double> minNext;
+    std::vector<ShardSplit> heldNext;
+    ShardSplit unheld;
+    unheld.predIdx = nPred;
+    for (unsigned int levelIdx = 0; levelIdx < levelCount; levelIdx++) {
+      ShardRoute &rt = route[levelIdx];
+      unsigned int predIdx = argPred[levelIdx];
+      rt.predIdx = predIdx;
+      rt.lNext = rt.rNext = extinct;
+      if (carry[levelIdx]) {
+        rt.predIdx = nPred;
+        rt.lNext = ptNext.size();
+        ptNext.push_back(ptFront[levelIdx]);
+        minNext.push_back(minFront[levelIdx]);
+        heldNext.push_back(Hold(heldFront[levelIdx], predIdx, argInfo[levelIdx], argLow[levelIdx], argHigh[levelIdx], argNA[levelIdx], lhCode, argBit[levelIdx], &argStat[levelIdx * nStat]));
+        continue;
+      }
+      else if (predIdx == nPred) {
+        continue;
+      }
+
+      unsigned int ptId = ptFront[levelIdx];
+      double info = argInfo[levelIdx];
+      if (PredBlock::IsFactor(predIdx)) {
+        preTree->NonTerminalFac(info, predIdx, ptId, rt.ptL, rt.ptR);
+        rt.bitOff = argBit[levelIdx];
+        for (unsigned int code = 0; code < binCount[predIdx]; code++) {
+          if (lhCode[rt.bitOff + code] != 0)
+            preTree->LHBit(ptId, code);
+        }
+      }
+      else {
+        preTree->NonTerminalNum(info, predIdx, argLow[levelIdx], argHigh[levelIdx], argNA[levelIdx], ptId, rt.ptL, rt.ptR);
+        rt.rkCut = argLow[levelIdx];
+        rt.naLeft = argNA[levelIdx];
+      }
+
+      // Offspring persist to the next level under the same constraints
+      // as in Index::Levels().
+      //
+      unsigned int lhSCount = argStat[levelIdx * nStat];
+      unsigned int rhSCount = stat[levelIdx * nStat] - lhSCount;
+      unsigned int lhIdxCount = argStat[levelIdx * nStat + 1];
+      unsigned int rhIdxCount = stat[levelIdx * nStat + 1] - lhIdxCount;
+      if (levelNext && ctx->Splitable(lhIdxCount, lhSCount)) {
+        rt.lNext = ptNext.size();
+        ptNext.push_back(rt.ptL);
+        minNext.push_back(ctx->MinInfo(info));
+        heldNext.push_back(unheld);
+      }
+      if (levelNext && ctx->Splitable(rhIdxCount, rhSCount)) {
+        rt.rNext = ptNext.size();
+        ptNext.push_back(rt.ptR);
+        minNext.push_back(ctx->MinInfo(info));
+        heldNext.push_back(unheld);
+      }
+    }
+
+    msg.clear();
+    ShardComm::Pack(msg, route);
+    ShardComm::Pack(msg, lhCode);
+    comm->Broadcast(msg);
+#pragma omp parallel default(shared) private(shardIdx) num_threads(Parallel::Threads())
+    {
+#pragma omp for schedule(dynamic, 1)
+      for (shardIdx = 0; shardIdx < int(nShard); shardIdx++) {
+        shard[shardIdx]->Route(comm, nPred);
+      }
+    }
+
+    ptFront = std::move(ptNext);
+    minFront = std::move(minNext);
+    heldFront = std::move(heldNext);
+  }
+
+  // Gathers the frontier map and retires the workers.
+  //
+  for (unsigned int shardIdx = 0; shardIdx < nShard; shardIdx++) {
+    shard[shardIdx]->Frontier(comm);
+    std::vector<unsigned char> msg;
+    comm->Recv(shardIdx, msg);
+    std::vector<unsigned int> ptId;
+    (void) ShardComm::Unpack(msg, 0, ptId);
+    for (unsigned int i = 0; i < ptId.size(); i++) {
+      preTree->SampleFrontier(sBase[shardIdx] + i, ptId[i]);
+    }
+    delete shard[shardIdx];
+    shard[shardIdx] = 0;
+  }
+
+  return preTree;
+}
+
+
+/**
+   @brief Records the split of a node carried under a leaf budget.
+
+   @param held is the split already held by the node, if any.
+
+   @param lhCode holds the left-hand codes of the level's factor splits.
+
+   @param argBit is the offset of the node's codes, if factor.
+
+   @param lhStat summarizes the left-hand side of the split.
+
+   @return record of the carried split.
+ */
+ShardSplit ShardTrain::Hold(const ShardSplit &held, unsigned int predIdx, double info, unsigned int rkLow, unsigned int rkHigh, bool naLeft, const std::vector<unsigned char> &lhCode, unsigned int argBit, const double lhStat[]) const {
+  if (held.predIdx < nPred)
+    return held;
+
+  ShardSplit split;
+  split.predIdx = predIdx;
+  split.info = info;
+  split.rkLow = rkLow;
+  split.rkHigh = rkHigh;
+  split.naLeft = naLeft;
+  if (PredBlock::IsFactor(split.predIdx))
+    split.lhCode.assign(lhCode.begin() + argBit, lhCode.begin() + argBit + binCount[split.predIdx]);
+  split.lhStat.assign(lhStat, lhStat + nStat);
+
+  return split;
+}
+
+
+/**
+   @brief Evaluates the splitting criterion for a left-hand summary against
+   node totals:  weighted variance for regression, Gini for classification.
+
+   @param statL summarizes the left-hand side, or is null to evaluate the
+   unsplit node, i.e., the pre-bias.
+
+   @param tot summarizes the node.
+
+   @return criterion value, or zero if either side is degenerate.
+ */
+double ShardTrain::Gain(const double statL[], const double tot[]) const {
+  if (statL == 0) {
+    if (ctgWidth == 0)
+      return (tot[2] * tot[2]) / tot[0];
+
+    double ss = 0.0;
+    for (unsigned int ctg = 0; ctg < ctgWidth; ctg++)
+      ss += tot[3 + ctg] * tot[3 + ctg];
+    return ss / tot[2];
+  }
+
+  double sCountL = statL[0];
+  double sCountR = tot[0] - sCountL;
+  double sumL = statL[2];
+  double sumR = tot[2] - sumL;
+  if (ctgWidth == 0) {
+    return sCountL > 0.0 && sCountR > 0.0 ? (sumL * sumL) / sCountL + (sumR * sumR) / sCountR : 0.0;
+  }
+
+  if (sumL <= minDenom || sumR <= minDenom)
+    return 0.0;
+  double ssL = 0.0;
+  double ssR = 0.0;
+  for (unsigned int ctg = 0; ctg < ctgWidth; ctg++) {
+    double ctgL = statL[3 + ctg];
+    double ctgR = tot[3 + ctg] - ctgL;
+    ssL += ctgL * ctgL;
+    ssR += ctgR * ctgR;
+  }
+
+  return ssL / sumL + ssR / sumR;
+}
+
+
+/**
+   @brief Accumulates a bin summary into a running summary.
+
+   @return void, with side-effected running summary.
+ */
+void ShardTrain::Accum(std::vector<double> &statAcc, const double stat[]) const {
+  for (unsigned int i = 0; i < nStat; i++)
+    statAcc[i] += stat[i];
+}
+
+
+/**
+   @brief Scans cuts between consecutive nonempty bins of a numeric predictor.
+   Observed rank extrema bound the cut, as in SamplePred::SplitRanks().
+   Missing values, binned last, are evaluated on either side of each cut,
+   as in SPReg::SplitNumWV(), and also apart from all observed values.
+
+   @param nBin is the bin count, including the bin of missing values.
+
+   @param maxGini inputs the threshold criterion and outputs any improvement.
+
+   @param rkLow outputs the highest left-hand rank.
+
+   @param rkHigh outputs the lowest right-hand rank, or the NA rank if
+   only missing values lie right.
+
+   @param naLeft outputs whether missing values are sent left.
+
+   @param lhStat outputs the left-hand summary.
+
+   @return true iff an improving cut was found.
+ */
+bool ShardTrain::SplitNum(const double stat[], const unsigned int rkMin[], const unsigned int rkMax[], unsigned int nBin, const double tot[], double &maxGini, unsigned int &rkLow, unsigned int &rkHigh, bool &naLeft, std::vector<double> &lhStat) const {
+  const double *naStat = &stat[(nBin - 1) * nStat];
+  std::vector<double> statL(nStat);
+  std::fill(statL.begin(), statL.end(), 0.0);
+  std::vector<double> statLNA(nStat);
+  bool found = false;
+  unsigned int binPrev = 0;
+  for (unsigned int bin = 0; bin < nBin; bin++) {
+    const double *binStat = &stat[bin * nStat];
+    if (binStat[1] == 0.0)
+      continue;
+    if (statL[1] > 0.0) {
+      unsigned int rkRight = bin == nBin - 1 ? PredBlock::NARank() : rkMin[bin];
+      double cutGini = Gain(&statL[0], tot);
+      if (cutGini > maxGini) {
+        maxGini = cutGini;
+        rkLow = rkMax[binPrev];
+        rkHigh = rkRight;
+        naLeft = false;
+        lhStat = statL;
+        found = true;
+      }
+      if (naStat[1] > 0.0 && bin < nBin - 1) { // Missing values sent left.
+        statLNA = statL;
+        Accum(statLNA, naStat);
+        double naGini = Gain(&statLNA[0], tot);
+        if (naGini > maxGini) {
+          maxGini = naGini;
+          rkLow = rkMax[binPrev];
+          rkHigh = rkRight;
+          naLeft = true;
+          lhStat = statLNA;
+          found = true;
+        }
+      }
+    }
+    Accum(statL, binStat);
+    binPrev = bin;
+  }
+
+  return found;
+}
+
+
+/**
+   @brief Splits the codes of a factor predictor.  Codes are ordered by mean
+   response, as in RunSet::HeapMean(), or by category-one concentration for
+   binary responses, as in RunSet::HeapBinary(), and cuts of the ordering
+   are scanned.  Other categorical responses enumerate subsets when narrow
+   enough, otherwise ordering by concentration of the node's plurality
+   category.
+
+   @param lhCode outputs a per-code flag indicating left-hand membership.
+
+   @return true iff an improving split was found.
+ */
+bool ShardTrain::SplitFac(const double stat[], unsigned int nBin, const double tot[], double &maxGini, std::vector<unsigned char> &lhCode, std::vector<double> &lhStat) const {
+  std::vector<unsigned int> code;
+  for (unsigned int bin = 0; bin < nBin; bin++) {
+    if (stat[bin * nStat + 1] > 0.0)
+      code.push_back(bin);
+  }
+  if (code.size() < 2)
+    return false;
+
+  lhCode.resize(nBin);
+  std::fill(lhCode.begin(), lhCode.end(), 0);
+  std::vector<double> statL(nStat);
+  bool found = false;
+  if (ctgWidth > 2 && code.size() <= RunSet::maxWidth) {
+    unsigned int slotSup = code.size() - 1; // Final code always right.
+    unsigned int lhBits = 0;
+    for (unsigned int subset = 1; subset < (1u << slotSup); subset++) {
+      std::fill(statL.begin(), statL.end(), 0.0);
+      for (unsigned int slot = 0; slot < slotSup; slot++) {
+        if ((subset & (1 << slot)) != 0)
+          Accum(statL, &stat[code[slot] * nStat]);
+      }
+      double subsetGini = Gain(&statL[0], tot);
+      if (subsetGini > maxGini) {
+        maxGini = subsetGini;
+        lhBits = subset;
+        lhStat = statL;
+        found = true;
+      }
+    }
+    for (unsigned int slot = 0; slot < slotSup; slot++) {
+      lhCode[code[slot]] = (lhBits & (1 << slot)) != 0 ? 1 : 0;
+    }
+    return found;
+  }
+
+  unsigned int keyCtg = ctgWidth > 1 ? 1 : 0;
+  if (ctgWidth > 2) {
+    for (unsigned int ctg = 0; ctg < ctgWidth; ctg++) {
+      keyCtg = tot[3 + ctg] > tot[3 + keyCtg] ? ctg : keyCtg;
+    }
+  }
+  std::vector<std::pair<double, unsigned int> > keyCode;
+  for (unsigned int i = 0; i < code.size(); i++) {
+    const double *codeStat = &stat[code[i] * nStat];
+    double key = ctgWidth == 0 ? codeStat[2] / codeStat[0] : codeStat[3 + keyCtg] / codeStat[2];
+    keyCode.push_back(std::make_pair(key, code[i]));
+  }
+  std::sort(keyCode.begin(), keyCode.end());
+
+  std::fill(statL.begin(), statL.end(), 0.0);
+  int cut = -1;
+  for (unsigned int slot = 0; slot < keyCode.size() - 1; slot++) {
+    Accum(statL, &stat[keyCode[slot].second * nStat]);
+    double cutGini = Gain(&statL[0], tot);
+    if (cutGini > maxGini) {
+      maxGini = cutGini;
+      cut = slot;
+      lhStat = statL;
+      found = true;
+    }
+  }
+  for (int slot = 0; slot <= cut; slot++) {
+    lhCode[keyCode[slot].second] = 1;
+  }
+
+  return found;
+}
@@ -0,0 +1,236 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file shard.h
+
+   @brief Class definitions for row-partitioned training of a single tree:  worker shards, the transport between them and the reducing trainer.
+
+   @author Mark Seligman
+
+ */
+
+#ifndef ARBORIST_SHARD_H
+#define ARBORIST_SHARD_H
+
+#include <vector>
+#include <cstring>
+#include <climits>
+#include "param.h"
+
+
+/**
+   @brief Message-passing interface between the reducer and its worker
+   shards.  Messages are opaque byte vectors, so that implementations
+   need not share address space with the trainer.
+ */
+class ShardComm {
+ public:
+  virtual ~ShardComm() {}
+
+  virtual void Send(unsigned int shardIdx, std::vector<unsigned char> &msg) = 0;
+  virtual void Recv(unsigned int shardIdx, std::vector<unsigned char> &msg) = 0;
+  virtual void Broadcast(const std::vector<unsigned char> &msg) = 0;
+  virtual void Listen(unsigned int shardIdx, std::vector<unsigned char> &msg) = 0;
+
+
+  /**
+     @brief Appends a length-prefixed copy of a vector of plain values.
+
+     @param msg is the message under construction.
+
+     @param vec is the vector to append.
+
+     @return void, with side-effected message.
+   */
+  template<typename T> static void Pack(std::vector<unsigned char> &msg, const std::vector<T> &vec) {
+    unsigned int len = vec.size();
+    unsigned int off = msg.size();
+    msg.resize(off + sizeof(len) + len * sizeof(T));
+    std::memcpy(&msg[off], &len, sizeof(len));
+    if (len > 0)
+      std::memcpy(&msg[off + sizeof(len)], &vec[0], len * sizeof(T));
+  }
+
+
+  /**
+     @brief Extracts a vector packed by Pack().
+
+     @param msg is the message being read.
+
+     @param off is the read position.
+
+     @param vec outputs the unpacked vector.
+
+     @return read position beyond the unpacked vector.
+   */
+  template<typename T> static unsigned int Unpack(const std::vector<unsigned char> &msg, unsigned int off, std::vector<T> &vec) {
+    unsigned int len;
+    std::memcpy(&len, &msg[off], sizeof(len));
+    off += sizeof(len);
+    vec.resize(len);
+    if (len > 0)
+      std::memcpy(&vec[0], &msg[off], len * sizeof(T));
+
+    return off + len * sizeof(T);
+  }
+};
+
+
+/**
+   @brief In-process stand-in for a distributed transport.  Each shard
+   owns a pair of mailboxes, so workers may post concurrently.
+ */
+class ShardLocal : public ShardComm {
+  std::vector<std::vector<unsigned char> > upBox; // Worker to reducer.
+  std::vector<unsigned char> downBox; // Reducer to all workers.
+ public:
+  ShardLocal(unsigned int nShard);
+  ~ShardLocal() {}
+
+  void Send(unsigned int shardIdx, std::vector<unsigned char> &msg);
+  void Recv(unsigned int shardIdx, std::vector<unsigned char> &msg);
+  void Broadcast(const std::vector<unsigned char> &msg);
+  void Listen(unsigned int shardIdx, std::vector<unsigned char> &msg);
+};
+
+
+/**
+   @brief Worker-local state of a sample:  response summary and position
+   within the frontier.
+ */
+class ShardSample {
+ public:
+  FltVal ySum;
+  unsigned int sCount;
+  unsigned int ctg;
+  unsigned int levelIdx; // Index of node in current level, if live.
+  unsigned int ptId; // Pretree node currently holding sample.
+};
+
+
+/**
+   @brief Instructs workers how to partition the samples of a node.
+ */
+class ShardRoute {
+ public:
+  unsigned int predIdx; // Splitting predictor, or 'nPred' if unsplit.
+  unsigned int rkCut; // Numeric:  highest rank on the left.
+  bool naLeft; // Numeric:  whether missing values are sent left.
+  unsigned int bitOff; // Factor:  offset of left-hand codes.
+  unsigned int ptL;
+  unsigned int ptR;
+  unsigned int lNext; // Next-level index of LHS, if splitable, or of carried node.
+  unsigned int rNext; // "" RHS.
+};
+
+
+/**
+   @brief Reducer-side record of a split deferred under a leaf budget.
+   The node is carried, unsplit, until its split is expanded.
+ */
+class ShardSplit {
+ public:
+  unsigned int predIdx; // Splitting predictor, or 'nPred' if none held.
+  double info;
+  unsigned int rkLow; // Numeric:  cut ranks.
+  unsigned int rkHigh;
+  bool naLeft; // Numeric:  whether missing values are sent left.
+  std::vector<unsigned char> lhCode; // Factor:  left-hand codes.
+  std::vector<double> lhStat; // Left-hand summary.
+};
+
+
+/**
+   @brief A worker holding a contiguous slice of the bag, together with
+   the predictor ranks of its samples.
+ */
+class Shard {
+  const unsigned int shardIdx;
+  const unsigned int sBase; // Tree-relative index of first local sample.
+  const unsigned int nLocal;
+  const std::vector<unsigned int> &binWidth;
+  std::vector<ShardSample> sample;
+  std::vector<unsigned int> rank; // Predictor-major ranks of local samples.
+  std::vector<unsigned int> candOff; // Per-node offsets into candidates.
+  std::vector<unsigned int> candPred; // Predictor of each candidate.
+  std::vector<unsigned int> candBin; // Histogram offset of each candidate.
+ public:
+  Shard(unsigned int _shardIdx, unsigned int _sBase, unsigned int _nLocal, unsigned int nPred, const std::vector<unsigned int> &_binWidth);
+
+  void Histogram(class ShardComm *comm, unsigned int nStat);
+  void Route(class ShardComm *comm, unsigned int nPred);
+  void Frontier(class ShardComm *comm);
+
+
+  /**
+     @brief Initializes a local sample at the root.
+
+     @param sIdx is the tree-relative sample index.
+
+     @return void.
+   */
+  inline void SetSample(unsigned int sIdx, FltVal ySum, unsigned int sCount, unsigned int ctg) {
+    ShardSample &smp = sample[sIdx - sBase];
+    smp.ySum = ySum;
+    smp.sCount = sCount;
+    smp.ctg = ctg;
+    smp.levelIdx = 0;
+    smp.ptId = 0;
+  }
+
+
+  /**
+     @brief Records predictor rank of a local sample.
+
+     @param sIdx is the tree-relative sample index.
+
+     @return void.
+   */
+  inline void SetRank(unsigned int predIdx, unsigned int sIdx, unsigned int _rank) {
+    rank[predIdx * nLocal + sIdx - sBase] = _rank;
+  }
+};
+
+
+/**
+   @brief Trains trees from row-sharded bags.  Each level, workers summarize
+   candidate (node, predictor) pairs as rank histograms and the reducer
+   selects the argmax under the criteria employed by SPReg and SPCtg.
+ */
+class ShardTrain {
+  class TrainCtx *ctx;
+  const unsigned int nShard; // Zero iff sharding disabled.
+  const unsigned int nPred;
+  const unsigned int ctgWidth;
+  static constexpr unsigned int binMax = 256; // Histogram width, numeric.
+  static constexpr double minDenom = 1.0e-5; // As in SPCtg.
+  const unsigned int nStat; // Accumulators per histogram bin.
+  std::vector<unsigned int> binWidth; // Ranks per bin, by predictor.
+  std::vector<unsigned int> binCount; // Bins per predictor.
+  class ShardComm *comm;
+  std::vector<class Shard *> shard;
+  std::vector<unsigned int> sBase;
+
+  void Stage(const class Sample *sample, const class RowRank *rowRank);
+  unsigned int Owner(unsigned int sIdx) const;
+  double Gain(const double statL[], const double tot[]) const;
+  bool SplitNum(const double stat[], const unsigned int rkMin[], const unsigned int rkMax[], unsigned int nBin, const double tot[], double &maxGini, unsigned int &rkLow, unsigned int &rkHigh, bool &naLeft, std::vector<double> &lhStat) const;
+  bool SplitFac(const double stat[], unsigned int nBin, const double tot[], double &maxGini, std::vector<unsigned char> &lhCode, std::vector<double> &lhStat) const;
+  void Accum(std::vector<double> &statAcc, const double stat[]) const;
+  ShardSplit Hold(const ShardSplit &held, unsigned int predIdx, double info, unsigned int rkLow, unsigned int rkHigh, bool naLeft, const std::vector<unsigned char> &lhCode, unsigned int argBit, const double lhStat[]) const;
+
+ public:
+  static const unsigned int extinct = UINT_MAX; // Sample no longer live.
+  static class PreTree **BlockTrees(class TrainCtx *ctx, class Sample **sampleBlock, const class RowRank *rowRank, int treeBlock);
+
+  ShardTrain(class TrainCtx *_ctx, const class RowRank *rowRank);
+  ~ShardTrain();
+  class PreTree *OneTree(const class Sample *sample, const class RowRank *rowRank);
+};
+
+#endif
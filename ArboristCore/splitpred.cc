@@ -22,22 +22,19 @@ using namespace std;
 #include "bottom.h"
 #include "runset.h"
 #include "samplepred.h"
-#include "callback.h"
 #include "sample.h"
 #include "predblock.h"
+#include "rowrank.h"
+#include "parallel.h"
+#include "trainctx.h"
 
-unsigned int SplitPred::nPred = 0;
-unsigned int SplitPred::predFixed = 0;
-const double *SplitPred::predProb = 0;
-
-const double *SPReg::feMono = 0;
-unsigned int SPReg::predMono = 0;
-unsigned int SPCtg::ctgWidth = 0;
+#include <algorithm>
+#include <numeric>
 
 /**
   @brief Constructor.  Initializes 'runFlags' to zero for the single-split root.
  */
-SplitPred::SplitPred(SamplePred *_samplePred, unsigned int bagCount) : samplePred(_samplePred) {
+SplitPred::SplitPred(const TrainCtx *_ctx, SamplePred *_samplePred, unsigned int bagCount) : predFixed(_ctx->predFixed), predProb(_ctx->predProb), ctx(_ctx), nPred(_ctx->nPred), samplePred(_samplePred) {
 }
 
 
@@ -50,57 +47,15 @@ SplitPred::~SplitPred() {
 }
 
 
-void SplitPred::Immutables(unsigned int _nPred, unsigned int _ctgWidth, unsigned int _predFixed, const double _predProb[], const double _regMono[]) {
-  nPred = _nPred;
-  predFixed = _predFixed;
-  predProb = _predProb;
-
-  if (_ctgWidth > 0) {
-    SPCtg::Immutables(_ctgWidth);
-  }
-  else {
-    SPReg::Immutables(nPred, _regMono);
-  }
-}
-
-
-void SplitPred::DeImmutables() {
-  nPred = 0;
-  predFixed = 0;
-
-  // 'ctgWidth' distinguishes regression from classification.
-  if (SPCtg::CtgWidth() > 0)
-    SPCtg::DeImmutables();
-  else
-    SPReg::DeImmutables();
-}
-
-
 /**
-   @brief Caches a local copy of the mono[] vector.
- */
-void SPReg::Immutables(unsigned int _nPred, const double _mono[]) {
-  predMono = 0;
-  feMono = _mono;
-  for (unsigned int i = 0; i < _nPred; i++) {
-    double monoProb = feMono[i];
-    predMono += monoProb != 0.0;
-  }
-}
-
-
-void SPReg::DeImmutables() {
-  predMono = 0;
-}
-
-
-void SPCtg::Immutables(unsigned int _ctgWidth) {
-  ctgWidth = _ctgWidth;
-}
-
+   @brief Determines whether a pair's numeric predictor is split by runs.
 
-void SPCtg::DeImmutables() {
-  ctgWidth = 0;
+   @return true iff the predictor was flagged as having few values.
+ */
+bool SplitPred::RunNum(unsigned int splitIdx) const {
+  unsigned int levelIdx, predIdx;
+  bottom->SplitRef(splitIdx, levelIdx, predIdx);
+  return ctx->RunNum(predIdx);
 }
 
 
@@ -108,8 +63,10 @@ void SPCtg::DeImmutables() {
    @brief Constructor.
 
    @param samplePred holds (re)staged node contents.
+
+   @param _outSum holds per-sample sums of a multi-output response, if any.
  */
-SPReg::SPReg(SamplePred *_samplePred, unsigned int bagCount) : SplitPred(_samplePred, bagCount), ruMono(0) {
+SPReg::SPReg(const TrainCtx *_ctx, SamplePred *_samplePred, unsigned int bagCount, const FltVal *_outSum) : SplitPred(_ctx, _samplePred, bagCount), predMono(_ctx->predMono), feMono(_ctx->regMono), nOut(_ctx->nOut), outSum(_outSum), ruMono(0), outNode(0) {
   run = new Run(0);
 }
 
@@ -121,7 +78,7 @@ SPReg::SPReg(SamplePred *_samplePred, unsigned int bagCount) : SplitPred(_sample
 
    @param sampleCtg is the sample vector for the tree, included for category lookup.
  */
-SPCtg::SPCtg(SamplePred *_samplePred, SampleNode _sampleCtg[], unsigned int bagCount): SplitPred(_samplePred, bagCount), sampleCtg(_sampleCtg) {
+SPCtg::SPCtg(const TrainCtx *_ctx, SamplePred *_samplePred, SampleNode _sampleCtg[], unsigned int bagCount): SplitPred(_ctx, _samplePred, bagCount), ctgWidth(_ctx->ctgWidth), runShift(_ctx->runShift), sampleCtg(_sampleCtg) {
   run = new Run(ctgWidth);
 }
 
@@ -139,6 +96,10 @@ void SplitPred::LevelInit(Index *index, IndexNode indexNode[], unsigned int _lev
   levelCount = _levelCount;
   std::vector<unsigned int> safeCount;
   bool *unsplitable = LevelPreset(index);
+  for (unsigned int levelIdx = 0; levelIdx < levelCount; levelIdx++) {
+    // Nodes carried under a leaf budget already hold their split.
+    unsplitable[levelIdx] = unsplitable[levelIdx] || indexNode[levelIdx].Carried();
+  }
   Splitable(unsplitable, safeCount);
   delete [] unsplitable;
 
@@ -175,7 +136,7 @@ void SPReg::LevelInit(Index *index, IndexNode indexNode[], unsigned int _levelCo
   if (predMono > 0) {
     unsigned int monoCount = _levelCount * nPred; // Clearly too big.
     ruMono = new double[monoCount];
-    CallBack::RUnif(monoCount, ruMono);
+    ctx->RUnif(monoCount, ruMono);
   }
   else {
     ruMono = 0;
@@ -199,7 +160,7 @@ void SPReg::RunOffsets(const std::vector<unsigned int> &safeCount) {
  */
 void SPCtg::RunOffsets(const std::vector<unsigned int> &safeCount) {
   run->RunSets(safeCount);
-  run->OffsetsCtg();
+  run->OffsetsCtg(ctx);
 }
 
 
@@ -215,7 +176,7 @@ void SplitPred::Splitable(const bool unsplitable[], std::vector<unsigned int> &s
   int cellCount = levelCount * nPred;
 
   double *ruPred = new double[cellCount];
-  CallBack::RUnif(cellCount, ruPred);
+  ctx->RUnif(cellCount, ruPred);
 
   BHPair *heap;
   if (predFixed > 0)
@@ -275,14 +236,17 @@ void SplitPred::SplitPredProb(unsigned int levelIdx, const double ruPred[], std:
  */
 void SplitPred::SplitPredFixed(unsigned int levelIdx, const double ruPred[], BHPair heap[], std::vector<unsigned int> &safeCount) {
   // Inserts negative, weighted probability value:  choose from lowest.
+  // Retired predictors are keyed to pop last.
   for (unsigned int predIdx = 0; predIdx < nPred; predIdx++) {
-    BHeap::Insert(heap, predIdx, -ruPred[predIdx] * predProb[predIdx]);
+    BHeap::Insert(heap, predIdx, ctx->Retired(predIdx) ? 1.0 : -ruPred[predIdx] * predProb[predIdx]);
   }
 
   // Pops 'predFixed' items in order of increasing value.
   unsigned int schedCount = 0;
   for (unsigned int heapSize = nPred; heapSize > 0; heapSize--) {
     unsigned int predIdx = BHeap::SlotPop(heap, heapSize - 1);
+    if (ctx->Retired(predIdx))
+      break;
     unsigned int rc = bottom->ScheduleSplit(levelIdx, predIdx, safeCount.size());
     if (rc > 1) {
       safeCount.push_back(rc);
@@ -294,6 +258,56 @@ void SplitPred::SplitPredFixed(unsigned int levelIdx, const double ruPred[], BHP
 }
 
 
+/**
+   @brief Draws splitting candidates without consulting Bottom, for trainers
+   which do not stage SamplePred locally.  Run counts are unavailable, so
+   fixed-count selection does not skip singletons.
+
+   @param ctx holds the fit's predictor-selection parameters.
+
+   @param levelCount is the number of nodes in the level.
+
+   @param candidate outputs a flag for each (node, predictor) pair, node-major.
+
+   @return void, with output vector.
+ */
+void SplitPred::Candidates(const TrainCtx *ctx, unsigned int levelCount, std::vector<bool> &candidate) {
+  unsigned int nPred = ctx->nPred;
+  unsigned int predFixed = ctx->predFixed;
+  const double *predProb = ctx->predProb;
+  unsigned int cellCount = levelCount * nPred;
+  candidate.assign(cellCount, false);
+
+  double *ruPred = new double[cellCount];
+  ctx->RUnif(cellCount, ruPred);
+  BHPair *heap = predFixed > 0 ? new BHPair[nPred] : 0;
+  for (unsigned int levelIdx = 0; levelIdx < levelCount; levelIdx++) {
+    unsigned int splitOff = levelIdx * nPred;
+    if (predFixed == 0) {
+      for (unsigned int predIdx = 0; predIdx < nPred; predIdx++) {
+        candidate[splitOff + predIdx] = ruPred[splitOff + predIdx] < predProb[predIdx];
+      }
+    }
+    else {
+      for (unsigned int predIdx = 0; predIdx < nPred; predIdx++) {
+        BHeap::Insert(heap, predIdx, ctx->Retired(predIdx) ? 1.0 : -ruPred[splitOff + predIdx] * predProb[predIdx]);
+      }
+      unsigned int schedCount = 0;
+      for (unsigned int heapSize = nPred; heapSize > 0 && schedCount < predFixed; heapSize--, schedCount++) {
+        unsigned int predIdx = BHeap::SlotPop(heap, heapSize - 1);
+        if (ctx->Retired(predIdx))
+          break;
+        candidate[splitOff + predIdx] = true;
+      }
+    }
+  }
+
+  if (heap != 0)
+    delete [] heap;
+  delete [] ruPred;
+}
+
+
 /**
    @brief Base method.  Deletes per-level run and split-flags vectors.
 
@@ -304,13 +318,68 @@ void SplitPred::LevelClear() {
 }
 
 
-void SplitPred::Split(unsigned int splitIdx, const IndexNode *indexNode, const SPNode *spn) {
-  if (bottom->HasRuns(splitIdx)) {
-    SplitFac(splitIdx, indexNode, spn);
+/**
+   @brief Buckets the level's splits by kernel, then dispatches them in
+   bucket order, so that each worker tends to run the same kernel on
+   consecutive splits.  Kernels resolve statically, with no per-split
+   virtual dispatch.
+
+   @param sp is the derived splitting object.
+
+   @param splitCoord are the scheduled splits.
+
+   @param indexNode[] is the vector of index nodes.
+
+   @return void.
+ */
+template<class SPType> void SplitPred::SplitBuckets(SPType *sp, const std::vector<SplitCoord> &splitCoord, const IndexNode indexNode[]) {
+  std::vector<unsigned int> kernel(splitCoord.size());
+  std::vector<unsigned int> bucketTop(SPType::kernelCount + 1);
+  for (unsigned int splitPos = 0; splitPos < splitCoord.size(); splitPos++) {
+    kernel[splitPos] = sp->Kernel(splitPos);
+    bucketTop[kernel[splitPos] + 1]++;
   }
-  else {
-    SplitNum(splitIdx, indexNode, spn);
+  for (unsigned int k = 1; k <= SPType::kernelCount; k++) {
+    bucketTop[k] += bucketTop[k-1];
   }
+  std::vector<unsigned int> order(splitCoord.size());
+  for (unsigned int splitPos = 0; splitPos < splitCoord.size(); splitPos++) {
+    order[bucketTop[kernel[splitPos]]++] = splitPos;
+  }
+
+  // Guards cast to int for OpenMP 2.0 back-compatibility.
+  int orderPos;
+#pragma omp parallel default(shared) private(orderPos) num_threads(Parallel::Threads())
+  {
+#pragma omp for schedule(dynamic, 1)
+    for (orderPos = 0; orderPos < int(order.size()); orderPos++) {
+      unsigned int splitPos = order[orderPos];
+      unsigned int levelIdx, predIdx, bufIdx;
+      int setPos;
+      splitCoord[splitPos].Ref(levelIdx, predIdx, setPos, bufIdx);
+      sp->SplitKernel(kernel[splitPos], splitPos, &indexNode[levelIdx], samplePred->PredBase(predIdx, bufIdx));
+    }
+  }
+}
+
+
+/**
+   @brief Splits the level's scheduled pairs.
+
+   @return void.
+ */
+void SPReg::SplitLevel(const std::vector<SplitCoord> &splitCoord, const IndexNode indexNode[]) {
+  SplitBuckets(this, splitCoord, indexNode);
+}
+
+
+/**
+   @brief Splits the level's scheduled pairs.
+
+   @return void.
+ */
+void SPCtg::SplitLevel(const std::vector<SplitCoord> &splitCoord, const IndexNode indexNode[]) {
+  SplitBuckets(this, splitCoord, indexNode);
 }
 
 
@@ -322,6 +391,10 @@ void SPReg::LevelClear() {
     delete [] ruMono;
     ruMono = 0;
   }
+  if (outNode != 0) {
+    delete [] outNode;
+    outNode = 0;
+  }
   SplitPred::LevelClear();
 }
 
@@ -346,9 +419,10 @@ void SPCtg::LevelClear() {
 
 
 /**
-   @brief Currently just a stub.
+   @brief Sums the outputs of a multi-output response by node.  Otherwise
+   just a stub.
 
-   @param index is not used by this instantiation.
+   @param index is the Index context.
 
    @param levelCount is the number of live index nodes.
 
@@ -358,11 +432,41 @@ bool *SPReg::LevelPreset(const Index *index) {
   bool* unsplitable = new bool[levelCount];
   for (unsigned int levelIdx = 0; levelIdx < levelCount; levelIdx++)
     unsplitable[levelIdx] = false;
+  if (outSum != 0)
+    SumsOut(index);
 
   return unsplitable;
 }
 
 
+/**
+   @brief Sums each output over the nodes of the upcoming level.  As
+   with SPCtg::SumsAndSquares(), sums are accumulated by level offset
+   and then copied to split-index order.
+
+   @param index is the Index context.
+
+   @return void.
+ */
+void SPReg::SumsOut(const Index *index) {
+  unsigned int levelWidth = index->LevelWidth();
+  std::vector<double> sumTemp(levelWidth * nOut);
+  for (unsigned int sIdx = 0; sIdx < index->BagCount(); sIdx++) {
+    unsigned int levelOff;
+    if (index->LevelOffSample(sIdx, levelOff))
+      AccumOut(&sumTemp[levelOff * nOut], sIdx);
+  }
+
+  outNode = new double[levelCount * nOut];
+  for (unsigned int levelIdx = 0; levelIdx < levelCount; levelIdx++) {
+    int levelOff = index->LevelOffSplit(levelIdx);
+    for (unsigned int outIdx = 0; outIdx < nOut; outIdx++) {
+      outNode[levelIdx * nOut + outIdx] = sumTemp[levelOff * nOut + outIdx];
+    }
+  }
+}
+
+
 /**
   @brief Weight-variance pre-bias computation for regression response.
 
@@ -372,10 +476,19 @@ bool *SPReg::LevelPreset(const Index *index) {
 
   @param sum is the sum of samples subsumed by the index node.
 
-  @return square squared, divided by sample count.
+  @return square squared, divided by sample count, summed over outputs
+  if multi-output.
 */
 double SPReg::Prebias(unsigned int levelIdx, unsigned int sCount, double sum) {
-  return (sum * sum) / sCount;
+  if (outNode == 0)
+    return (sum * sum) / sCount;
+
+  double ss = 0.0;
+  for (unsigned int outIdx = 0; outIdx < nOut; outIdx++) {
+    double sumOut = outNode[levelIdx * nOut + outIdx];
+    ss += sumOut * sumOut;
+  }
+  return ss / sCount;
 }
 
 
@@ -493,21 +606,58 @@ void SPCtg::LevelInitSumR() {
 //
 
 /**
-   @brief Invokes regression/numeric splitting method, currently only Gini available.
+   @brief Selects the kernel splitting a regression pair.
 
-   @param indexNode[] is the vector of index nodes.
+   @param splitIdx is the split index.
+
+   @return kernel index.
+ */
+unsigned int SPReg::Kernel(unsigned int splitIdx) {
+  if (outSum != 0)
+    return bottom->HasRuns(splitIdx) ? kernelFacOut : kernelNumOut;
+  if (bottom->HasRuns(splitIdx))
+    return kernelFac;
+
+  int monoMode = MonoMode(splitIdx);
+  if (monoMode != 0)
+    return monoMode > 0 ? kernelMonoUp : kernelMonoDown;
+  else
+    return RunNum(splitIdx) ? kernelRuns : kernelWV;
+}
 
-   @param nodeBase is the vector of SamplePred nodes for this level.
+
+/**
+   @brief Invokes the regression kernel selected for a pair.
+
+   @param indexNode is the pair's index node.
+
+   @param spn[] is the pair's SamplePred block.
 
    @return void.
  */
-void SPReg::SplitNum(unsigned int splitIdx, const IndexNode *indexNode, const SPNode spn[]) {
-  int monoMode = MonoMode(splitIdx);
-  if (monoMode != 0) {
-    SplitNumMono(splitIdx, indexNode, spn, monoMode > 0);
-  }
-  else {
+inline void SPReg::SplitKernel(unsigned int kernel, unsigned int splitIdx, const IndexNode *indexNode, const SPNode spn[]) {
+  switch (kernel) {
+  case kernelFac:
+    SplitFacWV(splitIdx, indexNode, spn);
+    break;
+  case kernelMonoUp:
+    SplitNumMono<true>(splitIdx, indexNode, spn);
+    break;
+  case kernelMonoDown:
+    SplitNumMono<false>(splitIdx, indexNode, spn);
+    break;
+  case kernelRuns:
+    SplitNumRuns(splitIdx, indexNode, spn);
+    break;
+  case kernelFacOut:
+    SplitFacOut(splitIdx, indexNode, spn);
+    break;
+  case kernelNumOut:
+    SplitNumOut(splitIdx, indexNode, spn);
+    break;
+  default:
     SplitNumWV(splitIdx, indexNode, spn);
+    break;
   }
 }
 
@@ -530,44 +680,62 @@ int SPReg::MonoMode(unsigned int splitIdx) {
 
 
 /**
-   @brief Invokes regression/factor splitting method, currently only Gini available.
-
-   @param indexNode[] is the vector of index nodes.
+   @brief Selects the kernel splitting a categorical pair.
 
-   @param nodeBase is the vector of SamplePred nodes for this level.
+   @param splitIdx is the split index.
 
-   @return void.
+   @return kernel index.
  */
-void SPReg::SplitFac(unsigned int splitIdx, const IndexNode indexNode[], const SPNode spn[]) {
-  SplitFacWV(splitIdx, indexNode, spn);
+unsigned int SPCtg::Kernel(unsigned int splitIdx) {
+  if (bottom->HasRuns(splitIdx))
+    return ctgWidth == 2 ? kernelFacBinary : kernelFacMulti;
+  else
+    return RunNum(splitIdx) ? kernelRuns : kernelGini;
 }
 
 
 /**
-   @brief Invokes categorical/numeric splitting method, currently only Gini available.
+   @brief Invokes the categorical kernel selected for a pair.
 
-   @param indexNode[] is the vector of index nodes.
+   @param indexNode is the pair's index node.
 
-   @param nodeBase is the vector of SamplePred nodes for this level.
+   @param spn[] is the pair's SamplePred block.
 
    @return void.
  */
-void SPCtg::SplitNum(unsigned int splitIdx, const IndexNode *indexNode, const SPNode spn[]) {
-  SplitNumGini(splitIdx, indexNode, spn);
+inline void SPCtg::SplitKernel(unsigned int kernel, unsigned int splitIdx, const IndexNode *indexNode, const SPNode spn[]) {
+  switch (kernel) {
+  case kernelFacBinary:
+    SplitFacGini<true>(splitIdx, indexNode, spn);
+    break;
+  case kernelFacMulti:
+    SplitFacGini<false>(splitIdx, indexNode, spn);
+    break;
+  case kernelRuns:
+    SplitNumRuns(splitIdx, indexNode, spn);
+    break;
+  default:
+    SplitNumGini(splitIdx, indexNode, spn);
+    break;
+  }
 }
 
 
 /**
-   @brief Invokes categorical/factor splitting method, currently only Gini available.
+   @brief Counts the trailing indices of a node having missing values.
+   As the NA rank exceeds all observed ranks, these sort to the end.
 
-   @param indexNode[] is the vector of index nodes.
+   @param spn[] are the node's SamplePred entries.
 
-   @param nodeBase is the vector of SamplePred nodes for this level.
-
-   @return void.
+   @return count of missing-value indices in the node.
  */
-void SPCtg::SplitFac(unsigned int splitIdx, const IndexNode *indexNode, const SPNode spn[]) {
-  SplitFacGini(splitIdx, indexNode, spn);
+unsigned int SplitPred::NACount(const SPNode spn[], unsigned int start, unsigned int end) {
+  unsigned int naRank = PredBlock::NARank();
+  unsigned int idx = end + 1;
+  while (idx > start && spn[idx - 1].Rank() == naRank)
+    idx--;
+
+  return end + 1 - idx;
 }
 
 
@@ -591,20 +759,51 @@ void SPReg::SplitNumWV(unsigned int splitIdx, const IndexNode *indexNode, const
   int sCountL = sCount - sampleCount; // >= 1: counts up to, including, this index. 
   int lhSampCt = 0;
 
+  // Missing values, if any, trail the node.  Cuts sending them right are
+  // evaluated conventionally;  those sending them left, only where some
+  // observed value lies to the right.
+  unsigned int naCount = NACount(spn, _start, _end);
+  double naSum = 0.0;
+  int naSCount = 0;
+  for (unsigned int naIdx = _end + 1 - naCount; naIdx <= _end; naIdx++) {
+    unsigned int rkNA, sCountNA;
+    FltVal ySumNA;
+    spn[naIdx].RegFields(ySumNA, rkNA, sCountNA);
+    naSum += ySumNA;
+    naSCount += sCountNA;
+  }
+  unsigned int naLH = 0;
+
   // Signing values avoids decrementing below zero.
   int start = _start;
   int end = _end;
   int lhSup = end;
+  int obsEnd = end - int(naCount); // Last observed index, if any.
   for (int i = end-1; i >= start; i--) {
     int sCountR = sCount - sCountL;
     double sumL = sum - sumR;
     double idxGini = (sumL * sumL) / sCountL + (sumR * sumR) / sCountR;
     unsigned int rkThis;
     spn[i].RegFields(ySum, rkThis, sampleCount);
-    if (idxGini > maxGini && rkThis != rkRight) {
-      lhSampCt = sCountL;
-      lhSup = i;
-      maxGini = idxGini;
+    if (rkThis != rkRight) {
+      if (idxGini > maxGini) {
+        lhSampCt = sCountL;
+        lhSup = i;
+        maxGini = idxGini;
+        naLH = 0;
+      }
+      if (naCount > 0 && i < obsEnd) { // Missing values sent left.
+        double sumLNA = sumL + naSum;
+        double sumRNA = sumR - naSum;
+        int sCountLNA = sCountL + naSCount;
+        double naGini = (sumLNA * sumLNA) / sCountLNA + (sumRNA * sumRNA) / (sCount - sCountLNA);
+        if (naGini > maxGini) {
+          lhSampCt = sCountLNA;
+          lhSup = i;
+          maxGini = naGini;
+          naLH = naCount;
+        }
+      }
     }
     sCountL -= sampleCount;
     sumR += ySum;
@@ -612,7 +811,88 @@ void SPReg::SplitNumWV(unsigned int splitIdx, const IndexNode *indexNode, const
   }
 
   if (lhSup < end) {
-    bottom->SSWrite(splitIdx, lhSampCt, lhSup + 1 - start, maxGini - preBias);
+    bottom->SSWrite(splitIdx, lhSampCt, lhSup + 1 - start + naLH, maxGini - preBias, naLH);
+  }
+}
+
+
+/**
+   @brief Weighted-variance splitting for predictors with few distinct
+   values.  A single pass bins the node's samples by rank, missing
+   values binned last.  Cuts are then evaluated from the right, one per
+   nonempty bin, at the boundaries SplitNumWV() considers.  Run sums
+   are formed before moving right, so agreement is up to rounding.
+
+   @return void.
+*/
+void SPReg::SplitNumRuns(unsigned int splitIdx, const IndexNode *indexNode, const SPNode spn[]) {
+  unsigned int _start, _end;
+  unsigned int sCount;
+  double sum;
+  FltVal preBias, maxGini;
+  maxGini = preBias = indexNode->SplitFields(_start, _end, sCount, sum);
+
+  // Observed ranks are dense and fewer than 'runMax'.
+  double binSum[runMax + 1] = {};
+  int binSCount[runMax + 1] = {};
+  int binExtent[runMax + 1] = {};
+  unsigned int naRank = PredBlock::NARank();
+  for (unsigned int i = _start; i <= _end; i++) {
+    unsigned int rk, sampleCount;
+    FltVal ySum;
+    spn[i].RegFields(ySum, rk, sampleCount);
+    unsigned int bin = rk == naRank ? runMax : rk;
+    binSum[bin] += ySum;
+    binSCount[bin] += sampleCount;
+    binExtent[bin]++;
+  }
+  unsigned int naCount = binExtent[runMax];
+  double naSum = binSum[runMax];
+  int naSCount = binSCount[runMax];
+  unsigned int naLH = 0;
+
+  int start = _start;
+  int end = _end;
+  int lhSampCt = 0;
+  int lhSup = end;
+  int obsEnd = end - int(naCount);
+  double sumR = 0.0;
+  int sCountL = sCount;
+  int idx = end;
+  for (int bin = runMax; bin >= 0; bin--) { // Moves each run right.
+    if (binExtent[bin] == 0)
+      continue;
+    sumR += binSum[bin];
+    sCountL -= binSCount[bin];
+    idx -= binExtent[bin];
+    if (idx < start) // Leftmost run:  no further cuts.
+      break;
+
+    int sCountR = sCount - sCountL;
+    double sumL = sum - sumR;
+    double idxGini = (sumL * sumL) / sCountL + (sumR * sumR) / sCountR;
+    if (idxGini > maxGini) {
+      lhSampCt = sCountL;
+      lhSup = idx;
+      maxGini = idxGini;
+      naLH = 0;
+    }
+    if (naCount > 0 && idx < obsEnd) { // Missing values sent left.
+      double sumLNA = sumL + naSum;
+      double sumRNA = sumR - naSum;
+      int sCountLNA = sCountL + naSCount;
+      double naGini = (sumLNA * sumLNA) / sCountLNA + (sumRNA * sumRNA) / (sCount - sCountLNA);
+      if (naGini > maxGini) {
+        lhSampCt = sCountLNA;
+        lhSup = idx;
+        maxGini = naGini;
+        naLH = naCount;
+      }
+    }
+  }
+
+  if (lhSup < end) {
+    bottom->SSWrite(splitIdx, lhSampCt, lhSup + 1 - start + naLH, maxGini - preBias, naLH);
   }
 }
 
@@ -622,7 +902,7 @@ void SPReg::SplitNumWV(unsigned int splitIdx, const IndexNode *indexNode, const
 
    @return void.
 */
-void SPReg::SplitNumMono(unsigned int splitIdx, const IndexNode *indexNode, const SPNode spn[], bool increasing) {
+template<bool increasing> void SPReg::SplitNumMono(unsigned int splitIdx, const IndexNode *indexNode, const SPNode spn[]) {
   // Walks samples backward from the end of nodes so that ties are not split.
   unsigned int _start, _end;
   unsigned int sCount;
@@ -637,24 +917,61 @@ void SPReg::SplitNumMono(unsigned int splitIdx, const IndexNode *indexNode, cons
   int sCountL = sCount - sampleCount; // >= 1: counts up to, including, this index. 
   int lhSampCt = 0;
 
+  // Missing values, if any, trail the node.  Cuts sending them right are
+  // evaluated conventionally;  those sending them left, only where some
+  // observed value lies to the right.
+  unsigned int naCount = NACount(spn, _start, _end);
+  double naSum = 0.0;
+  int naSCount = 0;
+  for (unsigned int naIdx = _end + 1 - naCount; naIdx <= _end; naIdx++) {
+    unsigned int rkNA, sCountNA;
+    FltVal ySumNA;
+    spn[naIdx].RegFields(ySumNA, rkNA, sCountNA);
+    naSum += ySumNA;
+    naSCount += sCountNA;
+  }
+  unsigned int naLH = 0;
+
   // Signing values avoids decrementing below zero.
   int start = _start;
   int end = _end;
   int lhSup = end;
+  int obsEnd = end - int(naCount); // Last observed index, if any.
   for (int i = end-1; i >= start; i--) {
     int sCountR = sCount - sCountL;
     FltVal sumL = sum - sumR;
     FltVal idxGini = (sumL * sumL) / sCountL + (sumR * sumR) / sCountR;
     unsigned int rkThis;
     spn[i].RegFields(yVal, rkThis, sampleCount);
-    if (idxGini > maxGini && rkThis != rkRight) {
-      FltVal meanL = sumL / sCountL;
-      FltVal meanR = sumR / sCountR;
-      bool doSplit = increasing ? meanL <= meanR : meanL >= meanR;
-      if (doSplit) {
-        lhSampCt = sCountL;
-        lhSup = i;
-        maxGini = idxGini;
+    if (rkThis != rkRight) {
+      if (idxGini > maxGini) {
+        FltVal meanL = sumL / sCountL;
+        FltVal meanR = sumR / sCountR;
+        bool doSplit = increasing ? meanL <= meanR : meanL >= meanR;
+        if (doSplit) {
+          lhSampCt = sCountL;
+          lhSup = i;
+          maxGini = idxGini;
+          naLH = 0;
+        }
+      }
+      if (naCount > 0 && i < obsEnd) { // Missing values sent left.
+        FltVal sumLNA = sumL + naSum;
+        FltVal sumRNA = sumR - naSum;
+        int sCountLNA = sCountL + naSCount;
+        int sCountRNA = sCount - sCountLNA;
+        FltVal naGini = (sumLNA * sumLNA) / sCountLNA + (sumRNA * sumRNA) / sCountRNA;
+        if (naGini > maxGini) {
+          FltVal meanL = sumLNA / sCountLNA;
+          FltVal meanR = sumRNA / sCountRNA;
+          bool doSplit = increasing ? meanL <= meanR : meanL >= meanR;
+          if (doSplit) {
+            lhSampCt = sCountLNA;
+            lhSup = i;
+            maxGini = naGini;
+            naLH = naCount;
+          }
+        }
       }
     }
     sCountL -= sampleCount;
@@ -663,7 +980,7 @@ void SPReg::SplitNumMono(unsigned int splitIdx, const IndexNode *indexNode, cons
   }
 
   if (lhSup < end) {
-    bottom->SSWrite(splitIdx, lhSampCt, lhSup + 1 - start, maxGini - preBias);
+    bottom->SSWrite(splitIdx, lhSampCt, lhSup + 1 - start + naLH, maxGini - preBias, naLH);
   }
 }
 
@@ -690,10 +1007,29 @@ void SPCtg::SplitNumGini(unsigned int splitIdx, const IndexNode *indexNode, cons
   unsigned int rkStart = spn[_start].Rank();
   unsigned int lhSampCt = 0;
 
+  // Missing values, if any, trail the node.  The variant sending them
+  // left tracks its own sums of squares, as only observed values move
+  // right.
+  unsigned int naCount = NACount(spn, _start, _end);
+  std::vector<double> naCtg(naCount > 0 ? ctgWidth : 0);
+  double naSum = 0.0;
+  unsigned int naSCount = 0;
+  for (unsigned int naIdx = _end + 1 - naCount; naIdx <= _end; naIdx++) {
+    unsigned int yCtg;
+    FltVal ySum;
+    naSCount += spn[naIdx].CtgFields(ySum, yCtg, runShift);
+    naCtg[yCtg] += ySum;
+    naSum += ySum;
+  }
+  double ssLNA = ssL;
+  double ssRNA = 0.0;
+  unsigned int naLH = 0;
+
   // Signing values avoids decrementing below zero.
   int start = _start;
   int end = _end;
   int lhSup = end;
+  int obsEnd = end - int(naCount); // Last observed index, if any.
   for (int i = end; i >= start; i--) {
     unsigned int rkThis = spn[i].Rank();
     FltVal sumR = sum - sumL;
@@ -703,6 +1039,20 @@ void SPCtg::SplitNumGini(unsigned int splitIdx, const IndexNode *indexNode, cons
         lhSampCt = sCountL;
         lhSup = i;
         maxGini = cutGini;
+        naLH = 0;
+      }
+    }
+    if (naCount > 0 && i < obsEnd && rkThis != rkRight) { // Missing values sent left.
+      FltVal sumLNA = sumL + naSum;
+      FltVal sumRNA = sum - sumLNA;
+      if (sumLNA > minDenom && sumRNA > minDenom) {
+        FltVal naGini = ssLNA / sumLNA + ssRNA / sumRNA;
+        if (naGini > maxGini) {
+          lhSampCt = sCountL + naSCount;
+          lhSup = i;
+          maxGini = naGini;
+          naLH = naCount;
+        }
       }
     }
     if (rkRight == rkStart) // Last valid cut already checked.
@@ -710,7 +1060,7 @@ void SPCtg::SplitNumGini(unsigned int splitIdx, const IndexNode *indexNode, cons
 
     unsigned int yCtg;
     FltVal ySum;    
-    sCountL -= spn[i].CtgFields(ySum, yCtg);
+    sCountL -= spn[i].CtgFields(ySum, yCtg, runShift);
 
     // Maintains sums of category squares incrementally, via update.
     //
@@ -721,12 +1071,136 @@ void SPCtg::SplitNumGini(unsigned int splitIdx, const IndexNode *indexNode, cons
     double sumLCtg = CtgSum(levelIdx, yCtg) - sumRCtg;
     ssR += ySum * (ySum + 2.0 * sumRCtg);
     ssL += ySum * (ySum - 2.0 * sumLCtg);
+    if (naCount > 0 && i <= obsEnd) { // Observed value moves right.
+      double sumRObs = sumRCtg - naCtg[yCtg];
+      double sumLObs = sumLCtg + naCtg[yCtg];
+      ssRNA += ySum * (ySum + 2.0 * sumRObs);
+      ssLNA += ySum * (ySum - 2.0 * sumLObs);
+    }
     sumL -= ySum;
     rkRight = rkThis;
   }
 
   if (lhSup < end) {
-    bottom->SSWrite(splitIdx, lhSampCt, lhSup + 1 - start, maxGini - preBias);
+    bottom->SSWrite(splitIdx, lhSampCt, lhSup + 1 - start + naLH, maxGini - preBias, naLH);
+  }
+}
+
+
+/**
+   @brief Gini-based splitting for predictors with few distinct values.
+   A single pass bins the node's samples by rank and category, missing
+   values binned last.  Each nonempty bin then moves right as a unit,
+   folded into the sums of squares once per category rather than once
+   per sample.  Cuts are evaluated at the same boundaries as
+   SplitNumGini(), with agreement up to rounding.
+
+   @return void.
+ */
+void SPCtg::SplitNumRuns(unsigned int splitIdx, const IndexNode *indexNode, const SPNode spn[]) {
+  unsigned int levelIdx, predIdx;
+  bottom->SplitRef(splitIdx, levelIdx, predIdx);
+  int numIdx = PredBlock::NumIdx(predIdx);
+  unsigned int _start, _end;
+  unsigned int sCountL;
+  double sum;
+  FltVal preBias, maxGini;
+  maxGini = preBias = indexNode->SplitFields(_start, _end, sCountL, sum);
+
+  // Observed ranks are dense and fewer than 'runMax'.
+  std::vector<double> binCtg((runMax + 1) * ctgWidth);
+  double binSum[runMax + 1] = {};
+  unsigned int binSCount[runMax + 1] = {};
+  int binExtent[runMax + 1] = {};
+  unsigned int naRank = PredBlock::NARank();
+  for (unsigned int i = _start; i <= _end; i++) {
+    unsigned int rk = spn[i].Rank();
+    unsigned int bin = rk == naRank ? runMax : rk;
+    unsigned int yCtg;
+    FltVal ySum;
+    binSCount[bin] += spn[i].CtgFields(ySum, yCtg, runShift);
+    binCtg[bin * ctgWidth + yCtg] += ySum;
+    binSum[bin] += ySum;
+    binExtent[bin]++;
+  }
+  unsigned int naCount = binExtent[runMax];
+  const double *naCtg = &binCtg[runMax * ctgWidth];
+  double naSum = binSum[runMax];
+  unsigned int naSCount = binSCount[runMax];
+
+  double ssL = sumSquares[levelIdx];
+  double ssR = 0.0;
+  double sumL = sum;
+  unsigned int lhSampCt = 0;
+  double ssLNA = ssL;
+  double ssRNA = 0.0;
+  unsigned int naLH = 0;
+
+  int start = _start;
+  int end = _end;
+  int lhSup = end;
+  int obsEnd = end - int(naCount);
+  int idx = end; // Last index of the current run.
+  for (int bin = runMax; bin >= 0; bin--) {
+    if (binExtent[bin] == 0)
+      continue;
+    int runStart = idx + 1 - binExtent[bin];
+
+    if (idx < end) { // Cut between this run and its right neighbour.
+      FltVal sumR = sum - sumL;
+      if (sumL > minDenom && sumR > minDenom) {
+        FltVal cutGini = ssL / sumL + ssR / sumR;
+        if (cutGini > maxGini) {
+          lhSampCt = sCountL;
+          lhSup = idx;
+          maxGini = cutGini;
+          naLH = 0;
+        }
+      }
+      if (naCount > 0 && idx < obsEnd) { // Missing values sent left.
+        FltVal sumLNA = sumL + naSum;
+        FltVal sumRNA = sum - sumLNA;
+        if (sumLNA > minDenom && sumRNA > minDenom) {
+          FltVal naGini = ssLNA / sumLNA + ssRNA / sumRNA;
+          if (naGini > maxGini) {
+            lhSampCt = sCountL + naSCount;
+            lhSup = idx;
+            maxGini = naGini;
+            naLH = naCount;
+          }
+        }
+      }
+    }
+    if (runStart == start) // Leftmost run:  no further cuts.
+      break;
+
+    // Folds the run into the sums of squares, as SplitNumGini() does
+    // sample by sample:  a run sum 's' moving right across running sum
+    // 'r' contributes s * (s + 2r).
+    const double *runCtg = &binCtg[bin * ctgWidth];
+    bool observed = naCount > 0 && idx <= obsEnd;
+    for (unsigned int ctg = 0; ctg < ctgWidth; ctg++) {
+      double ctgRun = runCtg[ctg];
+      if (ctgRun == 0.0)
+        continue;
+      double sumRCtg = CtgSumRight(levelIdx, numIdx, ctg, ctgRun);
+      double sumLCtg = CtgSum(levelIdx, ctg) - sumRCtg;
+      ssR += ctgRun * (ctgRun + 2.0 * sumRCtg);
+      ssL += ctgRun * (ctgRun - 2.0 * sumLCtg);
+      if (observed) {
+        double sumRObs = sumRCtg - naCtg[ctg];
+        double sumLObs = sumLCtg + naCtg[ctg];
+        ssRNA += ctgRun * (ctgRun + 2.0 * sumRObs);
+        ssLNA += ctgRun * (ctgRun - 2.0 * sumLObs);
+      }
+    }
+    sCountL -= binSCount[bin];
+    sumL -= binSum[bin];
+    idx = runStart - 1;
+  }
+
+  if (lhSup < end) {
+    bottom->SSWrite(splitIdx, lhSampCt, lhSup + 1 - start + naLH, maxGini - preBias, naLH);
   }
 }
 
@@ -736,7 +1210,7 @@ void SPCtg::SplitNumGini(unsigned int splitIdx, const IndexNode *indexNode, cons
 
    @return void.
  */
-void SPCtg::SplitFacGini(unsigned int splitIdx, const IndexNode *indexNode, const SPNode spn[]) {
+template<bool binary> void SPCtg::SplitFacGini(unsigned int splitIdx, const IndexNode *indexNode, const SPNode spn[]) {
   unsigned int start, end;
   unsigned int dummy;
   double sum, preBias, maxGini;
@@ -749,7 +1223,7 @@ void SPCtg::SplitFacGini(unsigned int splitIdx, const IndexNode *indexNode, cons
   bottom->SetRunCount(levelIdx, predIdx, BuildRuns(runSet, spn, start, end));
   
   unsigned int lhIdxCount, lhSampCt;
-  if (ctgWidth == 2)  {
+  if (binary)  {
     lhIdxCount = SplitBinary(runSet, levelIdx, sum, maxGini, lhSampCt);
   }
   else {
@@ -781,7 +1255,7 @@ unsigned int SPCtg::BuildRuns(RunSet *runSet, const SPNode spn[], unsigned int _
     unsigned int rkRight = rkThis;
     unsigned int yCtg;
     FltVal ySum;
-    unsigned int sampleCount = spn[i].CtgFields(ySum, rkThis, yCtg);
+    unsigned int sampleCount = spn[i].CtgFields(ySum, rkThis, yCtg, runShift);
 
     if (rkThis == rkRight) { // Current run's counters accumulate.
       sum += ySum;
@@ -1005,3 +1479,196 @@ unsigned int SPReg::HeapSplit(RunSet *runSet, double sum, unsigned int sCountNod
   lhIdxCount = runSet->LHSlots(cut, sCountL);
   return sCountL;
 }
+
+
+/**
+   @brief Weighted-variance criterion summed over the outputs of a
+   multi-output response.
+
+   @param sumNode[] are the node's sums, by output.
+
+   @param sumR[] are the sums to the right of the cut, by output.
+
+   @param shift[], if non-null, are sums moved from right to left.
+
+   @param sCountL is the sample count to the left.
+
+   @param sCountR is the sample count to the right.
+
+   @return summed criterion.
+ */
+double SPReg::OutGini(const double sumNode[], const double sumR[], const double shift[], unsigned int sCountL, unsigned int sCountR) const {
+  double gini = 0.0;
+  for (unsigned int outIdx = 0; outIdx < nOut; outIdx++) {
+    double sR = shift == 0 ? sumR[outIdx] : sumR[outIdx] - shift[outIdx];
+    double sL = sumNode[outIdx] - sR;
+    gini += (sL * sL) / sCountL + (sR * sR) / sCountR;
+  }
+
+  return gini;
+}
+
+
+/**
+   @brief Weighted-variance splitting of a numeric predictor under a
+   multi-output response.  Walks as SplitNumWV() does, accumulating the
+   outputs to the right through the sample indices parallel to the node's
+   SamplePred block.
+
+   @return void.
+*/
+void SPReg::SplitNumOut(unsigned int splitIdx, const IndexNode *indexNode, const SPNode spn[]) {
+  unsigned int _start, _end;
+  unsigned int sCount;
+  double sum;
+  FltVal preBias, maxGini;
+  maxGini = preBias = indexNode->SplitFields(_start, _end, sCount, sum);
+
+  unsigned int levelIdx, predIdx;
+  bottom->SplitRef(splitIdx, levelIdx, predIdx);
+  const double *sumNode = &outNode[levelIdx * nOut];
+  const unsigned int *sIdx = samplePred->SampleIdx(spn);
+
+  unsigned int rkRight, sampleCount;
+  FltVal ySum;
+  spn[_end].RegFields(ySum, rkRight, sampleCount);
+  std::vector<double> sumR(nOut);
+  AccumOut(&sumR[0], sIdx[_end]);
+  int sCountL = sCount - sampleCount;
+  int lhSampCt = 0;
+
+  unsigned int naCount = NACount(spn, _start, _end);
+  std::vector<double> naSum(nOut);
+  int naSCount = 0;
+  for (unsigned int naIdx = _end + 1 - naCount; naIdx <= _end; naIdx++) {
+    unsigned int rkNA, sCountNA;
+    FltVal ySumNA;
+    spn[naIdx].RegFields(ySumNA, rkNA, sCountNA);
+    AccumOut(&naSum[0], sIdx[naIdx]);
+    naSCount += sCountNA;
+  }
+  unsigned int naLH = 0;
+
+  int start = _start;
+  int end = _end;
+  int lhSup = end;
+  int obsEnd = end - int(naCount);
+  for (int i = end-1; i >= start; i--) {
+    unsigned int rkThis;
+    spn[i].RegFields(ySum, rkThis, sampleCount);
+    if (rkThis != rkRight) {
+      double idxGini = OutGini(sumNode, &sumR[0], 0, sCountL, sCount - sCountL);
+      if (idxGini > maxGini) {
+        lhSampCt = sCountL;
+        lhSup = i;
+        maxGini = idxGini;
+        naLH = 0;
+      }
+      if (naCount > 0 && i < obsEnd) { // Missing values sent left.
+        int sCountLNA = sCountL + naSCount;
+        double naGini = OutGini(sumNode, &sumR[0], &naSum[0], sCountLNA, sCount - sCountLNA);
+        if (naGini > maxGini) {
+          lhSampCt = sCountLNA;
+          lhSup = i;
+          maxGini = naGini;
+          naLH = naCount;
+        }
+      }
+    }
+    sCountL -= sampleCount;
+    AccumOut(&sumR[0], sIdx[i]);
+    rkRight = rkThis;
+  }
+
+  if (lhSup < end) {
+    bottom->SSWrite(splitIdx, lhSampCt, lhSup + 1 - start + naLH, maxGini - preBias, naLH);
+  }
+}
+
+
+/**
+   @brief Weighted-variance splitting of a factor under a multi-output
+   response.  Runs are ordered by their mean summed over outputs, which
+   is exact for a single output, and the ordered cuts are evaluated
+   under the summed criterion.
+
+   @return void.
+ */
+void SPReg::SplitFacOut(unsigned int splitIdx, const IndexNode *indexNode, const SPNode spn[]) {
+  unsigned int start, end;
+  unsigned int sCount;
+  double sum, preBias, maxGini;
+  maxGini = preBias = indexNode->SplitFields(start, end, sCount, sum);
+
+  unsigned int levelIdx, predIdx;
+  int setIdx;
+  bottom->SplitRef(splitIdx, levelIdx, predIdx, setIdx);
+  const double *sumNode = &outNode[levelIdx * nOut];
+  RunSet *runSet = run->RSet(setIdx);
+  std::vector<double> runSum;
+  bottom->SetRunCount(levelIdx, predIdx, BuildRunsOut(runSet, spn, start, end, runSum));
+  runSet->HeapMean();
+  runSet->DePop();
+
+  std::vector<double> sumR(sumNode, sumNode + nOut);
+  unsigned int sCountL = 0;
+  int cut = -1;
+  for (unsigned int outSlot = 0; outSlot < runSet->RunCount() - 1; outSlot++) {
+    unsigned int sCountRun;
+    (void) runSet->SumHeap(outSlot, sCountRun);
+    sCountL += sCountRun;
+    unsigned int slot = runSet->OutSlot(outSlot);
+    for (unsigned int outIdx = 0; outIdx < nOut; outIdx++)
+      sumR[outIdx] -= runSum[slot * nOut + outIdx];
+    double cutGini = OutGini(sumNode, &sumR[0], 0, sCountL, sCount - sCountL);
+    if (cutGini > maxGini) {
+      maxGini = cutGini;
+      cut = outSlot;
+    }
+  }
+
+  unsigned int idxCountL = runSet->LHSlots(cut, sCountL);
+  if (sCountL > 0) {
+    bottom->SSWrite(splitIdx, sCountL, idxCountL, maxGini - preBias);
+  }
+}
+
+
+/**
+   @brief As BuildRuns(), but also records each run's sums by output.
+   The run's scalar sum, by which it is ordered, totals its outputs.
+
+   @param runSum outputs the runs' sums, by slot and output.
+
+   @return run count.
+ */
+unsigned int SPReg::BuildRunsOut(RunSet *runSet, const SPNode spn[], unsigned int _start, unsigned int _end, std::vector<double> &runSum) {
+  const unsigned int *sIdx = samplePred->SampleIdx(spn);
+  std::vector<double> sumOut(nOut);
+  unsigned int frEnd = _end;
+  unsigned int sCount = 0;
+  unsigned int rkThis = spn[_end].Rank();
+
+  int start = _start;
+  int end = _end;
+  for (int i = end; i >= start; i--) {
+    unsigned int rkRight = rkThis;
+    unsigned int sampleCount;
+    FltVal ySum;
+    spn[i].RegFields(ySum, rkThis, sampleCount);
+
+    if (rkThis != rkRight) { // New run:  flushes accumulated counters.
+      runSet->Write(rkRight, sCount, std::accumulate(sumOut.begin(), sumOut.end(), 0.0), i+1, frEnd);
+      runSum.insert(runSum.end(), sumOut.begin(), sumOut.end());
+      std::fill(sumOut.begin(), sumOut.end(), 0.0);
+      sCount = 0;
+      frEnd = i;
+    }
+    AccumOut(&sumOut[0], sIdx[i]);
+    sCount += sampleCount;
+  }
+  runSet->Write(rkThis, sCount, std::accumulate(sumOut.begin(), sumOut.end(), 0.0), start, frEnd);
+  runSum.insert(runSum.end(), sumOut.begin(), sumOut.end());
+
+  return runSet->RunCount();
+}
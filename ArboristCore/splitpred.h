@@ -29,8 +29,8 @@
 // type of predictor:  { regression, categorical } x { numeric, factor }.
 //
 class SplitPred {
-  static unsigned int predFixed;
-  static const double *predProb;
+  const unsigned int predFixed;
+  const double *predProb;
 
   void SetPrebias(class IndexNode indexNode[]);
   void SplitFlags(bool unsplitable[]);
@@ -38,16 +38,20 @@ class SplitPred {
   void SplitPredFixed(unsigned int levelIdx, const double ruPred[], class BHPair heap[], std::vector<unsigned int> &safeCount);
 
  protected:
-  static unsigned int nPred;
+  const class TrainCtx *ctx;
+  const unsigned int nPred;
   class Bottom *bottom;
   unsigned int levelCount; // # subtree nodes at current level.
   class Run *run;
   void Splitable(const bool unsplitable[], std::vector<unsigned int> &safeCount);
+  static unsigned int NACount(const class SPNode spn[], unsigned int start, unsigned int end);
+  bool RunNum(unsigned int splitIdx) const;
+  template<class SPType> void SplitBuckets(SPType *sp, const std::vector<class SplitCoord> &splitCoord, const class IndexNode indexNode[]);
  public:
+  static const unsigned int runMax = 32; // Most distinct values split by runs.
   class SamplePred *samplePred;
-  SplitPred(class SamplePred *_samplePred, unsigned int bagCount);
-  static void Immutables(unsigned int _nPred, unsigned int _ctgWidth, unsigned int _predFixed, const double _predProb[], const double _regMono[]);
-  static void DeImmutables();
+  SplitPred(const class TrainCtx *_ctx, class SamplePred *_samplePred, unsigned int bagCount);
+  static void Candidates(const class TrainCtx *ctx, unsigned int levelCount, std::vector<bool> &candidate);
 
   class Run *Runs() {
     return run;
@@ -56,17 +60,13 @@ class SplitPred {
     bottom = _bottom;
   }
 
-  void Split(unsigned int splitIdx, const class IndexNode indexNode[], const class SPNode spn[]);
-  
   virtual ~SplitPred();
   virtual void LevelInit(class Index *index, class IndexNode indexNode[], unsigned int levelCount);
   virtual void RunOffsets(const std::vector<unsigned int> &safeCounts) = 0;
   virtual bool *LevelPreset(const class Index *index) = 0;
   virtual double Prebias(unsigned int levelIdx, unsigned int sCount, double sum) = 0;
   virtual void LevelClear();
-
-  virtual void SplitNum(unsigned int splitIdx, const class IndexNode indexNode[], const class SPNode spn[]) = 0;
-  virtual void SplitFac(unsigned int splitIdx, const class IndexNode indexNode[], const class SPNode spn[]) = 0;
+  virtual void SplitLevel(const std::vector<class SplitCoord> &splitCoord, const class IndexNode indexNode[]) = 0;
 };
 
 
@@ -74,32 +74,66 @@ class SplitPred {
    @brief Splitting facilities specific regression trees.
  */
 class SPReg : public SplitPred {
-  static unsigned int predMono;
-  static const double *feMono;
+  friend class SplitPred;
+  // Splitting kernels, by which each level's splits are bucketed.
+  static const unsigned int kernelFac = 0;
+  static const unsigned int kernelMonoUp = 1;
+  static const unsigned int kernelMonoDown = 2;
+  static const unsigned int kernelRuns = 3;
+  static const unsigned int kernelWV = 4;
+  static const unsigned int kernelFacOut = 5;
+  static const unsigned int kernelNumOut = 6;
+  static const unsigned int kernelCount = 7;
+  const unsigned int predMono;
+  const double *feMono;
+  const unsigned int nOut; // Response outputs.
+  const FltVal *outSum; // Multi-output:  per-sample sums, or null.
   double *ruMono;
+  double *outNode; // Multi-output:  per-level sums, by split and output.
 
   int MonoMode(unsigned int splitIdx);
   void SplitHeap(const class IndexNode *indexNode, const class SPNode spn[], unsigned int predIdx);
   void Split(const class IndexNode indexNode[], class SPNode *nodeBase);
-  void SplitNum(unsigned int splitIdx, const class IndexNode indexNode[], const class SPNode spn[]);
+  unsigned int Kernel(unsigned int splitIdx);
+  inline void SplitKernel(unsigned int kernel, unsigned int splitIdx, const class IndexNode *indexNode, const class SPNode spn[]);
   void SplitNumWV(unsigned int splitIdx, const class IndexNode *indexNode, const class SPNode spn[]);
-  void SplitNumMono(unsigned int splitIdx, const class IndexNode *indexNode, const class SPNode spn[], bool increasing);
-  void SplitFac(unsigned int splitIdx, const class IndexNode indexNode[], const class SPNode *nodeBase);
+  template<bool increasing> void SplitNumMono(unsigned int splitIdx, const class IndexNode *indexNode, const class SPNode spn[]);
+  void SplitNumRuns(unsigned int splitIdx, const class IndexNode *indexNode, const class SPNode spn[]);
   void SplitFacWV(unsigned int splitIdx, const class IndexNode *indexNode, const class SPNode spn[]);
   unsigned int BuildRuns(class RunSet *runSet, const class SPNode spn[], unsigned int start, unsigned int end);
   unsigned int HeapSplit(class RunSet *runSet, double sum, unsigned int sCountNode, unsigned int &lhIdxCount, double &maxGini);
+  void SumsOut(const class Index *index);
+  void SplitNumOut(unsigned int splitIdx, const class IndexNode *indexNode, const class SPNode spn[]);
+  void SplitFacOut(unsigned int splitIdx, const class IndexNode *indexNode, const class SPNode spn[]);
+  unsigned int BuildRunsOut(class RunSet *runSet, const class SPNode spn[], unsigned int start, unsigned int end, std::vector<double> &runSum);
+  double OutGini(const double sumNode[], const double sumR[], const double shift[], unsigned int sCountL, unsigned int sCountR) const;
+
+
+  /**
+     @brief Accumulates a multi-output sample's sums.
+
+     @param sum[] accumulates the sums, by output.
+
+     @param sIdx is the sample index.
+
+     @return void, with side-effected accumulator.
+   */
+  inline void AccumOut(double sum[], unsigned int sIdx) const {
+    const FltVal *sampleSum = outSum + sIdx * nOut;
+    for (unsigned int outIdx = 0; outIdx < nOut; outIdx++)
+      sum[outIdx] += sampleSum[outIdx];
+  }
 
 
  public:
-  static void Immutables(unsigned int _nPred, const double *_mono);
-  static void DeImmutables();
-  SPReg(class SamplePred *_samplePred, unsigned int bagCount);
+  SPReg(const class TrainCtx *_ctx, class SamplePred *_samplePred, unsigned int bagCount, const FltVal *_outSum = 0);
   ~SPReg();
   void RunOffsets(const std::vector<unsigned int> &safeCount);
   bool *LevelPreset(const class Index *index);
   double Prebias(unsigned int spiltIdx, unsigned int sCount, double sum);
   void LevelInit(class Index *index, class IndexNode indexNode[], unsigned int levelCount);
   void LevelClear();
+  void SplitLevel(const std::vector<class SplitCoord> &splitCoord, const class IndexNode indexNode[]);
 };
 
 
@@ -107,7 +141,15 @@ class SPReg : public SplitPred {
    @brief Splitting facilities for categorical trees.
  */
 class SPCtg : public SplitPred {
-  static unsigned int ctgWidth;
+  friend class SplitPred;
+  // Splitting kernels, by which each level's splits are bucketed.
+  static const unsigned int kernelFacBinary = 0;
+  static const unsigned int kernelFacMulti = 1;
+  static const unsigned int kernelRuns = 2;
+  static const unsigned int kernelGini = 3;
+  static const unsigned int kernelCount = 4;
+  const unsigned int ctgWidth;
+  const unsigned int runShift; // Packing shift for sample count.
   double *ctgSum; // Per-level sum, by split/category pair.
   double *ctgSumR; // Numeric predictors:  sum to right.
   double *sumSquares; // Per-level sum of squares, by split.
@@ -138,17 +180,17 @@ class SPCtg : public SplitPred {
   }
 
   void LevelInitSumR();
-  void SplitNum(unsigned int splitIdx, const class IndexNode indexNode[], const class SPNode spn[]);
+  unsigned int Kernel(unsigned int splitIdx);
+  inline void SplitKernel(unsigned int kernel, unsigned int splitIdx, const class IndexNode *indexNode, const class SPNode spn[]);
   void SplitNumGini(unsigned int splitIdx, const class IndexNode *indexNode, const class SPNode spn[]);
+  void SplitNumRuns(unsigned int splitIdx, const class IndexNode *indexNode, const class SPNode spn[]);
   unsigned int SplitBinary(class RunSet *runSet, unsigned int levelIdx, double sum, double &maxGini, unsigned int &sCount);
   unsigned int BuildRuns(class RunSet *runSet, const class SPNode spn[], unsigned int start, unsigned int end);
   unsigned int SplitRuns(class RunSet *runSet, unsigned int levelIdx, double sum, double &maxGini, unsigned int &lhSampCt);
   
  public:
-  SPCtg(class SamplePred *_samplePred, class SampleNode _sampleCtg[], unsigned int bagCount);
+  SPCtg(const class TrainCtx *_ctx, class SamplePred *_samplePred, class SampleNode _sampleCtg[], unsigned int bagCount);
   ~SPCtg();
-  static void Immutables(unsigned int _ctgWidth);
-  static void DeImmutables();
   
   /**
      @brief Records sum of proxy values at 'yCtg' strictly to the right and updates the
@@ -172,12 +214,8 @@ class SPCtg : public SplitPred {
     return val;
   }
 
- public:
-  static inline unsigned int CtgWidth() {
-    return ctgWidth;
-  }
-  void SplitFac(unsigned int splitIdx, const class IndexNode indexNode[], const class SPNode spn[]);
-  void SplitFacGini(unsigned int splitIdx, const class IndexNode *indexNode, const class SPNode spn[]);
+  template<bool binary> void SplitFacGini(unsigned int splitIdx, const class IndexNode *indexNode, const class SPNode spn[]);
+  void SplitLevel(const std::vector<class SplitCoord> &splitCoord, const class IndexNode indexNode[]);
 };
 
 
@@ -27,35 +27,15 @@ using namespace std;
    pass one (splitting) through argmax pass two.
 */
 
-unsigned int SplitSig::nPred = 0;
-double SSNode::minRatio = 0.0;
-
 // TODO:  Economize on width (nPred) here et seq.
 //
 
 /**
-   @brief Sets immutable static values.
+   @brief Constructor.
 
    @param _nPred is the number of predictors.
-
-   @param _minRatio is an inf information content for splitting.  Must
-   be non-negative, as otherwise ArgMax cannot distinguish splitting
-   candidates from unset SSNodes, which have initial 'info' == 0.
-
-   @return void.
  */
-void SplitSig::Immutables(unsigned int _nPred, double _minRatio) {
-  nPred = _nPred;
-  SSNode::minRatio = _minRatio;
-}
-
-
-/**
-   @brief Finalizer.
-*/  
-void SplitSig::DeImmutables() {
-  nPred = 0;
-  SSNode::minRatio = 0.0;
+SplitSig::SplitSig(unsigned int _nPred) : nPred(_nPred) {
 }
 
 
@@ -68,14 +48,17 @@ void SplitSig::DeImmutables() {
 
    @param _info is the splitting information value, currently Gini.
 
+   @param _naLHCount is the count of LHS indices having missing values.
+
    @return void.
  */
-void SplitSig::Write(unsigned int _levelIdx, unsigned int _predIdx, int _setIdx, unsigned int _bufIdx, unsigned int _sCount, unsigned int _lhIdxCount, double _info) {
+void SplitSig::Write(unsigned int _levelIdx, unsigned int _predIdx, int _setIdx, unsigned int _bufIdx, unsigned int _sCount, unsigned int _lhIdxCount, double _info, unsigned int _naLHCount) {
   SSNode ssn;
   ssn.setIdx = _setIdx;
   ssn.bufIdx = _bufIdx;
   ssn.sCount = _sCount;
   ssn.lhIdxCount = _lhIdxCount;
+  ssn.naLHCount = _naLHCount;
   ssn.info = _info;
   ssn.predIdx = _predIdx;
 
@@ -134,17 +117,72 @@ double SSNode::NonTerminalRun(SamplePred *samplePred, PreTree *preTree, unsigned
 
 
 /**
-   @brief Writes PreTree nonterminal node for numerical predictor.
+   @brief Copies the coordinates of the runs sent left by a factor
+   split, as run sets do not outlive the level.
+
+   @param run holds the level's run sets.
+
+   @param lhRun outputs the rank, start and end of each left-hand run.
+   Empty if the split is numeric.
+
+   @return void, with output vector.
+ */
+void SSNode::LHRuns(Run *run, std::vector<unsigned int> &lhRun) const {
+  if (setIdx < 0)
+    return;
+
+  for (unsigned int outSlot = 0; outSlot < run->RunsLH(setIdx); outSlot++) {
+    unsigned int runStart, runEnd;
+    unsigned int rank = run->RunBounds(setIdx, outSlot, runStart, runEnd);
+    lhRun.push_back(rank);
+    lhRun.push_back(runStart);
+    lhRun.push_back(runEnd);
+  }
+}
+
+
+/**
+   @brief Writes PreTree nonterminal node for a split held over from an
+   earlier level.  The node's extent and ordering are unchanged since
+   the split was found, so the signature's buffer remains valid.
+
+   @param lhRun holds the coordinates of the left-hand runs, if factor.
+
+   @return sum of left-hand subnode's response values.
+ */
+double SSNode::NonTerminalHeld(SamplePred *samplePred, PreTree *preTree, int start, int end, unsigned int ptId, unsigned int &ptLH, unsigned int &ptRH, const std::vector<unsigned int> &lhRun) {
+  if (setIdx < 0)
+    return NonTerminalNum(samplePred, preTree, 0, start, end, ptId, ptLH, ptRH);
+
+  preTree->NonTerminalFac(info, predIdx, ptId, ptLH, ptRH);
+  (void) preTree->Replay(samplePred, predIdx, bufIdx, start, end, ptRH);
+  double lhSum = 0.0;
+  for (unsigned int off = 0; off < lhRun.size(); off += 3) {
+    preTree->LHBit(ptId, lhRun[off]);
+    lhSum += preTree->Replay(samplePred, predIdx, bufIdx, lhRun[off + 1], lhRun[off + 2], ptLH);
+  }
+
+  return lhSum;
+}
+
+
+/**
+   @brief Writes PreTree nonterminal node for numerical predictor.  Missing
+   values occupy the tail of the node's extent and are replayed according
+   to the direction chosen by the splitting method.
 
    @return sum of LH subnode's sample values.
  */
 double SSNode::NonTerminalNum(SamplePred *samplePred, PreTree *preTree, unsigned int splitIdx, int start, int end, unsigned int ptId, unsigned int &ptLH, unsigned int &ptRH) {
   unsigned int rkLow, rkHigh;
-  samplePred->SplitRanks(predIdx, bufIdx, start + lhIdxCount - 1, rkLow, rkHigh);
-  preTree->NonTerminalNum(info, predIdx, rkLow, rkHigh, ptId, ptLH, ptRH);
+  int cutIdx = start + lhIdxCount - naLHCount - 1;
+  samplePred->SplitRanks(predIdx, bufIdx, cutIdx, rkLow, rkHigh);
+  preTree->NonTerminalNum(info, predIdx, rkLow, rkHigh, naLHCount > 0, ptId, ptLH, ptRH);
   
-  double lhSum = preTree->Replay(samplePred, predIdx, bufIdx, start, start + lhIdxCount - 1, ptLH);
-  (void) preTree->Replay(samplePred, predIdx, bufIdx, start + lhIdxCount, end, ptRH);
+  double lhSum = preTree->Replay(samplePred, predIdx, bufIdx, start, cutIdx, ptLH);
+  (void) preTree->Replay(samplePred, predIdx, bufIdx, cutIdx + 1, end - naLHCount, ptRH);
+  if (naLHCount > 0)
+    lhSum += preTree->Replay(samplePred, predIdx, bufIdx, end - naLHCount + 1, end, ptLH);
 
   return lhSum;
 }
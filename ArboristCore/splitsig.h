@@ -16,6 +16,8 @@
 #ifndef ARBORIST_SPLITSIG_H
 #define ARBORIST_SPLITSIG_H
 
+#include <vector>
+
 /**
    @brief SSNode records sample, index and information content for a
    potential split at a given split/predictor pair.
@@ -30,26 +32,15 @@ class SSNode {
   unsigned int predIdx; // Rederivable, but convenient to cache.
   unsigned int sCount; // # samples subsumed by split LHS.
   unsigned int lhIdxCount; // Index count of split LHS.
+  unsigned int naLHCount; // Missing-value indices sent left:  numeric only.
   double info; // Information content of split.
   unsigned char bufIdx;
   
-  static double minRatio;
-  
   // Ideally, there would be SplitSigFac and SplitSigNum subclasses, with
   // Replay() and NonTerminal() methods implemented virtually.  Coprocessor
   // may not support virtual invocation, however, so we opt for a less
   // elegant solution.
 
-  /**
-   @brief Derives an information threshold.
-
-   @return information threshold
-  */
-  double inline MinInfo() {
-    return minRatio * info;
-  }
-
-  
   /**
      @brief Accessor for bipartitioning.
 
@@ -66,6 +57,8 @@ class SSNode {
 
   
   double NonTerminal(class SamplePred *samplePred, class PreTree *preTree, unsigned int splitIdx, int start, int end, unsigned int ptId, unsigned int &ptL, unsigned int &ptR, class Run *run);
+  void LHRuns(class Run *run, std::vector<unsigned int> &lhRun) const;
+  double NonTerminalHeld(class SamplePred *samplePred, class PreTree *preTree, int start, int end, unsigned int ptId, unsigned int &ptL, unsigned int &ptR, const std::vector<unsigned int> &lhRun);
 };
 
 
@@ -76,7 +69,7 @@ class SplitSig {
   int splitCount;
   SSNode *levelSS; // Workspace records for the current level.
  protected:
-  static unsigned int nPred;
+  const unsigned int nPred;
 
   /**
      @brief Looks up the SplitSig associated with a given pair.
@@ -98,13 +91,12 @@ class SplitSig {
   }
 
  public:
+  SplitSig(unsigned int _nPred);
   SSNode *ArgMax(unsigned int splitIdx, double minInfo) const;
-  static void Immutables(unsigned int _nPred, double _minRatio);
-  static void DeImmutables();
 
   void LevelInit(int splitCount);
   void LevelClear();
-  void Write(unsigned int _splitIdx, unsigned int _predIdx, int _runIdx, unsigned int _bufIdx, unsigned int _sCount, unsigned int _lhIdxCount, double _info);
+  void Write(unsigned int _splitIdx, unsigned int _predIdx, int _runIdx, unsigned int _bufIdx, unsigned int _sCount, unsigned int _lhIdxCount, double _info, unsigned int _naLHCount);
 };
 
 #endif
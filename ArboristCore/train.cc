@@ -15,34 +15,32 @@
 
 #include "sample.h"
 #include "train.h"
+#include "trainctx.h"
 #include "forest.h"
 #include "rowrank.h"
 #include "predblock.h"
-#include "index.h"
 #include "pretree.h"
-#include "sample.h"
-#include "samplepred.h"
-#include "splitsig.h"
 #include "response.h"
-#include "splitpred.h"
 #include "leaf.h"
+#include "checkpoint.h"
+#include "callback.h"
 
 #include <algorithm>
+#include <numeric>
+#include <thread>
 // Testing only:
 //#include <iostream>
 //using namespace std;
 
-unsigned int Train::trainBlock = 0;
-unsigned int Train::nTree = 0;
-unsigned int Train::nRow = 0;
-unsigned int Train::nPred = 0;
+TrainCtx *Train::ctxInit = 0;
+std::vector<double> Train::predProbInit;
+std::vector<unsigned int> Train::retiredInit;
+unsigned int Train::adaptInit = 0;
 
 
 /**
-   @brief Initializes immutable values for "top-level" classes directly,
-   for those instances in which static initialization seems to make
-   more sense.  These may, in turn, initialize subclasses or classes
-   with objects strictly local to them.
+   @brief Initializes the predictor block and front-end sampler, and
+   records the session's parameters for the static entries following.
 
    @param minNode is the minimal index node size on which to split.
 
@@ -50,91 +48,213 @@ unsigned int Train::nPred = 0;
 
    @param totLevels, if positive, limits the number of levels to build.
 
+   @param nShard, if positive, trains each tree over this many row shards.
+   Ignored if 'regMono' constrains any predictor, as sharded splitting
+   does not enforce monotonicity.
+
+   @param ckptPath, if nonempty, names a log of completed blocks from
+   which training resumes.
+
+   @param obsWeight, if non-null, gives the integral multiplicity of each
+   row.  Rows are sampled as though repeated, so 'nSamp' counts expanded
+   observations.
+
+   @param nOut is the number of outputs of a regression response.
+
+   @param stratum, if non-null, gives the zero-based stratum of each row,
+   such as its response category.  Each tree then bags 'stratumSamp'
+   observations from the respective strata, in place of 'nSamp' drawn
+   by the front end.  Sample and observation weights apply within each
+   stratum.  Rows whose stratum is out of range are never bagged.
+
+   @param nStratum is the number of strata.
+
+   @param adaptTrees, if positive, is the number of leading trees whose
+   gains reweight predictor selection for the trees following.
+
+   @param retireRatio is the fraction of mean gain at or below which an
+   adapting fit retires a predictor.
+
+   @param maxLeaves, if positive, limits the number of leaves per tree.
+   Trees then grow best-first:  the most informative nodes of the entire
+   frontier split until the limit is reached.
+
    @return void.
 */
-void Train::Init(const double _feNum[], const unsigned int _feCard[], unsigned int _cardMax, unsigned int _nPredNum, unsigned int _nPredFac, unsigned int _nRow, unsigned int _nTree, unsigned int _nSamp, const double _feSampleWeight[], bool _withRepl, unsigned int _trainBlock, unsigned int _minNode, double _minRatio, unsigned int _totLevels, unsigned int _ctgWidth, unsigned int _predFixed, const double _predProb[], const double _regMono[]) {
-  nTree = _nTree;
-  nRow = _nRow;
-  nPred = _nPredNum + _nPredFac;
-  trainBlock = _trainBlock;
-  PBTrain::Immutables(_feNum, _feCard, _cardMax, _nPredNum, _nPredFac, nRow);
-  Sample::Immutables(nRow, nPred, _nSamp, _feSampleWeight, _withRepl, _ctgWidth, nTree);
-  SPNode::Immutables(_ctgWidth);
-  SplitSig::Immutables(nPred, _minRatio);
-  Index::Immutables(_minNode, _totLevels);
-  PreTree::Immutables(nPred, _nSamp, _minNode);
-  SplitPred::Immutables(nPred, _ctgWidth, _predFixed, _predProb, _regMono);
+void Train::Init(const double _feNum[], const unsigned int _feCard[], unsigned int _cardMax, unsigned int _nPredNum, unsigned int _nPredFac, unsigned int _nRow, unsigned int _nTree, unsigned int _nSamp, const double _feSampleWeight[], bool _withRepl, unsigned int _trainBlock, unsigned int _minNode, double _minRatio, unsigned int _totLevels, unsigned int _ctgWidth, unsigned int _predFixed, const double _predProb[], const double _regMono[], unsigned int _nShard, const std::string &_ckptPath, const unsigned int _obsWeight[], unsigned int _nOut, const unsigned int _stratum[], const unsigned int _stratumSamp[], unsigned int _nStratum, unsigned int _adaptTrees, double _retireRatio, unsigned int _maxLeaves) {
+  PBTrain::Immutables(_feNum, _feCard, _cardMax, _nPredNum, _nPredFac, _nRow);
+  delete ctxInit;
+  unsigned int nSamp = _stratum == 0 ? _nSamp : std::accumulate(_stratumSamp, _stratumSamp + _nStratum, 0u);
+  ctxInit = new TrainCtx(_nRow, _nPredNum + _nPredFac, _nTree, _trainBlock, _ckptPath, nSamp, _obsWeight, _ctgWidth, _minNode, _minRatio, _totLevels, _predFixed, _predProb, _regMono, _nShard, _nOut);
+  if (_stratum == 0)
+    ctxInit->SampleInit(_feSampleWeight, _withRepl);
+  else
+    ctxInit->Stratify(_stratum, _stratumSamp, _nStratum, _feSampleWeight, _withRepl);
+  ctxInit->Adaptive(_adaptTrees, _retireRatio);
+  ctxInit->LeafBudget(_maxLeaves);
 }
 
 
 /**
-   @brief Unsets immutables.
+   @brief Reports the predictor selection in effect at the close of the
+   last session trained by the static entries.
+
+   @param _predProb outputs the per-predictor selection probabilities.
+
+   @param _retired outputs a nonzero value for each retired predictor.
+
+   @return number of trees informing the adaptation, or zero if none made.
+ */
+unsigned int Train::Adaptation(std::vector<double> &_predProb, std::vector<unsigned int> &_retired) {
+  _predProb = predProbInit;
+  _retired = retiredInit;
+
+  return adaptInit;
+}
+
+
+/**
+   @brief Unsets immutables, retaining the session's predictor-selection
+   report for Adaptation().
 
    @return void.
 */
 void Train::DeImmutables() {
-  nTree = nRow = nPred = trainBlock = 0;
+  adaptInit = ctxInit->AdaptReport(predProbInit, retiredInit);
+  delete ctxInit;
+  ctxInit = 0;
   PBTrain::DeImmutables();
-  SplitSig::DeImmutables();
-  Index::DeImmutables();
-  PreTree::DeImmutables();
-  Sample::DeImmutables();
-  SPNode::DeImmutables();
-  SplitPred::DeImmutables();
 }
 
 
 /**
    @brief Regression constructor.
+
+   @param _scoreOut, if non-null, outputs per-leaf multi-output scores.
  */
-Train::Train(const std::vector<double> &_y, const std::vector<unsigned int> &_row2Rank, std::vector<unsigned int> &_origin, std::vector<unsigned int> &_facOrigin, double _predInfo[], std::vector<class ForestNode> &_forestNode, std::vector<unsigned int> &_facSplit, std::vector<unsigned int> &_leafOrigin, std::vector<class LeafNode> &_leafNode, std::vector<class BagRow> &_bagRow, std::vector<unsigned int> &_rank) : forest(new Forest(_forestNode, _origin, _facOrigin, _facSplit)), predInfo(_predInfo), response(Response::FactoryReg(_y, _row2Rank, _leafOrigin, _leafNode, _bagRow, _rank)) {
+Train::Train(TrainCtx *_ctx, const std::vector<double> &_y, const std::vector<unsigned int> &_row2Rank, std::vector<unsigned int> &_origin, std::vector<unsigned int> &_facOrigin, double _predInfo[], std::vector<class ForestNode> &_forestNode, std::vector<unsigned int> &_facSplit, std::vector<unsigned int> &_leafOrigin, std::vector<class LeafNode> &_leafNode, std::vector<class BagRow> &_bagRow, std::vector<unsigned int> &_rank, std::vector<double> *_scoreOut) : ctx(_ctx), forest(new Forest(_forestNode, _origin, _facOrigin, _facSplit)), predInfo(_predInfo), response(Response::FactoryReg(_y, _row2Rank, _leafOrigin, _leafNode, _bagRow, _rank, _scoreOut, ctx->nOut)) {
 }
 
 
 /**
-   @brief Static entry for regression training.
+   @brief Static entry for regression training, under the session set
+   by Init().
+
+   @return count of trees trained, with output reference parameters.
+*/
+unsigned int Train::Regression(unsigned int _feRow[], unsigned int _feRank[], unsigned int _feInvNum[], const std::vector<double> &_y, const std::vector<unsigned int> &_row2Rank, std::vector<unsigned int> &_origin, std::vector<unsigned int> &_facOrigin, double _predInfo[], std::vector<class ForestNode> &_forestNode, std::vector<unsigned int> &_facSplit, std::vector<unsigned int> &_leafOrigin, std::vector<class LeafNode> &_leafNode, std::vector<class BagRow> &_bagRow, std::vector<unsigned int> &_rank) {
+  RowRank *rowRank = new RowRank(_feRow, _feRank, _feInvNum, ctxInit->nRow, ctxInit->nPred);
+  unsigned int treeDone = Regression(ctxInit, rowRank, _y, _row2Rank, _origin, _facOrigin, _predInfo, _forestNode, _facSplit, _leafOrigin, _leafNode, _bagRow, _rank);
+
+  delete rowRank;
+  DeImmutables();
 
-   @param trainBlock is the maximum number of trees trainable simultaneously.
+  return treeDone;
+}
 
-   @param minNode is the mininal number of sample indices represented by a tree node.
 
-   @param minRatio is the minimum information ratio of a node to its parent.
+/**
+   @brief Reentrant entry for regression training.
 
-   @return forest height, with output reference parameter.
+   @param ctx holds the fit's parameters.
+
+   @param rowRank holds the presorted predictors, possibly shared.
+
+   @return count of trees trained, with output reference parameters.
 */
-void Train::Regression(unsigned int _feRow[], unsigned int _feRank[], unsigned int _feInvNum[], const std::vector<double> &_y, const std::vector<unsigned int> &_row2Rank, std::vector<unsigned int> &_origin, std::vector<unsigned int> &_facOrigin, double _predInfo[], std::vector<class ForestNode> &_forestNode, std::vector<unsigned int> &_facSplit, std::vector<unsigned int> &_leafOrigin, std::vector<class LeafNode> &_leafNode, std::vector<class BagRow> &_bagRow, std::vector<unsigned int> &_rank) {
-  Train *train = new Train(_y, _row2Rank, _origin, _facOrigin, _predInfo, _forestNode, _facSplit, _leafOrigin, _leafNode, _bagRow, _rank);
+unsigned int Train::Regression(TrainCtx *ctx, const RowRank *rowRank, const std::vector<double> &_y, const std::vector<unsigned int> &_row2Rank, std::vector<unsigned int> &_origin, std::vector<unsigned int> &_facOrigin, double _predInfo[], std::vector<class ForestNode> &_forestNode, std::vector<unsigned int> &_facSplit, std::vector<unsigned int> &_leafOrigin, std::vector<class LeafNode> &_leafNode, std::vector<class BagRow> &_bagRow, std::vector<unsigned int> &_rank) {
+  Train *train = new Train(ctx, _y, _row2Rank, _origin, _facOrigin, _predInfo, _forestNode, _facSplit, _leafOrigin, _leafNode, _bagRow, _rank);
+  unsigned int treeDone = train->ForestTrain(rowRank);
+  delete train;
+
+  return treeDone;
+}
 
-  RowRank *rowRank = new RowRank(_feRow, _feRank, _feInvNum, nRow, nPred);
-  train->ForestTrain(rowRank);
+
+/**
+   @brief Static entry for multi-output regression, under the session
+   set by Init().
+
+   @return count of trees trained, with output reference parameters.
+*/
+unsigned int Train::RegressionMulti(unsigned int _feRow[], unsigned int _feRank[], unsigned int _feInvNum[], const std::vector<double> &_y, const std::vector<unsigned int> &_row2Rank, std::vector<unsigned int> &_origin, std::vector<unsigned int> &_facOrigin, double _predInfo[], std::vector<class ForestNode> &_forestNode, std::vector<unsigned int> &_facSplit, std::vector<unsigned int> &_leafOrigin, std::vector<class LeafNode> &_leafNode, std::vector<class BagRow> &_bagRow, std::vector<unsigned int> &_rank, std::vector<double> &_scoreOut) {
+  RowRank *rowRank = new RowRank(_feRow, _feRank, _feInvNum, ctxInit->nRow, ctxInit->nPred);
+  unsigned int treeDone = RegressionMulti(ctxInit, rowRank, _y, _row2Rank, _origin, _facOrigin, _predInfo, _forestNode, _facSplit, _leafOrigin, _leafNode, _bagRow, _rank, _scoreOut);
 
   delete rowRank;
-  delete train;
   DeImmutables();
+
+  return treeDone;
+}
+
+
+/**
+   @brief Reentrant entry for multi-output regression.  The outputs share
+   each tree's splits, which maximize the weighted-variance criterion
+   summed over outputs.  The leading output plays the role of the
+   single-output response, as for ranks and quantiles.
+
+   @param ctx holds the fit's parameters, including the output count.
+
+   @param _y is the response, output-major:  'ctx->nOut' columns of
+   'ctx->nRow' values.
+
+   @param _row2Rank ranks the leading output.
+
+   @param _scoreOut outputs the leaf scores, leaf-major.
+
+   @return count of trees trained, with output reference parameters.
+*/
+unsigned int Train::RegressionMulti(TrainCtx *ctx, const RowRank *rowRank, const std::vector<double> &_y, const std::vector<unsigned int> &_row2Rank, std::vector<unsigned int> &_origin, std::vector<unsigned int> &_facOrigin, double _predInfo[], std::vector<class ForestNode> &_forestNode, std::vector<unsigned int> &_facSplit, std::vector<unsigned int> &_leafOrigin, std::vector<class LeafNode> &_leafNode, std::vector<class BagRow> &_bagRow, std::vector<unsigned int> &_rank, std::vector<double> &_scoreOut) {
+  Train *train = new Train(ctx, _y, _row2Rank, _origin, _facOrigin, _predInfo, _forestNode, _facSplit, _leafOrigin, _leafNode, _bagRow, _rank, &_scoreOut);
+  unsigned int treeDone = train->ForestTrain(rowRank);
+  delete train;
+
+  return treeDone;
 }
 
 
 /**
    @brief Classification constructor.
  */
-Train::Train(const std::vector<unsigned int> &_yCtg, unsigned int _ctgWidth, const std::vector<double> &_yProxy, std::vector<unsigned int> &_origin, std::vector<unsigned int> &_facOrigin, double _predInfo[], std::vector<ForestNode> &_forestNode, std::vector<unsigned int> &_facSplit, std::vector<unsigned int> &_leafOrigin, std::vector<LeafNode> &_leafNode, std::vector<BagRow> &_bagRow, std::vector<double> &_weight) : forest(new Forest(_forestNode, _origin, _facOrigin, _facSplit)), predInfo(_predInfo), response(Response::FactoryCtg(_yCtg, _yProxy, _leafOrigin, _leafNode, _bagRow, _weight, _ctgWidth)) {
+Train::Train(TrainCtx *_ctx, const std::vector<unsigned int> &_yCtg, const std::vector<double> &_yProxy, std::vector<unsigned int> &_origin, std::vector<unsigned int> &_facOrigin, double _predInfo[], std::vector<ForestNode> &_forestNode, std::vector<unsigned int> &_facSplit, std::vector<unsigned int> &_leafOrigin, std::vector<LeafNode> &_leafNode, std::vector<BagRow> &_bagRow, std::vector<double> &_weight) : ctx(_ctx), forest(new Forest(_forestNode, _origin, _facOrigin, _facSplit)), predInfo(_predInfo), response(Response::FactoryCtg(_yCtg, _yProxy, _leafOrigin, _leafNode, _bagRow, _weight, ctx->ctgWidth)) {
 }
 
 
 /**
-   @brief Static entry for regression training.
+   @brief Static entry for classification training, under the session
+   set by Init().
 
-   @return void.
-*/
-void Train::Classification(unsigned int _feRow[], unsigned int _feRank[], unsigned int _feInvNum[], const std::vector<unsigned int>  &_yCtg, unsigned int _ctgWidth, const std::vector<double> &_yProxy, std::vector<unsigned int> &_origin, std::vector<unsigned int> &_facOrigin, double _predInfo[], std::vector<class ForestNode> &_forestNode, std::vector<unsigned int> &_facSplit, std::vector<unsigned int> &_leafOrigin, std::vector<class LeafNode> &_leafNode, std::vector<class BagRow> &_bagRow, std::vector<double> &_weight) {
-  Train *train = new Train(_yCtg, _ctgWidth, _yProxy, _origin, _facOrigin, _predInfo, _forestNode, _facSplit, _leafOrigin, _leafNode, _bagRow, _weight);
+   @param _ctgWidth is the response cardinality, as passed to Init().
 
-  RowRank *rowRank = new RowRank(_feRow, _feRank, _feInvNum, nRow, nPred);
-  train->ForestTrain(rowRank);
+   @return count of trees trained, with output reference parameters.
+*/
+unsigned int Train::Classification(unsigned int _feRow[], unsigned int _feRank[], unsigned int _feInvNum[], const std::vector<unsigned int>  &_yCtg, unsigned int _ctgWidth, const std::vector<double> &_yProxy, std::vector<unsigned int> &_origin, std::vector<unsigned int> &_facOrigin, double _predInfo[], std::vector<class ForestNode> &_forestNode, std::vector<unsigned int> &_facSplit, std::vector<unsigned int> &_leafOrigin, std::vector<class LeafNode> &_leafNode, std::vector<class BagRow> &_bagRow, std::vector<double> &_weight) {
+  RowRank *rowRank = new RowRank(_feRow, _feRank, _feInvNum, ctxInit->nRow, ctxInit->nPred);
+  unsigned int treeDone = Classification(ctxInit, rowRank, _yCtg, _yProxy, _origin, _facOrigin, _predInfo, _forestNode, _facSplit, _leafOrigin, _leafNode, _bagRow, _weight);
 
   delete rowRank;
-  delete train;
   DeImmutables();
+
+  return treeDone;
+}
+
+
+/**
+   @brief Reentrant entry for classification training.
+
+   @param ctx holds the fit's parameters, including response cardinality.
+
+   @param rowRank holds the presorted predictors, possibly shared.
+
+   @return count of trees trained, with output reference parameters.
+*/
+unsigned int Train::Classification(TrainCtx *ctx, const RowRank *rowRank, const std::vector<unsigned int>  &_yCtg, const std::vector<double> &_yProxy, std::vector<unsigned int> &_origin, std::vector<unsigned int> &_facOrigin, double _predInfo[], std::vector<class ForestNode> &_forestNode, std::vector<unsigned int> &_facSplit, std::vector<unsigned int> &_leafOrigin, std::vector<class LeafNode> &_leafNode, std::vector<class BagRow> &_bagRow, std::vector<double> &_weight) {
+  Train *train = new Train(ctx, _yCtg, _yProxy, _origin, _facOrigin, _predInfo, _forestNode, _facSplit, _leafOrigin, _leafNode, _bagRow, _weight);
+  unsigned int treeDone = train->ForestTrain(rowRank);
+  delete train;
+
+  return treeDone;
 }
 
 
@@ -147,41 +267,109 @@ Train::~Train() {
 /**
   @brief Trains the requisite number of trees.
 
+  Sampling and splitting of each block remain on the calling thread,
+  which draws from the fit's generator.  Consumption of a block into the
+  forest and leaves proceeds on a helper thread, overlapping training
+  of the block following.  At most two blocks are therefore live, and
+  blocks are consumed in tree order.
+
+  Cancellation is polled between blocks and, via TrainCtx::Interrupted(), between
+  levels.  A block interrupted midway is discarded.  If checkpointing,
+  training begins at the first block not recorded by a previous run.
+
+  Adaptive predictor selection is applied once a block's consumption
+  brings the committed gains to the requisite tree count, and so takes
+  effect from the block after next.  Each record carries the adaptation
+  state as of its commit, so resumption reproduces the original run.
+
   @param trainBlock is the maximum Count of trees to train en block.
 
-  @return void.
+  @return count of trees trained.
 */
-void Train::ForestTrain(const RowRank *rowRank) {
-  for (unsigned treeStart = 0; treeStart < nTree; treeStart += trainBlock) {
-    unsigned int treeEnd = std::min(treeStart + trainBlock, nTree); // one beyond.
-    Block(rowRank, treeStart, treeEnd - treeStart);
+unsigned int Train::ForestTrain(const RowRank *rowRank) {
+  ctx->RunPredictors(rowRank);
+  ctx->RankRows(rowRank);
+  Checkpoint *ckpt = ctx->ckptPath.empty() ? 0 : new Checkpoint(ctx->ckptPath);
+  unsigned int treeFirst = ckpt == 0 ? 0 : ckpt->Resume(ctx->nTree, ctx->trainBlock, ctx->nRow, ctx->nPred, response->Fingerprint(rowRank->Fingerprint(ctx->Fingerprint())), forest, response, predInfo, ctx);
+  unsigned int treeDone = treeFirst;
+
+  std::thread commit;
+  unsigned int commitStart = treeFirst;
+  std::vector<unsigned char> rngState;
+  for (unsigned treeStart = treeFirst; treeStart < ctx->nTree && !ctx->Interrupted(); treeStart += ctx->trainBlock) {
+    if (ckpt != 0)
+      ctx->RNGState(rngState);
+    unsigned int treeEnd = std::min(treeStart + ctx->trainBlock, ctx->nTree); // one beyond.
+    unsigned int tCount = treeEnd - treeStart;
+    Sample **sampleBlock;
+    PreTree **ptBlock = response->BlockTree(ctx, rowRank, tCount, sampleBlock);
+
+    if (commit.joinable()) {
+      commit.join();
+      Committed(ckpt, commitStart, treeDone, rngState);
+      if (ctx->AdaptDue(treeDone))
+        ctx->Adapt(predInfo, treeDone);
+    }
+    else if (ctx->AdaptDue(treeDone)) // Fell due on the last restored block.
+      ctx->Adapt(predInfo, treeDone);
+
+    if (ctx->Interrupted()) {
+      for (unsigned int blockIdx = 0; blockIdx < tCount; blockIdx++)
+        delete ptBlock[blockIdx];
+      delete [] ptBlock;
+      response->DeBlock(sampleBlock, tCount);
+      break;
+    }
+
+    if (treeStart == treeFirst)
+      Reserve(ptBlock, tCount);
+    commit = std::thread(&Train::BlockTree, this, ptBlock, sampleBlock, treeStart, tCount);
+    commitStart = treeStart;
+    treeDone = treeEnd;
+  }
+  if (commit.joinable()) {
+    commit.join();
+    if (ckpt != 0)
+      ctx->RNGState(rngState);
+    Committed(ckpt, commitStart, treeDone, rngState);
   }
-    
+  delete ckpt;
+
+  if (treeDone < ctx->nTree)
+    return treeDone;
+
   // Normalizes 'predInfo' to per-tree means.
-  double recipNTree = 1.0 / nTree;
-  for (unsigned int i = 0; i < nPred; i++)
+  double recipNTree = 1.0 / ctx->nTree;
+  for (unsigned int i = 0; i < ctx->nPred; i++)
     predInfo[i] *= recipNTree;
 
   forest->SplitUpdate(rowRank);
+
+  return treeDone;
 }
 
 
 /**
+   @brief Notifies the front end of a consumed block and records the
+   block, if checkpointing.
 
-   @param tEnd is one 
- */
-void Train::Block(const RowRank *rowRank, unsigned int tStart, unsigned int tCount) {
-  PreTree **ptBlock = response->BlockTree(rowRank, tCount);
-  if (tStart == 0)
-    Reserve(ptBlock, tCount);
+   @param ckpt is the checkpoint log, if any.
 
-  BlockTree(ptBlock, tStart, tCount);
-  response->DeBlock(tCount);
+   @param tStart is the index of the block's first tree.
 
-  delete [] ptBlock;
+   @param tEnd is the index one beyond the block's last tree.
+
+   @param rngState is the fit's generator state as of the next block.
+
+   @return void.
+ */
+void Train::Committed(Checkpoint *ckpt, unsigned int tStart, unsigned int tEnd, const std::vector<unsigned char> &rngState) {
+  if (ckpt != 0)
+    ckpt->Commit(tStart, tEnd, forest, response, predInfo, ctx->nPred, ctx, rngState);
+  CallBack::Progress(tEnd, ctx->nTree);
 }
 
- 
+
 /** 
   @brief Estimates forest heights using size parameters from the first
   trained block of trees.
@@ -194,9 +382,9 @@ void Train::Reserve(PreTree **ptBlock, unsigned int tCount) {
   unsigned int blockFac, blockBag, blockLeaf;
   unsigned int maxHeight = 0;
   unsigned int blockHeight = BlockPeek(ptBlock, tCount, blockFac, blockBag, blockLeaf, maxHeight);
-  PreTree::Reserve(maxHeight);
+  ctx->Reserve(maxHeight);
 
-  double slop = (slopFactor * nTree) / trainBlock;
+  double slop = (slopFactor * ctx->nTree) / ctx->trainBlock;
   forest->Reserve(blockHeight, blockFac, slop);
   response->LeafReserve(slop * blockLeaf, slop * blockBag);
 }
@@ -226,24 +414,30 @@ unsigned int Train::BlockPeek(PreTree **ptBlock, unsigned int tCount, unsigned i
 
  
 /**
-   @brief Builds segment of decision forest for a block of trees.
+   @brief Builds segment of decision forest for a block of trees, then
+   releases the block.
 
    @param ptBlock is a vector of PreTree objects.
 
+   @param sampleBlock is the vector of Sample objects generating the trees.
+
    @param blockStart is the starting tree index for the block.
 
    @param blockCount is the number of trees in the block.
 
    @return void, with side-effected forest.
 */
-void Train::BlockTree(PreTree **ptBlock, unsigned int blockStart, unsigned int blockCount) {
+void Train::BlockTree(PreTree **ptBlock, Sample **sampleBlock, unsigned int blockStart, unsigned int blockCount) {
   for (unsigned int blockIdx = 0; blockIdx < blockCount; blockIdx++) {
     unsigned int tIdx = blockStart + blockIdx;
     const std::vector<unsigned int> leafMap = ptBlock[blockIdx]->DecTree(forest, tIdx, predInfo);
-    response->Leaves(leafMap, blockIdx, tIdx);
+    response->Leaves(sampleBlock[blockIdx], leafMap, tIdx);
+    forest->HotLayout(tIdx, leafMap);
 
     delete ptBlock[blockIdx];
   }
+  delete [] ptBlock;
+  response->DeBlock(sampleBlock, blockCount);
 }
 
 
@@ -17,19 +17,30 @@
 #define ARBORIST_TRAIN_H
 
 #include <vector>
+#include <string>
 //using namespace std;
 
 /**
-   @brief Interface class for front end.  Holds simulation-specific parameters
-   of the data and constructs forest, leaf and diagnostic structures.
+   @brief Interface class for front end.  Constructs forest, leaf and
+   diagnostic structures under the parameters of a training context.
+
+   The entries taking a context hold all per-fit state, including the
+   row sampler, in that context:  independent fits over a common RowRank
+   may run on separate threads.  Each context draws from its own
+   generator, seeded from the front end's on construction, so that fits
+   reproduce and checkpoint independently.  Cancellation is polled only
+   from the thread constructing the context; fits run elsewhere are
+   cancelled through TrainCtx::Cancel().  The remaining entries wrap
+   these, training a single session parameterized by Init().
 */
 class Train {
   static constexpr double slopFactor = 1.2; // Estimates tree growth.
-  static unsigned int trainBlock; // Front-end defined buffer size.
-  static unsigned int nTree;
-  static unsigned int nRow;
-  static unsigned int nPred;
+  static class TrainCtx *ctxInit; // Session parameters set by Init().
+  static std::vector<double> predProbInit; // Selection reported by the last session.
+  static std::vector<unsigned int> retiredInit;
+  static unsigned int adaptInit;
 
+  class TrainCtx *ctx;
   class Forest *forest;
   double *predInfo; // E.g., Gini gain:  nPred.
   class Response *response;
@@ -38,32 +49,42 @@ class Train {
 
   /**
   */
-  Train(const std::vector<unsigned int> &_yCtg, unsigned int _ctgWidth, const std::vector<double> &_yProxy, std::vector<unsigned int> &_origin, std::vector<unsigned int> &_facOrigin, double _predInfo[], std::vector<class ForestNode> &_forestNode, std::vector<unsigned int> &_facSplit, std::vector<unsigned int> &_leafOrigin, std::vector<class LeafNode> &_leafNode, std::vector<class BagRow> &_bagRow, std::vector<double> &_weight);
+  Train(class TrainCtx *_ctx, const std::vector<unsigned int> &_yCtg, const std::vector<double> &_yProxy, std::vector<unsigned int> &_origin, std::vector<unsigned int> &_facOrigin, double _predInfo[], std::vector<class ForestNode> &_forestNode, std::vector<unsigned int> &_facSplit, std::vector<unsigned int> &_leafOrigin, std::vector<class LeafNode> &_leafNode, std::vector<class BagRow> &_bagRow, std::vector<double> &_weight);
 
  /**
   */
-  Train(const std::vector<double> &_y, const std::vector<unsigned int> &_row2Rank, std::vector<unsigned int> &_origin, std::vector<unsigned int> &_facOrigin, double _predInfo[], std::vector<class ForestNode> &_forestNode, std::vector<unsigned int> &_facSplit, std::vector<unsigned int> &_leafOrigin, std::vector<class LeafNode> &_leafNode, std::vector<class BagRow> &_bagRow, std::vector<unsigned int> &_rank);
+  Train(class TrainCtx *_ctx, const std::vector<double> &_y, const std::vector<unsigned int> &_row2Rank, std::vector<unsigned int> &_origin, std::vector<unsigned int> &_facOrigin, double _predInfo[], std::vector<class ForestNode> &_forestNode, std::vector<unsigned int> &_facSplit, std::vector<unsigned int> &_leafOrigin, std::vector<class LeafNode> &_leafNode, std::vector<class BagRow> &_bagRow, std::vector<unsigned int> &_rank, std::vector<double> *_scoreOut = 0);
 
   ~Train();
   
-  void ForestTrain(const class RowRank *rowRank);
+  unsigned int ForestTrain(const class RowRank *rowRank);
+  void Committed(class Checkpoint *ckpt, unsigned int tStart, unsigned int tEnd, const std::vector<unsigned char> &rngState);
 
  public:
 /**
-   @brief Static initializer.
+   @brief Static initializer for the single-session entries below.
 
    @return void.
  */
-  static void Init(const double _feNum[], const unsigned int _facCard[], unsigned int _cardMax, unsigned int _nPredNum, unsigned int _nPredFac, unsigned int _nRow, unsigned int _nTree, unsigned int _nSamp, const double _feSampleWeight[], bool withRepl, unsigned int _trainBlock, unsigned int _minNode, double _minRatio, unsigned int _totLevels, unsigned int _ctgWidth, unsigned int _predFixed, const double _predProb[], const double _regMono[] = 0);
+  static void Init(const double _feNum[], const unsigned int _facCard[], unsigned int _cardMax, unsigned int _nPredNum, unsigned int _nPredFac, unsigned int _nRow, unsigned int _nTree, unsigned int _nSamp, const double _feSampleWeight[], bool withRepl, unsigned int _trainBlock, unsigned int _minNode, double _minRatio, unsigned int _totLevels, unsigned int _ctgWidth, unsigned int _predFixed, const double _predProb[], const double _regMono[] = 0, unsigned int _nShard = 0, const std::string &_ckptPath = "", const unsigned int _obsWeight[] = 0, unsigned int _nOut = 1, const unsigned int _stratum[] = 0, const unsigned int _stratumSamp[] = 0, unsigned int _nStratum = 0, unsigned int _adaptTrees = 0, double _retireRatio = 0.0, unsigned int _maxLeaves = 0);
 
-  static void Regression(unsigned int _feRow[], unsigned int _feRank[], unsigned int _feInvNum[], const std::vector<double> &_y, const std::vector<unsigned int> &_row2Rank, std::vector<unsigned int> &_origin, std::vector<unsigned int> &_facOrigin, double _predInfo[], std::vector<class ForestNode> &_forestNode, std::vector<unsigned int> &_facSplit, std::vector<unsigned int> &_leafOrigin, std::vector<class LeafNode> &_leafNode, std::vector<class BagRow> &_bagRow, std::vector<unsigned int> &_rank);
+  static unsigned int Adaptation(std::vector<double> &_predProb, std::vector<unsigned int> &_retired);
 
-  static void Classification(unsigned int _feRow[], unsigned int _feRank[], unsigned int _feInvNum[], const std::vector<unsigned int>  &_yCtg, unsigned int _ctgWidth, const std::vector<double> &_yProxy, std::vector<unsigned int> &_origin, std::vector<unsigned int> &_facOrigin, double _predInfo[], std::vector<class ForestNode> &_forestNode, std::vector<unsigned int> &_facSplit, std::vector<unsigned int> &_leafOrigin, std::vector<class LeafNode> &_leafNode, std::vector<class BagRow> &_bagRow, std::vector<double> &_weight);
+  static unsigned int Regression(unsigned int _feRow[], unsigned int _feRank[], unsigned int _feInvNum[], const std::vector<double> &_y, const std::vector<unsigned int> &_row2Rank, std::vector<unsigned int> &_origin, std::vector<unsigned int> &_facOrigin, double _predInfo[], std::vector<class ForestNode> &_forestNode, std::vector<unsigned int> &_facSplit, std::vector<unsigned int> &_leafOrigin, std::vector<class LeafNode> &_leafNode, std::vector<class BagRow> &_bagRow, std::vector<unsigned int> &_rank);
+
+  static unsigned int Classification(unsigned int _feRow[], unsigned int _feRank[], unsigned int _feInvNum[], const std::vector<unsigned int>  &_yCtg, unsigned int _ctgWidth, const std::vector<double> &_yProxy, std::vector<unsigned int> &_origin, std::vector<unsigned int> &_facOrigin, double _predInfo[], std::vector<class ForestNode> &_forestNode, std::vector<unsigned int> &_facSplit, std::vector<unsigned int> &_leafOrigin, std::vector<class LeafNode> &_leafNode, std::vector<class BagRow> &_bagRow, std::vector<double> &_weight);
+
+  static unsigned int Regression(class TrainCtx *ctx, const class RowRank *rowRank, const std::vector<double> &_y, const std::vector<unsigned int> &_row2Rank, std::vector<unsigned int> &_origin, std::vector<unsigned int> &_facOrigin, double _predInfo[], std::vector<class ForestNode> &_forestNode, std::vector<unsigned int> &_facSplit, std::vector<unsigned int> &_leafOrigin, std::vector<class LeafNode> &_leafNode, std::vector<class BagRow> &_bagRow, std::vector<unsigned int> &_rank);
+
+  static unsigned int RegressionMulti(unsigned int _feRow[], unsigned int _feRank[], unsigned int _feInvNum[], const std::vector<double> &_y, const std::vector<unsigned int> &_row2Rank, std::vector<unsigned int> &_origin, std::vector<unsigned int> &_facOrigin, double _predInfo[], std::vector<class ForestNode> &_forestNode, std::vector<unsigned int> &_facSplit, std::vector<unsigned int> &_leafOrigin, std::vector<class LeafNode> &_leafNode, std::vector<class BagRow> &_bagRow, std::vector<unsigned int> &_rank, std::vector<double> &_scoreOut);
+
+  static unsigned int RegressionMulti(class TrainCtx *ctx, const class RowRank *rowRank, const std::vector<double> &_y, const std::vector<unsigned int> &_row2Rank, std::vector<unsigned int> &_origin, std::vector<unsigned int> &_facOrigin, double _predInfo[], std::vector<class ForestNode> &_forestNode, std::vector<unsigned int> &_facSplit, std::vector<unsigned int> &_leafOrigin, std::vector<class LeafNode> &_leafNode, std::vector<class BagRow> &_bagRow, std::vector<unsigned int> &_rank, std::vector<double> &_scoreOut);
+
+  static unsigned int Classification(class TrainCtx *ctx, const class RowRank *rowRank, const std::vector<unsigned int>  &_yCtg, const std::vector<double> &_yProxy, std::vector<unsigned int> &_origin, std::vector<unsigned int> &_facOrigin, double _predInfo[], std::vector<class ForestNode> &_forestNode, std::vector<unsigned int> &_facSplit, std::vector<unsigned int> &_leafOrigin, std::vector<class LeafNode> &_leafNode, std::vector<class BagRow> &_bagRow, std::vector<double> &_weight);
 
   void Reserve(class PreTree **ptBlock, unsigned int tCount);
   unsigned int BlockPeek(class PreTree **ptBlock, unsigned int tCount, unsigned int &blockFac, unsigned int &blockBag, unsigned int &blockLeaf, unsigned int &maxHeight);
-  void BlockTree(class PreTree **ptBlock, unsigned int tStart, unsigned int tCount);
-  void Block(const class RowRank *rowRank, unsigned int tStart, unsigned int tCount);
+  void BlockTree(class PreTree **ptBlock, class Sample **sampleBlock, unsigned int tStart, unsigned int tCount);
 };
 
 
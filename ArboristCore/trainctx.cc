@@ -0,0 +1,784 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file trainctx.cc
+
+   @brief Methods for the parameters of a single training session.
+
+   @author Mark Seligman
+ */
+
+#include "trainctx.h"
+#include "rowrank.h"
+#include "predblock.h"
+#include "splitpred.h"
+#include "callback.h"
+#include "hash.h"
+#include "checkpoint.h"
+
+#include <unordered_set>
+#include <cmath>
+#include <sstream>
+#include <functional>
+
+//#include <iostream>
+//using namespace std;
+
+
+/**
+   @brief Records the session's parameters and computes an initial
+   estimate of pretree height.
+
+   @param _minNode is the minimal index node size on which to split.
+
+   @param _minRatio is a threshold ratio for determining whether to split.
+   Must be non-negative, as otherwise ArgMax cannot distinguish splitting
+   candidates from unset SSNodes, which have initial 'info' == 0.
+
+   @param _totLevels, if positive, limits the number of levels to build.
+
+   @param _regMono, if non-null, gives per-predictor monotonicity
+   probabilities for regression.
+
+   @param _nShard, if positive, trains each tree over this many row shards.
+   Ignored under monotonicity constraints, which the sharded trainer
+   does not enforce:  such fits train unsharded.
+
+   @param _nOut is the number of regression outputs.  Multi-output fits
+   are neither constrained monotonically nor sharded.
+
+   The constructing thread seeds the fit's generator from the front end
+   and is thereafter the only thread to poll the front end.
+ */
+TrainCtx::TrainCtx(unsigned int _nRow, unsigned int _nPred, unsigned int _nTree, unsigned int _trainBlock, const std::string &_ckptPath, int _nSamp, const unsigned int _obsWeight[], unsigned int _ctgWidth, unsigned int _minNode, double _minRatio, unsigned int _totLevels, unsigned int _predFixed, const double _predProb[], const double _regMono[], unsigned int _nShard, unsigned int _nOut) : interrupted(false), pollThread(std::this_thread::get_id()), sampleRepl(false), stratumRepl(false), adaptTrees(0), retireRatio(0.0), adaptAt(0), maxLeaves(0), nRow(_nRow), nPred(_nPred), nTree(_nTree), trainBlock(_trainBlock), ckptPath(_ckptPath), nSamp(_nSamp), obsWeight(_obsWeight), ctgWidth(_ctgWidth), runShift(RunShift(_ctgWidth)), minNode(_minNode), minRatio(_minRatio), totLevels(_totLevels), predFixed(_predFixed), predProb(_predProb), regMono(_ctgWidth == 0 && _nOut == 1 ? _regMono : 0), predMono(_ctgWidth == 0 && _nOut == 1 ? MonoCount(_nPred, _regMono) : 0), nShard(_nOut == 1 && predMono == 0 ? _nShard : 0), nOut(_nOut) {
+  // Initial estimate of pre-tree heights employs a minimal enclosing
+  // balanced tree.  This is probably naive, given that decision trees
+  // are not generally balanced.
+  //
+  // In any case, 'heightEst' is re-estimated following construction of the
+  // first PreTree block.  Nodes can also be reallocated during the
+  // interlevel pass as needed.
+  //
+  unsigned twoL = 1; // 2^level, beginning from level zero (root).
+  while (twoL * minNode < (unsigned int) nSamp) {
+    twoL <<= 1;
+  }
+
+  // Terminals plus accumulated nonterminals.
+  heightEst = (twoL << 2); // - 1, for exact count.
+
+  Seed();
+}
+
+
+/**
+   @brief Seeds the fit's generator from the front end's, which is
+   consulted nowhere else during training.
+
+   @return void.
+ */
+void TrainCtx::Seed() {
+  std::vector<double> ru(seedWords);
+  CallBack::RUnif(seedWords, &ru[0]);
+  std::vector<unsigned int> word(seedWords);
+  for (unsigned int i = 0; i < seedWords; i++) {
+    word[i] = (unsigned int) (ru[i] * 4294967296.0);
+  }
+  std::seed_seq seq(word.begin(), word.end());
+  rng.seed(seq);
+}
+
+
+/**
+   @brief Draws uniform variates from the fit's generator.
+
+   @param len is the number of variates to draw.
+
+   @param out outputs the variates, on [0, 1).
+
+   @return void, with output parameter vector.
+ */
+void TrainCtx::RUnif(unsigned int len, double out[]) const {
+  std::uniform_real_distribution<double> unif(0.0, 1.0);
+  for (unsigned int i = 0; i < len; i++) {
+    out[i] = unif(rng);
+  }
+}
+
+
+/**
+   @brief Draws from a range of cells, as observations or rows.  Uniform
+   draws without replacement employ Floyd's algorithm, so that the work
+   done is proportional to the sample count.  Weighted draws with
+   replacement search the prefix sums.  Weighted draws without
+   replacement take the cells having the least exponential keys, scaled
+   by inverse weight, and so do work proportional to the cell count.
+
+   @param nCell is the number of cells.
+
+   @param cum, if non-null, holds the 'nCell' + 1 weight prefix sums of
+   the cells.  Only differences between sums are consulted.
+
+   @param withRepl is true iff drawing with replacement.
+
+   @param nDraw is the number of draws requested.  Without replacement,
+   no more are made than there are cells of positive weight.
+
+   @param cellOut accumulates the cells drawn.
+
+   @return void, with output vector parameter.
+ */
+void TrainCtx::Draw(unsigned int nCell, const double cum[], bool withRepl, unsigned int nDraw, std::vector<unsigned int> &cellOut) const {
+  if (nCell == 0 || nDraw == 0)
+    return;
+
+  if (!withRepl && cum == 0 && nDraw >= nCell) {
+    for (unsigned int cell = 0; cell < nCell; cell++) {
+      cellOut.push_back(cell);
+    }
+    return;
+  }
+
+  if (withRepl) {
+    double cumSpan = cum == 0 ? 0.0 : cum[nCell] - cum[0];
+    if (cum != 0 && cumSpan <= 0.0)
+      return;
+
+    std::vector<double> ru(nDraw);
+    RUnif(nDraw, &ru[0]);
+    for (unsigned int i = 0; i < nDraw; i++) {
+      if (cum == 0)
+        cellOut.push_back(std::min((unsigned int) (ru[i] * nCell), nCell - 1));
+      else
+        cellOut.push_back(std::upper_bound(cum, cum + nCell, cum[0] + ru[i] * cumSpan) - cum - 1);
+    }
+  }
+  else if (cum == 0) {
+    std::vector<double> ru(nDraw);
+    RUnif(nDraw, &ru[0]);
+    std::unordered_set<unsigned int> drawn;
+    for (unsigned int top = nCell - nDraw, i = 0; top < nCell; top++, i++) {
+      unsigned int cell = std::min((unsigned int) (ru[i] * (top + 1)), top);
+      if (!drawn.insert(cell).second) {
+        drawn.insert(top);
+        cell = top;
+      }
+      cellOut.push_back(cell);
+    }
+  }
+  else {
+    std::vector<double> ru(nCell);
+    RUnif(nCell, &ru[0]);
+    std::vector<std::pair<double, unsigned int> > key;
+    for (unsigned int cell = 0; cell < nCell; cell++) {
+      double weight = cum[cell + 1] - cum[cell];
+      if (weight > 0.0)
+        key.push_back(std::make_pair(-std::log(ru[cell]) / weight, cell));
+    }
+    if (nDraw < key.size()) {
+      std::nth_element(key.begin(), key.begin() + nDraw, key.end());
+      key.resize(nDraw);
+    }
+    for (auto cellKey : key) {
+      cellOut.push_back(cellKey.second);
+    }
+  }
+}
+
+
+/**
+   @brief Serializes the generator, so that a resumed fit draws as the
+   interrupted one would have.
+
+   @param state outputs the generator state.
+
+   @return void, with output reference parameter.
+ */
+void TrainCtx::RNGState(std::vector<unsigned char> &state) const {
+  std::ostringstream out;
+  out << rng;
+  std::string text = out.str();
+  state.assign(text.begin(), text.end());
+}
+
+
+/**
+   @brief Restores a generator state obtained from RNGState().
+
+   @param state is the serialized generator.
+
+   @return void.
+ */
+void TrainCtx::RNGRestore(const std::vector<unsigned char> &state) {
+  std::istringstream in(std::string(state.begin(), state.end()));
+  in >> rng;
+}
+
+
+/**
+   @brief Computes a packing width sufficient to hold all (zero-based)
+   response category values.
+
+   @param ctgWidth is the response cardinality.
+
+   @return number of bits by which sample counts are shifted.
+ */
+unsigned int TrainCtx::RunShift(unsigned int ctgWidth) {
+  unsigned int bits = 1;
+  unsigned int shift = 0;
+  // Ctg values are zero-based, so the first power of 2 greater than or
+  // equal to 'ctgWidth' has sufficient bits to hold all response values.
+  while (bits < ctgWidth) {
+    bits <<= 1;
+    shift++;
+  }
+
+  return shift;
+}
+
+
+/**
+   @brief Counts the predictors subject to monotonicity constraints.
+
+   @return count of predictors with nonzero constraint probability.
+ */
+unsigned int TrainCtx::MonoCount(unsigned int nPred, const double regMono[]) {
+  unsigned int monoCount = 0;
+  if (regMono != 0) {
+    for (unsigned int predIdx = 0; predIdx < nPred; predIdx++) {
+      monoCount += regMono[predIdx] != 0.0;
+    }
+  }
+
+  return monoCount;
+}
+
+
+/**
+   @brief Records the fit's row sampler.  Observation weights are sampled as though each row were
+   repeated by its multiplicity, so that sample counts match those drawn
+   from the expanded rows.  With replacement, this amounts to scaling
+   each row's sampling weight by its multiplicity.  Without replacement,
+   the sampler draws from the expanded rows directly, and draws are
+   mapped back by SampleRow().
+
+   @param _sampleWeight are the per-row sampling weights.
+
+   @param withRepl is true iff sampling with replacement.
+
+   @return void.
+ */
+void TrainCtx::SampleInit(const double _sampleWeight[], bool withRepl) {
+  sampleRepl = withRepl;
+  if (obsWeight == 0) {
+    sampleWeight = std::vector<double>(_sampleWeight, _sampleWeight + nRow);
+  }
+  else if (withRepl) {
+    sampleWeight = std::vector<double>(nRow);
+    for (unsigned int row = 0; row < nRow; row++) {
+      sampleWeight[row] = _sampleWeight[row] * obsWeight[row];
+    }
+  }
+  else {
+    obsOff = std::vector<unsigned int>(nRow + 1);
+    obsOff[0] = 0;
+    for (unsigned int row = 0; row < nRow; row++) {
+      obsOff[row + 1] = obsOff[row] + obsWeight[row];
+    }
+    sampleWeight = std::vector<double>(obsOff[nRow]);
+    for (unsigned int row = 0; row < nRow; row++) {
+      for (unsigned int obs = obsOff[row]; obs < obsOff[row + 1]; obs++)
+        sampleWeight[obs] = _sampleWeight[row];
+    }
+  }
+
+  if (std::adjacent_find(sampleWeight.begin(), sampleWeight.end(), std::not_equal_to<double>()) != sampleWeight.end()) {
+    sampleCum = std::vector<double>(sampleWeight.size() + 1);
+    sampleCum[0] = 0.0;
+    for (unsigned int draw = 0; draw < sampleWeight.size(); draw++) {
+      sampleCum[draw + 1] = sampleCum[draw] + sampleWeight[draw];
+    }
+  }
+}
+
+
+/**
+   @brief Draws under this fit's sampler.
+
+   @param nDraw is the number of draws.
+
+   @param out outputs the draw indices, to be mapped by SampleRow().
+   Draws not made, as when too few indices have positive weight, are
+   set out of range.
+
+   @return void, with output vector parameter.
+ */
+void TrainCtx::SampleRows(int nDraw, int out[]) const {
+  std::vector<unsigned int> drawn;
+  Draw(sampleWeight.size(), sampleCum.empty() ? 0 : &sampleCum[0], sampleRepl, nDraw, drawn);
+  for (int i = 0; i < nDraw; i++) {
+    out[i] = (unsigned int) i < drawn.size() ? drawn[i] : -1;
+  }
+}
+
+
+/**
+   @brief Flags numeric predictors having few enough distinct values
+   that their nodes are better split a run of ties at a time.  Such
+   columns, typically flags or small counts, leave the per-sample walk
+   with little to do beyond accumulation.
+
+   @param rowRank holds the presorted predictors.
+
+   @return void.
+ */
+void TrainCtx::RunPredictors(const RowRank *rowRank) {
+  runNum = std::vector<bool>(nPred);
+  for (unsigned int predIdx = 0; predIdx < nPred; predIdx++) {
+    runNum[predIdx] = !PredBlock::IsFactor(predIdx) && rowRank->RankCount(predIdx) <= SplitPred::runMax;
+  }
+}
+
+
+/**
+   @brief Records strata from which each tree draws a fixed number of
+   rows, as in balanced bagging of rare classes.  Stratified draws
+   replace the row sampler, but honor the same weights:  observation weights expand each stratum as SampleInit()
+   expands the rows, and sample weights bias the draws within a stratum.
+   Each tree then visits only its bagged rows:  drawing and enumerating
+   them, and staging each predictor by ranking them, for O(bag log nRow)
+   work per predictor.
+
+   @param stratum is the zero-based stratum of each row, such as its
+   response category.  Rows whose stratum is not less than 'nStratum'
+   are never drawn.
+
+   @param _stratumSamp are the per-stratum sample counts.  Without
+   replacement, a count reaching the stratum's size bags the entire
+   stratum.
+
+   @param nStratum is the number of strata.
+
+   @param _sampleWeight, if non-null, are the per-row sampling weights.
+   Only their relative values within a stratum matter.
+
+   @param withRepl is true iff sampling with replacement.
+
+   @return void.
+ */
+void TrainCtx::Stratify(const unsigned int stratum[], const unsigned int _stratumSamp[], unsigned int nStratum, const double _sampleWeight[], bool withRepl) {
+  stratumRepl = withRepl;
+  stratumSamp = std::vector<unsigned int>(_stratumSamp, _stratumSamp + nStratum);
+  stratumOff = std::vector<unsigned int>(nStratum + 1, 0);
+  for (unsigned int row = 0; row < nRow; row++) {
+    if (stratum[row] < nStratum)
+      stratumOff[stratum[row] + 1]++;
+  }
+  for (unsigned int stIdx = 0; stIdx < nStratum; stIdx++) {
+    stratumOff[stIdx + 1] += stratumOff[stIdx];
+  }
+
+  std::vector<unsigned int> stratumTop(stratumOff.begin(), stratumOff.end() - 1);
+  stratumRow = std::vector<unsigned int>(stratumOff[nStratum]);
+  for (unsigned int row = 0; row < nRow; row++) {
+    if (stratum[row] < nStratum)
+      stratumRow[stratumTop[stratum[row]]++] = row;
+  }
+
+  if (obsWeight != 0) {
+    stratumObs = std::vector<unsigned int>(stratumRow.size() + 1);
+    stratumObs[0] = 0;
+    for (unsigned int pos = 0; pos < stratumRow.size(); pos++) {
+      stratumObs[pos + 1] = stratumObs[pos] + obsWeight[stratumRow[pos]];
+    }
+  }
+
+  // Weights constant over each stratum leave its draws uniform.
+  bool uniform = true;
+  for (unsigned int stIdx = 0; stIdx < nStratum && uniform && _sampleWeight != 0; stIdx++) {
+    for (unsigned int pos = stratumOff[stIdx]; pos < stratumOff[stIdx + 1]; pos++) {
+      if (_sampleWeight[stratumRow[pos]] != _sampleWeight[stratumRow[stratumOff[stIdx]]]) {
+        uniform = false;
+        break;
+      }
+    }
+  }
+  if (!uniform) {
+    stratumCum = std::vector<double>((stratumObs.empty() ? stratumRow.size() : stratumObs.back()) + 1);
+    stratumCum[0] = 0.0;
+    unsigned int obs = 0;
+    for (unsigned int pos = 0; pos < stratumRow.size(); pos++) {
+      unsigned int row = stratumRow[pos];
+      for (unsigned int copy = 0; copy < (obsWeight == 0 ? 1 : obsWeight[row]); copy++, obs++) {
+        stratumCum[obs + 1] = stratumCum[obs] + _sampleWeight[row];
+      }
+    }
+  }
+}
+
+
+/**
+   @brief Maps an observation of a stratum to its row.  Under observation
+   weights, each row of the stratum contributes as many observations as
+   its multiplicity.
+
+   @param stIdx is the stratum index.
+
+   @param obs is the observation's offset within the stratum.
+
+   @return row holding the observation.
+ */
+unsigned int TrainCtx::StratumObsRow(unsigned int stIdx, unsigned int obs) const {
+  if (stratumObs.empty())
+    return stratumRow[stratumOff[stIdx] + obs];
+
+  auto first = stratumObs.begin() + stratumOff[stIdx];
+  auto last = stratumObs.begin() + stratumOff[stIdx + 1];
+  return stratumRow[std::upper_bound(first, last, *first + obs) - stratumObs.begin() - 1];
+}
+
+
+/**
+   @brief Inverts the presorted factors, under stratification, so that
+   staging can look up the codes of the bagged rows directly.  Numeric
+   ranks are instead recovered by search, so need no inversion.
+
+   @param rowRank holds the presorted predictors.
+
+   @return void.
+ */
+void TrainCtx::RankRows(const RowRank *rowRank) {
+  if (!Stratified())
+    return;
+
+  unsigned int nPredFac = nPred - PredBlock::FacFirst();
+  facRank = std::vector<unsigned int>(nPredFac * nRow);
+  for (unsigned int facIdx = 0; facIdx < nPredFac; facIdx++) {
+    for (unsigned int idx = 0; idx < nRow; idx++) {
+      unsigned int rank;
+      unsigned int row = rowRank->Lookup(PredBlock::FacFirst() + facIdx, idx, rank);
+      facRank[facIdx * nRow + row] = rank;
+    }
+  }
+}
+
+
+/**
+   @brief Looks up a row's rank with respect to a predictor.  Only
+   available under stratified sampling.  Numeric ranks are dense over
+   the sorted distinct values, so are found by binary search of the
+   row's value.
+
+   @param rowRank holds the presorted predictors.
+
+   @return rank of predictor at row.
+ */
+unsigned int TrainCtx::RankOf(const RowRank *rowRank, unsigned int predIdx, unsigned int row) const {
+  if (PredBlock::IsFactor(predIdx))
+    return facRank[(predIdx - PredBlock::FacFirst()) * nRow + row];
+
+  double val = PBTrain::NumVal(predIdx, row);
+  if (std::isnan(val))
+    return PredBlock::NARank();
+
+  unsigned int rkLow = 0;
+  unsigned int rkHigh = rowRank->RankCount(predIdx);
+  while (rkLow < rkHigh) {
+    unsigned int rkMid = (rkLow + rkHigh) / 2;
+    if (PBTrain::NumVal(predIdx, rowRank->Rank2Row(predIdx, rkMid)) < val)
+      rkLow = rkMid + 1;
+    else
+      rkHigh = rkMid;
+  }
+
+  return rkLow;
+}
+
+
+/**
+   @brief Draws a tree's bag stratum by stratum.  Draws are made over a
+   stratum's observations, as expanded by their multiplicities, and
+   mapped back to rows.
+
+   @param bag outputs the sampled rows, in increasing order, paired with
+   their sample counts.
+
+   @return void, with output vector parameter.
+ */
+void TrainCtx::StratumSample(std::vector<std::pair<unsigned int, unsigned int> > &bag) const {
+  std::vector<unsigned int> rowDrawn;
+  std::vector<unsigned int> obsDrawn;
+  for (unsigned int stIdx = 0; stIdx + 1 < stratumOff.size(); stIdx++) {
+    unsigned int obsStart = stratumObs.empty() ? stratumOff[stIdx] : stratumObs[stratumOff[stIdx]];
+    unsigned int obsEnd = stratumObs.empty() ? stratumOff[stIdx + 1] : stratumObs[stratumOff[stIdx + 1]];
+    obsDrawn.clear();
+    Draw(obsEnd - obsStart, stratumCum.empty() ? 0 : &stratumCum[obsStart], stratumRepl, stratumSamp[stIdx], obsDrawn);
+    for (auto obs : obsDrawn) {
+      rowDrawn.push_back(StratumObsRow(stIdx, obs));
+    }
+  }
+
+  std::sort(rowDrawn.begin(), rowDrawn.end());
+  bag.clear();
+  for (auto row : rowDrawn) {
+    if (!bag.empty() && bag.back().first == row)
+      bag.back().second++;
+    else
+      bag.push_back(std::make_pair(row, 1));
+  }
+}
+
+
+/**
+   @brief Enables reweighting of predictor selection by the gains
+   observed over a leading set of trees.
+
+   @param _adaptTrees is the minimal number of trees whose gains inform
+   the reweighting.  Zero disables adaptation.
+
+   @param _retireRatio is the fraction of the mean predictor gain at or
+   below which a predictor is retired.
+
+   @return void.
+ */
+void TrainCtx::Adaptive(unsigned int _adaptTrees, double _retireRatio) {
+  adaptTrees = _adaptTrees;
+  retireRatio = _retireRatio;
+}
+
+
+/**
+   @brief Limits the number of leaves grown by each tree.
+
+   @param _maxLeaves is the per-tree leaf budget, spent on the most
+   informative splits of the frontier.  Zero leaves growth unlimited.
+
+   @return void.
+ */
+void TrainCtx::LeafBudget(unsigned int _maxLeaves) {
+  maxLeaves = _maxLeaves;
+}
+
+
+/**
+   @brief Selects, from the frontier's candidate splits, those to be
+   expanded this round under the leaf budget.  Candidates are popped
+   from a max-heap on information, as in sequential best-first growth,
+   for so long as expansion is certain:  a subtree subsuming n distinct
+   indices holds at most n - 1 splits, so the candidate popped next is
+   expanded by best-first growth whenever the splits possibly preceding
+   it, those of earlier pops and their descendants, number fewer than
+   the budget remaining.  The round's batch therefore expands exactly
+   the nodes which one-at-a-time growth would, and a budget which does
+   not bind expands the entire frontier.  Each expansion adds a single
+   leaf.
+
+   @param cand holds the information, index count and level position of
+   each candidate.  Outputs the expanded candidates, in order of
+   decreasing information, followed by the remainder.
+
+   @param leafCount is the tree's current count of leaves.  Outputs the
+   count following expansion.
+
+   @return count of candidates expanded.
+ */
+unsigned int TrainCtx::Budget(std::vector<BudgetCand> &cand, unsigned int &leafCount) const {
+  unsigned int splitMax = maxLeaves > leafCount ? maxLeaves - leafCount : 0;
+  std::make_heap(cand.begin(), cand.end());
+  std::vector<BudgetCand> expand;
+  unsigned int reach = 0; // Splits possibly preceding the next pop.
+  while (!cand.empty() && reach < splitMax) {
+    std::pop_heap(cand.begin(), cand.end());
+    expand.push_back(cand.back());
+    cand.pop_back();
+    reach += expand.back().idxCount - 1;
+  }
+  unsigned int expandCount = expand.size();
+  leafCount += expandCount;
+  expand.insert(expand.end(), cand.begin(), cand.end());
+  cand = std::move(expand);
+
+  return expandCount;
+}
+
+
+/**
+   @brief Hashes the parameters determining the trees trained, including
+   the sampler and its weights.  Adaptation state evolves during training
+   and is excluded.
+
+   @return hash of the fit's parameters.
+ */
+unsigned long long TrainCtx::Fingerprint() const {
+  std::vector<unsigned int> dim { nRow, nPred, nTree, trainBlock, (unsigned int) nSamp, ctgWidth, minNode, totLevels, predFixed, nShard, nOut, adaptTrees, maxLeaves, sampleRepl, stratumRepl };
+  unsigned long long key = Hash::Vec(dim, 0);
+  key = Hash::Val(minRatio, key);
+  key = Hash::Val(retireRatio, key);
+  key = Hash::Vec(sampleWeight, key);
+  key = obsWeight == 0 ? Hash::Val(0u, key) : Hash::Bytes(obsWeight, nRow * sizeof(unsigned int), key);
+  key = Hash::Vec(stratumOff, key);
+  key = Hash::Vec(stratumRow, key);
+  key = Hash::Vec(stratumSamp, key);
+  key = Hash::Vec(stratumCum, key);
+  key = Hash::Bytes(predProb, nPred * sizeof(double), key);
+  key = regMono == 0 ? Hash::Val(0u, key) : Hash::Bytes(regMono, nPred * sizeof(double), key);
+
+  return key;
+}
+
+
+/**
+   @brief Reweights predictor selection by accumulated gain.  Predictors
+   whose gain is negligible are retired:  they are neither scheduled for
+   splitting nor staged by subsequent trees.  The surviving predictors'
+   probabilities are scaled in proportion to their gains, preserving the
+   expected number of predictors selected per node, up to capping at
+   unity.  The predictor of greatest gain is never retired.
+
+   Adaptation is made once, between blocks, and so affects only trees
+   trained subsequently.
+
+   @param predInfo are the gains accumulated by predictor.
+
+   @param treeCount is the number of trees contributing to 'predInfo'.
+
+   @return void.
+ */
+void TrainCtx::Adapt(const double predInfo[], unsigned int treeCount) {
+  adaptAt = treeCount;
+  double infoSum = 0.0;
+  double probSum = 0.0;
+  unsigned int predMax = 0;
+  for (unsigned int predIdx = 0; predIdx < nPred; predIdx++) {
+    infoSum += predInfo[predIdx];
+    probSum += predProb[predIdx];
+    if (predInfo[predIdx] > predInfo[predMax])
+      predMax = predIdx;
+  }
+  if (infoSum <= 0.0)
+    return; // Nothing learned.
+
+  double infoFloor = retireRatio * infoSum / nPred;
+  retired = std::vector<bool>(nPred);
+  double weightSum = 0.0;
+  for (unsigned int predIdx = 0; predIdx < nPred; predIdx++) {
+    retired[predIdx] = predIdx != predMax && predInfo[predIdx] <= infoFloor;
+    if (!retired[predIdx])
+      weightSum += predProb[predIdx] * predInfo[predIdx];
+  }
+
+  // Fixed-count selection reads the probabilities as relative weights,
+  // which capping would flatten.
+  predAdapt = std::vector<double>(nPred);
+  for (unsigned int predIdx = 0; predIdx < nPred; predIdx++) {
+    if (!retired[predIdx]) {
+      double prob = probSum * predProb[predIdx] * predInfo[predIdx] / weightSum;
+      predAdapt[predIdx] = predFixed > 0 ? prob : std::min(1.0, prob);
+    }
+  }
+  predProb = &predAdapt[0];
+}
+
+
+/**
+   @brief Reports the predictor selection in effect at the close of
+   training.
+
+   @param predProbOut outputs the selection probability of each
+   predictor.
+
+   @param retiredOut outputs a nonzero value for each retired predictor.
+
+   @return number of trees informing the adaptation, or zero if none made.
+ */
+unsigned int TrainCtx::AdaptReport(std::vector<double> &predProbOut, std::vector<unsigned int> &retiredOut) const {
+  predProbOut = std::vector<double>(predProb, predProb + nPred);
+  retiredOut = std::vector<unsigned int>(nPred);
+  for (unsigned int predIdx = 0; predIdx < nPred; predIdx++) {
+    retiredOut[predIdx] = Retired(predIdx) ? 1 : 0;
+  }
+
+  return retired.empty() ? 0 : adaptAt;
+}
+
+
+/**
+   @brief Records the adaptation state in force as of a committed block.
+
+   @param ckpt is the checkpoint record under construction.
+
+   @return void.
+ */
+void TrainCtx::Dump(Checkpoint *ckpt) const {
+  std::vector<unsigned int> at { adaptAt };
+  ckpt->Put(at, 0, at.size());
+  ckpt->Put(predAdapt, 0, predAdapt.size());
+  std::vector<unsigned char> retiredByte(retired.begin(), retired.end());
+  ckpt->Put(retiredByte, 0, retiredByte.size());
+}
+
+
+/**
+   @brief Reinstates the adaptation state recorded by Dump().
+
+   @param ckpt is the checkpoint record under review.
+
+   @return void.
+ */
+void TrainCtx::Restore(Checkpoint *ckpt) {
+  std::vector<unsigned int> at;
+  ckpt->Get(at, 0);
+  adaptAt = at[0];
+  predAdapt.clear();
+  ckpt->Get(predAdapt, 0);
+  std::vector<unsigned char> retiredByte;
+  ckpt->Get(retiredByte, 0);
+  retired = std::vector<bool>(retiredByte.begin(), retiredByte.end());
+  if (!predAdapt.empty())
+    predProb = &predAdapt[0];
+}
+
+
+/**
+   @brief Refines the height estimate using the actual height of a
+   constructed PreTree.
+
+   @param height is an actual height value.
+
+   @return void.
+ */
+void TrainCtx::Reserve(unsigned int height) {
+  while (heightEst <= height) // Assigns next power-of-two above 'height'.
+    heightEst <<= 1;
+}
+
+
+/**
+   @brief Polls the front end for cancellation.  The request is latched,
+   as front ends may clear their own indication once polled.  Only the
+   thread constructing the fit polls:  others consult the latch, which
+   is set on their behalf by that thread or by Cancel().
+
+   @return true iff training has been cancelled.
+ */
+bool TrainCtx::Interrupted() {
+  if (!interrupted && std::this_thread::get_id() == pollThread)
+    interrupted = CallBack::Interrupted();
+
+  return interrupted;
+}
+
+
+/**
+   @brief Cancels training from a thread other than the polling thread.
+
+   @return void.
+ */
+void TrainCtx::Cancel() {
+  interrupted = true;
+}
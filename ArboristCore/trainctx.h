@@ -0,0 +1,252 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file trainctx.h
+
+   @brief Parameters and derived state of a single training session.
+
+   @author Mark Seligman
+
+ */
+
+#ifndef ARBORIST_TRAINCTX_H
+#define ARBORIST_TRAINCTX_H
+
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <atomic>
+#include <random>
+#include <thread>
+
+
+/**
+   @brief Frontier node holding a split, ranked under a leaf budget.
+ */
+class BudgetCand {
+ public:
+  double info; // Information content of the node's split.
+  unsigned int idxCount; // Distinct indices subsumed by the node.
+  unsigned int levelIdx; // Position within the current level.
+
+  BudgetCand(double _info, unsigned int _idxCount, unsigned int _levelIdx) : info(_info), idxCount(_idxCount), levelIdx(_levelIdx) {
+  }
+
+
+  /**
+     @brief Heap ordering:  higher information ranks first, with ties
+     favoring the earlier level position.
+   */
+  inline bool operator<(const BudgetCand &other) const {
+    return info < other.info || (info == other.info && levelIdx > other.levelIdx);
+  }
+};
+
+
+/**
+   @brief Per-fit replacement for the static immutables formerly held by
+   the training classes.  Each fit owns an instance, which is threaded
+   through sampling, splitting and tree construction, so that independent
+   fits may proceed concurrently.  Fits running concurrently must share
+   the predictor block, as with a common RowRank.  Each fit draws its
+   variates from its own generator, seeded from the front end's when
+   the fit is constructed, and polls the front end only from the thread
+   which constructed it.
+ */
+class TrainCtx {
+  static const unsigned int seedWords = 8; // Front-end variates seeding the generator.
+  std::atomic<bool> interrupted; // Latches cancellation.
+  const std::thread::id pollThread; // Sole thread polling the front end.
+  mutable std::mt19937 rng; // Fit's generator:  draws are serial per fit.
+  std::vector<bool> runNum; // Numeric predictors split by runs.
+  std::vector<double> sampleWeight; // Sampler weights, by draw index.
+  std::vector<double> sampleCum; // Prefix sums of 'sampleWeight' iff nonuniform.
+  bool sampleRepl; // Whether the sampler draws with replacement.
+  std::vector<unsigned int> obsOff; // Multiplicity prefix sums iff drawing expanded rows.
+  std::vector<unsigned int> stratumOff; // Offsets into 'stratumRow' iff stratified.
+  std::vector<unsigned int> stratumRow; // Rows, grouped by stratum.
+  std::vector<unsigned int> stratumSamp; // Per-stratum sample counts.
+  std::vector<unsigned int> stratumObs; // Multiplicity prefix sums of 'stratumRow' iff observation weights.
+  std::vector<double> stratumCum; // Weight prefix sums of stratum observations iff weights vary within a stratum.
+  bool stratumRepl; // Whether strata are sampled with replacement.
+  std::vector<unsigned int> facRank; // Factor-major code of each row, iff stratified.
+  unsigned int adaptTrees; // Trees informing adaptation:  zero iff not adapting.
+  double retireRatio; // Retirement threshold, relative to mean gain.
+  unsigned int adaptAt; // Trees informing the adaptation made, else zero.
+  std::vector<double> predAdapt; // Adapted selection probabilities.
+  std::vector<bool> retired; // Predictors no longer staged, iff adapted.
+  unsigned int maxLeaves; // Per-tree leaf budget:  zero iff unlimited.
+
+ public:
+  const unsigned int nRow;
+  const unsigned int nPred;
+  const unsigned int nTree;
+  const unsigned int trainBlock; // Front-end defined buffer size.
+  const std::string ckptPath; // Empty iff not checkpointing.
+  const int nSamp;
+  const unsigned int *obsWeight; // Per-row multiplicity, or null.
+  const unsigned int ctgWidth; // Zero iff regression.
+  const unsigned int runShift; // Pack:  nonzero iff categorical response.
+  const unsigned int minNode;
+  const double minRatio;
+  const unsigned int totLevels; // Zero iff unlimited.
+  const unsigned int predFixed;
+  const double *predProb;
+  const double *regMono; // Null iff unconstrained.
+  const unsigned int predMono; // # constrained predictors.
+  const unsigned int nShard; // Zero iff sharding disabled.
+  const unsigned int nOut; // Regression outputs:  unity unless multi-output.
+  unsigned int heightEst; // Pretree allocation height.
+
+  TrainCtx(unsigned int _nRow, unsigned int _nPred, unsigned int _nTree, unsigned int _trainBlock, const std::string &_ckptPath, int _nSamp, const unsigned int _obsWeight[], unsigned int _ctgWidth, unsigned int _minNode, double _minRatio, unsigned int _totLevels, unsigned int _predFixed, const double _predProb[], const double _regMono[], unsigned int _nShard, unsigned int _nOut = 1);
+
+  static unsigned int RunShift(unsigned int ctgWidth);
+  static unsigned int MonoCount(unsigned int nPred, const double regMono[]);
+  void Seed();
+  void RUnif(unsigned int len, double out[]) const;
+  void Draw(unsigned int nCell, const double cum[], bool withRepl, unsigned int nDraw, std::vector<unsigned int> &cellOut) const;
+  void RNGState(std::vector<unsigned char> &state) const;
+  void RNGRestore(const std::vector<unsigned char> &state);
+  void SampleInit(const double _sampleWeight[], bool withRepl);
+  void SampleRows(int nDraw, int out[]) const;
+  void RunPredictors(const class RowRank *rowRank);
+  void Stratify(const unsigned int stratum[], const unsigned int _stratumSamp[], unsigned int nStratum, const double _sampleWeight[], bool withRepl);
+  unsigned int StratumObsRow(unsigned int stIdx, unsigned int obs) const;
+  void RankRows(const class RowRank *rowRank);
+  unsigned int RankOf(const class RowRank *rowRank, unsigned int predIdx, unsigned int row) const;
+  void StratumSample(std::vector<std::pair<unsigned int, unsigned int> > &bag) const;
+  void Adaptive(unsigned int _adaptTrees, double _retireRatio);
+  void Adapt(const double predInfo[], unsigned int treeCount);
+  unsigned int AdaptReport(std::vector<double> &predProbOut, std::vector<unsigned int> &retiredOut) const;
+  void Dump(class Checkpoint *ckpt) const;
+  void Restore(class Checkpoint *ckpt);
+  void LeafBudget(unsigned int _maxLeaves);
+  unsigned int Budget(std::vector<BudgetCand> &cand, unsigned int &leafCount) const;
+  unsigned long long Fingerprint() const;
+  void Reserve(unsigned int height);
+  bool Interrupted();
+  void Cancel();
+
+
+  /**
+     @brief Determines whether a numeric predictor is split by runs.
+
+     @return true iff the predictor was flagged as having few values.
+   */
+  inline bool RunNum(unsigned int predIdx) const {
+    return runNum.empty() ? false : runNum[predIdx];
+  }
+
+
+  /**
+     @brief Determines whether rows are sampled by stratum.
+
+     @return true iff strata have been specified.
+   */
+  inline bool Stratified() const {
+    return !stratumOff.empty();
+  }
+
+
+  /**
+     @brief Determines whether predictor selection is to be adapted.
+
+     @param treeCount is the number of trees whose gains have been
+     accumulated.
+
+     @return true iff adaptation is enabled, pending and informed.
+   */
+  inline bool AdaptDue(unsigned int treeCount) const {
+    return adaptTrees > 0 && adaptAt == 0 && treeCount >= adaptTrees;
+  }
+
+
+  /**
+     @brief Determines whether a predictor has been retired from
+     selection and staging.
+
+     @return true iff predictor retired.
+   */
+  inline bool Retired(unsigned int predIdx) const {
+    return retired.empty() ? false : retired[predIdx];
+  }
+
+
+  /**
+     @brief Determines whether tree growth is limited by a leaf budget.
+
+     @return true iff a positive budget has been set.
+   */
+  inline bool Budgeted() const {
+    return maxLeaves > 0;
+  }
+
+
+  /**
+     @brief Determines whether a budgeted tree may grow further.
+
+     @param leafCount is the tree's current count of leaves.
+
+     @return true iff fewer leaves than the budget have been grown.
+   */
+  inline bool BudgetLeft(unsigned int leafCount) const {
+    return leafCount < maxLeaves;
+  }
+
+
+  /**
+     @brief Maps a sampler draw to the row it samples.
+
+     @param draw is the index returned by the sampler.
+
+     @return row index, collapsing expanded observations onto their rows,
+     or 'nRow' if the draw lies outside the sampler's range.
+   */
+  inline unsigned int SampleRow(int draw) const {
+    if (draw < 0 || (unsigned int) draw >= sampleWeight.size())
+      return nRow;
+    return obsOff.empty() ? draw : std::upper_bound(obsOff.begin(), obsOff.end(), (unsigned int) draw) - obsOff.begin() - 1;
+  }
+
+
+  /**
+     @brief Determines whether a node persists to the next level.  Nodes
+     are ordinarily sized by their distinct samples.  Under observation
+     weights, a row's sampled copies are distinct in the expanded data,
+     so nodes are sized by sample count, but must still hold at least two
+     samples.
+
+     MUST guarantee that no zero-length "splits" have been introduced.
+     Not only are these nonsensical, but they are also dangerous, as they
+     violate various assumptions about the integrity of the intermediate
+     respresentation.
+
+     @param idxCount is the count of indices subsumed by the node.
+
+     @param sCount is the sample count subsumed by the node.
+
+     @return true iff the node exceeds the minimal splitable size.
+   */
+  inline bool Splitable(unsigned int idxCount, unsigned int sCount) const {
+    return obsWeight == 0 ? idxCount > minNode : idxCount > 1 && sCount > minNode;
+  }
+
+
+  /**
+     @brief Derives an information threshold for a node's successors.
+
+     @param info is the information content of the node's split.
+
+     @return information threshold.
+   */
+  inline double MinInfo(double info) const {
+    return minRatio * info;
+  }
+};
+
+#endif